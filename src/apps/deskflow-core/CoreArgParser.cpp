@@ -18,7 +18,7 @@ const QString CoreArgParser::s_headerText = QStringLiteral("%1: %2\n").arg(kCore
 CoreArgParser::CoreArgParser(const QStringList &args)
 {
   m_parser.setApplicationDescription(kAppDescription);
-  m_parser.addPositionalArgument("coremode", "The mode to start in either: server or client", "coremode");
+  m_parser.addPositionalArgument("coremode", "The mode to start in either: server, client or replay <recording>", "coremode");
 
   m_parser.addOptions(CoreArgs::options);
   m_parser.setSingleDashWordOptionMode(QCommandLineParser::ParseAsLongOptions);
@@ -42,12 +42,18 @@ void CoreArgParser::parse()
   const QString mode = posArgs.takeFirst();
   m_serverMode = (mode.compare("server", Qt::CaseInsensitive) == 0);
   m_clientMode = (mode.compare("client", Qt::CaseInsensitive) == 0);
+  m_replayMode = (mode.compare("replay", Qt::CaseInsensitive) == 0);
 
-  if ((!m_clientMode && !m_serverMode) || mode.isEmpty()) {
+  if ((!m_clientMode && !m_serverMode && !m_replayMode) || mode.isEmpty()) {
     showHelpText();
     exit(s_exitSuccess);
   }
 
+  // replay takes the recording to play back after the mode
+  if (m_replayMode) {
+    m_replayFile = posArgs.value(0);
+  }
+
   if (m_parser.isSet(CoreArgs::configOption)) {
     Settings::setSettingsFile(m_parser.value(CoreArgs::configOption));
   }
@@ -190,6 +196,11 @@ bool CoreArgParser::clientMode() const
   return m_clientMode;
 }
 
+bool CoreArgParser::replayMode() const
+{
+  return m_replayMode;
+}
+
 bool CoreArgParser::singleInstanceOnly() const
 {
   return m_singleInstance;
@@ -209,6 +220,16 @@ QString CoreArgParser::linkDevice() const
   return m_parser.value(CoreArgs::linkOption);
 }
 
+QStringList CoreArgParser::bridgeSpecs() const
+{
+  return m_parser.values(CoreArgs::bridgeOption);
+}
+
+QString CoreArgParser::statusSocket() const
+{
+  return m_parser.value(CoreArgs::statusSocketOption);
+}
+
 int CoreArgParser::screenWidth() const
 {
   bool ok = false;
@@ -222,3 +243,18 @@ int CoreArgParser::screenHeight() const
   int height = m_parser.value(CoreArgs::screenHeightOption).toInt(&ok);
   return ok ? height : 0;
 }
+
+QString CoreArgParser::replayFile() const
+{
+  return m_replayFile;
+}
+
+double CoreArgParser::replaySpeed() const
+{
+  if (!m_parser.isSet(CoreArgs::replaySpeedOption)) {
+    return 1.0;
+  }
+  bool ok = false;
+  double speed = m_parser.value(CoreArgs::replaySpeedOption).toDouble(&ok);
+  return ok ? speed : -1.0;
+}
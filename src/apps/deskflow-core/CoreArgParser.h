@@ -33,10 +33,15 @@ public:
   bool version() const;
   bool serverMode() const;
   bool clientMode() const;
+  bool replayMode() const;
   bool singleInstanceOnly() const;
   QString linkDevice() const;
+  QStringList bridgeSpecs() const;
+  QString statusSocket() const;
   int screenWidth() const;
   int screenHeight() const;
+  QString replayFile() const;
+  double replaySpeed() const;
   const char *display() const;
 
 private:
@@ -45,6 +50,8 @@ private:
   QString m_helpText;
   bool m_clientMode = false;
   bool m_serverMode = false;
+  bool m_replayMode = false;
   bool m_singleInstance = true;
+  QString m_replayFile;
   static const QString s_headerText;
 };
@@ -82,17 +82,36 @@ struct CoreArgs
   inline static const auto linkOption =
       QCommandLineOption("link", "Bridge Client Mode: USB CDC device path for the bridge firmware", "device-path");
 
+  inline static const auto bridgeOption = QCommandLineOption(
+      "bridge",
+      "Bridge Client Mode: Host a bridge device in this process, may be given once per device.\n"
+      "spec is name=<screen-name>,link=<device-path>,width=<width>,height=<height>[,invertScroll=true|false][,keepAlive=true|false]",
+      "spec"
+  );
+
+  inline static const auto statusSocketOption = QCommandLineOption(
+      "status-socket", "Bridge Client Mode: Local socket to push bridge status events to", "server-name"
+  );
+
   inline static const auto screenWidthOption =
       QCommandLineOption("screen-width", "Bridge Client Mode: Screen width in pixels", "width");
   inline static const auto screenHeightOption =
       QCommandLineOption("screen-height", "Bridge Client Mode: Screen height in pixels", "height");
+  // Replay Options
+  inline static const auto replaySpeedOption = QCommandLineOption(
+      "replay-speed",
+      "Replay Mode: Playback speed of the HID recording, 0 sends it as fast as the device accepts (default: 1)",
+      "factor"
+  );
+
   inline static const auto displayOption =
       QCommandLineOption("display", "When in X mode, connect to the X server at <display>", "display");
 
-  inline static const auto options = {helpOption,      versionOption,      multiInstanceOption, configOption,
-                                      interfaceOption, portOption,         nameOption,          logLevelOption,
-                                      logFileOption,   secureOption,       tlsCertOption,       preventSleepOption,
-                                      restartOption,   useHooksOption,     peerCheckOption,     serverConfigOption,
-                                      yscrollOption,   languageSyncOption, invertScrollOption,  remoteHostOption,
-                                      linkOption,      screenWidthOption,  screenHeightOption,  displayOption};
+  inline static const auto options = {helpOption,         versionOption,      multiInstanceOption, configOption,
+                                      interfaceOption,    portOption,         nameOption,          logLevelOption,
+                                      logFileOption,      secureOption,       tlsCertOption,       preventSleepOption,
+                                      restartOption,      useHooksOption,     peerCheckOption,     serverConfigOption,
+                                      yscrollOption,      languageSyncOption, invertScrollOption,  remoteHostOption,
+                                      linkOption,         bridgeOption,       statusSocketOption,  screenWidthOption,
+                                      screenHeightOption, replaySpeedOption,  displayOption};
 };
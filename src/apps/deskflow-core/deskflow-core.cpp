@@ -10,15 +10,20 @@
 
 #include "arch/Arch.h"
 #include "base/EventQueue.h"
+#include "base/InputLatency.h"
 #include "base/Log.h"
 #include "client/BridgeClientApp.h"
+#include "client/MultiBridgeClientApp.h"
 #include "common/Constants.h"
 #include "common/ExitCodes.h"
 #include "common/Settings.h"
 #include "deskflow/ClientApp.h"
 #include "deskflow/ServerApp.h"
 #include "platform/OpenSSLCompat.h"
+#include "platform/bridge/BridgeStatusChannel.h"
 #include "platform/bridge/CdcTransport.h"
+#include "platform/bridge/HidRecording.h"
+#include "platform/bridge/HidTxQueue.h"
 
 #ifndef _WIN32
 #include <signal.h>
@@ -31,14 +36,100 @@
 #endif
 
 #include <QFileInfo>
+#include <QSet>
 #include <QSharedMemory>
 #include <QTextStream>
 
+#include <chrono>
+#include <thread>
+
 void showHelp(const CoreArgParser &parser)
 {
   QTextStream(stdout) << parser.helpText();
 }
 
+/**
+ * @brief Play a HID recording back to a bridge device
+ *
+ * Events go through the same transmit queue as live input, so motion coalesces, is shaped and
+ * waits for flow control credits the way it did when it was recorded. Events recorded at the same
+ * instant are flushed together, like one burst of input from the server.
+ */
+int replayHidRecording(const CoreArgParser &parser)
+{
+  using namespace deskflow::bridge;
+
+  const QString file = parser.replayFile();
+  const QString linkDevice = parser.linkDevice();
+  const double speed = parser.replaySpeed();
+  if (file.isEmpty() || linkDevice.isEmpty() || speed < 0.0) {
+    LOG_ERR("replay needs a recording, --link and a non-negative --replay-speed");
+    return s_exitArgs;
+  }
+
+  std::string error;
+  const auto records = loadHidRecording(file.toStdString(), error);
+  if (!records) {
+    LOG_ERR("failed to load HID recording %s: %s", qPrintable(file), error.c_str());
+    return s_exitFailed;
+  }
+
+  auto transport = std::make_shared<CdcTransport>(linkDevice);
+  transport->setSessionTicketCache(SessionTicketCache::shared());
+  if (!transport->open()) {
+    LOG_ERR("failed to open CDC transport %s: %s", qPrintable(linkDevice), transport->lastError().c_str());
+    return s_exitFailed;
+  }
+
+  LOG_INFO("replaying %zu HID events from %s at %.2fx", records->size(), qPrintable(file), speed);
+  HidTxQueue::Stats stats;
+  bool failed = false;
+  const auto start = std::chrono::steady_clock::now();
+  {
+    HidTxQueue queue(transport);
+    const auto origin = records->empty() ? std::chrono::microseconds(0) : records->front().time;
+    for (size_t i = 0; i < records->size() && !failed; ++i) {
+      const auto &record = (*records)[i];
+      if (speed > 0.0) {
+        std::this_thread::sleep_until(
+            start + std::chrono::duration_cast<std::chrono::steady_clock::duration>((record.time - origin) / speed)
+        );
+      }
+
+      const auto &packet = record.packet;
+      if (packet.type == HidEventType::MouseMove && packet.length == 4) {
+        const auto dx = static_cast<int16_t>(packet.data[0] | (packet.data[1] << 8));
+        const auto dy = static_cast<int16_t>(packet.data[2] | (packet.data[3] << 8));
+        failed = !queue.enqueueMouseMove(dx, dy, deskflow::InputLatency::markQueued());
+      } else {
+        failed = !queue.enqueue(packet, deskflow::InputLatency::markQueued());
+      }
+
+      if (i + 1 == records->size() || (*records)[i + 1].time != record.time) {
+        queue.flush();
+      }
+    }
+    failed = failed || queue.hasFailed();
+    stats = queue.stats();
+  }
+  const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+  transport->close();
+  if (failed) {
+    LOG_ERR("replay stopped, the device stopped accepting HID events");
+    return s_exitFailed;
+  }
+
+  LOG_INFO(
+      "replay finished in %.3fs: sent=%llu batches=%llu coalesced=%llu credit stalls=%llu max depth=%zu",
+      elapsed.count(), static_cast<unsigned long long>(stats.eventsSent),
+      static_cast<unsigned long long>(stats.batches), static_cast<unsigned long long>(stats.coalesced),
+      static_cast<unsigned long long>(stats.creditStalls), stats.maxDepth
+  );
+  deskflow::InputLatency::instance().report();
+  return s_exitSuccess;
+}
+
 int main(int argc, char **argv)
 {
 #if defined(Q_OS_UNIX)
@@ -71,6 +162,8 @@ int main(int argc, char **argv)
   bool isClient = false;
   bool isServer = false;
   bool isBridgeClient = false;
+  bool isBridgeHost = false;
+  bool isReplay = false;
 
   QString configOverride;
 
@@ -83,20 +176,37 @@ int main(int argc, char **argv)
       linkDevice = QString::fromUtf8(argv[++i]);
       isBridgeClient = true;
       isClient = true; // Bridge client is a type of client
+    } else if (arg == "--bridge" && (i + 1 < argc)) {
+      ++i;
+      isBridgeHost = true;
+      isBridgeClient = true;
+      isClient = true;
     } else if ((arg == "--settings" || arg == "-s") && (i + 1 < argc)) {
       configOverride = QString::fromUtf8(argv[++i]);
     } else if (arg == "client") {
       isClient = true;
     } else if (arg == "server") {
       isServer = true;
+    } else if (arg == "replay") {
+      isReplay = true;
     }
   }
 
+  // Replay borrows --link for the device but is not a bridge client
+  if (isReplay) {
+    isBridgeClient = false;
+    isClient = false;
+  }
+
   Settings::setBridgeClientMode(isBridgeClient);
 
   // Determine initial settings file before constructing CoreArgParser so CLI overrides take effect.
   QString initialSettingsFile;
-  if (isBridgeClient) {
+  if (isBridgeHost) {
+    // A process hosting several bridges is not one of the per-device bridge clients
+    initialSettingsFile =
+        configOverride.isEmpty() ? QStringLiteral("%1/bridge-host.conf").arg(Settings::settingsPath()) : configOverride;
+  } else if (isBridgeClient) {
     // Bridge clients use: ~/.config/deskflow/bridge-clients/<client-name>.conf
     initialSettingsFile = QStringLiteral("%1/bridge-clients/%2.conf").arg(Settings::settingsPath(), instanceName);
   } else if (!configOverride.isEmpty()) {
@@ -126,7 +236,11 @@ int main(int argc, char **argv)
 
   // Step 2: Build shared memory key based on role
   QString sharedMemKey;
-  if (isClient) {
+  if (isReplay) {
+    sharedMemKey = QString("deskflow-core-replay-%1").arg(instanceName);
+  } else if (isBridgeHost) {
+    sharedMemKey = QString("deskflow-core-bridge-host-%1").arg(instanceName);
+  } else if (isClient) {
     sharedMemKey = QString("deskflow-core-client-%1").arg(instanceName);
   } else if (isServer) {
     sharedMemKey = "deskflow-core-server";
@@ -152,6 +266,15 @@ int main(int argc, char **argv)
   // Step 4: Full argument parsing with CoreArgParser
   parser.parse();
 
+  // Connect before the first handshake so the GUI sees its outcome
+  if (isBridgeClient && !parser.statusSocket().isEmpty()) {
+    deskflow::bridge::BridgeStatusChannel::instance().connectToServer(parser.statusSocket());
+  }
+
+  if (parser.replayMode()) {
+    return replayHidRecording(parser);
+  }
+
   EventQueue events;
   const auto processName = QFileInfo(argv[0]).fileName();
 
@@ -159,13 +282,37 @@ int main(int argc, char **argv)
     ServerApp app(&events, processName);
     return app.run();
   } else if (parser.clientMode()) {
-    // Check if this is a bridge client
-    if (isBridgeClient) {
+    if (isBridgeHost) {
+      std::vector<MultiBridgeClientApp::Spec> specs;
+      QSet<QString> screenNames;
+      QSet<QString> linkDevices;
+      for (const QString &text : parser.bridgeSpecs()) {
+        QString error;
+        const auto spec = MultiBridgeClientApp::Spec::parse(text, error);
+        if (!spec) {
+          LOG_ERR("invalid --bridge '%s': %s", qPrintable(text), qPrintable(error));
+          return s_exitArgs;
+        }
+        if (screenNames.contains(spec->screenName) || linkDevices.contains(spec->linkDevice)) {
+          LOG_ERR("invalid --bridge '%s': screen name and device must be unique", qPrintable(text));
+          return s_exitArgs;
+        }
+        screenNames.insert(spec->screenName);
+        linkDevices.insert(spec->linkDevice);
+        specs.push_back(*spec);
+      }
+
+      MultiBridgeClientApp app(&events, processName, specs);
+      return app.run();
+    } else if (isBridgeClient) {
+      // Single bridge client
       // Step 6: Bridge client initialization
       LOG_INFO("initializing bridge client with link device: %s", linkDevice.toUtf8().constData());
 
       // Create CDC transport
       auto transport = std::make_shared<deskflow::bridge::CdcTransport>(linkDevice);
+      // The GUI has usually just synced this device, so its session can be resumed
+      transport->setSessionTicketCache(deskflow::bridge::SessionTicketCache::shared());
       if (!transport->open()) {
         LOG_ERR("failed to open CDC transport %s: %s", linkDevice.toUtf8().constData(), transport->lastError().c_str());
         return s_exitFailed;
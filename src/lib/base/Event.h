@@ -10,7 +10,10 @@
 #include "EventTypes.h"
 
 #include <assert.h>
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
+#include <type_traits>
 
 using deskflow::EventTypes;
 
@@ -24,6 +27,12 @@ public:
 //! Event
 /*!
  \c Event holds an event type and a pointer to event data. It is movable, but not copyable
+
+Small POD data, such as the motion, button and wheel info sent for every
+input event, can instead be stored inline in the event with \c withData(),
+which saves a malloc() and free() per event.  \c getData() then points
+into the event itself, so it is only valid as long as the event is not
+moved or destroyed, which holds for the duration of a dispatch.
 */
 class Event
 {
@@ -36,6 +45,9 @@ public:
     inline static const Flags DontFreeData = 0x02;       //!< Don't free data in deleteData
   };
 
+  //! Largest data that \c withData() stores inline
+  static constexpr size_t kInlineDataSize = 24;
+
   Event() = default;
   Event(const Event &) = delete;
   Event(Event &&other) = default;
@@ -65,6 +77,22 @@ public:
     // do nothing
   }
 
+  //! Create \c Event with a copy of \p data stored inline
+  /*!
+  \p data must be trivially copyable and fit in \c kInlineDataSize bytes.
+  The event owns no heap memory, so \c deleteData() has nothing to free.
+  */
+  template <typename T>
+  static Event withData(EventTypes type, void *target, const T &data, Flags flags = EventFlags::NoFlags)
+  {
+    static_assert(std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>, "inline event data must be POD");
+    static_assert(sizeof(T) <= kInlineDataSize && alignof(T) <= 8, "inline event data too large");
+    Event event(type, target, nullptr, flags);
+    std::memcpy(event.m_inlineData, &data, sizeof(T));
+    event.m_inlineTag = &s_inlineTag<T>;
+    return event;
+  }
+
   //! @name manipulators
   //@{
 
@@ -84,7 +112,7 @@ public:
 
     default:
       if ((event.getFlags() & EventFlags::DontFreeData) == 0) {
-        free(event.getData());
+        free(event.m_data);
         delete event.getDataObject();
       }
       break;
@@ -126,11 +154,21 @@ public:
 
   //! Get the event data (POD).
   /*!
-  Returns the event data (POD).
+  Returns the event data (POD), whether it was malloc()'d or stored inline.
   */
   void *getData() const
   {
-    return m_data;
+    return m_inlineTag != nullptr ? const_cast<std::byte *>(m_inlineData) : m_data;
+  }
+
+  //! Get inline event data
+  /*!
+  Returns the data stored by \c withData() if it was stored as a \p T,
+  otherwise null.
+  */
+  template <typename T> const T *getInlineData() const
+  {
+    return m_inlineTag == &s_inlineTag<T> ? reinterpret_cast<const T *>(m_inlineData) : nullptr;
   }
 
   //! Get the event data (non-POD)
@@ -156,9 +194,14 @@ public:
   //@}
 
 private:
+  // Only the address matters; it tags which type is in m_inlineData
+  template <typename T> static constexpr char s_inlineTag = 0;
+
   EventTypes m_type = EventTypes::Unknown;
   void *m_target = nullptr;
   void *m_data = nullptr;
   Flags m_flags = EventFlags::NoFlags;
   EventData *m_dataObject = nullptr;
+  const char *m_inlineTag = nullptr;
+  alignas(8) std::byte m_inlineData[kInlineDataSize] = {};
 };
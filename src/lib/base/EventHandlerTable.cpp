@@ -0,0 +1,170 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/EventHandlerTable.h"
+
+#include "base/Event.h"
+#include "base/FinalAction.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+constexpr size_t kMinCapacity = 8;
+} // namespace
+
+//
+// EventHandlerTable
+//
+
+EventHandlerTable::EventHandlerTable() : m_table(build({}))
+{
+  // do nothing
+}
+
+EventHandlerTable::~EventHandlerTable()
+{
+  delete m_table.load();
+  for (const Table *table : m_retired) {
+    delete table;
+  }
+}
+
+void EventHandlerTable::add(EventTypes type, void *target, const EventHandler &handler)
+{
+  auto shared = std::make_shared<const EventHandler>(handler);
+  std::scoped_lock lock{m_writeMutex};
+  auto entries = liveEntries();
+  auto index = std::ranges::find_if(entries, [&](const Entry &e) { return e.target == target && e.type == type; });
+  if (index != entries.end()) {
+    index->handler = std::move(shared);
+  } else {
+    entries.push_back(Entry{target, type, std::move(shared)});
+  }
+  publish(entries);
+}
+
+void EventHandlerTable::remove(EventTypes type, void *target)
+{
+  std::scoped_lock lock{m_writeMutex};
+  auto entries = liveEntries();
+  if (std::erase_if(entries, [&](const Entry &e) { return e.target == target && e.type == type; }) != 0) {
+    publish(entries);
+  }
+}
+
+void EventHandlerTable::removeAll(void *target)
+{
+  std::scoped_lock lock{m_writeMutex};
+  auto entries = liveEntries();
+  if (std::erase_if(entries, [&](const Entry &e) { return e.target == target; }) != 0) {
+    publish(entries);
+  }
+}
+
+bool EventHandlerTable::dispatch(const Event &event) const
+{
+  // The count keeps every table a reader might have loaded alive, see publish()
+  m_readers.fetch_add(1, std::memory_order_seq_cst);
+  const auto leave = deskflow::finally([this] {
+    if (m_readers.fetch_sub(1, std::memory_order_seq_cst) == 1 && m_hasRetired.load(std::memory_order_seq_cst)) {
+      reclaim();
+    }
+  });
+
+  const Table *table = m_table.load(std::memory_order_seq_cst);
+  const EventHandler *handler = table->find(event.getType(), event.getTarget());
+  if (handler == nullptr) {
+    handler = table->find(EventTypes::Unknown, event.getTarget());
+  }
+  if (handler == nullptr) {
+    return false;
+  }
+  (*handler)(event);
+  return true;
+}
+
+size_t EventHandlerTable::size() const
+{
+  std::scoped_lock lock{m_writeMutex};
+  return m_table.load(std::memory_order_relaxed)->size;
+}
+
+const EventHandlerTable::EventHandler *EventHandlerTable::Table::find(EventTypes type, void *target) const
+{
+  const size_t mask = entries.size() - 1;
+  for (size_t index = slotFor(type, target, mask);; index = (index + 1) & mask) {
+    const Entry &entry = entries[index];
+    if (entry.handler == nullptr) {
+      return nullptr;
+    }
+    if (entry.target == target && entry.type == type) {
+      return entry.handler.get();
+    }
+  }
+}
+
+size_t EventHandlerTable::slotFor(EventTypes type, void *target, size_t mask)
+{
+  // Fibonacci hashing; the low bits of a target pointer are mostly alignment
+  const uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(target)) ^
+                       (static_cast<uint64_t>(type) << 48);
+  return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+EventHandlerTable::Table *EventHandlerTable::build(const std::vector<Entry> &entries)
+{
+  auto *table = new Table;
+  table->entries.resize(std::max(kMinCapacity, std::bit_ceil(entries.size() * 2)));
+  table->size = entries.size();
+  const size_t mask = table->entries.size() - 1;
+  for (const Entry &entry : entries) {
+    size_t index = slotFor(entry.type, entry.target, mask);
+    while (table->entries[index].handler != nullptr) {
+      index = (index + 1) & mask;
+    }
+    table->entries[index] = entry;
+  }
+  return table;
+}
+
+std::vector<EventHandlerTable::Entry> EventHandlerTable::liveEntries() const
+{
+  // note -- m_writeMutex must be locked on entry
+  std::vector<Entry> entries;
+  const Table *table = m_table.load(std::memory_order_relaxed);
+  entries.reserve(table->size + 1);
+  std::ranges::copy_if(table->entries, std::back_inserter(entries), [](const Entry &e) { return e.handler != nullptr; });
+  return entries;
+}
+
+void EventHandlerTable::publish(const std::vector<Entry> &entries)
+{
+  // note -- m_writeMutex must be locked on entry
+  m_retired.push_back(m_table.exchange(build(entries), std::memory_order_seq_cst));
+  m_hasRetired.store(true, std::memory_order_seq_cst);
+
+  // A reader that still holds an old table was counted before the exchange, so when the count is
+  // zero now, every later reader sees the new table. Otherwise the last reader out reclaims.
+  if (m_readers.load(std::memory_order_seq_cst) == 0) {
+    for (const Table *table : m_retired) {
+      delete table;
+    }
+    m_retired.clear();
+    m_hasRetired.store(false, std::memory_order_relaxed);
+  }
+}
+
+void EventHandlerTable::reclaim() const
+{
+  std::scoped_lock lock{m_writeMutex};
+  if (m_readers.load(std::memory_order_seq_cst) != 0) {
+    return;
+  }
+  for (const Table *table : m_retired) {
+    delete table;
+  }
+  m_retired.clear();
+  m_hasRetired.store(false, std::memory_order_relaxed);
+}
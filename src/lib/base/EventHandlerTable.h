@@ -0,0 +1,92 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "base/IEventQueue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//! Event handlers keyed by target and event type
+/*!
+Dispatch reads an immutable open-addressing hash table without taking
+a lock.  Adding or removing a handler builds a new table under a
+writer mutex and publishes it with one atomic store (copy-on-write),
+which is cheap because registration is rare next to dispatch.
+
+A replaced table is retired rather than freed, and reclaimed once no
+dispatch is running, so a handler that removes itself, or others, while
+it runs keeps working with the table it was found in.  Handlers are
+shared between tables, so copying one costs a reference count per
+handler, not a copy of each std::function.
+*/
+class EventHandlerTable
+{
+public:
+  using EventHandler = IEventQueue::EventHandler;
+
+  EventHandlerTable();
+  EventHandlerTable(EventHandlerTable const &) = delete;
+  EventHandlerTable(EventHandlerTable &&) = delete;
+  ~EventHandlerTable();
+
+  EventHandlerTable &operator=(EventHandlerTable const &) = delete;
+  EventHandlerTable &operator=(EventHandlerTable &&) = delete;
+
+  //! Set the handler for \p type on \p target, replacing any previous one
+  void add(EventTypes type, void *target, const EventHandler &handler);
+
+  //! Remove the handler for \p type on \p target
+  void remove(EventTypes type, void *target);
+
+  //! Remove every handler on \p target
+  void removeAll(void *target);
+
+  //! Call the handler for the event
+  /*!
+  Falls back to the target's EventTypes::Unknown handler when there is
+  none for the event's type.  Returns false if neither exists.
+  */
+  bool dispatch(const Event &event) const;
+
+  //! Number of handlers
+  size_t size() const;
+
+private:
+  struct Entry
+  {
+    void *target = nullptr;
+    EventTypes type = EventTypes::Unknown;
+    std::shared_ptr<const EventHandler> handler; // empty slot when null
+  };
+
+  struct Table
+  {
+    std::vector<Entry> entries; // power of two, at most half full
+    size_t size = 0;
+
+    const EventHandler *find(EventTypes type, void *target) const;
+  };
+
+  static size_t slotFor(EventTypes type, void *target, size_t mask);
+  static Table *build(const std::vector<Entry> &entries);
+
+  std::vector<Entry> liveEntries() const;
+  void publish(const std::vector<Entry> &entries);
+  void reclaim() const;
+
+  std::atomic<const Table *> m_table;
+
+  // Writers only, under m_writeMutex
+  mutable std::mutex m_writeMutex;
+  mutable std::vector<const Table *> m_retired;
+
+  mutable std::atomic<uint32_t> m_readers = 0;
+  mutable std::atomic_bool m_hasRetired = false;
+};
@@ -9,13 +9,19 @@
 #include "base/EventQueue.h"
 
 #include "arch/Arch.h"
-#include "base/EventQueueTimer.h"
 #include "base/Log.h"
 #include "base/SimpleEventQueueBuffer.h"
 #include "mt/Lock.h"
 #include "mt/Mutex.h"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include "base/MpscEventQueueBuffer.h"
+#endif
 
 // interrupt handler.  this just adds a quit event to the queue.
 static void interrupt(Arch::ThreadSignal, void *data)
@@ -24,6 +30,16 @@ static void interrupt(Arch::ThreadSignal, void *data)
   events->addEvent(Event(EventTypes::Quit));
 }
 
+// buffer used until a screen adopts its own, and again after it lets go
+static std::unique_ptr<IEventQueueBuffer> newDefaultBuffer()
+{
+#if defined(__linux__)
+  return std::make_unique<MpscEventQueueBuffer>();
+#else
+  return std::make_unique<SimpleEventQueueBuffer>();
+#endif
+}
+
 //
 // EventQueue
 //
@@ -32,7 +48,7 @@ EventQueue::EventQueue() : m_readyMutex(new Mutex), m_readyCondVar(new CondVar<b
 {
   ARCH->setSignalHandler(Arch::ThreadSignal::Interrupt, &interrupt, this);
   ARCH->setSignalHandler(Arch::ThreadSignal::Terminate, &interrupt, this);
-  m_buffer = std::make_unique<SimpleEventQueueBuffer>();
+  m_buffer = newDefaultBuffer();
 }
 
 EventQueue::~EventQueue()
@@ -71,7 +87,12 @@ void EventQueue::loop()
 
 void EventQueue::adoptBuffer(IEventQueueBuffer *buffer)
 {
-  std::scoped_lock lock{m_mutex};
+  // no event can be added while the lock is held; wait for any still
+  // being handed to the old buffer
+  std::scoped_lock lock{m_eventsMutex};
+  while (m_adding.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
 
   LOG_DEBUG("adopting new buffer");
 
@@ -83,16 +104,12 @@ void EventQueue::adoptBuffer(IEventQueueBuffer *buffer)
 
   // discard old buffer and old events
   m_buffer.reset();
-  for (auto i = m_events.begin(); i != m_events.end(); ++i) {
-    Event::deleteData(i->second);
-  }
-  m_events.clear();
-  m_oldEventIDs.clear();
+  m_events.clear([](const Event &event) { Event::deleteData(event); });
 
   // use new buffer
   m_buffer.reset(buffer);
   if (buffer == nullptr) {
-    m_buffer = std::make_unique<SimpleEventQueueBuffer>();
+    m_buffer = newDefaultBuffer();
   }
 }
 
@@ -141,7 +158,7 @@ bool EventQueue::processEvent(Event &event, double timeout, Stopwatch &timer)
     return true;
 
   case User: {
-    std::scoped_lock lock{m_mutex};
+    std::scoped_lock lock{m_eventsMutex};
     event = removeEvent(dataID);
     return true;
   }
@@ -160,16 +177,7 @@ bool EventQueue::getEvent(Event &event, double timeout)
 
 bool EventQueue::dispatchEvent(const Event &event)
 {
-  void *target = event.getTarget();
-  if (const auto *type_handler = getHandler(event.getType(), target); type_handler) {
-    (*type_handler)(event);
-    return true;
-  }
-  if (const auto *any_handler = getHandler(EventTypes::Unknown, target); any_handler) {
-    (*any_handler)(event);
-    return true;
-  }
-  return false;
+  return m_handlers.dispatch(event);
 }
 
 void EventQueue::addEvent(Event &&event)
@@ -197,199 +205,136 @@ void EventQueue::addEvent(Event &&event)
 
 void EventQueue::addEventToBuffer(Event &&event)
 {
-  std::scoped_lock lock{m_mutex};
-
   // store the event's data locally
-  auto eventID = saveEvent(std::move(event));
+  std::unique_lock lock{m_eventsMutex};
+  const auto eventID = m_events.insert(std::move(event));
+  if (!eventID) {
+    lock.unlock();
+    LOG_ERR("too many events waiting, discarding event type %d", static_cast<int>(event.getType()));
+    Event::deleteData(event);
+    return;
+  }
+
+  // the buffers take events from any number of threads at once, so only
+  // adoptBuffer() has to know this thread is still using this one
+  IEventQueueBuffer *buffer = m_buffer.get();
+  m_adding.fetch_add(1, std::memory_order_relaxed);
+  lock.unlock();
 
   // add it
-  if (!m_buffer->addEvent(eventID)) {
+  const bool added = buffer->addEvent(*eventID);
+  m_adding.fetch_sub(1, std::memory_order_release);
+  if (!added) {
     // failed to send event
-    auto removedEvent = removeEvent(eventID);
+    lock.lock();
+    auto removedEvent = removeEvent(*eventID);
+    lock.unlock();
     Event::deleteData(removedEvent);
   }
 }
 
 EventQueueTimer *EventQueue::newTimer(double duration, void *target)
 {
-  assert(duration > 0.0);
-
-  auto timer = new EventQueueTimer;
-  if (target == nullptr) {
-    target = timer;
-  }
-  std::scoped_lock lock{m_mutex};
-  m_timers.insert(timer);
-  // initial duration is requested duration plus whatever's on
-  // the clock currently because the latter will be subtracted
-  // the next time we check for timers.
-  m_timerQueue.push(Timer(timer, duration, duration + m_time.getTime(), target, false));
-  return timer;
+  return addTimer(duration, target, false);
 }
 
 EventQueueTimer *EventQueue::newOneShotTimer(double duration, void *target)
 {
-  assert(duration > 0.0);
-
-  auto timer = new EventQueueTimer;
-  if (target == nullptr) {
-    target = timer;
-  }
-  std::scoped_lock lock{m_mutex};
-  m_timers.insert(timer);
-  // initial duration is requested duration plus whatever's on
-  // the clock currently because the latter will be subtracted
-  // the next time we check for timers.
-  m_timerQueue.push(Timer(timer, duration, duration + m_time.getTime(), target, true));
-  return timer;
+  return addTimer(duration, target, true);
 }
 
 void EventQueue::deleteTimer(EventQueueTimer *timer)
 {
   std::scoped_lock lock{m_mutex};
-  for (auto index = m_timerQueue.begin(); index != m_timerQueue.end(); ++index) {
-    if (index->getTimer() == timer) {
-      m_timerQueue.erase(index);
-      break;
-    }
-  }
-  if (Timers::iterator index = m_timers.find(timer); index != m_timers.end()) {
-    m_timers.erase(index);
+  if (auto *queued = dynamic_cast<Timer *>(timer); queued != nullptr) {
+    m_timerWheel.cancel(*queued);
   }
   delete timer;
 }
 
 void EventQueue::addHandler(EventTypes type, void *target, const EventHandler &handler)
 {
-  std::scoped_lock lock{m_mutex};
-  m_handlers[target][type] = handler;
+  m_handlers.add(type, target, handler);
 }
 
 void EventQueue::removeHandler(EventTypes type, void *target)
 {
-  std::scoped_lock lock{m_mutex};
-  HandlerTable::iterator index = m_handlers.find(target);
-  if (index != m_handlers.end()) {
-    TypeHandlerTable &typeHandlers = index->second;
-    if (auto index2 = typeHandlers.find(type); index2 != typeHandlers.end()) {
-      typeHandlers.erase(index2);
-    }
-    if (typeHandlers.empty()) {
-      m_handlers.erase(index);
-    }
-  }
+  m_handlers.remove(type, target);
 }
 
 void EventQueue::removeHandlers(void *target)
 {
-  std::scoped_lock lock{m_mutex};
-  HandlerTable::iterator index = m_handlers.find(target);
-  if (index != m_handlers.end()) {
-    m_handlers.erase(index);
-  }
+  m_handlers.removeAll(target);
 }
 
-const EventQueue::EventHandler *EventQueue::getHandler(EventTypes type, void *target) const
+Event EventQueue::removeEvent(uint32_t eventID)
 {
-  std::scoped_lock lock{m_mutex};
-  if (HandlerTable::const_iterator index = m_handlers.find(target); index != m_handlers.end()) {
-    const TypeHandlerTable &typeHandlers = index->second;
-    TypeHandlerTable::const_iterator index2 = typeHandlers.find(type);
-    if (index2 != typeHandlers.end()) {
-      return &index2->second;
-    }
+  // note -- m_eventsMutex must be locked on entry
+  Event event;
+  if (!m_events.remove(eventID, event)) {
+    // the buffer handed back an event that was already removed or discarded with an old buffer
+    LOG_DEBUG("ignoring stale event id %08x", eventID);
   }
-  return nullptr;
+  return event;
 }
 
-uint32_t EventQueue::saveEvent(Event &&event)
+EventQueueTimer *EventQueue::addTimer(double duration, void *target, bool oneShot)
 {
-  // choose id
-  uint32_t id;
-  if (!m_oldEventIDs.empty()) {
-    // reuse an id
-    id = m_oldEventIDs.back();
-    m_oldEventIDs.pop_back();
-  } else {
-    // make a new id
-    id = static_cast<uint32_t>(m_events.size());
-  }
+  assert(duration > 0.0);
 
-  // save data
-  m_events[id] = std::move(event);
-  return id;
+  // timers tick in whole milliseconds, and at least one
+  const auto period = std::max<uint64_t>(1, std::llround(duration * 1000.0));
+  auto timer = new Timer(period, target, oneShot);
+  std::scoped_lock lock{m_mutex};
+  m_timerWheel.schedule(*timer, getTimerTick() + period);
+  return timer;
 }
 
-Event EventQueue::removeEvent(uint32_t eventID)
+uint64_t EventQueue::getTimerTick()
 {
-  // look up id
-  EventTable::iterator index = m_events.find(eventID);
-  if (index == m_events.end()) {
-    return Event();
-  }
-
-  // get data
-  Event event = std::move(index->second);
-  m_events.erase(index);
-
-  // save old id for reuse
-  m_oldEventIDs.push_back(eventID);
-
-  return event;
+  // note -- m_mutex must be locked on entry
+  return static_cast<uint64_t>(m_time.getTime() * 1000.0);
 }
 
 bool EventQueue::hasTimerExpired(Event &event)
 {
-  // return true if there's a timer in the timer priority queue that
-  // has expired.  if returning true then fill in event appropriately
-  // and reset and reinsert the timer.
-  if (m_timerQueue.empty()) {
+  // return true if a timer has expired.  if returning true then fill
+  // in event appropriately and reschedule the timer.
+  std::scoped_lock lock{m_mutex};
+  if (m_timerWheel.empty()) {
     return false;
   }
 
-  // get time elapsed since last check
-  const double time = m_time.getTime();
-  m_time.reset();
-
-  // countdown elapsed time
-  for (auto index = m_timerQueue.begin(); index != m_timerQueue.end(); ++index) {
-    (*index) -= time;
-  }
-
-  // done if no timers are expired
-  if (m_timerQueue.top() > 0.0) {
+  const uint64_t now = getTimerTick();
+  m_timerWheel.advance(now);
+  auto *timer = static_cast<Timer *>(m_timerWheel.popExpired());
+  if (timer == nullptr) {
     return false;
   }
 
-  // remove timer from queue
-  Timer timer = m_timerQueue.top();
-  m_timerQueue.pop();
-
-  // prepare event and reset the timer's clock
-  timer.fillEvent(m_timerEvent);
-  event = Event(EventTypes::Timer, timer.getTarget(), &m_timerEvent);
-  timer.reset();
+  // prepare event, counting any periods missed while the timer was overdue
+  m_timerEvent.m_timer = timer;
+  m_timerEvent.m_count = static_cast<uint32_t>(1 + (now - timer->deadline()) / timer->getPeriod());
+  event = Event(EventTypes::Timer, timer->getTarget(), &m_timerEvent);
 
-  // reinsert timer into queue if it's not a one-shot
-  if (!timer.isOneShot()) {
-    m_timerQueue.push(timer);
+  // reschedule timer if it's not a one-shot
+  if (!timer->isOneShot()) {
+    m_timerWheel.schedule(*timer, now + timer->getPeriod());
   }
 
   return true;
 }
 
-double EventQueue::getNextTimerTimeout() const
+double EventQueue::getNextTimerTimeout()
 {
-  // return -1 if no timers, 0 if the top timer has expired, otherwise
-  // the time until the top timer in the timer priority queue will
-  // expire.
-  if (m_timerQueue.empty()) {
+  // return -1 if no timers, 0 if a timer has expired, otherwise the
+  // time until the next timer may expire.
+  std::scoped_lock lock{m_mutex};
+  const auto next = m_timerWheel.nextDeadline();
+  if (!next.has_value()) {
     return -1.0;
   }
-  if (m_timerQueue.top() <= 0.0) {
-    return 0.0;
-  }
-  return m_timerQueue.top();
+  return std::max(0.0, static_cast<double>(*next) / 1000.0 - m_time.getTime());
 }
 
 void *EventQueue::getSystemTarget()
@@ -414,40 +359,17 @@ void EventQueue::waitForReady() const
 // EventQueue::Timer
 //
 
-EventQueue::Timer::Timer(EventQueueTimer *timer, double timeout, double initialTime, void *target, bool oneShot)
-    : m_timer(timer),
-      m_timeout(timeout),
-      m_target(target),
-      m_oneShot(oneShot),
-      m_time(initialTime)
-{
-  assert(m_timeout > 0.0);
-}
-
-void EventQueue::Timer::reset()
+EventQueue::Timer::Timer(uint64_t period, void *target, bool oneShot)
+    : m_period(period),
+      m_target(target == nullptr ? static_cast<EventQueueTimer *>(this) : target),
+      m_oneShot(oneShot)
 {
-  m_time = m_timeout;
+  assert(m_period > 0);
 }
 
-EventQueue::Timer &EventQueue::Timer::operator-=(double dt)
+uint64_t EventQueue::Timer::getPeriod() const
 {
-  m_time -= dt;
-  return *this;
-}
-
-EventQueue::Timer::operator double() const
-{
-  return m_time;
-}
-
-bool EventQueue::Timer::isOneShot() const
-{
-  return m_oneShot;
-}
-
-EventQueueTimer *EventQueue::Timer::getTimer() const
-{
-  return m_timer;
+  return m_period;
 }
 
 void *EventQueue::Timer::getTarget() const
@@ -455,11 +377,7 @@ void *EventQueue::Timer::getTarget() const
   return m_target;
 }
 
-void EventQueue::Timer::fillEvent(TimerEvent &event) const
+bool EventQueue::Timer::isOneShot() const
 {
-  event.m_timer = m_timer;
-  event.m_count = 0;
-  if (m_time <= 0.0) {
-    event.m_count = static_cast<uint32_t>((m_timeout - m_time) / m_timeout);
-  }
+  return m_oneShot;
 }
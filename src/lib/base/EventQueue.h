@@ -8,16 +8,18 @@
 
 #pragma once
 
+#include "base/EventHandlerTable.h"
+#include "base/EventSlab.h"
+#include "base/EventQueueTimer.h"
 #include "base/IEventQueue.h"
-#include "base/PriorityQueue.h"
 #include "base/Stopwatch.h"
+#include "base/TimerWheel.h"
 #include "mt/CondVar.h"
 
-#include <map>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <queue>
-#include <set>
 
 //! Event queue
 /*!
@@ -50,11 +52,11 @@ public:
   void waitForReady() const override;
 
 private:
-  const EventHandler *getHandler(EventTypes type, void *target) const;
-  uint32_t saveEvent(Event &&event);
   Event removeEvent(uint32_t eventID);
+  EventQueueTimer *addTimer(double duration, void *target, bool oneShot);
+  uint64_t getTimerTick();
   bool hasTimerExpired(Event &event);
-  double getNextTimerTimeout() const;
+  double getNextTimerTimeout();
   void addEventToBuffer(Event &&event);
 
   //!
@@ -67,56 +69,40 @@ private:
   bool processEvent(Event &event, double timeout, Stopwatch &timer);
 
 private:
-  class Timer
+  class Timer : public EventQueueTimer, public TimerWheel::Entry
   {
   public:
-    Timer(EventQueueTimer *, double timeout, double initialTime, void *target, bool oneShot);
-    ~Timer() = default;
+    Timer(uint64_t period, void *target, bool oneShot);
 
-    void reset();
-
-    Timer &operator-=(double);
-
-    operator double() const;
-
-    bool isOneShot() const;
-    EventQueueTimer *getTimer() const;
+    uint64_t getPeriod() const;
     void *getTarget() const;
-    void fillEvent(TimerEvent &) const;
+    bool isOneShot() const;
 
   private:
-    EventQueueTimer *m_timer;
-    double m_timeout;
+    uint64_t m_period;
     void *m_target;
     bool m_oneShot;
-    double m_time;
   };
 
-  using Timers = std::set<EventQueueTimer *>;
-  using TimerQueue = PriorityQueue<Timer>;
-  using EventTable = std::map<uint32_t, Event>;
-  using EventIDList = std::vector<uint32_t>;
-  using TypeHandlerTable = std::map<EventTypes, EventHandler>;
-  using HandlerTable = std::map<void *, TypeHandlerTable>;
-
   int m_systemTarget = 0;
-  mutable std::mutex m_mutex;
 
-  // buffer of events
+  // buffer of events; threads add to it without a lock, counted in
+  // m_adding so adoptBuffer() can wait for them before replacing it
   std::unique_ptr<IEventQueueBuffer> m_buffer;
+  std::atomic<uint32_t> m_adding = 0;
 
-  // saved events
-  EventTable m_events;
-  EventIDList m_oldEventIDs;
+  // saved events, locked only while an event goes in or out
+  std::mutex m_eventsMutex;
+  EventSlab m_events;
 
-  // timers
+  // timers, scheduled in milliseconds since m_time started
+  mutable std::mutex m_mutex;
   Stopwatch m_time;
-  Timers m_timers;
-  TimerQueue m_timerQueue;
+  TimerWheel m_timerWheel;
   TimerEvent m_timerEvent;
 
-  // event handlers
-  HandlerTable m_handlers;
+  // event handlers, read without m_mutex
+  EventHandlerTable m_handlers;
 
   Mutex *m_readyMutex = nullptr;
   CondVar<bool> *m_readyCondVar = nullptr;
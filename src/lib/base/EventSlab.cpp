@@ -0,0 +1,73 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/EventSlab.h"
+
+#include <algorithm>
+
+//
+// EventSlab
+//
+
+EventSlab::EventSlab(uint32_t maxEvents) : m_maxEvents(std::min(maxEvents, kMaxEvents))
+{
+  // do nothing
+}
+
+std::optional<uint32_t> EventSlab::insert(Event &&event)
+{
+  uint32_t index = m_freeHead;
+  if (index != kNoSlot) {
+    m_freeHead = m_slots[index].nextFree;
+    if (m_freeHead == kNoSlot) {
+      m_freeTail = kNoSlot;
+    }
+  } else if (m_slots.size() < m_maxEvents) {
+    index = static_cast<uint32_t>(m_slots.size());
+    m_slots.emplace_back();
+  } else {
+    return std::nullopt;
+  }
+
+  Slot &slot = m_slots[index];
+  slot.event = std::move(event);
+  slot.used = true;
+  ++m_size;
+  return (slot.generation << kIndexBits) | index;
+}
+
+bool EventSlab::remove(uint32_t eventID, Event &event)
+{
+  const uint32_t index = eventID & kIndexMask;
+  if (index >= m_slots.size()) {
+    return false;
+  }
+
+  Slot &slot = m_slots[index];
+  if (!slot.used || slot.generation != (eventID >> kIndexBits)) {
+    return false;
+  }
+
+  event = std::move(slot.event);
+  release(index);
+  return true;
+}
+
+void EventSlab::release(uint32_t index)
+{
+  Slot &slot = m_slots[index];
+  slot.event = Event();
+  slot.used = false;
+  slot.generation = (slot.generation + 1) & kGenerationMask;
+
+  // Queue the slot behind the others, so it is reused last
+  slot.nextFree = kNoSlot;
+  if (m_freeTail != kNoSlot) {
+    m_slots[m_freeTail].nextFree = index;
+  } else {
+    m_freeHead = index;
+  }
+  m_freeTail = index;
+  --m_size;
+}
@@ -0,0 +1,91 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "base/Event.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! Storage for events waiting in an event queue buffer
+/*!
+Events live in a vector of slots and are named by a 32-bit ID made of
+a 16-bit slot index and a 16-bit generation count.  Saving and removing
+an event is O(1) and, once the vector has grown to the deepest backlog
+seen, never allocates.
+
+Every removal bumps the slot's generation, so an ID that was already
+removed, or that a discarded buffer still held when clear() was called,
+is recognised as stale instead of returning whichever event took its
+slot since.  Freed slots are reused oldest first, so the generations
+advance evenly over all the slots there are, and a stale ID could only
+be mistaken for a live one after its slot has been reused 65536 times.
+*/
+class EventSlab
+{
+public:
+  static constexpr unsigned kIndexBits = 16;
+  static constexpr uint32_t kMaxEvents = 1u << kIndexBits;
+
+  //! At most \p maxEvents (no more than kMaxEvents) can be saved at once
+  explicit EventSlab(uint32_t maxEvents = kMaxEvents);
+
+  //! Save an event
+  /*!
+  Returns the event's ID, or nothing if the slab is full, in which case
+  \p event is left as it was.
+  */
+  std::optional<uint32_t> insert(Event &&event);
+
+  //! Take an event out
+  /*!
+  Returns false if \p eventID is unknown or stale.
+  */
+  bool remove(uint32_t eventID, Event &event);
+
+  //! Drop every saved event, calling \p visit on each first
+  template <typename Visitor> void clear(Visitor &&visit)
+  {
+    for (uint32_t index = 0; index < m_slots.size(); ++index) {
+      if (m_slots[index].used) {
+        visit(m_slots[index].event);
+        release(index);
+      }
+    }
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  bool empty() const
+  {
+    return m_size == 0;
+  }
+
+private:
+  static constexpr uint32_t kIndexMask = kMaxEvents - 1;
+  static constexpr uint32_t kGenerationMask = UINT32_MAX >> kIndexBits;
+  static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+  struct Slot
+  {
+    Event event;
+    uint32_t generation = 0;
+    uint32_t nextFree = kNoSlot;
+    bool used = false;
+  };
+
+  void release(uint32_t index);
+
+  std::vector<Slot> m_slots;
+  uint32_t m_maxEvents;
+  uint32_t m_freeHead = kNoSlot; // next slot to reuse
+  uint32_t m_freeTail = kNoSlot; // last slot freed
+  size_t m_size = 0;
+};
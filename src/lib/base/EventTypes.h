@@ -229,5 +229,8 @@ enum class EventTypes : uint32_t
 
   /// Stop libei
   EISessionClosed,
+
+  /// Bridge status events from other threads are waiting to be written by the event loop thread.
+  BridgeStatusQueued,
 };
 } // namespace deskflow
@@ -0,0 +1,226 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/InputLatency.h"
+
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace deskflow {
+
+namespace {
+struct CurrentInput
+{
+  InputLatency::Clock::time_point received;
+  InputLatency::Clock::time_point dispatched;
+};
+
+thread_local CurrentInput t_current;
+
+double toMicroseconds(std::chrono::nanoseconds value)
+{
+  return std::chrono::duration<double, std::micro>(value).count();
+}
+
+void reportOnSignal(Arch::ThreadSignal, void *)
+{
+  // The histograms are lock-free, so they can be read straight from the signal thread
+  InputLatency::instance().report();
+}
+} // namespace
+
+//
+// LatencyHistogram
+//
+
+size_t LatencyHistogram::bucketFor(uint64_t value)
+{
+  if (value < kSubBuckets) {
+    return static_cast<size_t>(value);
+  }
+  const auto exponent = static_cast<unsigned>(std::bit_width(value) - 1);
+  const auto shift = exponent - kSubBucketBits;
+  const auto subBucket = static_cast<size_t>((value >> shift) & (kSubBuckets - 1));
+  return kSubBuckets + shift * kSubBuckets + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketMidpoint(size_t bucket)
+{
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  const auto shift = static_cast<unsigned>((bucket - kSubBuckets) / kSubBuckets);
+  const auto subBucket = static_cast<uint64_t>((bucket - kSubBuckets) % kSubBuckets);
+  const uint64_t lower = (kSubBuckets + subBucket) << shift;
+  return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+  const auto value = static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(latency.count(), 0));
+  m_buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t max = m_max.load(std::memory_order_relaxed);
+  while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double quantile) const
+{
+  const uint64_t count = m_count.load(std::memory_order_relaxed);
+  const uint64_t max = m_max.load(std::memory_order_relaxed);
+  if (count == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  const auto target =
+      std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * double(count))));
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+    seen += m_buckets[bucket].load(std::memory_order_relaxed);
+    if (seen >= target) {
+      return std::chrono::nanoseconds(std::min(bucketMidpoint(bucket), max));
+    }
+  }
+  // Samples recorded while we were walking the buckets
+  return std::chrono::nanoseconds(max);
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+  Summary summary;
+  summary.count = m_count.load(std::memory_order_relaxed);
+  summary.p50 = percentile(0.50);
+  summary.p99 = percentile(0.99);
+  summary.max = std::chrono::nanoseconds(m_max.load(std::memory_order_relaxed));
+  return summary;
+}
+
+void LatencyHistogram::reset()
+{
+  for (auto &bucket : m_buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  m_count.store(0, std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+}
+
+//
+// InputLatency
+//
+
+InputLatency &InputLatency::instance()
+{
+  static InputLatency s_instance;
+  return s_instance;
+}
+
+void InputLatency::markReceived(Clock::time_point now)
+{
+  t_current.received = now;
+  t_current.dispatched = Clock::time_point();
+}
+
+void InputLatency::markDispatched(Clock::time_point now)
+{
+  if (t_current.received == Clock::time_point()) {
+    return;
+  }
+  t_current.dispatched = now;
+  instance().record(Stage::ReceiveToDispatch, now - t_current.received);
+}
+
+InputLatency::Trace InputLatency::markQueued(Clock::time_point now)
+{
+  // One message can queue several events (e.g. a modifier and its key), only the first is
+  // charged with the dispatch cost
+  if (t_current.dispatched != Clock::time_point()) {
+    instance().record(Stage::DispatchToQueue, now - t_current.dispatched);
+    t_current.dispatched = Clock::time_point();
+  }
+  return Trace{t_current.received, now};
+}
+
+void InputLatency::clearCurrent()
+{
+  t_current = CurrentInput();
+}
+
+void InputLatency::recordWritten(const Trace &trace, Clock::time_point now)
+{
+  if (!trace.isValid()) {
+    return;
+  }
+  record(Stage::QueueToWrite, now - trace.queued);
+  if (trace.received != Clock::time_point()) {
+    record(Stage::Total, now - trace.received);
+  }
+}
+
+void InputLatency::record(Stage stage, std::chrono::nanoseconds latency)
+{
+  m_stages[static_cast<size_t>(stage)].record(latency);
+}
+
+const LatencyHistogram &InputLatency::histogram(Stage stage) const
+{
+  return m_stages[static_cast<size_t>(stage)];
+}
+
+void InputLatency::report() const
+{
+  for (size_t i = 0; i < m_stages.size(); ++i) {
+    const auto stage = static_cast<Stage>(i);
+    const auto summary = m_stages[i].summary();
+    if (summary.count == 0) {
+      continue;
+    }
+    LOG_INFO(
+        "latency: %-17s n=%llu p50=%.1fus p99=%.1fus max=%.1fus", stageName(stage),
+        static_cast<unsigned long long>(summary.count), toMicroseconds(summary.p50), toMicroseconds(summary.p99),
+        toMicroseconds(summary.max)
+    );
+  }
+}
+
+void InputLatency::reportOnUserSignal()
+{
+  ARCH->setSignalHandler(Arch::ThreadSignal::User, &reportOnSignal, nullptr);
+}
+
+void InputLatency::stopReportingOnUserSignal()
+{
+  ARCH->setSignalHandler(Arch::ThreadSignal::User, nullptr, nullptr);
+}
+
+void InputLatency::reset()
+{
+  for (auto &stage : m_stages) {
+    stage.reset();
+  }
+}
+
+const char *InputLatency::stageName(Stage stage)
+{
+  switch (stage) {
+    using enum Stage;
+  case ReceiveToDispatch:
+    return "receive->dispatch";
+  case DispatchToQueue:
+    return "dispatch->queue";
+  case QueueToWrite:
+    return "queue->write";
+  case Total:
+    return "total";
+  default:
+    return "unknown";
+  }
+}
+
+} // namespace deskflow
@@ -0,0 +1,143 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace deskflow {
+
+/**
+ * @brief Lock-free latency histogram with log-linear buckets
+ *
+ * Each power of two is split into eight linear sub-buckets, so any reported percentile is within
+ * 12.5% of the true value. Recording is a couple of relaxed atomic adds and is safe from any
+ * number of threads; a summary taken while others record is approximate but never torn.
+ */
+class LatencyHistogram
+{
+public:
+  struct Summary
+  {
+    uint64_t count = 0;
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds max{0};
+  };
+
+  void record(std::chrono::nanoseconds latency);
+  Summary summary() const;
+  void reset();
+
+  /**
+   * @brief Value at the given quantile (0..1), reported as the midpoint of its bucket
+   */
+  std::chrono::nanoseconds percentile(double quantile) const;
+
+private:
+  static constexpr unsigned kSubBucketBits = 3;
+  static constexpr unsigned kSubBuckets = 1u << kSubBucketBits;
+  static constexpr size_t kBuckets = kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+
+  static size_t bucketFor(uint64_t value);
+  static uint64_t bucketMidpoint(size_t bucket);
+
+  std::array<std::atomic<uint64_t>, kBuckets> m_buckets{};
+  std::atomic<uint64_t> m_count = 0;
+  std::atomic<uint64_t> m_max = 0;
+};
+
+/**
+ * @brief Per-stage latency of input forwarded by the client
+ *
+ * Each input is stamped when its message is read from the server and again when the client hands
+ * it to the screen. The stamps live in thread-local state, so the receive path and the screen
+ * need no shared data: a screen that queues the input picks up a Trace with markQueued() and
+ * passes it along with the event to whichever thread writes it out, which calls recordWritten().
+ */
+class InputLatency
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Stage
+  {
+    ReceiveToDispatch, // message read from the server -> handed to the screen
+    DispatchToQueue,   // handed to the screen -> queued for the output device
+    QueueToWrite,      // queued -> write to the output device completed
+    Total,             // message read from the server -> write completed
+    Count
+  };
+
+  /**
+   * @brief Timestamps carried with a queued event
+   */
+  struct Trace
+  {
+    Clock::time_point received;
+    Clock::time_point queued;
+
+    bool isValid() const
+    {
+      return queued != Clock::time_point();
+    }
+  };
+
+  static InputLatency &instance();
+
+  /**
+   * @brief Start tracing a message read on the calling thread
+   */
+  static void markReceived(Clock::time_point now = Clock::now());
+
+  /**
+   * @brief The traced message is being handed to the screen
+   */
+  static void markDispatched(Clock::time_point now = Clock::now());
+
+  /**
+   * @brief The traced input has been queued for output
+   * @return Trace to hand to recordWritten(); received is empty when no message is being traced
+   */
+  static Trace markQueued(Clock::time_point now = Clock::now());
+
+  /**
+   * @brief Stop tracing on the calling thread, so later output is not charged to the last message
+   */
+  static void clearCurrent();
+
+  void recordWritten(const Trace &trace, Clock::time_point now = Clock::now());
+  void record(Stage stage, std::chrono::nanoseconds latency);
+
+  const LatencyHistogram &histogram(Stage stage) const;
+
+  /**
+   * @brief Log p50/p99/max of every stage that has samples
+   */
+  void report() const;
+
+  /**
+   * @brief Log a report() of the shared instance whenever the process gets SIGUSR2
+   *
+   * SIGUSR1 already wakes the event loop, so the dump uses the user signal instead.
+   */
+  static void reportOnUserSignal();
+
+  /**
+   * @brief Remove the handler installed by reportOnUserSignal()
+   */
+  static void stopReportingOnUserSignal();
+
+  void reset();
+
+  static const char *stageName(Stage stage);
+
+private:
+  std::array<LatencyHistogram, static_cast<size_t>(Stage::Count)> m_stages;
+};
+
+} // namespace deskflow
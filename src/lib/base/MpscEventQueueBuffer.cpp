@@ -0,0 +1,156 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/MpscEventQueueBuffer.h"
+
+#include <bit>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+//
+// MpscEventQueueBuffer
+//
+
+MpscEventQueueBuffer::MpscEventQueueBuffer(size_t capacity)
+    : m_mask(std::bit_ceil(capacity < 2 ? size_t(2) : capacity) - 1),
+      m_slots(std::make_unique<Slot[]>(m_mask + 1))
+{
+  // A slot is free for the producer at position n when its sequence is n and holds an event for
+  // the consumer when it is n + 1
+  for (size_t i = 0; i <= m_mask; ++i) {
+    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_wakeFd < 0) {
+    throw std::runtime_error(std::string("failed to create event queue eventfd: ") + std::strerror(errno));
+  }
+}
+
+MpscEventQueueBuffer::~MpscEventQueueBuffer()
+{
+  close(m_wakeFd);
+}
+
+void MpscEventQueueBuffer::waitForEvent(double timeout)
+{
+  // Producers check the flag after publishing, so either they see it set or the check below sees
+  // their event
+  m_sleeping.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!isEmpty()) {
+    m_sleeping.store(false, std::memory_order_relaxed);
+    return;
+  }
+
+  // Round up so a timer due in under a millisecond does not turn this into a busy loop
+  const int timeoutMs = (timeout < 0.0) ? -1 : static_cast<int>(std::ceil(timeout * 1000.0));
+  pollfd pfd = {m_wakeFd, POLLIN, 0};
+  if (poll(&pfd, 1, timeoutMs) > 0 && (pfd.revents & POLLIN) != 0) {
+    uint64_t count = 0;
+    // Reading resets the counter; a wake that raced with an earlier read only costs a spurious return
+    if (ssize_t read_response = read(m_wakeFd, &count, sizeof(count)); read_response < 0) {
+      // nothing to reset
+    }
+  }
+  m_sleeping.store(false, std::memory_order_relaxed);
+}
+
+IEventQueueBuffer::Type MpscEventQueueBuffer::getEvent(Event &, uint32_t &dataID)
+{
+  if (tryPop(dataID)) {
+    return IEventQueueBuffer::Type::User;
+  }
+
+  // Overflowed events are next once every ring slot claimed before them has been taken; a slot
+  // that is claimed but not yet written holds them back until its producer finishes
+  if (overflowReady()) {
+    std::scoped_lock lock{m_overflowMutex};
+    if (!m_overflow.empty()) {
+      dataID = m_overflow.front();
+      m_overflow.pop_front();
+      if (m_overflow.empty()) {
+        m_overflowing.store(false, std::memory_order_release);
+      }
+      return IEventQueueBuffer::Type::User;
+    }
+  }
+  return IEventQueueBuffer::Type::Unknown;
+}
+
+bool MpscEventQueueBuffer::addEvent(uint32_t dataID)
+{
+  // Once anything overflowed, later events queue behind it until the loop has caught up
+  if (m_overflowing.load(std::memory_order_acquire) || !tryPush(dataID)) {
+    std::scoped_lock lock{m_overflowMutex};
+    m_overflow.push_back(dataID);
+    m_overflowing.store(true, std::memory_order_release);
+  }
+  wake();
+  return true;
+}
+
+bool MpscEventQueueBuffer::isEmpty() const
+{
+  return m_slots[m_head & m_mask].sequence.load(std::memory_order_acquire) != m_head + 1 && !overflowReady();
+}
+
+bool MpscEventQueueBuffer::overflowReady() const
+{
+  // The flag is set after the overflowing producer's earlier ring claims, so they show in m_tail
+  return m_overflowing.load(std::memory_order_acquire) && m_tail.load(std::memory_order_relaxed) == m_head;
+}
+
+bool MpscEventQueueBuffer::tryPush(uint32_t dataID)
+{
+  uint64_t position = m_tail.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot &slot = m_slots[position & m_mask];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto difference = static_cast<int64_t>(sequence - position);
+    if (difference == 0) {
+      if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        slot.dataID = dataID;
+        slot.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (difference < 0) {
+      // The consumer has not freed this slot from the previous lap yet
+      return false;
+    } else {
+      position = m_tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool MpscEventQueueBuffer::tryPop(uint32_t &dataID)
+{
+  Slot &slot = m_slots[m_head & m_mask];
+  if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) {
+    return false;
+  }
+  dataID = slot.dataID;
+  slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+  ++m_head;
+  return true;
+}
+
+void MpscEventQueueBuffer::wake()
+{
+  // Only the first event after the loop went to sleep pays for the system call
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_sleeping.load(std::memory_order_relaxed) && m_sleeping.exchange(false, std::memory_order_relaxed)) {
+    const uint64_t one = 1;
+    if (ssize_t write_response = write(m_wakeFd, &one, sizeof(one)); write_response < 0) {
+      // the counter is already non-zero, so the loop wakes anyway
+    }
+  }
+}
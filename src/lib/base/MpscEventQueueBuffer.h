@@ -0,0 +1,80 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "base/IEventQueueBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+//! Lock-free event queue buffer for Linux
+/*!
+Any number of threads may add events while the event loop takes them
+out.  Event IDs go through a bounded ring of sequence-numbered slots, so
+a producer claims a slot with one compare-and-swap and the consumer
+never locks.  The event loop sleeps on an eventfd which producers only
+write to while it is actually asleep, so a busy loop costs no system
+calls either.
+
+Should the ring fill up, for example while the loop is stuck in a long
+handler, further events go to a locked overflow list until the loop has
+caught up.  Events are never dropped, and events added by one thread
+come out in the order they went in.
+*/
+class MpscEventQueueBuffer : public IEventQueueBuffer
+{
+public:
+  static constexpr size_t kDefaultCapacity = 1 << 16;
+
+  //! \p capacity is rounded up to a power of two
+  explicit MpscEventQueueBuffer(size_t capacity = kDefaultCapacity);
+  MpscEventQueueBuffer(MpscEventQueueBuffer const &) = delete;
+  MpscEventQueueBuffer(MpscEventQueueBuffer &&) = delete;
+  ~MpscEventQueueBuffer() override;
+
+  MpscEventQueueBuffer &operator=(MpscEventQueueBuffer const &) = delete;
+  MpscEventQueueBuffer &operator=(MpscEventQueueBuffer &&) = delete;
+
+  // IEventQueueBuffer overrides
+  void init() override
+  {
+    // do nothing
+  }
+  void waitForEvent(double timeout) override;
+  Type getEvent(Event &event, uint32_t &dataID) override;
+  bool addEvent(uint32_t dataID) override;
+  bool isEmpty() const override;
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence;
+    uint32_t dataID;
+  };
+
+  bool tryPush(uint32_t dataID);
+  bool tryPop(uint32_t &dataID);
+  bool overflowReady() const;
+  void wake();
+
+  const size_t m_mask;
+  std::unique_ptr<Slot[]> m_slots;
+
+  // Producers and the consumer advance on separate cache lines
+  alignas(64) std::atomic<uint64_t> m_tail = 0;
+  alignas(64) uint64_t m_head = 0; // consumer only
+
+  alignas(64) std::atomic_bool m_sleeping = false;
+  int m_wakeFd = -1;
+
+  // Set while m_overflow is not empty; written with m_overflowMutex held
+  std::atomic_bool m_overflowing = false;
+  std::mutex m_overflowMutex;
+  std::deque<uint32_t> m_overflow;
+};
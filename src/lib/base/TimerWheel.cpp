@@ -0,0 +1,209 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/TimerWheel.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+//
+// TimerWheel::Entry
+//
+
+TimerWheel::Entry::~Entry()
+{
+  // the wheel would be left pointing at freed memory
+  assert(!isScheduled());
+}
+
+//
+// TimerWheel
+//
+
+TimerWheel::TimerWheel(uint64_t now) : m_now(now)
+{
+  // do nothing
+}
+
+TimerWheel::~TimerWheel()
+{
+  // let entries that outlive the wheel be destroyed
+  auto release = [](Link &list) {
+    while (list.m_next != &list) {
+      auto *entry = static_cast<Entry *>(list.m_next);
+      unlink(*entry);
+      entry->m_bucket = kUnscheduled;
+    }
+  };
+  for (auto &level : m_wheel) {
+    std::ranges::for_each(level, release);
+  }
+  release(m_expired);
+  release(m_overflow);
+}
+
+void TimerWheel::schedule(Entry &entry, uint64_t deadline)
+{
+  cancel(entry);
+  entry.m_deadline = deadline;
+  place(entry);
+  ++m_size;
+}
+
+void TimerWheel::cancel(Entry &entry)
+{
+  if (!entry.isScheduled()) {
+    return;
+  }
+
+  const uint16_t bucket = entry.m_bucket;
+  unlink(entry);
+  entry.m_bucket = kUnscheduled;
+  --m_size;
+
+  if (bucket < kExpired) {
+    const unsigned level = bucket / kSlots;
+    const unsigned slot = bucket % kSlots;
+    if (const Link &list = m_wheel[level][slot]; list.m_next == &list) {
+      m_occupied[level] &= ~(uint64_t{1} << slot);
+    }
+  }
+}
+
+void TimerWheel::advance(uint64_t now)
+{
+  while (m_now < now) {
+    // jump straight to the next tick with slots to empty, if any comes first
+    const auto next = nextWork();
+    if (!next.has_value() || *next > now) {
+      m_now = now;
+      break;
+    }
+    m_now = std::max(*next, m_now + 1);
+    step();
+  }
+}
+
+TimerWheel::Entry *TimerWheel::popExpired()
+{
+  if (m_expired.m_next == &m_expired) {
+    return nullptr;
+  }
+
+  auto *entry = static_cast<Entry *>(m_expired.m_next);
+  unlink(*entry);
+  entry->m_bucket = kUnscheduled;
+  --m_size;
+  return entry;
+}
+
+std::optional<uint64_t> TimerWheel::nextDeadline() const
+{
+  if (m_expired.m_next != &m_expired) {
+    return m_now;
+  }
+  return nextWork();
+}
+
+void TimerWheel::append(Link &list, Link &link)
+{
+  link.m_prev = list.m_prev;
+  link.m_next = &list;
+  list.m_prev->m_next = &link;
+  list.m_prev = &link;
+}
+
+void TimerWheel::unlink(Link &link)
+{
+  link.m_prev->m_next = link.m_next;
+  link.m_next->m_prev = link.m_prev;
+  link.m_prev = &link;
+  link.m_next = &link;
+}
+
+void TimerWheel::place(Entry &entry)
+{
+  if (entry.m_deadline <= m_now) {
+    append(m_expired, entry);
+    entry.m_bucket = kExpired;
+    return;
+  }
+
+  // The level is the highest group of slot bits in which the deadline
+  // differs from now, so an entry's slot is always ahead of the clock
+  // in its level and it is cascaded down before that level wraps.
+  const unsigned level = (std::bit_width(entry.m_deadline ^ m_now) - 1) / kSlotBits;
+  if (level >= kLevels) {
+    append(m_overflow, entry);
+    entry.m_bucket = kOverflow;
+    return;
+  }
+
+  const auto slot = static_cast<unsigned>(entry.m_deadline >> (level * kSlotBits)) & (kSlots - 1);
+  append(m_wheel[level][slot], entry);
+  m_occupied[level] |= uint64_t{1} << slot;
+  entry.m_bucket = static_cast<uint16_t>(level * kSlots + slot);
+}
+
+void TimerWheel::cascade(unsigned level, unsigned slot)
+{
+  Link &list = m_wheel[level][slot];
+  m_occupied[level] &= ~(uint64_t{1} << slot);
+  while (list.m_next != &list) {
+    auto &entry = static_cast<Entry &>(*list.m_next);
+    unlink(entry);
+    place(entry);
+  }
+}
+
+std::optional<uint64_t> TimerWheel::nextWork() const
+{
+  std::optional<uint64_t> next;
+  for (unsigned level = 0; level < kLevels; ++level) {
+    const unsigned shift = level * kSlotBits;
+    const auto current = static_cast<unsigned>(m_now >> shift) & (kSlots - 1);
+    const uint64_t ahead = current + 1 < kSlots ? m_occupied[level] & (~uint64_t{0} << (current + 1)) : 0;
+    if (ahead == 0) {
+      continue;
+    }
+    const uint64_t base = (m_now >> (shift + kSlotBits)) << (shift + kSlotBits);
+    const uint64_t tick = base | (uint64_t(std::countr_zero(ahead)) << shift);
+    next = std::min(next.value_or(tick), tick);
+  }
+
+  if (m_overflow.m_next != &m_overflow) {
+    const uint64_t tick = ((m_now >> kRangeBits) + 1) << kRangeBits;
+    next = std::min(next.value_or(tick), tick);
+  }
+  return next;
+}
+
+void TimerWheel::step()
+{
+  // On a boundary, coarser slots are emptied first so their entries can
+  // land in the finer slot that is emptied next.
+  if ((m_now & ((uint64_t{1} << kRangeBits) - 1)) == 0) {
+    // entries still out of range go back on the overflow list, so take them all off first
+    Link pending;
+    while (m_overflow.m_next != &m_overflow) {
+      Link &link = *m_overflow.m_next;
+      unlink(link);
+      append(pending, link);
+    }
+    while (pending.m_next != &pending) {
+      auto &entry = static_cast<Entry &>(*pending.m_next);
+      unlink(entry);
+      place(entry);
+    }
+  }
+
+  for (unsigned level = kLevels - 1; level > 0; --level) {
+    const unsigned shift = level * kSlotBits;
+    if ((m_now & ((uint64_t{1} << shift) - 1)) == 0) {
+      cascade(level, static_cast<unsigned>(m_now >> shift) & (kSlots - 1));
+    }
+  }
+  cascade(0, static_cast<unsigned>(m_now) & (kSlots - 1));
+}
@@ -0,0 +1,153 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+//! Hierarchical timing wheel
+/*!
+Schedules timer entries by deadline in whole ticks (EventQueue uses one
+tick per millisecond).  Five levels of 64 slots each cover 2^30 ticks,
+about 12 days at 1ms; level 0 holds entries due in the next 64 ticks,
+each higher level slots 64 times coarser.  A deadline beyond the wheel
+waits on an overflow list and is placed once the wheel gets near it.
+
+Scheduling and cancelling are O(1): entries are intrusive list nodes and
+remember which slot they are in.  Advancing the clock only visits the
+slots it crosses, moving entries from a coarse slot into finer ones
+(cascading) as their time comes, and skips stretches with nothing
+scheduled using per-level occupancy bitmaps.  Nothing ever walks every
+scheduled entry.
+
+Entries that fall due are queued in the order they fell due and taken
+out one at a time with popExpired().
+*/
+class TimerWheel
+{
+public:
+  static constexpr unsigned kSlotBits = 6;
+  static constexpr unsigned kLevels = 5;
+  static constexpr unsigned kSlots = 1u << kSlotBits;
+
+  //! Doubly linked list node, also used as list head
+  class Link
+  {
+  public:
+    Link() = default;
+    Link(Link const &) = delete;
+    Link &operator=(Link const &) = delete;
+
+  private:
+    friend class TimerWheel;
+
+    Link *m_prev = this;
+    Link *m_next = this;
+  };
+
+  //! Something that can be scheduled; derive from it
+  class Entry : public Link
+  {
+  public:
+    Entry() = default;
+    ~Entry();
+    Entry(Entry const &) = delete;
+    Entry &operator=(Entry const &) = delete;
+
+    //! Tick at which the entry falls due, valid while scheduled
+    uint64_t deadline() const
+    {
+      return m_deadline;
+    }
+
+    //! True while scheduled, including once due but not popped
+    bool isScheduled() const
+    {
+      return m_bucket != kUnscheduled;
+    }
+
+  private:
+    friend class TimerWheel;
+
+    uint64_t m_deadline = 0;
+    uint16_t m_bucket = kUnscheduled;
+  };
+
+  //! Start the clock at \p now
+  explicit TimerWheel(uint64_t now = 0);
+  TimerWheel(TimerWheel const &) = delete;
+  TimerWheel(TimerWheel &&) = delete;
+  ~TimerWheel();
+
+  TimerWheel &operator=(TimerWheel const &) = delete;
+  TimerWheel &operator=(TimerWheel &&) = delete;
+
+  //! Schedule \p entry at \p deadline, rescheduling it if it already is
+  /*!
+  A deadline that is not after the current tick is due straight away.
+  */
+  void schedule(Entry &entry, uint64_t deadline);
+
+  //! Unschedule \p entry; does nothing if it isn't scheduled
+  void cancel(Entry &entry);
+
+  //! Move the clock forward to \p now, queueing entries that fall due
+  /*!
+  Going backwards is ignored.
+  */
+  void advance(uint64_t now);
+
+  //! Take out the earliest due entry, or null if none is due
+  Entry *popExpired();
+
+  //! Earliest tick at which advance() may have something to do
+  /*!
+  Exact for entries due within 64 ticks; otherwise the start of the
+  coarse slot holding the earliest entries, which is never later than
+  their deadline.  Returns the current tick if an entry is already due,
+  and nothing if no entry is scheduled.
+  */
+  std::optional<uint64_t> nextDeadline() const;
+
+  //! Current tick
+  uint64_t now() const
+  {
+    return m_now;
+  }
+
+  //! Number of scheduled entries
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  bool empty() const
+  {
+    return m_size == 0;
+  }
+
+private:
+  static constexpr uint16_t kExpired = kLevels * kSlots;
+  static constexpr uint16_t kOverflow = kExpired + 1;
+  static constexpr uint16_t kUnscheduled = UINT16_MAX;
+  static constexpr unsigned kRangeBits = kLevels * kSlotBits;
+
+  static void append(Link &list, Link &link);
+  static void unlink(Link &link);
+
+  void place(Entry &entry);
+  void cascade(unsigned level, unsigned slot);
+  std::optional<uint64_t> nextWork() const;
+  void step();
+
+  uint64_t m_now;
+  size_t m_size = 0;
+  std::array<std::array<Link, kSlots>, kLevels> m_wheel;
+  std::array<uint64_t, kLevels> m_occupied = {};
+  Link m_expired;
+  Link m_overflow;
+};
@@ -7,6 +7,7 @@
 #include "BridgeSocketFactory.h"
 #include "base/Event.h"
 #include "base/EventQueue.h"
+#include "base/InputLatency.h"
 #include "base/Log.h"
 #include "common/ExitCodes.h"
 #include "common/Settings.h"
@@ -14,6 +15,7 @@
 #include "deskflow/Screen.h"
 #include "net/SocketMultiplexer.h"
 #include "platform/bridge/BridgePlatformScreen.h"
+#include "platform/bridge/BridgeStatusChannel.h"
 
 BridgeClientApp::BridgeClientApp(
     IEventQueue *events, const QString &processName, std::shared_ptr<deskflow::bridge::CdcTransport> transport,
@@ -28,9 +30,19 @@ BridgeClientApp::BridgeClientApp(
   LOG_INFO("BridgeClientApp: initialized for screen=%dx%d", m_screenWidth, m_screenHeight);
 }
 
+BridgeClientApp::~BridgeClientApp()
+{
+  deskflow::bridge::BridgeStatusChannel::instance().setEventQueue(nullptr);
+  deskflow::InputLatency::stopReportingOnUserSignal();
+}
+
 void BridgeClientApp::initApp()
 {
   ClientApp::initApp();
+  deskflow::InputLatency::reportOnUserSignal();
+
+  // Handshakes also run on the HID writer thread; their status reaches the GUI through the loop
+  deskflow::bridge::BridgeStatusChannel::instance().setEventQueue(getEvents());
 }
 
 deskflow::Screen *BridgeClientApp::createScreen()
@@ -64,6 +76,9 @@ void BridgeClientApp::handleScreenError() const
 void BridgeClientApp::handleClientConnected()
 {
   ClientApp::handleClientConnected();
+  if (m_transport) {
+    deskflow::bridge::BridgeStatusChannel::instance().connected(m_transport->devicePath());
+  }
   LOG_INFO("BridgeClientApp: Pre-connecting to bridge device...");
   if (m_transport && !m_transport->open()) {
     LOG_WARN("BridgeClientApp: Failed to pre-connect to bridge device (%s)", m_transport->lastError().c_str());
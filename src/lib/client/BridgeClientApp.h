@@ -39,7 +39,7 @@ public:
       const deskflow::bridge::FirmwareConfig &config, int32_t screenWidth, int32_t screenHeight
   );
 
-  ~BridgeClientApp() override = default;
+  ~BridgeClientApp() override;
 
   // Override createScreen to return BridgePlatformScreen
   deskflow::Screen *createScreen() override;
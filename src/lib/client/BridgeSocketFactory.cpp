@@ -12,13 +12,27 @@
 #include "net/TCPListenSocket.h"
 #include "net/TCPSocket.h"
 
-BridgeSocketFactory::BridgeSocketFactory(IEventQueue *events, SocketMultiplexer *socketMultiplexer)
+#include <utility>
+
+BridgeSocketFactory::BridgeSocketFactory(
+    IEventQueue *events, SocketMultiplexer *socketMultiplexer, std::shared_ptr<ssl_ctx_st> tlsContext
+)
     : m_events(events),
-      m_socketMultiplexer(socketMultiplexer)
+      m_socketMultiplexer(socketMultiplexer),
+      m_tlsContext(std::move(tlsContext))
 {
 }
 
-SecurityLevel BridgeSocketFactory::getServerSecurityLevel() const
+std::shared_ptr<ssl_ctx_st> BridgeSocketFactory::createSharedTlsContext()
+{
+  const SecurityLevel level = getServerSecurityLevel();
+  if (level == SecurityLevel::PlainText) {
+    return nullptr;
+  }
+  return SecureSocket::createClientContext(level);
+}
+
+SecurityLevel BridgeSocketFactory::getServerSecurityLevel()
 {
   // CLI `--secure` flag (handled by CoreArgParser) stores desired TLS state in settings
   bool tlsEnabled = Settings::value(Settings::Security::TlsEnabled).toBool();
@@ -39,7 +53,11 @@ IDataSocket *BridgeSocketFactory::create(IArchNetwork::AddressFamily family, Sec
   // Create socket based on security level
   if (actualLevel != SecurityLevel::PlainText) {
     auto *secureSocket = new SecureSocket(m_events, m_socketMultiplexer, family, actualLevel);
-    secureSocket->initSsl(false);
+    if (m_tlsContext != nullptr) {
+      secureSocket->initSsl(m_tlsContext);
+    } else {
+      secureSocket->initSsl(false);
+    }
     return secureSocket;
   } else {
     return new TCPSocket(m_events, m_socketMultiplexer, family);
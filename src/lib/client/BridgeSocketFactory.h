@@ -6,8 +6,11 @@
 
 #include "net/ISocketFactory.h"
 
+#include <memory>
+
 class IEventQueue;
 class SocketMultiplexer;
+struct ssl_ctx_st;
 
 /**
  * @brief Socket factory for bridge clients
@@ -16,13 +19,24 @@ class SocketMultiplexer;
  * - Read TLS preference from CLI `--secure` flag (persisted in Settings)
  * - Always use SecurityLevel::PeerAuth when TLS is enabled
  * - This keeps bridge clients aligned with upstream security expectations
+ *
+ * Given a shared TLS context, secure sockets use it instead of each creating a context and
+ * loading the certificate again.
  */
 class BridgeSocketFactory : public ISocketFactory
 {
 public:
-  BridgeSocketFactory(IEventQueue *events, SocketMultiplexer *socketMultiplexer);
+  BridgeSocketFactory(
+      IEventQueue *events, SocketMultiplexer *socketMultiplexer, std::shared_ptr<ssl_ctx_st> tlsContext = nullptr
+  );
   ~BridgeSocketFactory() override = default;
 
+  /**
+   * @brief Create a client TLS context for several factories to share
+   * @return The context, or null if TLS is disabled or the certificate could not be loaded
+   */
+  static std::shared_ptr<ssl_ctx_st> createSharedTlsContext();
+
   // ISocketFactory overrides
   IDataSocket *create(
       IArchNetwork::AddressFamily family = IArchNetwork::AddressFamily::INet,
@@ -39,8 +53,9 @@ private:
    * @brief Read TLS preference from settings (populated by CLI `--secure`)
    * @return SecurityLevel::PeerAuth if TLS is enabled, SecurityLevel::PlainText otherwise
    */
-  SecurityLevel getServerSecurityLevel() const;
+  static SecurityLevel getServerSecurityLevel();
 
   IEventQueue *m_events;
   SocketMultiplexer *m_socketMultiplexer;
+  std::shared_ptr<ssl_ctx_st> m_tlsContext;
 };
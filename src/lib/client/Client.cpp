@@ -10,6 +10,7 @@
 
 #include "arch/Arch.h"
 #include "base/IEventQueue.h"
+#include "base/InputLatency.h"
 #include "base/Log.h"
 #include "client/ServerProxy.h"
 #include "common/Settings.h"
@@ -230,44 +231,62 @@ void Client::setClipboardDirty(ClipboardID, bool)
 
 void Client::keyDown(KeyID id, KeyModifierMask mask, KeyButton button, const std::string &lang)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->keyDown(id, mask, button, lang);
 }
 
 void Client::keyRepeat(KeyID id, KeyModifierMask mask, int32_t count, KeyButton button, const std::string &lang)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->keyRepeat(id, mask, count, button, lang);
 }
 
 void Client::keyUp(KeyID id, KeyModifierMask mask, KeyButton button)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->keyUp(id, mask, button);
 }
 
 void Client::mouseDown(ButtonID id)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->mouseDown(id);
 }
 
 void Client::mouseUp(ButtonID id)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->mouseUp(id);
 }
 
 void Client::mouseMove(int32_t x, int32_t y)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->mouseMove(x, y);
 }
 
 void Client::mouseRelativeMove(int32_t dx, int32_t dy)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->mouseRelativeMove(dx, dy);
 }
 
 void Client::mouseWheel(int32_t xDelta, int32_t yDelta)
 {
+  deskflow::InputLatency::markDispatched();
   m_screen->mouseWheel(xDelta, yDelta);
 }
 
+void Client::beginInput()
+{
+  m_screen->beginInput();
+}
+
+void Client::flushInput()
+{
+  m_screen->flushInput();
+}
+
 void Client::screensaver(bool activate)
 {
   m_screen->screensaver(activate);
@@ -148,6 +148,8 @@ public:
   void mouseMove(int32_t xAbs, int32_t yAbs) override;
   void mouseRelativeMove(int32_t xRel, int32_t yRel) override;
   void mouseWheel(int32_t xDelta, int32_t yDelta) override;
+  void beginInput() override;
+  void flushInput() override;
   void screensaver(bool activate) override;
   void resetOptions() override;
   void setOptions(const OptionsList &options) override;
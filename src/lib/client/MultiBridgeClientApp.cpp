@@ -0,0 +1,390 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "MultiBridgeClientApp.h"
+
+#include "BridgeSocketFactory.h"
+#include "base/Event.h"
+#include "base/IEventQueue.h"
+#include "base/InputLatency.h"
+#include "base/Log.h"
+#include "client/Client.h"
+#include "common/BridgeStatus.h"
+#include "common/ExitCodes.h"
+#include "common/Settings.h"
+#include "deskflow/Screen.h"
+#include "net/SocketMultiplexer.h"
+#include "platform/bridge/BridgePlatformScreen.h"
+#include "platform/bridge/BridgeStatusChannel.h"
+#include "platform/bridge/SessionTicketCache.h"
+
+#include <QJsonObject>
+
+#include <algorithm>
+
+namespace {
+// Same pace as ClientApp for server reconnects; a device that dropped off USB gets longer to return
+constexpr double kReconnectDelay = 1.0;
+constexpr double kReopenDelay = 3.0;
+
+// How often to look for bridges the GUI wants added or removed
+constexpr double kCommandPollInterval = 0.25;
+
+std::optional<bool> parseFlag(const QString &value)
+{
+  const QString flag = value.toLower();
+  if (flag == QStringLiteral("true") || flag == QStringLiteral("1")) {
+    return true;
+  }
+  if (flag == QStringLiteral("false") || flag == QStringLiteral("0")) {
+    return false;
+  }
+  return std::nullopt;
+}
+} // namespace
+
+std::optional<MultiBridgeClientApp::Spec> MultiBridgeClientApp::Spec::parse(const QString &text, QString &error)
+{
+  Spec spec;
+  for (const QString &field : text.split(',', Qt::SkipEmptyParts)) {
+    const auto separator = field.indexOf('=');
+    if (separator <= 0) {
+      error = QStringLiteral("expected key=value, got '%1'").arg(field);
+      return std::nullopt;
+    }
+
+    const QString key = field.left(separator).trimmed();
+    const QString value = field.mid(separator + 1).trimmed();
+    bool ok = true;
+    if (key == QStringLiteral("name")) {
+      spec.screenName = value;
+    } else if (key == QStringLiteral("link")) {
+      spec.linkDevice = value;
+    } else if (key == QStringLiteral("width")) {
+      spec.screenWidth = value.toInt(&ok);
+    } else if (key == QStringLiteral("height")) {
+      spec.screenHeight = value.toInt(&ok);
+    } else if (key == QStringLiteral("invertScroll")) {
+      spec.invertScroll = parseFlag(value);
+      ok = spec.invertScroll.has_value();
+    } else if (key == QStringLiteral("keepAlive")) {
+      spec.bluetoothKeepAlive = parseFlag(value);
+      ok = spec.bluetoothKeepAlive.has_value();
+    } else {
+      error = QStringLiteral("unknown key '%1'").arg(key);
+      return std::nullopt;
+    }
+
+    if (!ok) {
+      error = QStringLiteral("invalid %1 '%2'").arg(key, value);
+      return std::nullopt;
+    }
+  }
+
+  if (spec.screenName.isEmpty() || spec.linkDevice.isEmpty()) {
+    error = QStringLiteral("name and link are required");
+    return std::nullopt;
+  }
+  if (spec.screenWidth <= 0 || spec.screenHeight <= 0) {
+    error = QStringLiteral("width and height must be positive");
+    return std::nullopt;
+  }
+  return spec;
+}
+
+MultiBridgeClientApp::MultiBridgeClientApp(
+    IEventQueue *events, const QString &processName, const std::vector<Spec> &specs
+)
+    : ClientApp(events, processName + "[BRIDGE]")
+{
+  for (const auto &spec : specs) {
+    m_bridges.push_back(makeBridge(spec));
+  }
+  LOG_INFO("MultiBridgeClientApp: hosting %zu bridge(s)", m_bridges.size());
+}
+
+MultiBridgeClientApp::~MultiBridgeClientApp()
+{
+  for (const auto &bridge : m_bridges) {
+    stopBridge(*bridge);
+  }
+  deskflow::bridge::BridgeStatusChannel::instance().setEventQueue(nullptr);
+  deskflow::InputLatency::stopReportingOnUserSignal();
+}
+
+void MultiBridgeClientApp::initApp()
+{
+  ClientApp::initApp();
+  deskflow::InputLatency::reportOnUserSignal();
+
+  // Handshakes also run on the HID writer thread; their status reaches the GUI through the loop
+  deskflow::bridge::BridgeStatusChannel::instance().setEventQueue(getEvents());
+}
+
+ISocketFactory *MultiBridgeClientApp::getSocketFactory() const
+{
+  // Every bridge's connection shares one TLS context; retried on the next connection if it failed
+  if (m_tlsContext == nullptr) {
+    m_tlsContext = BridgeSocketFactory::createSharedTlsContext();
+  }
+  return new BridgeSocketFactory(getEvents(), getSocketMultiplexer(), m_tlsContext);
+}
+
+int MultiBridgeClientApp::mainLoop()
+{
+  // create socket multiplexer.  this must happen after daemonization
+  // on unix because threads evaporate across a fork().
+  setSocketMultiplexer(std::make_unique<SocketMultiplexer>());
+
+  appUtil().startNode();
+  getEvents()->loop();
+
+  if (m_commandTimer != nullptr) {
+    getEvents()->deleteTimer(m_commandTimer);
+    getEvents()->removeHandler(EventTypes::Timer, m_commandTimer);
+    m_commandTimer = nullptr;
+  }
+
+  LOG_DEBUG("stopping bridges");
+  for (const auto &bridge : m_bridges) {
+    stopBridge(*bridge);
+  }
+  LOG_NOTE("stopped bridges");
+
+  return s_exitSuccess;
+}
+
+void MultiBridgeClientApp::startNode()
+{
+  // A device that is missing at startup should not keep the others from connecting
+  for (const auto &bridge : m_bridges) {
+    if (!startBridge(*bridge)) {
+      scheduleRestart(*bridge, kReopenDelay);
+    }
+  }
+
+  // Started by the GUI: it adds and removes bridges while the process runs
+  if (m_commandTimer == nullptr && deskflow::bridge::BridgeStatusChannel::instance().isConnected()) {
+    m_commandTimer = getEvents()->newTimer(kCommandPollInterval, nullptr);
+    getEvents()->addHandler(EventTypes::Timer, m_commandTimer, [this](const auto &) { handleCommands(); });
+  }
+}
+
+std::unique_ptr<MultiBridgeClientApp::Bridge> MultiBridgeClientApp::makeBridge(const Spec &spec) const
+{
+  auto bridge = std::make_unique<Bridge>();
+  bridge->spec = spec;
+  bridge->spec.invertScroll =
+      spec.invertScroll.value_or(Settings::value(Settings::Client::InvertScrollDirection).toBool());
+  bridge->name = spec.screenName.toUtf8();
+  bridge->transport = std::make_shared<deskflow::bridge::CdcTransport>(spec.linkDevice);
+  bridge->transport->setSessionTicketCache(deskflow::bridge::SessionTicketCache::shared());
+  return bridge;
+}
+
+void MultiBridgeClientApp::addBridge(const Spec &spec)
+{
+  const bool taken = std::ranges::any_of(m_bridges, [&spec](const auto &bridge) {
+    return bridge->spec.screenName == spec.screenName || bridge->spec.linkDevice == spec.linkDevice;
+  });
+  if (taken) {
+    LOG_WARN("bridge '%s': screen name or device already hosted, not adding", qPrintable(spec.screenName));
+    return;
+  }
+
+  Bridge &bridge = *m_bridges.emplace_back(makeBridge(spec));
+  LOG_NOTE("bridge '%s': added on %s", bridge.name.constData(), qPrintable(spec.linkDevice));
+  if (!startBridge(bridge)) {
+    scheduleRestart(bridge, kReopenDelay);
+  }
+}
+
+void MultiBridgeClientApp::removeBridge(const QString &linkDevice)
+{
+  const auto it = std::ranges::find_if(m_bridges, [&linkDevice](const auto &bridge) {
+    return bridge->spec.linkDevice == linkDevice;
+  });
+  if (it == m_bridges.end()) {
+    LOG_DEBUG("no bridge on %s to remove", qPrintable(linkDevice));
+    return;
+  }
+
+  // stopBridge() removes every handler that refers to the bridge, so it can go
+  LOG_NOTE("bridge '%s': removed", (*it)->name.constData());
+  stopBridge(**it);
+  m_bridges.erase(it);
+}
+
+void MultiBridgeClientApp::handleCommands()
+{
+  for (const auto &command : deskflow::bridge::BridgeStatusChannel::instance().readCommands()) {
+    const QString kind = command.value(BridgeStatus::kCommandKey).toString();
+    if (kind == BridgeStatus::kAddBridge) {
+      const QString text = command.value(BridgeStatus::kBridgeKey).toString();
+      QString error;
+      if (const auto spec = Spec::parse(text, error)) {
+        addBridge(*spec);
+      } else {
+        LOG_ERR("invalid bridge '%s' from the GUI: %s", qPrintable(text), qPrintable(error));
+      }
+    } else if (kind == BridgeStatus::kRemoveBridge) {
+      removeBridge(command.value(BridgeStatus::kDeviceKey).toString());
+    } else {
+      LOG_WARN("ignoring unknown command '%s' from the GUI", qPrintable(kind));
+    }
+  }
+}
+
+bool MultiBridgeClientApp::startBridge(Bridge &bridge)
+{
+  if (!bridge.transport->isOpen()) {
+    if (!bridge.transport->open()) {
+      LOG_WARN(
+          "bridge '%s': failed to open %s: %s", bridge.name.constData(), qPrintable(bridge.spec.linkDevice),
+          bridge.transport->lastError().c_str()
+      );
+      return false;
+    }
+    if (!bridge.transport->hasDeviceConfig()) {
+      LOG_WARN("bridge '%s': CDC handshake did not provide metadata", bridge.name.constData());
+      bridge.transport->close();
+      return false;
+    }
+
+    const auto &config = bridge.transport->deviceConfig();
+    LOG_INFO(
+        "bridge '%s': firmware handshake on %s proto=%u activation_state=%s(%u) fw_bcd=%u hw_bcd=%u",
+        bridge.name.constData(), qPrintable(bridge.spec.linkDevice), config.protocolVersion,
+        config.activationStateString(), static_cast<unsigned>(config.activationState),
+        static_cast<unsigned>(config.firmwareVersionBcd), static_cast<unsigned>(config.hardwareVersionBcd)
+    );
+  }
+
+  if (bridge.screen == nullptr) {
+    auto *platformScreen = new deskflow::bridge::BridgePlatformScreen(
+        getEvents(), bridge.transport, bridge.spec.screenWidth, bridge.spec.screenHeight, *bridge.spec.invertScroll,
+        bridge.spec.bluetoothKeepAlive
+    );
+    bridge.screen = new deskflow::Screen(platformScreen, getEvents());
+    getEvents()->addHandler(EventTypes::ScreenError, bridge.screen->getEventTarget(), [this, &bridge](const auto &) {
+      handleBridgeScreenError(bridge);
+    });
+  }
+
+  if (bridge.client == nullptr) {
+    const auto &address = getCurrentServerAddress();
+    bridge.client = new Client(getEvents(), bridge.name.toStdString(), address, getSocketFactory(), bridge.screen);
+
+    using enum EventTypes;
+    void *target = bridge.client->getEventTarget();
+    getEvents()->addHandler(ClientConnected, target, [this, &bridge](const auto &) { handleBridgeConnected(bridge); });
+    getEvents()->addHandler(ClientConnectionFailed, target, [this, &bridge](const auto &e) {
+      handleBridgeFailed(bridge, e);
+    });
+    getEvents()->addHandler(ClientConnectionRefused, target, [this, &bridge](const auto &e) {
+      handleBridgeFailed(bridge, e);
+    });
+    getEvents()->addHandler(ClientDisconnected, target, [this, &bridge](const auto &) {
+      handleBridgeDisconnected(bridge);
+    });
+    LOG_NOTE("bridge '%s': started client", bridge.name.constData());
+  }
+
+  bridge.client->setServerAddress(getCurrentServerAddress());
+  bridge.client->connect();
+  return true;
+}
+
+void MultiBridgeClientApp::stopBridge(Bridge &bridge)
+{
+  if (bridge.restartTimer != nullptr) {
+    getEvents()->deleteTimer(bridge.restartTimer);
+    getEvents()->removeHandler(EventTypes::Timer, bridge.restartTimer);
+    bridge.restartTimer = nullptr;
+  }
+
+  // The client refers to the screen, so it goes first
+  if (bridge.client != nullptr) {
+    using enum EventTypes;
+    void *target = bridge.client->getEventTarget();
+    getEvents()->removeHandler(ClientConnected, target);
+    getEvents()->removeHandler(ClientConnectionFailed, target);
+    getEvents()->removeHandler(ClientConnectionRefused, target);
+    getEvents()->removeHandler(ClientDisconnected, target);
+    delete bridge.client;
+    bridge.client = nullptr;
+  }
+
+  if (bridge.screen != nullptr) {
+    getEvents()->removeHandler(EventTypes::ScreenError, bridge.screen->getEventTarget());
+    delete bridge.screen;
+    bridge.screen = nullptr;
+  }
+
+  bridge.transport->close();
+}
+
+void MultiBridgeClientApp::scheduleRestart(Bridge &bridge, double delay)
+{
+  if (bridge.restartTimer != nullptr) {
+    return;
+  }
+
+  LOG_DEBUG("bridge '%s': retry in %.0f seconds", bridge.name.constData(), delay);
+  EventQueueTimer *timer = getEvents()->newOneShotTimer(delay, nullptr);
+  bridge.restartTimer = timer;
+  getEvents()->addHandler(EventTypes::Timer, timer, [this, &bridge, timer](const auto &) {
+    handleBridgeRestart(bridge, timer);
+  });
+}
+
+void MultiBridgeClientApp::handleBridgeRestart(Bridge &bridge, EventQueueTimer *timer)
+{
+  getEvents()->deleteTimer(timer);
+  getEvents()->removeHandler(EventTypes::Timer, timer);
+  bridge.restartTimer = nullptr;
+
+  if (!startBridge(bridge)) {
+    scheduleRestart(bridge, kReopenDelay);
+  }
+}
+
+void MultiBridgeClientApp::handleBridgeConnected(Bridge &bridge)
+{
+  LOG_IPC("bridge '%s': connected to server", bridge.name.constData());
+  deskflow::bridge::BridgeStatusChannel::instance().connected(bridge.spec.linkDevice);
+  if (!bridge.transport->open()) {
+    LOG_WARN(
+        "bridge '%s': failed to pre-connect to bridge device (%s)", bridge.name.constData(),
+        bridge.transport->lastError().c_str()
+    );
+  }
+}
+
+void MultiBridgeClientApp::handleBridgeFailed(Bridge &bridge, const Event &e)
+{
+  std::unique_ptr<Client::FailInfo> info(static_cast<Client::FailInfo *>(e.getData()));
+  if (e.getType() == EventTypes::ClientConnectionRefused && !info->m_retry) {
+    // The server will not take this screen; the other bridges carry on without it
+    LOG_ERR("bridge '%s': failed to connect to server: %s", bridge.name.constData(), info->m_what.c_str());
+    return;
+  }
+
+  LOG_WARN("bridge '%s': failed to connect to server: %s", bridge.name.constData(), info->m_what.c_str());
+  scheduleRestart(bridge, kReconnectDelay);
+}
+
+void MultiBridgeClientApp::handleBridgeDisconnected(Bridge &bridge)
+{
+  LOG_IPC("bridge '%s': disconnected from server", bridge.name.constData());
+  scheduleRestart(bridge, kReconnectDelay);
+}
+
+void MultiBridgeClientApp::handleBridgeScreenError(Bridge &bridge)
+{
+  // Usually the device was unplugged or reset; rebuild this bridge from a fresh handshake
+  LOG_ERR("bridge '%s': screen error, restarting bridge", bridge.name.constData());
+  stopBridge(bridge);
+  scheduleRestart(bridge, kReopenDelay);
+}
@@ -0,0 +1,99 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "deskflow/ClientApp.h"
+#include "platform/bridge/CdcTransport.h"
+
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class EventQueueTimer;
+struct ssl_ctx_st;
+
+/**
+ * @brief Bridge client application hosting several bridge devices in one process
+ *
+ * Each device gets its own CDC transport, BridgePlatformScreen and Client, and joins the server
+ * as a separately named screen. The bridges share the event loop, the socket multiplexer and the
+ * process itself, so a workstation with several dongles runs one core instead of one per device.
+ *
+ * Unlike BridgeClientApp, a failed device or connection does not exit the process, which would
+ * take every other bridge down with it. The affected bridge is torn down and restarted on its own.
+ *
+ * With TLS enabled, every bridge's server connection shares one client context, created with the
+ * certificate loaded on the first connection that needs it.
+ *
+ * The GUI runs all the bridges it manages in one such process. It starts the process with the first
+ * bridge and adds or removes the rest with commands on the status socket (see BridgeStatus.h).
+ */
+class MultiBridgeClientApp : public ClientApp
+{
+public:
+  /**
+   * @brief One hosted bridge: `name=<screen-name>,link=<device-path>,width=<px>,height=<px>`
+   *
+   * An optional `invertScroll=true|false` (or 1|0) overrides --invertScrollDirection for this bridge,
+   * and `keepAlive=true|false` the bridge/BluetoothKeepAlive setting.
+   */
+  struct Spec
+  {
+    QString screenName;
+    QString linkDevice;
+    int32_t screenWidth = 0;
+    int32_t screenHeight = 0;
+    std::optional<bool> invertScroll;
+    std::optional<bool> bluetoothKeepAlive;
+
+    /**
+     * @brief Parse a bridge spec from the command line
+     * @param error Reason the spec was rejected
+     */
+    static std::optional<Spec> parse(const QString &text, QString &error);
+  };
+
+  MultiBridgeClientApp(IEventQueue *events, const QString &processName, const std::vector<Spec> &specs);
+  ~MultiBridgeClientApp() override;
+
+  int mainLoop() override;
+  void startNode() override;
+
+protected:
+  void initApp() override;
+  ISocketFactory *getSocketFactory() const override;
+
+private:
+  struct Bridge
+  {
+    Spec spec;
+    QByteArray name; // screen name for log messages
+    std::shared_ptr<deskflow::bridge::CdcTransport> transport;
+    deskflow::Screen *screen = nullptr;
+    Client *client = nullptr;
+    EventQueueTimer *restartTimer = nullptr;
+  };
+
+  std::unique_ptr<Bridge> makeBridge(const Spec &spec) const;
+  void addBridge(const Spec &spec);
+  void removeBridge(const QString &linkDevice);
+  void handleCommands();
+
+  bool startBridge(Bridge &bridge);
+  void stopBridge(Bridge &bridge);
+  void scheduleRestart(Bridge &bridge, double delay);
+  void handleBridgeRestart(Bridge &bridge, EventQueueTimer *timer);
+  void handleBridgeConnected(Bridge &bridge);
+  void handleBridgeFailed(Bridge &bridge, const Event &e);
+  void handleBridgeDisconnected(Bridge &bridge);
+  void handleBridgeScreenError(Bridge &bridge);
+
+  std::vector<std::unique_ptr<Bridge>> m_bridges;
+  mutable std::shared_ptr<ssl_ctx_st> m_tlsContext;
+  EventQueueTimer *m_commandTimer = nullptr;
+};
@@ -8,7 +8,9 @@
 
 #include "client/ServerProxy.h"
 
+#include "base/FinalAction.h"
 #include "base/IEventQueue.h"
+#include "base/InputLatency.h"
 #include "base/Log.h"
 #include "client/Client.h"
 #include "deskflow/Clipboard.h"
@@ -77,10 +79,20 @@ void ServerProxy::setKeepAliveRate(double rate)
 
 void ServerProxy::handleData()
 {
+  // input is traced from the moment its message is read until the screen has queued it
+  const auto endTrace = deskflow::finally([] { deskflow::InputLatency::clearCurrent(); });
+
+  // the screen may hold input back until the flush, so make sure it comes on every way out.
+  // a disconnect deletes this proxy, so the flush only relies on the client.
+  m_client->beginInput();
+  const auto endInput = deskflow::finally([client = m_client] { client->flushInput(); });
+
   // handle messages until there are no more.  first read message code.
   uint8_t code[4];
   uint32_t n = m_stream->read(code, 4);
   while (n != 0) {
+    deskflow::InputLatency::markReceived();
+
     // verify we got an entire code
     if (n != 4) {
       LOG_ERR("incomplete message from server: %d bytes", n);
@@ -0,0 +1,43 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <QString>
+
+// Status events a bridge core process pushes to the GUI over its --status-socket.
+// Each event is one compact JSON object per line: {"event": <kind>, "device": <link path>, ...}
+namespace BridgeStatus {
+
+// Event kinds, with the fields each one carries
+const auto kConnected = QStringLiteral("connected");             // (none)
+const auto kDeviceName = QStringLiteral("deviceName");           // name
+const auto kActivation = QStringLiteral("activation");           // state, profile
+const auto kBle = QStringLiteral("ble");                         // connected
+const auto kHandshakeFailed = QStringLiteral("handshakeFailed"); // reason, message
+
+// Fields
+const auto kEventKey = QStringLiteral("event");
+const auto kDeviceKey = QStringLiteral("device");
+const auto kNameKey = QStringLiteral("name");
+const auto kStateKey = QStringLiteral("state");
+const auto kProfileKey = QStringLiteral("profile");
+const auto kConnectedKey = QStringLiteral("connected");
+const auto kReasonKey = QStringLiteral("reason");
+const auto kMessageKey = QStringLiteral("message");
+
+// Values of handshakeFailed.reason
+const auto kReasonAuthentication = QStringLiteral("authentication");
+const auto kReasonTimeout = QStringLiteral("timeout");
+const auto kReasonError = QStringLiteral("error");
+
+// Commands the GUI sends back to a process hosting several bridges, on the same socket:
+// {"command": <kind>, ...}
+const auto kAddBridge = QStringLiteral("addBridge");       // bridge (a --bridge spec)
+const auto kRemoveBridge = QStringLiteral("removeBridge"); // device
+
+const auto kCommandKey = QStringLiteral("command");
+const auto kBridgeKey = QStringLiteral("bridge");
+
+} // namespace BridgeStatus
@@ -247,6 +247,22 @@ QVariant Settings::defaultValue(const QString &key)
     return QStringLiteral("landscape");
   }
 
+  if (key == Bridge::MotionReportInterval) {
+    return 7500; // Shortest BLE connection interval, in microseconds
+  }
+
+  if (key == Bridge::MotionMaxStep) {
+    return 127; // Largest delta of a compact mouse report
+  }
+
+  if (key == Bridge::LatencyReportInterval) {
+    return 0; // Input latency is only logged on SIGUSR2
+  }
+
+  if (key == Bridge::HidRecordDir) {
+    return QString(); // HID events are only recorded when a directory is set
+  }
+
   return QVariant();
 }
 
@@ -112,6 +112,10 @@ public:
     inline static const auto BluetoothKeepAlive = QStringLiteral("bridge/bluetoothKeepAlive");
     inline static const auto AutoConnect = QStringLiteral("bridge/autoConnect");
     inline static const auto ShowLogs = QStringLiteral("bridge/showLogs");
+    inline static const auto MotionReportInterval = QStringLiteral("bridge/motionReportIntervalUs");
+    inline static const auto MotionMaxStep = QStringLiteral("bridge/motionMaxStep");
+    inline static const auto LatencyReportInterval = QStringLiteral("bridge/latencyReportIntervalSec");
+    inline static const auto HidRecordDir = QStringLiteral("bridge/hidRecordDir");
   };
 
   // Enums types used in settings
@@ -246,6 +250,10 @@ private:
     , Settings::Server::ExternalConfigFile
     , Settings::Bridge::ActiveProfileOrientation
     , Settings::Bridge::AutoConnect
+    , Settings::Bridge::MotionReportInterval
+    , Settings::Bridge::MotionMaxStep
+    , Settings::Bridge::LatencyReportInterval
+    , Settings::Bridge::HidRecordDir
   };
 
   // When checking the default values this list contains the ones that default to false.
@@ -80,9 +80,9 @@ public:
 
 protected:
   virtual ISocketFactory *getSocketFactory() const;
+  NetworkAddress &getCurrentServerAddress();
 
 private:
-  NetworkAddress &getCurrentServerAddress();
   void tryNextServer();
 
 private:
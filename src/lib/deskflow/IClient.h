@@ -127,6 +127,27 @@ public:
   */
   virtual void mouseWheel(int32_t xDelta, int32_t yDelta) = 0;
 
+  //! Notify of the start of an input batch
+  /*!
+  Called before a run of input notifications that is guaranteed to end
+  with flushInput(), e.g. the messages read from the server in one go.
+  Clients may hold input back until then.  The default does nothing.
+  */
+  virtual void beginInput()
+  {
+    // do nothing
+  }
+
+  //! Notify of the end of an input batch
+  /*!
+  Ends the run started with beginInput().  Clients that held input back
+  should deliver it now.  The default does nothing.
+  */
+  virtual void flushInput()
+  {
+    // do nothing
+  }
+
   //! Notify of screen saver change
   virtual void screensaver(bool activate) = 0;
 
@@ -46,5 +46,27 @@ public:
   */
   virtual void fakeMouseWheel(int32_t xDelta, int32_t yDelta) const = 0;
 
+  //! Begin a run of fake input
+  /*!
+  Called before a run of fake input calls that is guaranteed to end with
+  fakeInputFlush(), e.g. while pending messages from the server are
+  handled.  Screens may hold synthesized input back until the flush, but
+  must not outside such a run.  The default does nothing.
+  */
+  virtual void fakeInputBatchBegin() const
+  {
+    // do nothing
+  }
+
+  //! Flush fake input
+  /*!
+  Ends the run started with fakeInputBatchBegin().  Screens that buffer
+  synthesized input should deliver it now.  The default does nothing.
+  */
+  virtual void fakeInputFlush() const
+  {
+    // do nothing
+  }
+
   //@}
 };
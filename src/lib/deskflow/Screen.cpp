@@ -228,6 +228,18 @@ void Screen::mouseWheel(int32_t xDelta, int32_t yDelta) const
   m_screen->fakeMouseWheel(xDelta, yDelta);
 }
 
+void Screen::beginInput() const
+{
+  assert(!m_isPrimary);
+  m_screen->fakeInputBatchBegin();
+}
+
+void Screen::flushInput() const
+{
+  assert(!m_isPrimary);
+  m_screen->fakeInputFlush();
+}
+
 void Screen::resetOptions()
 {
   // reset options
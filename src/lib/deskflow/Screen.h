@@ -164,6 +164,20 @@ public:
   */
   void mouseWheel(int32_t xDelta, int32_t yDelta) const;
 
+  //! Begin a batch of synthesized input
+  /*!
+  Lets the platform screen hold input back until flushInput(), which
+  must follow.
+  */
+  void beginInput() const;
+
+  //! Flush synthesized input
+  /*!
+  Deliver any input the platform screen is still holding back.  Called
+  once per batch of input messages.
+  */
+  void flushInput() const;
+
   //! Notify of options changes
   /*!
   Resets all options to their default values.
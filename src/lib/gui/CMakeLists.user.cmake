@@ -7,6 +7,8 @@ set(bridge_sources
     core/BridgeClientProcess.h
     core/BridgeDeviceService.cpp
     core/BridgeDeviceService.h
+    core/BridgeHostProcess.cpp
+    core/BridgeHostProcess.h
     devices/UsbDeviceMonitor.cpp
     devices/UsbDeviceMonitor.h
     dialogs/BridgeClientConfigDialog.cpp
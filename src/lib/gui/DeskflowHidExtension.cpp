@@ -1013,6 +1013,8 @@ void DeskflowHidExtension::bridgeClientConnectToggled(
     int scrollSpeed = config.value(Settings::Client::ScrollSpeed, defaultScrollSpeed).toInt();
     const QVariant defaultInvertScroll = Settings::defaultValue(Settings::Client::InvertScrollDirection);
     bool invertScroll = config.value(Settings::Client::InvertScrollDirection, defaultInvertScroll).toBool();
+    const QVariant defaultKeepAlive = Settings::defaultValue(Settings::Bridge::BluetoothKeepAlive);
+    const bool bluetoothKeepAlive = config.value(Settings::Bridge::BluetoothKeepAlive, defaultKeepAlive).toBool();
 
     if (!devicePath.isEmpty()) {
       deskflow::bridge::CdcTransport transport(devicePath);
@@ -1117,25 +1119,6 @@ void DeskflowHidExtension::bridgeClientConnectToggled(
     // Get TLS/secure setting from server configuration
     bool tlsEnabled = Settings::value(Settings::Security::TlsEnabled).toBool();
 
-    // Build the command
-    QStringList command;
-    command << "deskflow-core";
-    command << "client";
-    command << "--name" << screenName;
-    command << "--link" << devicePath;
-    command << "--remoteHost" << remoteHost;
-    command << "--secure" << (tlsEnabled ? "true" : "false");
-    command << "--log-level" << logLevel;
-    command << "--screen-width" << QString::number(screenWidth);
-    command << "--screen-height" << QString::number(screenHeight);
-    command << "--yscroll" << QString::number(scrollSpeed);
-    command << "--invertScrollDirection" << (invertScroll ? "true" : "false");
-
-    // Print the command
-    QString commandString = command.join(" ");
-    qInfo() << "Bridge client command:";
-    qInfo().noquote() << commandString;
-
     // Show in status and also log it
     if (m_mainWindow) {
       m_mainWindow->setStatus(tr("Starting bridge client: %1").arg(screenName));
@@ -1150,8 +1133,8 @@ void DeskflowHidExtension::bridgeClientConnectToggled(
     bridgeProcConfig.logLevel = logLevel;
     bridgeProcConfig.screenWidth = screenWidth;
     bridgeProcConfig.screenHeight = screenHeight;
-    bridgeProcConfig.scrollSpeed = scrollSpeed;
     bridgeProcConfig.invertScroll = invertScroll;
+    bridgeProcConfig.bluetoothKeepAlive = bluetoothKeepAlive;
 
     auto *process = new BridgeClientProcess(devicePath, this);
 
@@ -1205,7 +1188,7 @@ void DeskflowHidExtension::bridgeClientConnectToggled(
       return;
     }
 
-    qInfo() << "Bridge client process started for device:" << devicePath << "PID:" << process->processId();
+    qInfo() << "Bridge client started for device:" << devicePath << "host PID:" << process->processId();
 
     // Start connection timeout timer (120 seconds)
     QTimer *timer = new QTimer(this);
@@ -6,12 +6,23 @@
 
 #include <QObject>
 #include <QProcess>
-#include <QRegularExpression>
 #include <QString>
-#include <QStringList>
+
+#include <memory>
+
+class QJsonObject;
 
 namespace deskflow::gui {
 
+class BridgeHostProcess;
+
+/**
+ * @brief One bridge device, run in the core process shared by all bridges (see BridgeHostProcess)
+ *
+ * State changes (server connection, device name, activation, BLE, handshake failures) arrive as
+ * typed events on the host's status socket. Output is only forwarded as log lines. finished() is
+ * emitted if the host process exits while the bridge runs in it.
+ */
 class BridgeClientProcess : public QObject
 {
   Q_OBJECT
@@ -26,8 +37,8 @@ public:
     QString logLevel;
     int screenWidth;
     int screenHeight;
-    int scrollSpeed;
     bool invertScroll;
+    bool bluetoothKeepAlive;
   };
 
   explicit BridgeClientProcess(const QString &devicePath, QObject *parent = nullptr);
@@ -42,6 +53,19 @@ public:
     return m_devicePath;
   }
 
+  /**
+   * @brief The --bridge spec the host runs this device with
+   * @return The spec, or empty if a field would not survive the spec's syntax
+   */
+  static QString bridgeSpec(const Config &config);
+
+  /**
+   * @brief Emit the signal for one status event read from the core
+   *
+   * Events for the other devices in the host are ignored.
+   */
+  void handleStatus(const QJsonObject &status);
+
 Q_SIGNALS:
   void connectionEstablished();
   void deviceNameDetected(const QString &name);
@@ -51,26 +75,14 @@ Q_SIGNALS:
   void logAvailable(const QString &line);
   void finished(int exitCode, QProcess::ExitStatus exitStatus);
 
-private Q_SLOTS:
-  void onReadyRead();
-  void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
-
 private:
-  void parseLine(const QString &line);
+  friend class BridgeHostProcess;
+
+  void handleHostOutput(const QString &line);
+  void handleHostFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
   QString m_devicePath;
-  QProcess *m_process = nullptr;
-  bool m_showLogs = false;
-
-  static const QRegularExpression s_connectedRegex;
-  static const QRegularExpression s_deviceNameRegex;
-  static const QRegularExpression s_activationRegex;
-  static const QRegularExpression s_activeProfileRegex;
-  static const QRegularExpression s_bleRegex;
-  static const QRegularExpression s_handshakeFailRegex;
-  static const QRegularExpression s_handshakeTimeoutRegex;
-  static const QRegularExpression s_logPrefixRegex;
-  static const QRegularExpression s_bridgePrefixRegex;
+  std::shared_ptr<BridgeHostProcess> m_host;
 };
 
 } // namespace deskflow::gui
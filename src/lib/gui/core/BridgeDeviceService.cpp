@@ -20,6 +20,7 @@ bool BridgeDeviceService::syncDeviceConfig(
 )
 {
   deskflow::bridge::CdcTransport transport(devicePath);
+  transport.setSessionTicketCache(deskflow::bridge::SessionTicketCache::shared());
 
   // Attempt to open the transport with retries (macOS port readiness can be tricky)
   bool opened = false;
@@ -0,0 +1,267 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "BridgeHostProcess.h"
+#include "BridgeClientProcess.h"
+#include "common/BridgeStatus.h"
+#include "common/Constants.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QUuid>
+
+#include <utility>
+
+namespace deskflow::gui {
+
+const QRegularExpression
+    BridgeHostProcess::s_logPrefixRegex(R"(^\[\d{4}-\d{2}-\d{2}T\d{2}:\d{2}:\d{2}(?:\.\d{3})?\]\s*[A-Z0-9]+:\s*)");
+const QRegularExpression BridgeHostProcess::s_bridgePrefixRegex(R"(^\[Bridge\]\s*)");
+
+std::shared_ptr<BridgeHostProcess> BridgeHostProcess::shared(const Options &options)
+{
+  static std::weak_ptr<BridgeHostProcess> s_current;
+  if (auto host = s_current.lock(); host && host->m_options == options && !host->m_exited) {
+    return host;
+  }
+
+  // The last bridge may let go from inside one of the host's own slots, so delete later
+  std::shared_ptr<BridgeHostProcess> host(new BridgeHostProcess(options), [](BridgeHostProcess *hostProcess) {
+    hostProcess->stop();
+    hostProcess->deleteLater();
+  });
+  s_current = host;
+  return host;
+}
+
+BridgeHostProcess::BridgeHostProcess(const Options &options) : m_options(options)
+{
+}
+
+BridgeHostProcess::~BridgeHostProcess()
+{
+  stop();
+}
+
+bool BridgeHostProcess::attach(BridgeClientProcess *bridge, const QString &spec)
+{
+  if (m_exited) {
+    return false;
+  }
+
+  if (m_process == nullptr) {
+    if (!start(spec)) {
+      return false;
+    }
+  } else {
+    sendCommand({{BridgeStatus::kCommandKey, BridgeStatus::kAddBridge}, {BridgeStatus::kBridgeKey, spec}});
+  }
+
+  m_bridges.append(bridge);
+  return true;
+}
+
+void BridgeHostProcess::detach(BridgeClientProcess *bridge)
+{
+  if (!m_bridges.removeOne(bridge)) {
+    return;
+  }
+
+  if (m_process != nullptr) {
+    sendCommand({{BridgeStatus::kCommandKey, BridgeStatus::kRemoveBridge},
+                 {BridgeStatus::kDeviceKey, bridge->devicePath()}});
+  }
+}
+
+bool BridgeHostProcess::isRunning() const
+{
+  return m_process && m_process->state() == QProcess::Running;
+}
+
+qint64 BridgeHostProcess::processId() const
+{
+  return m_process ? m_process->processId() : 0;
+}
+
+bool BridgeHostProcess::start(const QString &spec)
+{
+  if (!listenForStatus()) {
+    return false;
+  }
+
+  m_process = new QProcess(this);
+  QString appPath = QStringLiteral("%1/%2").arg(QCoreApplication::applicationDirPath(), kCoreBinName);
+
+  // A host being replaced runs on until its bridges are moved, so skip the running instance check
+  QStringList args;
+  args << "client";
+  args << "--new-instance";
+  args << "--bridge" << spec;
+  args << "--remoteHost" << m_options.remoteHost;
+  args << "--secure" << (m_options.tlsEnabled ? "true" : "false");
+  args << "--log-level" << m_options.logLevel;
+  args << "--status-socket" << m_statusServer->fullServerName();
+
+  connect(m_process, &QProcess::readyReadStandardOutput, this, &BridgeHostProcess::onReadyRead);
+  connect(m_process, &QProcess::readyReadStandardError, this, &BridgeHostProcess::onReadyRead);
+  connect(
+      m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &BridgeHostProcess::onFinished
+  );
+
+  qInfo() << "Starting bridge host process with args:" << args.join(" ");
+  m_process->start(appPath, args);
+
+  if (!m_process->waitForStarted(3000)) {
+    qWarning() << "Failed to start bridge host process";
+    m_process->deleteLater();
+    m_process = nullptr;
+    closeStatusChannel();
+    return false;
+  }
+
+  return true;
+}
+
+void BridgeHostProcess::stop()
+{
+  if (m_process) {
+    m_process->disconnect(this);
+    m_process->terminate();
+    if (!m_process->waitForFinished(1000)) {
+      m_process->kill();
+      m_process->waitForFinished(500);
+    }
+    m_process->deleteLater();
+    m_process = nullptr;
+  }
+  closeStatusChannel();
+  m_pendingCommands.clear();
+}
+
+void BridgeHostProcess::onReadyRead()
+{
+  if (!m_process)
+    return;
+
+  QByteArray data = m_process->readAllStandardOutput();
+  data += m_process->readAllStandardError();
+
+  if (data.isEmpty() || m_bridges.isEmpty())
+    return;
+
+  // Output is shown once, through whichever bridge attached first
+  QString output = QString::fromLocal8Bit(data);
+  QStringList lines = output.split('\n', Qt::SkipEmptyParts);
+  for (const QString &line : lines) {
+    QString logLine = line.trimmed();
+    logLine.remove(s_logPrefixRegex);
+    logLine.remove(s_bridgePrefixRegex);
+    if (auto *bridge = m_bridges.first().data()) {
+      bridge->handleHostOutput(logLine);
+    }
+  }
+}
+
+void BridgeHostProcess::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+  m_process->deleteLater();
+  m_process = nullptr;
+  m_exited = true;
+  // Deliver whatever the process managed to report before it exited
+  onStatusReadyRead();
+  closeStatusChannel();
+  m_pendingCommands.clear();
+
+  // Each bridge may start again from its slot, on a new host
+  for (const auto &bridge : std::exchange(m_bridges, {})) {
+    if (bridge) {
+      bridge->handleHostFinished(exitCode, exitStatus);
+    }
+  }
+}
+
+void BridgeHostProcess::sendCommand(const QJsonObject &command)
+{
+  QByteArray line = QJsonDocument(command).toJson(QJsonDocument::Compact);
+  line.append('\n');
+  if (m_statusSocket == nullptr) {
+    m_pendingCommands.append(line);
+    return;
+  }
+  m_statusSocket->write(line);
+}
+
+bool BridgeHostProcess::listenForStatus()
+{
+  m_statusServer = new QLocalServer(this);
+  m_statusServer->setSocketOptions(QLocalServer::UserAccessOption);
+  const auto name = QStringLiteral("%1-bridge-status-%2").arg(kAppId, QUuid::createUuid().toString(QUuid::Id128));
+  if (!m_statusServer->listen(name)) {
+    qWarning() << "Failed to listen for bridge status on" << name << m_statusServer->errorString();
+    closeStatusChannel();
+    return false;
+  }
+
+  connect(m_statusServer, &QLocalServer::newConnection, this, &BridgeHostProcess::onStatusConnection);
+  return true;
+}
+
+void BridgeHostProcess::closeStatusChannel()
+{
+  if (m_statusSocket) {
+    m_statusSocket->disconnect(this);
+    m_statusSocket->deleteLater();
+    m_statusSocket = nullptr;
+  }
+  if (m_statusServer) {
+    m_statusServer->close();
+    m_statusServer->deleteLater();
+    m_statusServer = nullptr;
+  }
+}
+
+void BridgeHostProcess::onStatusConnection()
+{
+  while (QLocalSocket *socket = m_statusServer->nextPendingConnection()) {
+    if (m_statusSocket) {
+      // Only the process we started reports here
+      socket->deleteLater();
+      continue;
+    }
+    m_statusSocket = socket;
+    connect(m_statusSocket, &QLocalSocket::readyRead, this, &BridgeHostProcess::onStatusReadyRead);
+
+    // Bridges attached while the process was starting up
+    for (const auto &line : std::exchange(m_pendingCommands, {})) {
+      m_statusSocket->write(line);
+    }
+  }
+}
+
+void BridgeHostProcess::onStatusReadyRead()
+{
+  // The last bridge stopping from one of its slots closes the channel
+  while (m_statusSocket && m_statusSocket->canReadLine()) {
+    const QByteArray line = m_statusSocket->readLine();
+    QJsonParseError error;
+    const auto document = QJsonDocument::fromJson(line, &error);
+    if (!document.isObject()) {
+      qWarning() << "Ignoring malformed bridge status" << error.errorString();
+      continue;
+    }
+
+    // A bridge may stop itself from one of its slots
+    const auto status = document.object();
+    for (const auto &bridge : QList(m_bridges)) {
+      if (bridge) {
+        bridge->handleStatus(status);
+      }
+    }
+  }
+}
+
+} // namespace deskflow::gui
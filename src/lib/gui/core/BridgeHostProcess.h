@@ -0,0 +1,91 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QString>
+
+#include <memory>
+
+class QJsonObject;
+class QLocalServer;
+class QLocalSocket;
+
+namespace deskflow::gui {
+
+class BridgeClientProcess;
+
+/**
+ * @brief The core process that runs every bridge the GUI manages
+ *
+ * The process is started with the first bridge's --bridge spec. Later bridges are added and removed
+ * with commands on the status socket, so plugging in one device does not disturb the others. Status
+ * events go to every attached BridgeClientProcess, which picks out its own device.
+ *
+ * Bridges get the host from shared(), which returns the running one while the server address, TLS
+ * setting and log level still match. Otherwise a new host starts, and the old one is stopped once its
+ * last bridge lets go of it.
+ */
+class BridgeHostProcess : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Options
+  {
+    QString remoteHost;
+    bool tlsEnabled = false;
+    QString logLevel;
+
+    bool operator==(const Options &) const = default;
+  };
+
+  static std::shared_ptr<BridgeHostProcess> shared(const Options &options);
+
+  ~BridgeHostProcess() override;
+
+  /**
+   * @brief Run a bridge in this host, starting the process for the first one
+   * @param spec The bridge's --bridge spec
+   * @return false if the process could not be started or has already exited
+   */
+  bool attach(BridgeClientProcess *bridge, const QString &spec);
+  void detach(BridgeClientProcess *bridge);
+
+  bool isRunning() const;
+  qint64 processId() const;
+
+private Q_SLOTS:
+  void onReadyRead();
+  void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+  void onStatusConnection();
+  void onStatusReadyRead();
+
+private:
+  explicit BridgeHostProcess(const Options &options);
+
+  bool start(const QString &spec);
+  void stop();
+  void sendCommand(const QJsonObject &command);
+  bool listenForStatus();
+  void closeStatusChannel();
+
+  Options m_options;
+  QProcess *m_process = nullptr;
+  QLocalServer *m_statusServer = nullptr;
+  QLocalSocket *m_statusSocket = nullptr;
+  QList<QByteArray> m_pendingCommands; // sent once the process connects to the status socket
+  QList<QPointer<BridgeClientProcess>> m_bridges;
+  bool m_exited = false;
+
+  static const QRegularExpression s_logPrefixRegex;
+  static const QRegularExpression s_bridgePrefixRegex;
+};
+
+} // namespace deskflow::gui
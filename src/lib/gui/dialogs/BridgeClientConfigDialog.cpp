@@ -285,6 +285,27 @@ void BridgeClientConfigDialog::setupProfileUI(QVBoxLayout *mainLayout)
     addComplexRow(tr("HID Mode:"), l, 36);
   }
 
+  // Pointer Mode
+  m_profilePointerModeGroup = new QButtonGroup(this);
+  m_radioProfileRelative = new QRadioButton(tr("Relative"), this);
+  m_radioProfileRelative->setMinimumWidth(180); // Fix alignment for 2nd column
+  m_radioProfileRelative->setToolTip(tr("Move the pointer like a mouse, subject to the phone's acceleration"));
+
+  m_radioProfileAbsolute = new QRadioButton(tr("Absolute"), this);
+  m_radioProfileAbsolute->setToolTip(tr("Place the pointer directly; needs firmware with digitizer support"));
+
+  m_profilePointerModeGroup->addButton(m_radioProfileRelative, deskflow::bridge::kPointerModeRelative);
+  m_profilePointerModeGroup->addButton(m_radioProfileAbsolute, deskflow::bridge::kPointerModeAbsolute);
+
+  {
+    auto *l = createHBox();
+    l->addWidget(m_radioProfileRelative);
+    l->addSpacing(10);
+    l->addWidget(m_radioProfileAbsolute);
+    l->addStretch();
+    addComplexRow(tr("Pointer:"), l, 36);
+  }
+
   // Scroll Settings
   auto *scrollLayout = createHBox();
 
@@ -408,6 +429,18 @@ void BridgeClientConfigDialog::loadProfilesFromDevice()
   if (m_deviceActiveProfileIndex < 0)
     m_deviceActiveProfileIndex = 0; // Default fallback
 
+  // Fetch profiles, all requests pipelined in one exchange; a failed read must not leave blank
+  // profiles the user could save back over the real ones
+  std::vector<std::optional<deskflow::bridge::DeviceProfile>> profiles;
+  if (!transport.getProfiles(0, static_cast<uint8_t>(m_totalProfiles), profiles)) {
+    m_lblProfileGroupTitle->setText(tr("Profiles (Failed to Read Device)"));
+    m_profileGroup->setEnabled(false);
+    QMessageBox::critical(
+        this, tr("Error"), tr("Failed to read profiles: %1").arg(QString::fromStdString(transport.lastError()))
+    );
+    return;
+  }
+
   // Populate Tabs
   while (m_profileTabBar->count() > 0)
     m_profileTabBar->removeTab(0);
@@ -416,15 +449,14 @@ void BridgeClientConfigDialog::loadProfilesFromDevice()
     m_profileTabBar->addTab(QString("Slot %1").arg(i));
   }
 
-  // Fetch profiles
   for (int i = 0; i < m_totalProfiles; ++i) {
     deskflow::bridge::DeviceProfile profile;
-    if (transport.getProfile(i, profile)) {
-      m_profileCache[i] = profile;
+    if (profiles[i].has_value()) {
+      profile = *profiles[i];
     } else {
       std::memset(&profile, 0, sizeof(profile));
-      m_profileCache[i] = profile;
     }
+    m_profileCache[i] = profile;
   }
 
   updateTabLabels();
@@ -470,6 +502,8 @@ void BridgeClientConfigDialog::saveUiToCache(int index)
   p.screenHeight = static_cast<uint16_t>(m_spinProfileHeight->value());
   p.rotation = m_radioProfilePortrait->isChecked() ? 0 : 1;
   p.hidMode = m_radioProfileMouseOnly->isChecked() ? 1 : 0;
+  p.pointerMode = m_radioProfileAbsolute->isChecked() ? deskflow::bridge::kPointerModeAbsolute
+                                                      : deskflow::bridge::kPointerModeRelative;
   p.slot = index;
   p.invert = m_checkInvertScroll->isChecked() ? 1 : 0;
   p.speed = static_cast<uint8_t>(m_spinScrollSpeed->value());
@@ -528,6 +562,11 @@ void BridgeClientConfigDialog::updateProfileDetailUI(int index)
   else
     m_radioProfileCombo->setChecked(true);
 
+  if (p.pointerMode == deskflow::bridge::kPointerModeAbsolute)
+    m_radioProfileAbsolute->setChecked(true);
+  else
+    m_radioProfileRelative->setChecked(true);
+
   m_spinScrollSpeed->setValue(p.speed);
   m_checkInvertScroll->setChecked(p.invert != 0);
 
@@ -88,6 +88,9 @@ private:
   QButtonGroup *m_profileHidModeGroup = nullptr;
   QRadioButton *m_radioProfileCombo = nullptr;
   QRadioButton *m_radioProfileMouseOnly = nullptr;
+  QButtonGroup *m_profilePointerModeGroup = nullptr;
+  QRadioButton *m_radioProfileRelative = nullptr;
+  QRadioButton *m_radioProfileAbsolute = nullptr;
 
   QPushButton *m_btnProfileSave = nullptr;
   QPushButton *m_btnProfileActivate = nullptr;
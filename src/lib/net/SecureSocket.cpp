@@ -49,6 +49,83 @@ static int verifyIgnoreCertCallback(X509_STORE_CTX *, void *)
   return 1;
 }
 
+static SSL_CTX *newContext(bool server, SecurityLevel securityLevel)
+{
+  SSL_library_init();
+
+  const SSL_METHOD *method;
+
+  // load & register all cryptos, etc.
+  OpenSSL_add_all_algorithms();
+
+  // load all error messages
+  SSL_load_error_strings();
+  SslLogger::logSecureLibInfo();
+
+  if (server) {
+    method = SSLv23_server_method();
+  } else {
+    method = SSLv23_client_method();
+  }
+
+  // create new context from method
+  const auto *m = const_cast<SSL_METHOD *>(method);
+  SSL_CTX *context = SSL_CTX_new(m);
+
+  // Prevent the usage of of all version prior to TLSv1.2 as they are known to
+  // be vulnerable
+  SSL_CTX_set_options(
+      context, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_NO_TLSv1 | SSL_OP_NO_TLSv1_1 | SSL_OP_IGNORE_UNEXPECTED_EOF
+  );
+
+  if (context == nullptr) {
+    SslLogger::logError();
+  }
+
+  if (securityLevel == SecurityLevel::PeerAuth) {
+    // We want to ask for peer certificate, but not verify it. If we don't ask for peer
+    // certificate, e.g. client won't send it.
+    SSL_CTX_set_verify(context, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nullptr);
+    SSL_CTX_set_cert_verify_callback(context, verifyIgnoreCertCallback, nullptr);
+  }
+
+  return context;
+}
+
+static bool useCertificate(SSL_CTX *context, const QString &filename)
+{
+  if (filename.isEmpty()) {
+    SslLogger::logError("tls certificate is not specified");
+    return false;
+  }
+
+  if (!QFile::exists(filename)) {
+    std::string errorMsg("tls certificate doesn't exist: ");
+    errorMsg.append(filename.toStdString());
+    SslLogger::logError(errorMsg.c_str());
+    return false;
+  }
+
+  const auto fName = filename.toStdString();
+
+  if (SSL_CTX_use_certificate_file(context, fName.c_str(), SSL_FILETYPE_PEM) <= 0) {
+    SslLogger::logError("could not use tls certificate");
+    return false;
+  }
+
+  if (SSL_CTX_use_PrivateKey_file(context, fName.c_str(), SSL_FILETYPE_PEM) <= 0) {
+    SslLogger::logError("could not use tls private key");
+    return false;
+  }
+
+  if (!SSL_CTX_check_private_key(context)) {
+    SslLogger::logError("could not verify tls private key");
+    return false;
+  }
+
+  return true;
+}
+
 SecureSocket::SecureSocket(
     IEventQueue *events, SocketMultiplexer *socketMultiplexer, IArchNetwork::AddressFamily family,
     SecurityLevel securityLevel
@@ -295,78 +372,39 @@ bool SecureSocket::loadCertificate(const QString &filename)
 {
   std::scoped_lock ssl_lock{ssl_mutex_};
 
-  if (filename.isEmpty()) {
-    SslLogger::logError("tls certificate is not specified");
-    return false;
-  }
+  return useCertificate(m_ssl->m_context, filename);
+}
 
-  if (!QFile::exists(filename)) {
-    std::string errorMsg("tls certificate doesn't exist: ");
-    errorMsg.append(filename.toStdString());
-    SslLogger::logError(errorMsg.c_str());
-    return false;
-  }
+void SecureSocket::initSsl(const std::shared_ptr<ssl_ctx_st> &context)
+{
+  std::scoped_lock ssl_lock{ssl_mutex_};
 
-  const auto fName = filename.toStdString();
+  m_ssl = std::make_unique<Ssl>();
 
-  if (SSL_CTX_use_certificate_file(m_ssl->m_context, fName.c_str(), SSL_FILETYPE_PEM) <= 0) {
-    SslLogger::logError("could not use tls certificate");
-    return false;
-  }
+  // freeSSL() drops this reference like it frees a context of our own
+  SSL_CTX_up_ref(context.get());
+  m_ssl->m_context = context.get();
+  m_sharedContext = true;
+}
 
-  if (SSL_CTX_use_PrivateKey_file(m_ssl->m_context, fName.c_str(), SSL_FILETYPE_PEM) <= 0) {
-    SslLogger::logError("could not use tls private key");
-    return false;
+std::shared_ptr<ssl_ctx_st> SecureSocket::createClientContext(SecurityLevel securityLevel)
+{
+  SSL_CTX *context = newContext(false, securityLevel);
+  if (context == nullptr) {
+    return nullptr;
   }
 
-  if (!SSL_CTX_check_private_key(m_ssl->m_context)) {
-    SslLogger::logError("could not verify tls private key");
-    return false;
+  if (!useCertificate(context, Settings::value(Settings::Security::Certificate).toString())) {
+    SSL_CTX_free(context);
+    return nullptr;
   }
 
-  return true;
+  return std::shared_ptr<ssl_ctx_st>(context, SSL_CTX_free);
 }
 
 void SecureSocket::initContext(bool server)
 {
-  SSL_library_init();
-
-  const SSL_METHOD *method;
-
-  // load & register all cryptos, etc.
-  OpenSSL_add_all_algorithms();
-
-  // load all error messages
-  SSL_load_error_strings();
-  SslLogger::logSecureLibInfo();
-
-  if (server) {
-    method = SSLv23_server_method();
-  } else {
-    method = SSLv23_client_method();
-  }
-
-  // create new context from method
-  const auto *m = const_cast<SSL_METHOD *>(method);
-  m_ssl->m_context = SSL_CTX_new(m);
-
-  // Prevent the usage of of all version prior to TLSv1.2 as they are known to
-  // be vulnerable
-  SSL_CTX_set_options(
-      m_ssl->m_context,
-      SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_NO_TLSv1 | SSL_OP_NO_TLSv1_1 | SSL_OP_IGNORE_UNEXPECTED_EOF
-  );
-
-  if (m_ssl->m_context == nullptr) {
-    SslLogger::logError();
-  }
-
-  if (m_securityLevel == SecurityLevel::PeerAuth) {
-    // We want to ask for peer certificate, but not verify it. If we don't ask for peer
-    // certificate, e.g. client won't send it.
-    SSL_CTX_set_verify(m_ssl->m_context, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nullptr);
-    SSL_CTX_set_cert_verify_callback(m_ssl->m_context, verifyIgnoreCertCallback, nullptr);
-  }
+  m_ssl->m_context = newContext(server, m_securityLevel);
 }
 
 void SecureSocket::createSSL()
@@ -459,7 +497,8 @@ int SecureSocket::secureAccept(int socket)
 
 int SecureSocket::secureConnect(int socket)
 {
-  if (!loadCertificate(Settings::value(Settings::Security::Certificate).toString())) {
+  // A shared context was given the certificate when it was created
+  if (!m_sharedContext && !loadCertificate(Settings::value(Settings::Security::Certificate).toString())) {
     LOG_ERR("could not load client certificates");
     disconnect();
     return -1;
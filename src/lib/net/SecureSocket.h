@@ -20,6 +20,7 @@ class ISocketMultiplexerJob;
 class QString;
 
 struct Ssl;
+struct ssl_ctx_st;
 
 //! Secure socket
 /*!
@@ -68,6 +69,19 @@ public:
   void initSsl(bool server);
   bool loadCertificate(const QString &filename);
 
+  //! Set up as a client on a context shared with other sockets
+  /*!
+  Like initSsl(false), but the socket takes a reference to \p context instead of
+  creating its own, and does not load the certificate again on connect.
+  */
+  void initSsl(const std::shared_ptr<ssl_ctx_st> &context);
+
+  //! Create a client context holding the certificate, for several sockets to share
+  /*!
+  Returns null if the certificate could not be loaded.
+  */
+  static std::shared_ptr<ssl_ctx_st> createClientContext(SecurityLevel securityLevel);
+
 private:
   // SSL
   void initContext(bool server);
@@ -95,5 +109,6 @@ private:
   std::unique_ptr<Ssl> m_ssl;
   bool m_secureReady = false;
   bool m_fatal = false;
+  bool m_sharedContext = false;
   SecurityLevel m_securityLevel = SecurityLevel::Encrypted;
 };
@@ -653,7 +653,7 @@ void EiScreen::onButtonEvent(ei_event *event)
 
   auto eventType = pressed ? EventTypes::PrimaryScreenButtonDown : EventTypes::PrimaryScreenButtonUp;
 
-  sendEvent(eventType, ButtonInfo::alloc(buttonID, mask));
+  m_events->addEvent(Event::withData(eventType, getEventTarget(), ButtonInfo{buttonID, mask}));
 }
 
 void EiScreen::onPointerScrollEvent(ei_event *event)
@@ -696,10 +696,10 @@ void EiScreen::onPointerScrollEvent(ei_event *event)
   // to send the opposite of the value reported by EI if we want to
   // remain compatible with other platforms (including X11).
   if (x != 0 || y != 0)
-    sendEvent(
-        EventTypes::PrimaryScreenWheel,
-        WheelInfo::alloc((int32_t)-x * s_pixelToWheelRatio, (int32_t)-y * s_pixelToWheelRatio)
-    );
+    m_events->addEvent(Event::withData(
+        EventTypes::PrimaryScreenWheel, getEventTarget(),
+        WheelInfo{(int32_t)-x * s_pixelToWheelRatio, (int32_t)-y * s_pixelToWheelRatio}
+    ));
 
   remainder->x = rx;
   remainder->y = ry;
@@ -721,7 +721,7 @@ void EiScreen::onPointerScrollDiscreteEvent(ei_event *event)
   // libei and deskflow seem to use opposite directions, so we have
   // to send the opposite of the value reported by EI if we want to
   // remain compatible with other platforms (including X11).
-  sendEvent(EventTypes::PrimaryScreenWheel, WheelInfo::alloc(-dx, -dy));
+  m_events->addEvent(Event::withData(EventTypes::PrimaryScreenWheel, getEventTarget(), WheelInfo{-dx, -dy}));
 }
 
 void EiScreen::onMotionEvent(ei_event *event)
@@ -733,7 +733,9 @@ void EiScreen::onMotionEvent(ei_event *event)
 
   if (m_isOnScreen) {
     LOG_DEBUG("event: motion on primary x=%i y=%i)", m_cursorX, m_cursorY);
-    sendEvent(EventTypes::PrimaryScreenMotionOnPrimary, MotionInfo::alloc(m_cursorX, m_cursorY));
+    m_events->addEvent(
+        Event::withData(EventTypes::PrimaryScreenMotionOnPrimary, getEventTarget(), MotionInfo{m_cursorX, m_cursorY})
+    );
     if (m_portalInputCapture->isActive()) {
       m_portalInputCapture->release();
     }
@@ -744,7 +746,9 @@ void EiScreen::onMotionEvent(ei_event *event)
     auto pixelDy = static_cast<std::int32_t>(m_bufferDY);
     if (pixelDx || pixelDy) {
       LOG_DEBUG1("event: motion on secondary x=%d y=%d", pixelDx, pixelDy);
-      sendEvent(EventTypes::PrimaryScreenMotionOnSecondary, MotionInfo::alloc(pixelDx, pixelDy));
+      m_events->addEvent(
+          Event::withData(EventTypes::PrimaryScreenMotionOnSecondary, getEventTarget(), MotionInfo{pixelDx, pixelDy})
+      );
       m_bufferDX -= pixelDx;
       m_bufferDY -= pixelDy;
     }
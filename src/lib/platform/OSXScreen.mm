@@ -939,7 +939,9 @@ bool OSXScreen::onMouseMove()
 
   if (m_isOnScreen) {
     // motion on primary screen
-    sendEvent(EventTypes::PrimaryScreenMotionOnPrimary, MotionInfo::alloc(m_xCursor, m_yCursor));
+    m_events->addEvent(
+        Event::withData(EventTypes::PrimaryScreenMotionOnPrimary, getEventTarget(), MotionInfo{m_xCursor, m_yCursor})
+    );
   } else {
     // motion on secondary screen.  warp mouse back to
     // center.
@@ -970,7 +972,9 @@ bool OSXScreen::onMouseMove()
       // And keep only the fractional part
       m_xFractionalMove -= intX;
       m_yFractionalMove -= intY;
-      sendEvent(EventTypes::PrimaryScreenMotionOnSecondary, MotionInfo::alloc(intX, intY));
+      m_events->addEvent(
+          Event::withData(EventTypes::PrimaryScreenMotionOnSecondary, getEventTarget(), MotionInfo{intX, intY})
+      );
     }
   }
 
@@ -986,13 +990,17 @@ bool OSXScreen::onMouseButton(bool pressed, uint16_t macButton)
     LOG_DEBUG1("event: button press button=%d", button);
     if (button != kButtonNone) {
       KeyModifierMask mask = m_keyState->getActiveModifiers();
-      sendEvent(EventTypes::PrimaryScreenButtonDown, ButtonInfo::alloc(button, mask));
+      m_events->addEvent(
+          Event::withData(EventTypes::PrimaryScreenButtonDown, getEventTarget(), ButtonInfo{button, mask})
+      );
     }
   } else {
     LOG_DEBUG1("event: button release button=%d", button);
     if (button != kButtonNone) {
       KeyModifierMask mask = m_keyState->getActiveModifiers();
-      sendEvent(EventTypes::PrimaryScreenButtonUp, ButtonInfo::alloc(button, mask));
+      m_events->addEvent(
+          Event::withData(EventTypes::PrimaryScreenButtonUp, getEventTarget(), ButtonInfo{button, mask})
+      );
     }
   }
 
@@ -1002,7 +1010,7 @@ bool OSXScreen::onMouseButton(bool pressed, uint16_t macButton)
 bool OSXScreen::onMouseWheel(int32_t xDelta, int32_t yDelta) const
 {
   LOG_DEBUG1("event: button wheel delta=%+d,%+d", xDelta, yDelta);
-  sendEvent(EventTypes::PrimaryScreenWheel, WheelInfo::alloc(xDelta, yDelta));
+  m_events->addEvent(Event::withData(EventTypes::PrimaryScreenWheel, getEventTarget(), WheelInfo{xDelta, yDelta}));
   return true;
 }
 
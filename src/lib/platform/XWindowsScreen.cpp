@@ -1454,7 +1454,9 @@ void XWindowsScreen::onMousePress(const XButtonEvent &xbutton)
   ButtonID button = mapButtonFromX(&xbutton);
   KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
   if (button != kButtonNone) {
-    sendEvent(EventTypes::PrimaryScreenButtonDown, ButtonInfo::alloc(button, mask));
+    m_events->addEvent(
+        Event::withData(EventTypes::PrimaryScreenButtonDown, getEventTarget(), ButtonInfo{button, mask})
+    );
   }
 }
 
@@ -1465,13 +1467,13 @@ void XWindowsScreen::onMouseRelease(const XButtonEvent &xbutton)
   ButtonID button = mapButtonFromX(&xbutton);
   KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
   if (button != kButtonNone) {
-    sendEvent(PrimaryScreenButtonUp, ButtonInfo::alloc(button, mask));
+    m_events->addEvent(Event::withData(PrimaryScreenButtonUp, getEventTarget(), ButtonInfo{button, mask}));
   } else if (xbutton.button == 4) {
     // wheel forward (away from user)
-    sendEvent(PrimaryScreenWheel, WheelInfo::alloc(0, 120));
+    m_events->addEvent(Event::withData(PrimaryScreenWheel, getEventTarget(), WheelInfo{0, 120}));
   } else if (xbutton.button == 5) {
     // wheel backward (toward user)
-    sendEvent(PrimaryScreenWheel, WheelInfo::alloc(0, -120));
+    m_events->addEvent(Event::withData(PrimaryScreenWheel, getEventTarget(), WheelInfo{0, -120}));
   }
   // XXX -- support x-axis scrolling
 }
@@ -1507,7 +1509,9 @@ void XWindowsScreen::onMouseMove(const XMotionEvent &xmotion)
     cntr = 0;
   } else if (m_isOnScreen) {
     // motion on primary screen
-    sendEvent(EventTypes::PrimaryScreenMotionOnPrimary, MotionInfo::alloc(m_xCursor, m_yCursor));
+    m_events->addEvent(
+        Event::withData(EventTypes::PrimaryScreenMotionOnPrimary, getEventTarget(), MotionInfo{m_xCursor, m_yCursor})
+    );
   } else {
     // motion on secondary screen.  warp mouse back to
     // center.
@@ -1534,7 +1538,9 @@ void XWindowsScreen::onMouseMove(const XMotionEvent &xmotion)
     // warping to the primary screen's enter position,
     // effectively overriding it.
     if (x != 0 || y != 0) {
-      sendEvent(EventTypes::PrimaryScreenMotionOnSecondary, MotionInfo::alloc(x, y));
+      m_events->addEvent(
+          Event::withData(EventTypes::PrimaryScreenMotionOnSecondary, getEventTarget(), MotionInfo{x, y})
+      );
     }
   }
 }
@@ -5,26 +5,51 @@
 #include "BridgePlatformScreen.h"
 
 #include "HidFrame.h"
+#include "HidKeyMap.h"
 #include "base/Event.h"
 #include "base/EventTypes.h"
+#include "base/InputLatency.h"
 #include "base/Log.h"
 #include "common/Settings.h"
 
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <iomanip>
+#include <span>
 #include <sstream>
 #include <utility>
 
 namespace deskflow::bridge {
 
 namespace {
-constexpr int kMinMouseDelta = -32767;
-constexpr int kMaxMouseDelta = 32767;
 constexpr std::chrono::seconds kKeepAliveInterval(30);
 constexpr double kKeepAliveIntervalSeconds = static_cast<double>(kKeepAliveInterval.count());
 
+// Wheel input is scaled by the profile speed (120 by default), so one 120-unit notch at the default
+// speed fills one detent
+constexpr int32_t kDetentThreshold = 120 * 120;
+constexpr int32_t kHiResUnitThreshold = kDetentThreshold / kHiResScrollUnitsPerDetent;
+static_assert(kDetentThreshold % kHiResScrollUnitsPerDetent == 0);
+
+/**
+ * Add a wheel delta to an axis accumulator and take out the whole units it completes, at most
+ * limit in either direction. The remainder carries over to the next wheel event.
+ */
+int32_t takeWheelUnits(int32_t &accumulator, int32_t delta, int32_t speed, int32_t threshold, int32_t limit)
+{
+  accumulator += delta * speed;
+  const int32_t units = std::clamp(accumulator / threshold, -limit, limit);
+  accumulator -= units * threshold;
+  return units;
+}
+
 std::string hexDump(const uint8_t *data, size_t length, size_t maxBytes = 32)
 {
   if (data == nullptr || length == 0) {
@@ -51,7 +76,7 @@ std::string hexDump(const uint8_t *data, size_t length, size_t maxBytes = 32)
 
 BridgePlatformScreen::BridgePlatformScreen(
     IEventQueue *events, std::shared_ptr<CdcTransport> transport, int32_t screenWidth, int32_t screenHeight,
-    bool invertScroll
+    bool invertScroll, std::optional<bool> bluetoothKeepAlive
 )
     : PlatformScreen(events, invertScroll),
       m_transport(std::move(transport)),
@@ -63,20 +88,86 @@ BridgePlatformScreen::BridgePlatformScreen(
 
   m_lastCdcCommand = std::chrono::steady_clock::now();
 
-  m_bluetoothKeepAliveEnabled = Settings::value(Settings::Bridge::BluetoothKeepAlive).toBool();
+  MotionShaper::Config shaping;
+  shaping.reportInterval = std::chrono::microseconds(Settings::value(Settings::Bridge::MotionReportInterval).toInt());
+  shaping.maxStep = Settings::value(Settings::Bridge::MotionMaxStep).toInt();
+  LOG_INFO(
+      "BridgeScreen: motion report interval=%lldus max step=%d", static_cast<long long>(shaping.reportInterval.count()),
+      shaping.maxStep
+  );
+
+  // HID events are written by the queue's own thread; a failed write is reported back as a screen error
+  m_txQueue = std::make_unique<HidTxQueue>(
+      m_transport,
+      [this] {
+        if (m_events != nullptr) {
+          m_events->addEvent(Event(EventTypes::ScreenError, getEventTarget()));
+        }
+      },
+      shaping
+  );
+
+  m_bluetoothKeepAliveEnabled =
+      bluetoothKeepAlive.value_or(Settings::value(Settings::Bridge::BluetoothKeepAlive).toBool());
+  const double latencyReportInterval = Settings::value(Settings::Bridge::LatencyReportInterval).toDouble();
+  if (m_events != nullptr && (m_bluetoothKeepAliveEnabled || latencyReportInterval > 0.0)) {
+    m_events->addHandler(deskflow::EventTypes::Timer, this, [this](const Event &event) { handleTimer(event); });
+  }
+
   if (m_bluetoothKeepAliveEnabled && m_events != nullptr) {
     LOG_INFO("BridgeScreen: Bluetooth keep-alive enabled, starting timer");
-    m_events->addHandler(deskflow::EventTypes::Timer, this, [this](const Event &event) {
-      handleKeepAliveTimer(event);
-    });
     startKeepAliveTimer();
   }
+
+  if (latencyReportInterval > 0.0 && m_events != nullptr) {
+    LOG_INFO("BridgeScreen: reporting input latency every %.0fs", latencyReportInterval);
+    m_latencyReportTimer = m_events->newTimer(latencyReportInterval, this);
+  }
+
+  const QString recordDir = Settings::value(Settings::Bridge::HidRecordDir).toString();
+  if (!recordDir.isEmpty()) {
+    // One file per screen and session, so bridges sharing a process or a directory never collide
+    const QString fileName = QStringLiteral("hid-%1-%2.hidrec")
+                                 .arg(
+                                     QFileInfo(m_transport->devicePath()).fileName(),
+                                     QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss"))
+                                 );
+    m_recorder = std::make_unique<HidRecorder>(QDir(recordDir).filePath(fileName).toStdString());
+    if (m_recorder->isOpen()) {
+      LOG_WARN(
+          "BridgeScreen: recording all HID input to %s, including everything typed such as passwords",
+          m_recorder->path().string().c_str()
+      );
+    } else {
+      m_recorder.reset();
+    }
+  }
 }
 
 BridgePlatformScreen::~BridgePlatformScreen()
 {
+  const auto stats = m_txQueue->stats();
+  LOG_INFO(
+      "BridgeScreen: tx queue sent=%llu batches=%llu coalesced=%llu spilled=%llu credit stalls=%llu max depth=%zu",
+      static_cast<unsigned long long>(stats.eventsSent), static_cast<unsigned long long>(stats.batches),
+      static_cast<unsigned long long>(stats.coalesced), static_cast<unsigned long long>(stats.spilled),
+      static_cast<unsigned long long>(stats.creditStalls), stats.maxDepth
+  );
+  // Drain and stop the writer before the rest of the screen goes away
+  m_txQueue.reset();
+  if (m_recorder != nullptr) {
+    LOG_INFO(
+        "BridgeScreen: recorded %llu HID events to %s", static_cast<unsigned long long>(m_recorder->recorded()),
+        m_recorder->path().string().c_str()
+    );
+  }
+  InputLatency::instance().report();
+
   stopKeepAliveTimer();
   if (m_events != nullptr) {
+    if (m_latencyReportTimer != nullptr) {
+      m_events->deleteTimer(m_latencyReportTimer);
+    }
     m_events->removeHandler(deskflow::EventTypes::Timer, this);
   }
 }
@@ -188,6 +279,17 @@ void BridgePlatformScreen::fakeMouseMove(int32_t x, int32_t y)
 {
   LOG_DEBUG2("BridgeScreen: mouse move to %d,%d", x, y);
 
+  if (m_absolutePointer) {
+    m_cursorX = x;
+    m_cursorY = y;
+
+    // Every report carries the whole position, so a lost one leaves no lasting offset
+    if (!sendMouseAbsoluteEvent(x, y)) {
+      LOG_ERR("BridgeScreen: failed to send mouse position");
+    }
+    return;
+  }
+
   int32_t dx = x - m_cursorX;
   int32_t dy = y - m_cursorY;
 
@@ -205,38 +307,56 @@ void BridgePlatformScreen::fakeMouseRelativeMove(int32_t dx, int32_t dy) const
     return;
   }
 
-  int16_t stepDx =
-      std::clamp(static_cast<int64_t>(dx), static_cast<int64_t>(kMinMouseDelta), static_cast<int64_t>(kMaxMouseDelta));
-  int16_t stepDy =
-      std::clamp(static_cast<int64_t>(dy), static_cast<int64_t>(kMinMouseDelta), static_cast<int64_t>(kMaxMouseDelta));
-
-  if (!sendMouseMoveEvent(stepDx, stepDy)) {
+  // The tx queue's motion shaper splits large deltas into paced reports
+  if (!sendMouseMoveEvent(dx, dy)) {
     LOG_ERR("BridgeScreen: failed to send mouse move");
   }
 }
 
-void BridgePlatformScreen::fakeMouseWheel(int32_t, int32_t yDelta) const
+void BridgePlatformScreen::fakeInputBatchBegin() const
+{
+  m_txQueue->beginBatch();
+}
+
+void BridgePlatformScreen::fakeInputFlush() const
+{
+  // Everything queued since fakeInputBatchBegin() goes out together, batched when the firmware allows
+  m_txQueue->flush();
+}
+
+void BridgePlatformScreen::fakeMouseWheel(int32_t xDelta, int32_t yDelta) const
 {
-  LOG_DEBUG("BridgeScreen: mouse wheel y=%d", yDelta);
+  LOG_DEBUG("BridgeScreen: mouse wheel x=%d y=%d", xDelta, yDelta);
 
-  if (yDelta == 0) {
+  if (xDelta == 0 && yDelta == 0) {
     return;
   }
 
+  // The HID wheel counts up as positive like deskflow does, AC Pan counts right where deskflow counts left
   yDelta = mapClientScrollDirection(yDelta);
+  xDelta = -mapClientScrollDirection(xDelta);
 
-  int32_t speed = (m_scrollSpeed > 0) ? m_scrollSpeed : 120;
-  m_wheelAccumulatorY += (yDelta * speed);
-
-  constexpr int32_t kStepThreshold = 14400;
-  int8_t steps = static_cast<int8_t>(m_wheelAccumulatorY / kStepThreshold);
-
-  if (steps != 0) {
-    m_wheelAccumulatorY %= kStepThreshold;
-
-    if (!sendMouseScrollEvent(steps)) {
+  const int32_t speed = (m_scrollSpeed > 0) ? m_scrollSpeed : 120;
+  if (m_scrollMode == ScrollMode::HighResolution) {
+    const int32_t y = takeWheelUnits(m_wheelAccumulatorY, yDelta, speed, kHiResUnitThreshold, INT16_MAX);
+    const int32_t x = takeWheelUnits(m_wheelAccumulatorX, xDelta, speed, kHiResUnitThreshold, INT16_MAX);
+    if ((x != 0 || y != 0) && !sendMouseScrollHiResEvent(static_cast<int16_t>(y), static_cast<int16_t>(x))) {
       LOG_ERR("BridgeScreen: failed to send scroll event");
     }
+    return;
+  }
+
+  if (const int32_t steps = takeWheelUnits(m_wheelAccumulatorY, yDelta, speed, kDetentThreshold, INT8_MAX);
+      steps != 0 && !sendMouseScrollEvent(static_cast<int8_t>(steps))) {
+    LOG_ERR("BridgeScreen: failed to send scroll event");
+  }
+
+  if (m_scrollMode != ScrollMode::Horizontal) {
+    return;
+  }
+  if (const int32_t steps = takeWheelUnits(m_wheelAccumulatorX, xDelta, speed, kDetentThreshold, INT8_MAX);
+      steps != 0 && !sendMousePanEvent(static_cast<int8_t>(steps))) {
+    LOG_ERR("BridgeScreen: failed to send pan event");
   }
 }
 
@@ -284,7 +404,9 @@ void BridgePlatformScreen::fakeKeyDown(KeyID id, KeyModifierMask mask, KeyButton
     return;
   }
 
-  if (!sendKeyboardEvent(HidEventType::KeyboardPress, hidModifiers, hidKey)) {
+  const bool sent = m_keyboardReports ? sendKeyboardReport(m_currentHidModifiers)
+                                      : sendKeyboardEvent(HidEventType::KeyboardPress, hidModifiers, hidKey);
+  if (!sent) {
     LOG_ERR("BridgeScreen: failed to send key press");
   }
 }
@@ -324,6 +446,20 @@ bool BridgePlatformScreen::fakeKeyRepeat(
     return true;
   }
 
+  if (m_keyboardReports) {
+    if (hidKey == 0) {
+      return true;
+    }
+    // Toggling the key and then restoring the held state repeats it whether or not it is down
+    for (int32_t i = 0; i < count; ++i) {
+      if (!sendKeyboardReport(hidModifiers, hidKey) || !sendKeyboardReport(m_currentHidModifiers)) {
+        LOG_ERR("BridgeScreen: failed to send keyboard repeat");
+        return false;
+      }
+    }
+    return true;
+  }
+
   for (int32_t i = 0; i < count; ++i) {
     if (!sendKeyboardEvent(HidEventType::KeyboardPress, hidModifiers, hidKey) ||
         !sendKeyboardEvent(HidEventType::KeyboardRelease, hidModifiers, hidKey)) {
@@ -368,7 +504,10 @@ bool BridgePlatformScreen::fakeKeyUp(KeyButton button)
     m_currentHidModifiers = activeModifierBitmap();
   }
 
-  if (!sendKeyboardEvent(HidEventType::KeyboardRelease, m_currentHidModifiers, hidKey)) {
+  const bool sent = m_keyboardReports
+                        ? sendKeyboardReport(m_currentHidModifiers)
+                        : sendKeyboardEvent(HidEventType::KeyboardRelease, m_currentHidModifiers, hidKey);
+  if (!sent) {
     LOG_ERR("BridgeScreen: failed to send key release");
   }
   return true;
@@ -384,12 +523,14 @@ void BridgePlatformScreen::fakeAllKeysUp()
     }
   }
 
-  for (const auto &[button, state] : m_buttonToActiveKey) {
-    if (state.modifierBit != 0) {
-      m_currentHidModifiers &= ~state.modifierBit;
-    }
-    if (!sendKeyboardEvent(HidEventType::KeyboardRelease, m_currentHidModifiers, state.hidKey)) {
-      LOG_ERR("BridgeScreen: failed to send key release for %u", state.hidKey);
+  if (!m_keyboardReports) {
+    for (const auto &[button, state] : m_buttonToActiveKey) {
+      if (state.modifierBit != 0) {
+        m_currentHidModifiers &= ~state.modifierBit;
+      }
+      if (!sendKeyboardEvent(HidEventType::KeyboardRelease, m_currentHidModifiers, state.hidKey)) {
+        LOG_ERR("BridgeScreen: failed to send key release for %u", state.hidKey);
+      }
     }
   }
 
@@ -398,6 +539,11 @@ void BridgePlatformScreen::fakeAllKeysUp()
   m_buttonToActiveKey.clear();
   m_currentHidModifiers = 0;
   m_activeModifiers = 0;
+
+  // One empty report releases everything, including keys the device holds from a lost frame
+  if (m_keyboardReports && !sendKeyboardReport(0)) {
+    LOG_ERR("BridgeScreen: failed to send all keys up");
+  }
 }
 
 void BridgePlatformScreen::updateKeyMap()
@@ -460,22 +606,71 @@ void BridgePlatformScreen::enter()
 {
   LOG_DEBUG("BridgeScreen: enter");
   resetMouseAccumulator();
+  auto transportLock = m_txQueue->lockTransport();
   if (m_transport != nullptr && !m_transport->open()) {
     LOG_WARN("BridgeScreen: failed to open transport on enter (%s)", m_transport->lastError().c_str());
   }
 
   if (m_transport != nullptr && m_transport->isOpen()) {
+    m_txQueue->resetError();
+    if (m_keyboardReports != m_transport->hasKeyboardReport()) {
+      m_keyboardReports = m_transport->hasKeyboardReport();
+      LOG_INFO("BridgeScreen: keyboard %s", m_keyboardReports ? "sends whole reports" : "sends key transitions");
+    }
+    if (m_scrollMode != m_transport->scrollMode()) {
+      m_scrollMode = m_transport->scrollMode();
+      resetMouseAccumulator();
+    }
     if (m_transport->hasDeviceConfig()) {
       const auto &config = m_transport->deviceConfig();
       DeviceProfile profile;
       if (m_transport->getProfile(config.activeProfile, profile)) {
         m_scrollSpeed = profile.speed;
         LOG_INFO("BridgeScreen: loaded scroll speed %d from profile %d", m_scrollSpeed, config.activeProfile);
+        applyPointerMode(profile);
       } else {
         LOG_WARN("BridgeScreen: failed to load profile %d", config.activeProfile);
       }
     }
   }
+  transportLock.unlock();
+
+  // Client::enter moves the cursor before the pointer mode is known, so place it once more
+  if (m_absolutePointer && !sendMouseAbsoluteEvent(m_cursorX, m_cursorY)) {
+    LOG_ERR("BridgeScreen: failed to send pointer position");
+  }
+}
+
+void BridgePlatformScreen::applyPointerMode(const DeviceProfile &profile)
+{
+  // The profile holds the phone's resolution in portrait; the size from the command line only
+  // stands in for profiles that leave it empty
+  if (profile.screenWidth != 0 && profile.screenHeight != 0) {
+    const int32_t shortSide = (std::min)(profile.screenWidth, profile.screenHeight);
+    const int32_t longSide = (std::max)(profile.screenWidth, profile.screenHeight);
+    const int32_t width = profile.rotation != 0 ? longSide : shortSide;
+    const int32_t height = profile.rotation != 0 ? shortSide : longSide;
+    if (width != m_screenWidth || height != m_screenHeight) {
+      LOG_INFO("BridgeScreen: screen=%dx%d from profile, was %dx%d", width, height, m_screenWidth, m_screenHeight);
+      m_screenWidth = width;
+      m_screenHeight = height;
+      // The server maps positions onto the shape it knows, so it has to learn the new one
+      if (m_events != nullptr) {
+        m_events->addEvent(Event(EventTypes::ScreenShapeChanged, getEventTarget()));
+      }
+    }
+  }
+  m_digitizer = DigitizerMapping(m_screenWidth, m_screenHeight, profile.rotation);
+
+  bool absolute = profile.pointerMode == kPointerModeAbsolute;
+  if (absolute && !m_transport->hasAbsolutePointer()) {
+    LOG_WARN("BridgeScreen: profile asks for an absolute pointer but the firmware has no digitizer");
+    absolute = false;
+  }
+  if (absolute != m_absolutePointer) {
+    m_absolutePointer = absolute;
+    LOG_INFO("BridgeScreen: pointer mode %s", absolute ? "absolute" : "relative");
+  }
 }
 
 bool BridgePlatformScreen::canLeave()
@@ -547,24 +742,37 @@ void BridgePlatformScreen::handleSystemEvent(const Event &event)
 {
 }
 
-bool BridgePlatformScreen::sendEvent(HidEventType type, const std::vector<uint8_t> &payload) const
+bool BridgePlatformScreen::sendEvent(HidEventType type, std::initializer_list<uint8_t> payload) const
 {
+  // The packet keeps its payload inline so per-event sends stay off the heap
+  return sendEvent(HidEventPacket(type, payload));
+}
+
+bool BridgePlatformScreen::sendEvent(const HidEventPacket &packet) const
+{
+  const HidEventType type = packet.type;
+  if (!packet.isValid()) {
+    // Already logged when the packet was built; dropping one event is no reason to tear down the screen
+    return false;
+  }
   if (CLOG->getFilter() >= LogLevel::Debug) {
-    std::string payloadHex = hexDump(payload.data(), payload.size(), 48);
+    const auto bytes = packet.payload();
+    std::string payloadHex = hexDump(bytes.data(), bytes.size(), 48);
     if (!payloadHex.empty()) {
       LOG_DEBUG(
-          "BridgeScreen: TX HID type=0x%02x len=%zu payload=%s", static_cast<unsigned>(type), payload.size(),
+          "BridgeScreen: TX HID type=0x%02x len=%zu payload=%s", static_cast<unsigned>(type), bytes.size(),
           payloadHex.c_str()
       );
     } else {
-      LOG_DEBUG("BridgeScreen: TX HID type=0x%02x len=%zu", static_cast<unsigned>(type), payload.size());
+      LOG_DEBUG("BridgeScreen: TX HID type=0x%02x len=%zu", static_cast<unsigned>(type), bytes.size());
     }
   }
 
-  HidEventPacket packet;
-  packet.type = type;
-  packet.payload = payload;
-  if (!m_transport->sendHidEvent(packet)) {
+  if (m_recorder != nullptr) {
+    m_recorder->record(packet);
+  }
+
+  if (!m_txQueue->enqueue(packet, InputLatency::markQueued())) {
     LOG_ERR("BridgeScreen: failed to send HID event type=%u", static_cast<unsigned>(type));
     m_events->addEvent(Event(EventTypes::ScreenError, getEventTarget()));
     return false;
@@ -582,15 +790,76 @@ bool BridgePlatformScreen::sendKeyboardEvent(HidEventType type, uint8_t modifier
   return true;
 }
 
-bool BridgePlatformScreen::sendMouseMoveEvent(int16_t dx, int16_t dy) const
+bool BridgePlatformScreen::sendKeyboardReport(uint8_t modifiers, uint8_t toggledKey) const
 {
-  uint8_t dxLo = static_cast<uint8_t>(dx & 0xFF);
-  uint8_t dxHi = static_cast<uint8_t>((dx >> 8) & 0xFF);
-  uint8_t dyLo = static_cast<uint8_t>(dy & 0xFF);
-  uint8_t dyHi = static_cast<uint8_t>((dy >> 8) & 0xFF);
+  // The report is rebuilt from the held keys, so every frame carries the complete state
+  std::array<uint8_t, kKeyboardReportSize> report{};
+  report[0] = modifiers;
+  const auto keys = std::span(report).subspan(kKeyboardReportKeyOffset);
+  size_t keyCount = 0;
+  bool toggled = false;
+  bool rollOver = false;
+  const auto addKey = [&](uint8_t key) {
+    if (std::find(keys.begin(), keys.begin() + keyCount, key) != keys.begin() + keyCount) {
+      return;
+    }
+    if (keyCount == keys.size()) {
+      rollOver = true;
+      return;
+    }
+    keys[keyCount++] = key;
+  };
+
+  for (const auto &[button, state] : m_buttonToActiveKey) {
+    if (state.hidKey == 0) {
+      continue;
+    }
+    if (state.hidKey == toggledKey) {
+      toggled = true;
+      continue;
+    }
+    addKey(state.hidKey);
+  }
+  if (toggledKey != 0 && !toggled) {
+    addKey(toggledKey);
+  }
+  if (rollOver) {
+    std::fill(keys.begin(), keys.end(), kKeyErrorRollOver);
+  }
 
-  if (!sendEvent(HidEventType::MouseMove, {dxLo, dxHi, dyLo, dyHi})) {
+  if (!sendEvent(HidEventPacket(HidEventType::KeyboardReport, report))) {
+    LOG_ERR("BridgeScreen: failed to send keyboard report");
+    return false;
+  }
+  return true;
+}
+
+bool BridgePlatformScreen::sendMouseMoveEvent(int32_t dx, int32_t dy) const
+{
+  if (m_recorder != nullptr) {
+    m_recorder->recordMouseMove(dx, dy);
+  }
+
+  // Motion is merged with any move the device has not taken yet
+  if (!m_txQueue->enqueueMouseMove(dx, dy, InputLatency::markQueued())) {
     LOG_ERR("BridgeScreen: failed to send mouse move event");
+    m_events->addEvent(Event(EventTypes::ScreenError, getEventTarget()));
+    return false;
+  }
+  return true;
+}
+
+bool BridgePlatformScreen::sendMouseAbsoluteEvent(int32_t x, int32_t y) const
+{
+  uint16_t logicalX = 0;
+  uint16_t logicalY = 0;
+  m_digitizer.map(x, y, logicalX, logicalY);
+  if (!sendEvent(
+          HidEventType::MouseAbsolute,
+          {static_cast<uint8_t>(logicalX & 0xFF), static_cast<uint8_t>(logicalX >> 8),
+           static_cast<uint8_t>(logicalY & 0xFF), static_cast<uint8_t>(logicalY >> 8)}
+      )) {
+    LOG_ERR("BridgeScreen: failed to send absolute pointer event");
     return false;
   }
   return true;
@@ -614,6 +883,30 @@ bool BridgePlatformScreen::sendMouseScrollEvent(int8_t delta) const
   return true;
 }
 
+bool BridgePlatformScreen::sendMousePanEvent(int8_t delta) const
+{
+  if (!sendEvent(HidEventType::MousePan, {static_cast<uint8_t>(delta)})) {
+    LOG_ERR("BridgeScreen: failed to send pan event");
+    return false;
+  }
+  return true;
+}
+
+bool BridgePlatformScreen::sendMouseScrollHiResEvent(int16_t vertical, int16_t horizontal) const
+{
+  const auto v = static_cast<uint16_t>(vertical);
+  const auto h = static_cast<uint16_t>(horizontal);
+  if (!sendEvent(
+          HidEventType::MouseScrollHiRes,
+          {static_cast<uint8_t>(v & 0xFF), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(h & 0xFF),
+           static_cast<uint8_t>(h >> 8)}
+      )) {
+    LOG_ERR("BridgeScreen: failed to send hi-res scroll event");
+    return false;
+  }
+  return true;
+}
+
 bool BridgePlatformScreen::sendConsumerControlEvent(HidEventType type, uint16_t usageCode) const
 {
   const uint8_t lowByte = static_cast<uint8_t>(usageCode & 0xFF);
@@ -644,39 +937,7 @@ uint8_t BridgePlatformScreen::convertModifiers(KeyModifierMask mask) const
 
 uint8_t BridgePlatformScreen::modifierBitForKey(KeyID id) const
 {
-  switch (id) {
-  case ::kKeyShift_L:
-  case 0xFFE1:
-    return 0x02;
-  case ::kKeyShift_R:
-  case 0xFFE2:
-    return 0x20;
-  case ::kKeyControl_L:
-  case 0xFFE3:
-    return 0x01;
-  case ::kKeyControl_R:
-  case 0xFFE4:
-    return 0x10;
-  case ::kKeyAlt_L:
-  case 0xFFE9:
-    return 0x04;
-  case ::kKeyAlt_R:
-  case 0xFFEA:
-  case ::kKeyAltGr:
-    return 0x40;
-  case ::kKeyMeta_L:
-  case ::kKeySuper_L:
-  case 0xFFE7:
-  case 0xFFEB:
-    return 0x08;
-  case ::kKeyMeta_R:
-  case ::kKeySuper_R:
-  case 0xFFE8:
-  case 0xFFEC:
-    return 0x80;
-  default:
-    return 0;
-  }
+  return hidModifierBitForKeyId(id);
 }
 
 uint8_t BridgePlatformScreen::modifierBitForButton(KeyButton button) const
@@ -746,532 +1007,25 @@ uint8_t BridgePlatformScreen::modifierBitForButton(KeyButton button) const
 
 uint16_t BridgePlatformScreen::convertMediaKeyToConsumerControl(KeyID id) const
 {
-  switch (id) {
-  case 0xE0AD: // kKeyAudioMute
-    return 0x00E2;
-  case 0xE0AE: // kKeyAudioDown
-    return 0x00EA;
-  case 0xE0AF: // kKeyAudioUp
-    return 0x00E9;
-  case 0xE0B0: // kKeyAudioNext
-    return 0x00B5;
-  case 0xE0B1: // kKeyAudioPrev
-    return 0x00B6;
-  case 0xE0B2: // kKeyAudioStop
-    return 0x00B7;
-  case 0xE0B3: // kKeyAudioPlay
-    return 0x00CD;
-  case 0xE0B8: // kKeyBrightnessDown
-    return 0x0070;
-  case 0xE0B9: // kKeyBrightnessUp
-    return 0x006F;
-  case 0xE0A6: // kKeyWWWBack
-    return 0x0224;
-  case 0xE0A7: // kKeyWWWForward
-    return 0x0225;
-  case 0xE0A8: // kKeyWWWRefresh
-    return 0x0227;
-  case 0xE0A9: // kKeyWWWStop
-    return 0x0226;
-  case 0xE0AA: // kKeyWWWSearch
-    return 0x0221;
-  case 0xE0AB: // kKeyWWWFavorites
-    return 0x022A;
-  case 0xE0AC: // kKeyWWWHome
-    return 0x0223;
-  case 0xE0B4: // kKeyAppMail
-    return 0x018A;
-  case 0xE0B5: // kKeyAppMedia
-    return 0x0183;
-  default:
-    return 0;
-  }
+  return consumerUsageForKeyId(id);
 }
 
 uint8_t BridgePlatformScreen::convertKeyID(KeyID id) const
 {
-  if (id >= 'a' && id <= 'z')
-    return static_cast<uint8_t>(0x04 + (id - 'a'));
-  if (id >= 'A' && id <= 'Z')
-    return static_cast<uint8_t>(0x04 + (id - 'A'));
-  if (id >= '1' && id <= '9')
-    return static_cast<uint8_t>(0x1E + (id - '1'));
-  if (id == '0')
-    return 0x27;
-
-  switch (id) {
-  case '-':
-  case '_':
-    return 0x2D;
-  case '=':
-  case '+':
-    return 0x2E;
-  case '[':
-  case '{':
-    return 0x2F;
-  case ']':
-  case '}':
-    return 0x30;
-  case '\\':
-  case '|':
-    return 0x31;
-  case ';':
-  case ':':
-    return 0x33;
-  case '\'':
-  case '"':
-    return 0x34;
-  case '`':
-  case '~':
-    return 0x35;
-  case ',':
-  case '<':
-    return 0x36;
-  case '.':
-  case '>':
-    return 0x37;
-  case '/':
-  case '?':
-    return 0x38;
-  case '!':
-    return 0x1E;
-  case '@':
-    return 0x1F;
-  case '#':
-    return 0x20;
-  case '$':
-    return 0x21;
-  case '%':
-    return 0x22;
-  case '^':
-    return 0x23;
-  case '&':
-    return 0x24;
-  case '*':
-    return 0x25;
-  case '(':
-    return 0x26;
-  case ')':
-    return 0x27;
-  default:
-    break;
-  }
-
-  switch (id) {
-  case 0xFFE5:
-  case 0xEFE5:
-    return 0x39;
-  case 0xFFBE:
-  case 0xEFBE:
-    return 0x3A;
-  case 0xFFBF:
-  case 0xEFBF:
-    return 0x3B;
-  case 0xFFC0:
-  case 0xEFC0:
-    return 0x3C;
-  case 0xFFC1:
-  case 0xEFC1:
-    return 0x3D;
-  case 0xFFC2:
-  case 0xEFC2:
-    return 0x3E;
-  case 0xFFC3:
-  case 0xEFC3:
-    return 0x3F;
-  case 0xFFC4:
-  case 0xEFC4:
-    return 0x40;
-  case 0xFFC5:
-  case 0xEFC5:
-    return 0x41;
-  case 0xFFC6:
-  case 0xEFC6:
-    return 0x42;
-  case 0xFFC7:
-  case 0xEFC7:
-    return 0x43;
-  case 0xFFC8:
-  case 0xEFC8:
-    return 0x44;
-  case 0xFFC9:
-  case 0xEFC9:
-    return 0x45;
-  case 0xFF61:
-  case 0xEF61:
-    return 0x46;
-  case 0xFF14:
-  case 0xEF14:
-    return 0x47;
-  case 0xFF13:
-  case 0xEF13:
-    return 0x48;
-  case 0xFF63:
-  case 0xEF63:
-    return 0x49;
-  case 0xFF0D:
-  case 0xEF0D:
-    return 0x28;
-  case 0xFF1B:
-  case 0xEF1B:
-    return 0x29;
-  case 0xFF08:
-  case 0xEF08:
-    return 0x2A;
-  case 0xFF09:
-  case 0xEF09:
-    return 0x2B;
-  case 0x0020:
-    return 0x2C;
-  case 0xFF50:
-  case 0xEF50:
-    return 0x4A;
-  case 0xFF57:
-  case 0xEF57:
-    return 0x4D;
-  case 0xFF55:
-  case 0xEF55:
-    return 0x4B;
-  case 0xFF56:
-  case 0xEF56:
-    return 0x4E;
-  case 0xFFFF:
-  case 0xEFFF:
-    return 0x4C;
-  case 0xFF7F:
-  case 0xEF7F:
-    return 0x53;
-  case 0xFF67:
-  case 0xEF67:
-    return 0x65;
-  case 0xFF51:
-  case 0xEF51:
-    return 0x50;
-  case 0xFF52:
-  case 0xEF52:
-    return 0x52;
-  case 0xFF53:
-  case 0xEF53:
-    return 0x4F;
-  case 0xFF54:
-  case 0xEF54:
-    return 0x51;
-  default:
+  const uint8_t usage = hidUsageForKeyId(id);
+  if (usage == 0) {
     LOG_DEBUG2("BridgeScreen: unmapped KeyID 0x%04x", id);
-    return 0;
   }
+  return usage;
 }
 
 uint8_t BridgePlatformScreen::convertKeyButton(KeyButton button) const
 {
-#if defined(__APPLE__)
-  switch (button) {
-  case 19: // macOS '1'
-    return convertKeyID('1');
-  case 20: // macOS '2'
-    return convertKeyID('2');
-  case 21: // macOS '3'
-    return convertKeyID('3');
-  case 22: // macOS '4'
-    return convertKeyID('4');
-  case 24: // macOS '5'
-    return convertKeyID('5');
-  case 23: // macOS '6'
-    return convertKeyID('6');
-  case 27: // macOS '7'
-    return convertKeyID('7');
-  case 29: // macOS '8'
-    return convertKeyID('8');
-  case 26: // macOS '9'
-    return convertKeyID('9');
-  case 30: // macOS '0'
-    return convertKeyID('0');
-  case 28: // macOS '-'
-    return 0x2d;
-  case 25: // macOS '='
-    return 0x2e;
-  case 52: // macOS Backspace
-    return 0x2a;
-  case 49: // macOS Tab
-    return 0x2b;
-  case 13: // macOS 'q'
-    return convertKeyID('q');
-  case 14: // macOS 'w'
-    return convertKeyID('w');
-  case 15: // macOS 'e'
-    return convertKeyID('e');
-  case 16: // macOS 'r'
-    return convertKeyID('r');
-  case 18: // macOS 't'
-    return convertKeyID('t');
-  case 17: // macOS 'y'
-    return convertKeyID('y');
-  case 33: // macOS 'u'
-    return convertKeyID('u');
-  case 35: // macOS 'i'
-    return convertKeyID('i');
-  case 32: // macOS 'o', Linux 'o' (overlap)
-    return convertKeyID('o');
-  case 36: // macOS 'p'
-    return convertKeyID('p');
-  case 34: // macOS '[', Linux '[' (overlap)
-    return 0x2f;
-  case 31: // macOS ']'
-    return 0x30;
-  case 37: // macOS Enter
-    return 0x28;
-  case 1: // macOS 'a'
-    return convertKeyID('a');
-  case 2: // macOS 's'
-    return convertKeyID('s');
-  case 3: // macOS 'd'
-    return convertKeyID('d');
-  case 4: // macOS 'f'
-    return convertKeyID('f');
-  case 6: // macOS 'g'
-    return convertKeyID('g');
-  case 5: // macOS 'h'
-    return convertKeyID('h');
-  case 39: // macOS 'j'
-    return convertKeyID('j');
-  case 41: // macOS 'k'
-    return convertKeyID('k');
-  case 38: // macOS 'l'
-    return convertKeyID('l');
-  case 42: // macOS ';'
-    return 0x33;
-  case 40: // macOS '\''
-    return 0x34;
-  case 51: // macOS '`'
-    return 0x35;
-  case 43: // macOS '\'
-    return 0x31;
-  case 7: // macOS 'z'
-    return convertKeyID('z');
-  case 8: // macOS 'x'
-    return convertKeyID('x');
-  case 9: // macOS 'c'
-    return convertKeyID('c');
-  case 10: // macOS 'v'
-    return convertKeyID('v');
-  case 12: // macOS 'b'
-    return convertKeyID('b');
-  case 46: // macOS 'n'
-    return convertKeyID('n');
-  case 47: // macOS 'm'
-    return convertKeyID('m');
-  case 44: // macOS ','
-    return 0x36;
-  case 48: // macOS '.'
-    return 0x37;
-  case 45: // macOS '/'
-    return 0x38;
-  case 50: // macOS Space
-    return 0x2c;
-  case 58: // macOS CapsLock
-    return 0x39;
-  case 123: // macOS F1
-    return 0x3A;
-  case 121: // macOS F2
-    return 0x3B;
-  case 100: // macOS F3
-    return 0x3C;
-  case 119: // macOS F4
-    return 0x3D;
-  case 97: // macOS F5
-    return 0x3E;
-  case 98: // macOS F6
-    return 0x3F;
-  case 99: // macOS F7
-    return 0x40;
-  case 101: // macOS F8
-    return 0x41;
-  case 102: // macOS F9
-    return 0x42;
-  case 110: // macOS F10
-    return 0x43;
-  case 72: // macOS Numlock (Clear)
-    return 0x53;
-  case 127: // macOS Up
-    return 0x52;
-  case 124: // macOS Left
-    return 0x50;
-  case 125: // macOS Right
-    return 0x4F;
-  case 126: // macOS Down
-    return 0x51;
-  case 115: // macOS Help
-    return 0x49;
-  case 118: // macOS Delete
-    return 0x4C;
-  case 104: // macOS F11
-    return 0x44;
-  case 112: // macOS F12
-    return 0x45;
-  case 111: // macOS F13 (Help/Insert on some, or just F13)
-    return 0x65;
-  default:
-    LOG_DEBUG2("BridgeScreen: unmapped button code %u", button);
-    return 0;
-  }
-#else
-  switch (button) {
-  case 10: // Linux '1'
-  case 90: // Linux '1' (alt?)
-    return convertKeyID('1');
-  case 11: // Linux '2'
-    return convertKeyID('2');
-  case 12: // Linux '3'
-    return convertKeyID('3');
-  case 13: // Linux '4'
-    return convertKeyID('4');
-  case 14: // Linux '5'
-    return convertKeyID('5');
-  case 15: // Linux '6'
-    return convertKeyID('6');
-  case 16: // Linux '7'
-    return convertKeyID('7');
-  case 17: // Linux '8'
-    return convertKeyID('8');
-  case 18: // Linux '9'
-    return convertKeyID('9');
-  case 19: // Linux '0'
-    return convertKeyID('0');
-  case 20: // Linux '-'
-    return 0x2d;
-  case 21: // Linux '='
-    return 0x2e;
-  case 22: // Linux Backspace
-    return 0x2a;
-  case 23: // Linux Tab
-    return 0x2b;
-  case 24: // Linux 'q'
-    return convertKeyID('q');
-  case 25: // Linux 'w'
-    return convertKeyID('w');
-  case 26: // Linux 'e'
-    return convertKeyID('e');
-  case 27: // Linux 'r'
-    return convertKeyID('r');
-  case 28: // Linux 't'
-    return convertKeyID('t');
-  case 29: // Linux 'y'
-    return convertKeyID('y');
-  case 30: // Linux 'u'
-    return convertKeyID('u');
-  case 31: // Linux 'i'
-    return convertKeyID('i');
-  case 32: // Linux 'o'
-    return convertKeyID('o');
-  case 33: // Linux 'p'
-    return convertKeyID('p');
-  case 34: // Linux '['
-    return 0x2f;
-  case 35: // Linux ']'
-    return 0x30;
-  case 36: // Linux Enter
-    return 0x28;
-  case 38: // Linux 'a'
-    return convertKeyID('a');
-  case 39: // Linux 's'
-    return convertKeyID('s');
-  case 40: // Linux 'd'
-    return convertKeyID('d');
-  case 41: // Linux 'f'
-    return convertKeyID('f');
-  case 42: // Linux 'g'
-    return convertKeyID('g');
-  case 43: // Linux 'h'
-    return convertKeyID('h');
-  case 44: // Linux 'j'
-    return convertKeyID('j');
-  case 45: // Linux 'k'
-    return convertKeyID('k');
-  case 46: // Linux 'l'
-    return convertKeyID('l');
-  case 47: // Linux ';'
-    return 0x33;
-  case 48: // Linux '\''
-    return 0x34;
-  case 49: // Linux '`'
-    return 0x35;
-  case 51: // Linux '\'
-    return 0x31;
-  case 52: // Linux 'z'
-    return convertKeyID('z');
-  case 53: // Linux 'x'
-    return convertKeyID('x');
-  case 54: // Linux 'c'
-    return convertKeyID('c');
-  case 55: // Linux 'v'
-    return convertKeyID('v');
-  case 56: // Linux 'b'
-    return convertKeyID('b');
-  case 57: // Linux 'n'
-    return convertKeyID('n');
-  case 58: // Linux 'm'
-    return convertKeyID('m');
-  case 59: // Linux ','
-    return 0x36;
-  case 60: // Linux '.'
-    return 0x37;
-  case 61: // Linux '/'
-    return 0x38;
-  case 65: // Linux Space
-    return 0x2c;
-  case 66: // Linux CapsLock
-    return 0x39;
-  case 67: // Linux F1
-    return 0x3A;
-  case 68: // Linux F2
-    return 0x3B;
-  case 69: // Linux F3
-    return 0x3C;
-  case 70: // Linux F4
-    return 0x3D;
-  case 71: // Linux F5
-    return 0x3E;
-  case 72: // Linux F6
-    return 0x3F;
-  case 73: // Linux F7
-    return 0x40;
-  case 74: // Linux F8
-    return 0x41;
-  case 75: // Linux F9
-    return 0x42;
-  case 76: // Linux F10
-    return 0x43;
-  case 77: // Linux NumLock
-    return 0x53;
-  case 78: // Linux ScrollLock
-    return 0x47;
-  case 107: // Linux PrintScreen
-    return 0x46;
-  case 111: // Linux Up
-    return 0x52;
-  case 113: // Linux Left
-    return 0x50;
-  case 114: // Linux Right
-    return 0x4F;
-  case 116: // Linux Down
-    return 0x51;
-  case 118: // Linux Insert
-    return 0x49;
-  case 119: // Linux Delete
-    return 0x4C;
-  case 127: // Linux Pause
-    return 0x48;
-  case 95: // Linux F11
-    return 0x44;
-  case 96: // Linux F12
-    return 0x45;
-  case 135: // Linux Menu
-    return 0x65;
-  default:
+  const uint8_t usage = hidUsageForKeyButton(button);
+  if (usage == 0) {
     LOG_DEBUG2("BridgeScreen: unmapped button code %u", button);
-    return 0;
   }
-#endif
+  return usage;
 }
 
 uint8_t BridgePlatformScreen::convertKey(KeyID id, KeyButton button) const
@@ -1300,18 +1054,22 @@ uint8_t BridgePlatformScreen::convertButtonID(ButtonID id) const
   return static_cast<uint8_t>(id);
 }
 
-void BridgePlatformScreen::handleKeepAliveTimer(const Event &event) const
+void BridgePlatformScreen::handleTimer(const Event &event) const
 {
   if (event.getTarget() != this) {
     return;
   }
 
   const auto *timerEvent = static_cast<IEventQueue::TimerEvent *>(event.getData());
-  if (timerEvent == nullptr || timerEvent->m_timer != m_keepAliveTimer) {
+  if (timerEvent == nullptr) {
     return;
   }
 
-  sendKeepAliveIfIdle();
+  if (timerEvent->m_timer == m_keepAliveTimer) {
+    sendKeepAliveIfIdle();
+  } else if (timerEvent->m_timer == m_latencyReportTimer) {
+    InputLatency::instance().report();
+  }
 }
 
 void BridgePlatformScreen::startKeepAliveTimer()
@@ -1341,7 +1099,17 @@ void BridgePlatformScreen::sendKeepAliveIfIdle() const
     return;
   }
 
+  if (CLOG->getFilter() >= LogLevel::Debug) {
+    const auto stats = m_txQueue->stats();
+    LOG_DEBUG(
+        "BridgeScreen: tx queue depth=%zu max=%zu sent=%llu batches=%llu coalesced=%llu", stats.depth,
+        stats.maxDepth, static_cast<unsigned long long>(stats.eventsSent),
+        static_cast<unsigned long long>(stats.batches), static_cast<unsigned long long>(stats.coalesced)
+    );
+  }
+
   uint32_t uptimeSeconds = 0;
+  auto transportLock = m_txQueue->lockTransport();
   if (m_transport->sendKeepAlive(uptimeSeconds)) {
     LOG_INFO("BridgeScreen: keep-alive ack uptime=%us", static_cast<unsigned>(uptimeSeconds));
     recordCdcCommand(now);
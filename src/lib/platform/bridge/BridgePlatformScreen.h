@@ -5,12 +5,17 @@
 #pragma once
 
 #include "CdcTransport.h"
+#include "DigitizerMapping.h"
+#include "HidRecording.h"
+#include "HidTxQueue.h"
 #include "deskflow/PlatformScreen.h"
 
 #include <chrono>
 #include <cstdint>
+#include <initializer_list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 
 class Event;
@@ -28,13 +33,15 @@ namespace deskflow::bridge {
  * - Screen dimensions are provided by the GUI/CLI (mobile device screen)
  * - Clipboard operations are discarded
  * - Input events are converted to HID reports and sent via CDC
+ *
+ * @p bluetoothKeepAlive overrides the bridge/BluetoothKeepAlive setting for this screen.
  */
 class BridgePlatformScreen : public PlatformScreen
 {
 public:
   BridgePlatformScreen(
       IEventQueue *events, std::shared_ptr<CdcTransport> transport, int32_t screenWidth, int32_t screenHeight,
-      bool invertScroll
+      bool invertScroll, std::optional<bool> bluetoothKeepAlive = std::nullopt
   );
   ~BridgePlatformScreen() override;
 
@@ -61,6 +68,8 @@ public:
   void fakeMouseMove(int32_t x, int32_t y) override;
   void fakeMouseRelativeMove(int32_t dx, int32_t dy) const override;
   void fakeMouseWheel(int32_t xDelta, int32_t yDelta) const override;
+  void fakeInputBatchBegin() const override;
+  void fakeInputFlush() const override;
 
   // IKeyState overrides
   void fakeKeyDown(KeyID id, KeyModifierMask mask, KeyButton button, const std::string &lang) override;
@@ -100,11 +109,16 @@ protected:
   void handleSystemEvent(const Event &event) override;
 
 private:
-  bool sendEvent(HidEventType type, const std::vector<uint8_t> &payload) const;
+  bool sendEvent(HidEventType type, std::initializer_list<uint8_t> payload) const;
+  bool sendEvent(const HidEventPacket &packet) const;
   bool sendKeyboardEvent(HidEventType type, uint8_t modifiers, uint8_t keycode) const;
-  bool sendMouseMoveEvent(int16_t dx, int16_t dy) const;
+  bool sendKeyboardReport(uint8_t modifiers, uint8_t toggledKey = 0) const;
+  bool sendMouseMoveEvent(int32_t dx, int32_t dy) const;
+  bool sendMouseAbsoluteEvent(int32_t x, int32_t y) const;
   bool sendMouseButtonEvent(HidEventType type, uint8_t buttonMask) const;
   bool sendMouseScrollEvent(int8_t delta) const;
+  bool sendMousePanEvent(int8_t delta) const;
+  bool sendMouseScrollHiResEvent(int16_t vertical, int16_t horizontal) const;
   bool sendConsumerControlEvent(HidEventType type, uint16_t usageCode) const;
 
   uint8_t convertModifiers(KeyModifierMask mask) const;
@@ -117,15 +131,17 @@ private:
   uint8_t convertButtonID(ButtonID id) const;
   uint8_t activeModifierBitmap() const;
   void resetMouseAccumulator() const;
+  void applyPointerMode(const DeviceProfile &profile);
 
   void recordCdcCommand(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const;
-  void handleKeepAliveTimer(const Event &event) const;
+  void handleTimer(const Event &event) const;
   void startKeepAliveTimer();
   void stopKeepAliveTimer();
   void sendKeepAliveIfIdle() const;
 
   std::shared_ptr<CdcTransport> m_transport;
-  int32_t m_screenWidth = 0;
+  std::unique_ptr<HidTxQueue> m_txQueue;
+  int32_t m_screenWidth = 0; // from the active profile once it is loaded
   int32_t m_screenHeight = 0;
   IEventQueue *m_events = nullptr;
 
@@ -133,6 +149,8 @@ private:
   int32_t m_cursorX = 0;
   int32_t m_cursorY = 0;
   uint8_t m_mouseButtons = 0; // HID button bitmap
+  bool m_absolutePointer = false; // digitizer reports instead of relative motion, per profile
+  DigitizerMapping m_digitizer;
 
   std::set<KeyButton> m_pressedButtons;
   std::map<KeyButton, uint16_t> m_pressedConsumerControls; // button -> consumer code
@@ -144,6 +162,8 @@ private:
   std::map<KeyButton, ActiveKeyState> m_buttonToActiveKey;
   uint8_t m_currentHidModifiers = 0;
   KeyModifierMask m_activeModifiers = 0;
+  bool m_keyboardReports = false; // send whole keyboard reports instead of key transitions
+  ScrollMode m_scrollMode = ScrollMode::Vertical;
 
   bool m_enabled = false;
   uint32_t m_sequenceNumber = 0;
@@ -153,6 +173,12 @@ private:
   void *m_keepAliveTimer = nullptr;
   bool m_bluetoothKeepAliveEnabled = false;
 
+  // Periodic input latency report, off when the interval is zero
+  EventQueueTimer *m_latencyReportTimer = nullptr;
+
+  // Trace of every HID event handed to the queue, when a record directory is configured
+  std::unique_ptr<HidRecorder> m_recorder;
+
   // Scroll accumulation
   mutable int32_t m_wheelAccumulatorX = 0;
   mutable int32_t m_wheelAccumulatorY = 0;
@@ -0,0 +1,206 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "BridgeStatusChannel.h"
+
+#include "base/Event.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "common/BridgeStatus.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+
+#include <utility>
+
+namespace deskflow::bridge {
+
+BridgeStatusChannel &BridgeStatusChannel::instance()
+{
+  static BridgeStatusChannel s_instance;
+  return s_instance;
+}
+
+BridgeStatusChannel::~BridgeStatusChannel() = default;
+
+bool BridgeStatusChannel::connectToServer(const QString &serverName)
+{
+  std::scoped_lock lock(m_mutex);
+  m_socket = std::make_unique<QLocalSocket>();
+  m_socket->connectToServer(serverName, QIODevice::ReadWrite);
+  if (!m_socket->waitForConnected(kConnectTimeoutMs)) {
+    LOG_WARN("status: failed to connect to %s: %s", qPrintable(serverName), qPrintable(m_socket->errorString()));
+    m_socket.reset();
+    return false;
+  }
+  m_owner = std::this_thread::get_id();
+  m_queued.clear();
+  LOG_DEBUG("status: connected to %s", qPrintable(serverName));
+  return true;
+}
+
+void BridgeStatusChannel::disconnectFromServer()
+{
+  std::scoped_lock lock(m_mutex);
+  if (m_socket != nullptr) {
+    m_socket->flush();
+    m_socket->disconnectFromServer();
+    m_socket.reset();
+  }
+  m_queued.clear();
+}
+
+bool BridgeStatusChannel::isConnected() const
+{
+  std::scoped_lock lock(m_mutex);
+  return m_socket != nullptr;
+}
+
+void BridgeStatusChannel::setEventQueue(IEventQueue *events)
+{
+  IEventQueue *previous = nullptr;
+  bool pending = false;
+  {
+    std::scoped_lock lock(m_mutex);
+    previous = std::exchange(m_events, events);
+    m_posted = false;
+    pending = !m_queued.empty();
+  }
+
+  if (previous != nullptr) {
+    previous->removeHandler(EventTypes::BridgeStatusQueued, this);
+  }
+  if (events != nullptr) {
+    events->addHandler(EventTypes::BridgeStatusQueued, this, [this](const Event &) { writeQueued(); });
+    if (pending) {
+      std::scoped_lock lock(m_mutex);
+      m_posted = true;
+      events->addEvent(Event(EventTypes::BridgeStatusQueued, this));
+    }
+  }
+}
+
+void BridgeStatusChannel::connected(const QString &devicePath)
+{
+  send(BridgeStatus::kConnected, devicePath, {});
+}
+
+void BridgeStatusChannel::handshakeCompleted(const QString &devicePath, const FirmwareConfig &config)
+{
+  if (!config.deviceName.empty()) {
+    send(BridgeStatus::kDeviceName, devicePath, {{BridgeStatus::kNameKey, QString::fromStdString(config.deviceName)}});
+  }
+  send(
+      BridgeStatus::kActivation, devicePath,
+      {{BridgeStatus::kStateKey, QString::fromUtf8(config.activationStateString())},
+       {BridgeStatus::kProfileKey, config.activeProfile}}
+  );
+  send(BridgeStatus::kBle, devicePath, {{BridgeStatus::kConnectedKey, config.isBleConnected}});
+}
+
+void BridgeStatusChannel::handshakeFailed(
+    const QString &devicePath, CdcTransport::HandshakeFailure failure, const std::string &message
+)
+{
+  QString reason;
+  switch (failure) {
+    using enum CdcTransport::HandshakeFailure;
+  case Authentication:
+    reason = BridgeStatus::kReasonAuthentication;
+    break;
+  case Timeout:
+    reason = BridgeStatus::kReasonTimeout;
+    break;
+  default:
+    reason = BridgeStatus::kReasonError;
+    break;
+  }
+  send(
+      BridgeStatus::kHandshakeFailed, devicePath,
+      {{BridgeStatus::kReasonKey, reason}, {BridgeStatus::kMessageKey, QString::fromStdString(message)}}
+  );
+}
+
+std::vector<QJsonObject> BridgeStatusChannel::readCommands()
+{
+  std::vector<QJsonObject> commands;
+  std::scoped_lock lock(m_mutex);
+  if (m_socket == nullptr || std::this_thread::get_id() != m_owner) {
+    return commands;
+  }
+
+  // No Qt event loop runs here, so take in whatever has arrived by polling
+  while (m_socket->waitForReadyRead(0)) {
+  }
+  while (m_socket->canReadLine()) {
+    QJsonParseError error;
+    const auto document = QJsonDocument::fromJson(m_socket->readLine(), &error);
+    if (!document.isObject()) {
+      LOG_WARN("status: ignoring malformed command: %s", qPrintable(error.errorString()));
+      continue;
+    }
+    commands.push_back(document.object());
+  }
+  return commands;
+}
+
+void BridgeStatusChannel::send(const QString &event, const QString &devicePath, QJsonObject fields)
+{
+  fields.insert(BridgeStatus::kEventKey, event);
+  fields.insert(BridgeStatus::kDeviceKey, devicePath);
+  QByteArray line = QJsonDocument(fields).toJson(QJsonDocument::Compact);
+  line.append('\n');
+
+  std::scoped_lock lock(m_mutex);
+  if (m_socket == nullptr) {
+    return;
+  }
+
+  if (std::this_thread::get_id() == m_owner) {
+    // Keep the order: anything queued from other threads was sent first
+    for (const auto &queued : std::exchange(m_queued, {})) {
+      write(queued);
+    }
+    write(line);
+    return;
+  }
+
+  // The socket is not this thread's to use, so leave the line to the owner
+  if (m_queued.size() >= kMaxQueuedLines) {
+    LOG_WARN("status: dropping %s event, the event loop is not writing", qPrintable(event));
+    return;
+  }
+  m_queued.push_back(std::move(line));
+  if (m_events != nullptr && !m_posted) {
+    m_posted = true;
+    m_events->addEvent(Event(EventTypes::BridgeStatusQueued, this));
+  }
+}
+
+void BridgeStatusChannel::writeQueued()
+{
+  std::scoped_lock lock(m_mutex);
+  m_posted = false;
+  for (const auto &line : std::exchange(m_queued, {})) {
+    write(line);
+  }
+}
+
+void BridgeStatusChannel::write(const QByteArray &line)
+{
+  if (m_socket == nullptr) {
+    return;
+  }
+
+  const bool written = m_socket->write(line) == line.size() && m_socket->flush();
+  if (!written && (m_socket->bytesToWrite() == 0 || !m_socket->waitForBytesWritten(kWriteTimeoutMs))) {
+    // The GUI went away; carry on without it rather than stalling input on every event
+    LOG_WARN("status: write failed, closing channel: %s", qPrintable(m_socket->errorString()));
+    m_socket->abort();
+    m_socket.reset();
+  }
+}
+
+} // namespace deskflow::bridge
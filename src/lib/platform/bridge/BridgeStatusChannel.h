@@ -0,0 +1,87 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "CdcTransport.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class IEventQueue;
+class QJsonObject;
+class QLocalSocket;
+
+namespace deskflow::bridge {
+
+/**
+ * @brief Pushes typed bridge status events to the GUI
+ *
+ * The GUI listens on a local socket and passes its name with --status-socket; events are written
+ * as one JSON object per line (see common/BridgeStatus.h), tagged with the link device so a
+ * process hosting several bridges can share the channel. Until connected, every event is dropped.
+ *
+ * The socket belongs to the thread that connected, which runs the event loop. Events from that
+ * thread are written straight away; events from any other thread, such as a handshake on the HID
+ * writer thread, are queued and posted to the event loop given to setEventQueue(), which writes
+ * them in order. Writes block for at most kWriteTimeoutMs.
+ *
+ * A process hosting several bridges also reads commands from the GUI on the same socket.
+ */
+class BridgeStatusChannel
+{
+public:
+  static BridgeStatusChannel &instance();
+
+  ~BridgeStatusChannel();
+
+  bool connectToServer(const QString &serverName);
+  void disconnectFromServer();
+  bool isConnected() const;
+
+  /**
+   * @brief Event loop running on the connecting thread, to hand events from other threads to
+   *
+   * Until one is set, such events wait for the next event sent from the connecting thread.
+   * @param events Event queue, or null to stop posting to it
+   */
+  void setEventQueue(IEventQueue *events);
+
+  void connected(const QString &devicePath);
+  void handshakeCompleted(const QString &devicePath, const FirmwareConfig &config);
+  void handshakeFailed(const QString &devicePath, CdcTransport::HandshakeFailure failure, const std::string &message);
+
+  /**
+   * @brief Commands the GUI sent since the last call, without waiting for more
+   *
+   * Only the connecting thread reads; from any other thread this returns nothing.
+   */
+  std::vector<QJsonObject> readCommands();
+
+private:
+  static constexpr int kConnectTimeoutMs = 1000;
+  static constexpr int kWriteTimeoutMs = 100;
+  static constexpr size_t kMaxQueuedLines = 64;
+
+  BridgeStatusChannel() = default;
+
+  void send(const QString &event, const QString &devicePath, QJsonObject fields);
+  void writeQueued();
+  void write(const QByteArray &line);
+
+  mutable std::mutex m_mutex;
+  std::unique_ptr<QLocalSocket> m_socket;
+  std::thread::id m_owner;
+  IEventQueue *m_events = nullptr;
+  std::vector<QByteArray> m_queued; // from other threads, waiting for the owner to write them
+  bool m_posted = false;            // an event to write m_queued is on its way
+};
+
+} // namespace deskflow::bridge
@@ -3,6 +3,7 @@
  */
 
 #include "CdcTransport.h"
+#include "BridgeStatusChannel.h"
 #include "platform/OpenSSLCompat.h"
 
 #include "base/Log.h"
@@ -14,12 +15,13 @@
 #include <chrono>
 #include <cstring>
 #include <iomanip>
-#include <mutex>
+#include <limits>
+#include <memory>
 #include <random>
 #include <sstream>
-#include <thread>
 
 #include <openssl/core_names.h>
+#include <openssl/crypto.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/obj_mac.h>
@@ -31,6 +33,7 @@
 #if defined(Q_OS_UNIX)
 #include <cerrno>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/stat.h>
 #include <termios.h>
 #include <unistd.h>
@@ -46,27 +49,59 @@ namespace deskflow::bridge {
 namespace {
 constexpr uint16_t kUsbLinkMagic = 0xC35A; // USB Control Link Constants
 constexpr uint8_t kUsbLinkVersion = 0x01;
+constexpr size_t kUsbFrameHeaderSize = 8;
+static_assert(
+    kUsbLinkMagic == LinkFrameParser::kMagic && kUsbLinkVersion == LinkFrameParser::kVersion &&
+    kUsbFrameHeaderSize == LinkFrameParser::kHeaderSize
+);
 constexpr uint8_t kAuthModeNone = 0x00;
 
 constexpr uint8_t kAuthModeEcdsa = 0x02; // New mode
+constexpr uint8_t kAuthModeTicket = 0x03; // Resume with a session ticket, the ACK tag is an HMAC
 constexpr uint8_t kUsbFrameTypeHid = 0x01;
 constexpr uint8_t kUsbFrameTypeHidMouseCompact = 0x02;
 constexpr uint8_t kUsbFrameTypeHidKeyCompact = 0x03;
 constexpr uint8_t kUsbFrameTypeHidMouseButtonCompact = 0x04;
 constexpr uint8_t kUsbFrameTypeHidScrollCompact = 0x05;
+// Batch frame: flags = record count, payload = records of [frame type, flags, length, payload...]
+constexpr uint8_t kUsbFrameTypeHidBatch = 0x06;
+// Keyboard state frame: modifiers then the pressed keys; empty trailing key slots are not sent
+constexpr uint8_t kUsbFrameTypeHidKeyboardReport = 0x07;
+constexpr uint8_t kUsbFrameTypeHidPanCompact = 0x08;
+constexpr uint8_t kUsbFrameTypeHidScrollHiRes = 0x09;
+constexpr uint8_t kUsbFrameTypeHidAbsoluteCompact = 0x0A;
+constexpr size_t kHidBatchRecordHeaderSize = 3;
+constexpr size_t kHidBatchMaxPayload = 120; // Whole batch frame stays within two full-speed USB packets
+constexpr size_t kInlineFrameCapacity = kUsbFrameHeaderSize + kHidBatchMaxPayload; // Assembled on the stack
 constexpr uint8_t kUsbFrameTypeControl = 0x80;
 
+// Compact frames carry the bare HID payload; press/release is signalled in the link header flags
+constexpr uint8_t kCompactFlagPress = 0x01;
+constexpr uint8_t kProtocolVersionCompactHid = 2; // First firmware protocol accepting compact frames
+constexpr uint8_t kProtocolVersionHidBatch = 3;   // First firmware protocol accepting batch frames
+constexpr uint8_t kProtocolVersionSessionTicket = 4; // First firmware protocol issuing session tickets
+constexpr uint8_t kProtocolVersionFlowControl = 5;   // First firmware protocol granting HID credits
+constexpr uint8_t kProtocolVersionKeyboardReport = 6; // First firmware protocol accepting keyboard state frames
+constexpr uint8_t kProtocolVersionHorizontalScroll = 7; // First firmware protocol accepting AC Pan frames
+constexpr uint8_t kProtocolVersionHiResScroll = 8;      // First firmware protocol accepting hi-res scroll frames
+constexpr uint8_t kProtocolVersionAbsolutePointer = 9;  // First firmware protocol with a digitizer interface
+
 constexpr uint8_t kUsbControlHello = 0x01;
 constexpr uint8_t kUsbControlKeepAlive = 0x09;
 
 constexpr uint8_t kUsbControlAck = 0x81;
 constexpr uint8_t kUsbControlConfigResponse = 0x82;
+// Unsolicited: [0x83, reports consumed u32 LE, window u16 LE], sent after the ACK and whenever
+// the firmware has forwarded queued reports
+constexpr uint8_t kUsbControlCreditUpdate = 0x83;
+constexpr size_t kCreditUpdatePayloadSize = 7;
 
 constexpr uint8_t kUsbConfigGetDeviceName = 0x02;
 constexpr uint8_t kUsbConfigSetDeviceName = 0x03;
 constexpr uint8_t kUsbConfigGetSerialNumber = 0x04;
 constexpr uint8_t kUsbConfigActivateDevice = 0x07;
 constexpr uint8_t kUsbConfigGotoFactory = 0x08;
+constexpr uint8_t kUsbConfigIssueTicket = 0x0A;
 constexpr uint8_t kUsbControlUnpairAll = 0x30;
 constexpr uint8_t kUsbControlSwitchProfile = 0x31;
 constexpr uint8_t kUsbControlGetProfile = 0x32;
@@ -86,10 +121,17 @@ constexpr size_t kAckBleConnectionIndex = 8;
 constexpr size_t kAckMinimumPayloadSize = 1 + kAckCoreLen;
 
 constexpr int kHandshakeTimeoutMs = 2000; // 2000ms needed for Linux stability (slow device enumeration)
-constexpr int kReadPollIntervalMs = 10;
+constexpr int kHandshakeAttempts = 2;      // a dropped session ticket costs one extra, full handshake
+constexpr int kWriteTimeoutMs = 1000;
 constexpr int kConfigCommandTimeoutMs = 1000;
 constexpr int kKeepAliveTimeoutMs = 1000;
+// Profile requests in flight at once; bounded so a burst never overruns the firmware RX buffer
+constexpr size_t kMaxPipelinedRequests = 4;
+// Frames kept for the next reader while the writer waits for credits; more means nobody is reading
+constexpr size_t kMaxHeldFrames = 16;
 constexpr size_t kMaxDeviceNameBytes = 22;
+// Upper bound on what we accept from the firmware, so a ticket never outlives a short replug window
+constexpr auto kMaxTicketLifetime = std::chrono::minutes(5);
 
 constexpr size_t kAuthNonceBytes = 32;
 constexpr size_t kAuthTagBytes = 64; // Signature size (R+S)
@@ -139,8 +181,8 @@ std::string hexDump(const uint8_t *data, size_t length, size_t maxBytes = 64)
   return oss.str();
 }
 
-// Helper to append a DER integer
-void appendDerInteger(std::vector<uint8_t> &der, const uint8_t *data, size_t len)
+// Helper to append a DER integer, returns the new write offset
+size_t appendDerInteger(std::span<uint8_t> der, size_t offset, const uint8_t *data, size_t len)
 {
   // Skip leading zeros
   while (len > 0 && *data == 0) {
@@ -150,45 +192,180 @@ void appendDerInteger(std::vector<uint8_t> &der, const uint8_t *data, size_t len
 
   if (len == 0) {
     // Zero is encoded as 02 01 00
-    der.push_back(0x02);
-    der.push_back(0x01);
-    der.push_back(0x00);
-    return;
+    der[offset++] = 0x02;
+    der[offset++] = 0x01;
+    der[offset++] = 0x00;
+    return offset;
   }
 
-  der.push_back(0x02); // INTEGER tag
+  der[offset++] = 0x02; // INTEGER tag
 
   // If MSB is set, prepend 0x00 to make it positive
   if (data[0] & 0x80) {
-    der.push_back(static_cast<uint8_t>(len + 1));
-    der.push_back(0x00);
+    der[offset++] = static_cast<uint8_t>(len + 1);
+    der[offset++] = 0x00;
   } else {
-    der.push_back(static_cast<uint8_t>(len));
+    der[offset++] = static_cast<uint8_t>(len);
   }
 
-  der.insert(der.end(), data, data + len);
+  std::copy(data, data + len, der.begin() + offset);
+  return offset + len;
 }
 
-bool verifySignature(
-    const uint8_t *hostNonce, const uint8_t *deviceNonce, const uint8_t *ackCore, const uint8_t *signature
+/**
+ * Map a HID event onto its compact frame. Mouse moves shrink to one signed byte per axis when
+ * the deltas fit, which the firmware tells apart by payload length.
+ * Returns the number of payload bytes written to out, or 0 for event types without a compact form.
+ */
+size_t encodeCompactHidEvent(const HidEventPacket &packet, uint8_t &frameType, uint8_t &flags, std::span<uint8_t> out)
+{
+  const auto payload = packet.payload();
+  flags = 0;
+  switch (packet.type) {
+  case HidEventType::MouseMove: {
+    if (payload.size() != 4) {
+      return 0;
+    }
+    const auto dx = static_cast<int16_t>(payload[0] | (payload[1] << 8));
+    const auto dy = static_cast<int16_t>(payload[2] | (payload[3] << 8));
+    frameType = kUsbFrameTypeHidMouseCompact;
+    if (dx >= INT8_MIN && dx <= INT8_MAX && dy >= INT8_MIN && dy <= INT8_MAX) {
+      out[0] = static_cast<uint8_t>(dx);
+      out[1] = static_cast<uint8_t>(dy);
+      return 2;
+    }
+    break;
+  }
+  case HidEventType::KeyboardPress:
+  case HidEventType::KeyboardRelease:
+    frameType = kUsbFrameTypeHidKeyCompact;
+    flags = packet.type == HidEventType::KeyboardPress ? kCompactFlagPress : 0;
+    break;
+  case HidEventType::MouseButtonPress:
+  case HidEventType::MouseButtonRelease:
+    frameType = kUsbFrameTypeHidMouseButtonCompact;
+    flags = packet.type == HidEventType::MouseButtonPress ? kCompactFlagPress : 0;
+    break;
+  case HidEventType::MouseScroll:
+    frameType = kUsbFrameTypeHidScrollCompact;
+    break;
+  case HidEventType::MousePan:
+    frameType = kUsbFrameTypeHidPanCompact;
+    break;
+  case HidEventType::MouseScrollHiRes:
+    frameType = kUsbFrameTypeHidScrollHiRes;
+    break;
+  case HidEventType::MouseAbsolute:
+    frameType = kUsbFrameTypeHidAbsoluteCompact;
+    break;
+  case HidEventType::KeyboardReport: {
+    if (payload.size() != kKeyboardReportSize || out.size() < kKeyboardReportSize - 1) {
+      return 0;
+    }
+    // Keys fill the report from the front, so the usual one or two held keys cost a byte each
+    size_t size = 1;
+    out[0] = payload[0];
+    for (size_t i = kKeyboardReportKeyOffset; i < payload.size() && payload[i] != 0; ++i) {
+      out[size++] = payload[i];
+    }
+    frameType = kUsbFrameTypeHidKeyboardReport;
+    return size;
+  }
+  default:
+    return 0;
+  }
+
+  if (payload.empty() || payload.size() > out.size()) {
+    return 0;
+  }
+  std::copy(payload.begin(), payload.end(), out.begin());
+  return payload.size();
+}
+
+/**
+ * Encode one event in its per-event frame form: compact when allowed and available, else legacy.
+ * Returns the payload size written to out, or 0 if the event could not be serialized.
+ */
+size_t encodeHidEvent(
+    const HidEventPacket &packet, bool allowCompact, uint8_t &frameType, uint8_t &flags, std::span<uint8_t> out
 )
+{
+  if (allowCompact) {
+    if (const size_t size = encodeCompactHidEvent(packet, frameType, flags, out); size != 0) {
+      return size;
+    }
+  }
+  frameType = kUsbFrameTypeHid;
+  flags = 0;
+  return packet.serialize(out);
+}
+
+const char *scrollModeToString(ScrollMode mode)
+{
+  switch (mode) {
+  case ScrollMode::Vertical:
+    return "vertical";
+  case ScrollMode::Horizontal:
+    return "horizontal";
+  case ScrollMode::HighResolution:
+    return "high-resolution";
+  default:
+    return "unknown";
+  }
+}
+
+const char *hidEncodingToString(HidEncoding encoding)
+{
+  switch (encoding) {
+  case HidEncoding::Legacy:
+    return "legacy";
+  case HidEncoding::Compact:
+    return "compact";
+  case HidEncoding::Batch:
+    return "batch";
+  default:
+    return "unknown";
+  }
+}
+
+// Milliseconds left until the deadline, rounded up so a sub-millisecond remainder still waits
+int remainingMs(std::chrono::steady_clock::time_point deadline)
+{
+  const auto remaining = deadline - std::chrono::steady_clock::now();
+  if (remaining <= std::chrono::steady_clock::duration::zero()) {
+    return 0;
+  }
+  return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+}
+
+struct EvpPkeyDeleter
+{
+  void operator()(EVP_PKEY *key) const
+  {
+    EVP_PKEY_free(key);
+  }
+};
+
+struct EvpMdCtxDeleter
+{
+  void operator()(EVP_MD_CTX *ctx) const
+  {
+    EVP_MD_CTX_free(ctx);
+  }
+};
+
+using EvpMdCtxPtr = std::unique_ptr<EVP_MD_CTX, EvpMdCtxDeleter>;
+
+std::shared_ptr<EVP_PKEY> loadPublicKey(std::span<const uint8_t> publicKey)
 {
   deskflow::platform::initializeOpenSSL();
 
-  // 1. Reconstruct Message
-  std::vector<uint8_t> msg;
-  msg.reserve(sizeof(kAckLabel) + kAuthNonceBytes + kAuthNonceBytes + kAckCoreLen);
-  // Reconstruct message: HostNonce || DeviceNonce
-  // Firmware only signs the concatenated nonces
-  msg.insert(msg.end(), hostNonce, hostNonce + kAuthNonceBytes);
-  msg.insert(msg.end(), deviceNonce, deviceNonce + kAuthNonceBytes); // 2. Load Public Key (EVP_PKEY)
-  // 2. Load Public Key (Via DER SubjectPublicKeyInfo)
+  // Load Public Key (Via DER SubjectPublicKeyInfo)
   // Construct the ASN.1 structure manually to avoid provider parameter issues.
   // Sequence (id-ecPublicKey, prime256v1), BitString (0x04 | X | Y)
-  const uint8_t *pubKeyData = kDevicePublicKey;
-  if (sizeof(kDevicePublicKey) != 65 || kDevicePublicKey[0] != 0x04) {
+  if (publicKey.size() != 65 || publicKey[0] != 0x04) {
     LOG_ERR("CDC: Invalid public key format (expected 65 bytes with 0x04 prefix)");
-    return false;
+    return nullptr;
   }
 
   // OIDs:
@@ -203,60 +380,91 @@ bool verifySignature(
       0x00                                                        // Unused bits padding
   };
 
-  std::vector<uint8_t> derKey;
-  derKey.reserve(sizeof(kDerHeader) + 65);
-  derKey.insert(derKey.end(), kDerHeader, kDerHeader + sizeof(kDerHeader));
-  derKey.insert(derKey.end(), pubKeyData, pubKeyData + 65);
+  std::array<uint8_t, sizeof(kDerHeader) + 65> derKey;
+  std::copy(std::begin(kDerHeader), std::end(kDerHeader), derKey.begin());
+  std::copy(publicKey.begin(), publicKey.end(), derKey.begin() + sizeof(kDerHeader));
 
   const uint8_t *p = derKey.data();
-  EVP_PKEY *pkey = d2i_PUBKEY(nullptr, &p, static_cast<long>(derKey.size()));
-
+  std::shared_ptr<EVP_PKEY> pkey(d2i_PUBKEY(nullptr, &p, static_cast<long>(derKey.size())), EvpPkeyDeleter());
   if (!pkey) {
     char errBuf[256];
     ERR_error_string_n(ERR_peek_last_error(), errBuf, sizeof(errBuf));
     LOG_ERR("CDC: Failed to load public key via d2i_PUBKEY: %s", errBuf);
-    return false;
   }
+  return pkey;
+}
 
-  // 3. Convert Raw Signature (R||S) to DER
-  // Signature is 64 bytes: 32 bytes R, 32 bytes S
-  if (kAuthTagBytes != 64) {
-    LOG_ERR("CDC: Unexpected signature size definition");
-    EVP_PKEY_free(pkey);
-    return false;
+std::shared_ptr<EVP_PKEY> builtInDeviceKey()
+{
+  static const std::shared_ptr<EVP_PKEY> builtIn = loadPublicKey(kDevicePublicKey);
+  return builtIn;
+}
+
+/**
+ * Digest context set up for the device key, so a handshake only pays for the verification.
+ * Each thread keeps a template initialised for the last key it verified with and copies it
+ * into its working context, since a context cannot be reused after a one-shot verify.
+ */
+EVP_MD_CTX *acquireVerifyContext(const std::shared_ptr<EVP_PKEY> &pkey)
+{
+  if (!pkey) {
+    return nullptr;
+  }
+
+  thread_local std::shared_ptr<EVP_PKEY> initialisedFor;
+  thread_local EvpMdCtxPtr initialised;
+  thread_local EvpMdCtxPtr working;
+  if (initialisedFor != pkey) {
+    EvpMdCtxPtr ctx(EVP_MD_CTX_new());
+    if (!ctx || EVP_DigestVerifyInit(ctx.get(), nullptr, EVP_sha256(), nullptr, pkey.get()) != 1) {
+      LOG_ERR("CDC: Failed to set up ECDSA verification context");
+      return nullptr;
+    }
+    initialised = std::move(ctx);
+    initialisedFor = pkey;
+    if (!working) {
+      working.reset(EVP_MD_CTX_new());
+    }
   }
 
+  if (!working || EVP_MD_CTX_copy_ex(working.get(), initialised.get()) != 1) {
+    LOG_ERR("CDC: Failed to copy ECDSA verification context");
+    return nullptr;
+  }
+  return working.get();
+}
+
+bool verifySignature(
+    const std::shared_ptr<EVP_PKEY> &pkey, const uint8_t *hostNonce, const uint8_t *deviceNonce, const uint8_t *ackCore, const uint8_t *signature
+)
+{
+  // 1. Reconstruct Message
+  // Firmware only signs the concatenated nonces: HostNonce || DeviceNonce
+  std::array<uint8_t, kAuthNonceBytes * 2> msg;
+  std::copy(hostNonce, hostNonce + kAuthNonceBytes, msg.begin());
+  std::copy(deviceNonce, deviceNonce + kAuthNonceBytes, msg.begin() + kAuthNonceBytes);
+
+  // 2. Convert Raw Signature (R||S) to DER
+  // Signature is 64 bytes: 32 bytes R, 32 bytes S
+  static_assert(kAuthTagBytes == 64, "Unexpected signature size definition");
   const uint8_t *r = signature;
   const uint8_t *s = signature + 32;
 
-  std::vector<uint8_t> derSig;
-  // Sequence content
-  std::vector<uint8_t> seqContent;
-  appendDerInteger(seqContent, r, 32);
-  appendDerInteger(seqContent, s, 32);
+  // SEQUENCE header plus two INTEGERs of at most 33 bytes each (tag, length, sign padding)
+  // Short length form (< 128 bytes) is always enough for P-256 signatures
+  std::array<uint8_t, 2 + 2 * (2 + 33)> derSig;
+  size_t derSize = appendDerInteger(derSig, 2, r, 32);
+  derSize = appendDerInteger(derSig, derSize, s, 32);
+  derSig[0] = 0x30; // SEQUENCE
+  derSig[1] = static_cast<uint8_t>(derSize - 2);
 
-  // Sequence Header
-  derSig.push_back(0x30); // SEQUENCE
-  // Assuming short length form (< 128 bytes) which is true for P-256 sigs (~70 bytes)
-  derSig.push_back(static_cast<uint8_t>(seqContent.size()));
-  derSig.insert(derSig.end(), seqContent.begin(), seqContent.end());
-
-  // 4. Verify
-  EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+  // 3. Verify
+  EVP_MD_CTX *mdctx = acquireVerifyContext(pkey);
   if (!mdctx) {
-    LOG_ERR("CDC: Failed to create MD_CTX");
-    EVP_PKEY_free(pkey);
     return false;
   }
 
-  int ret = EVP_DigestVerifyInit(mdctx, nullptr, EVP_sha256(), nullptr, pkey);
-  if (ret > 0) {
-    ret = EVP_DigestVerify(mdctx, derSig.data(), derSig.size(), msg.data(), msg.size());
-  }
-
-  EVP_MD_CTX_free(mdctx);
-  EVP_PKEY_free(pkey);
-
+  const int ret = EVP_DigestVerify(mdctx, derSig.data(), derSize, msg.data(), msg.size());
   if (ret != 1) {
     LOG_ERR("CDC: ECDSA verification failed (ret=%d)", ret);
     return false;
@@ -264,9 +472,38 @@ bool verifySignature(
 
   return true;
 }
+
+/**
+ * A resumed session is authenticated by an HMAC over the same nonces, keyed with the ticket key
+ * that the firmware handed out over a verified session. The ACK core is covered too, so the
+ * reported configuration cannot be altered.
+ */
+bool verifyTicketTag(
+    const SessionTicket &ticket, const uint8_t *hostNonce, const uint8_t *deviceNonce, const uint8_t *ackCore,
+    const uint8_t *tag
+)
+{
+  std::array<uint8_t, sizeof(kAckLabel) + kAuthNonceBytes * 2 + kAckCoreLen> msg;
+  auto out = std::copy(std::begin(kAckLabel), std::end(kAckLabel), msg.begin());
+  out = std::copy(hostNonce, hostNonce + kAuthNonceBytes, out);
+  out = std::copy(deviceNonce, deviceNonce + kAuthNonceBytes, out);
+  std::copy(ackCore, ackCore + kAckCoreLen, out);
+
+  std::array<uint8_t, 32> expected;
+  size_t expectedSize = 0;
+  if (EVP_Q_mac(
+          nullptr, "HMAC", nullptr, "SHA256", nullptr, ticket.key.data(), ticket.key.size(), msg.data(), msg.size(),
+          expected.data(), expected.size(), &expectedSize
+      ) == nullptr ||
+      expectedSize != expected.size()) {
+    LOG_ERR("CDC: failed to compute session ticket HMAC");
+    return false;
+  }
+  return CRYPTO_memcmp(expected.data(), tag, expected.size()) == 0;
+}
 } // namespace
 
-CdcTransport::CdcTransport(const QString &devicePath) : m_devicePath(devicePath)
+CdcTransport::CdcTransport(const QString &devicePath) : m_devicePath(devicePath), m_trustedKey(builtInDeviceKey())
 {
   resetState();
 }
@@ -280,11 +517,21 @@ void CdcTransport::resetState()
 {
   m_handshakeComplete = false;
   m_isSecure = false;
+  m_isResumed = false;
   m_hostNonce.fill(0);
   m_hasHostNonce = false;
-  m_rxBuffer.clear();
+  m_rxParser.reset();
+  m_heldFrames.clear();
   m_hasDeviceConfig = false;
   m_deviceConfig = FirmwareConfig{};
+  m_hidEncoding = HidEncoding::Legacy;
+  m_hasFlowControl = false;
+  m_hasKeyboardReport = false;
+  m_scrollMode = ScrollMode::Vertical;
+  m_hasAbsolutePointer = false;
+  m_hidReportsSent = 0;
+  m_hidReportsConsumed = 0;
+  m_hidCreditWindow = 0;
 }
 
 bool CdcTransport::ensureOpen(bool allowInsecure)
@@ -294,7 +541,7 @@ bool CdcTransport::ensureOpen(bool allowInsecure)
       return true;
     }
     // If open but handshake not complete, try to complete it
-    return performHandshake(allowInsecure);
+    return handshake(allowInsecure);
   }
   // If not open, try to open and perform handshake
   if (!open(allowInsecure)) {
@@ -309,7 +556,7 @@ bool CdcTransport::open(bool allowInsecure)
     if (m_handshakeComplete) {
       return true;
     }
-    return performHandshake(allowInsecure);
+    return handshake(allowInsecure);
   }
 
 #if defined(Q_OS_UNIX)
@@ -344,7 +591,7 @@ bool CdcTransport::open(bool allowInsecure)
 #elif defined(Q_OS_WIN)
   HANDLE handle = CreateFileW(
       reinterpret_cast<LPCWSTR>(m_devicePath.utf16()), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
-      FILE_ATTRIBUTE_NORMAL, nullptr
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr
   );
 
   if (handle == INVALID_HANDLE_VALUE) {
@@ -379,11 +626,13 @@ bool CdcTransport::open(bool allowInsecure)
     return false;
   }
 
+  // MAXDWORD interval + multiplier makes ReadFile complete as soon as at least one byte is available.
+  // The caller bounds every overlapped operation with its own deadline and cancels it on timeout.
   COMMTIMEOUTS timeouts = {0};
-  timeouts.ReadIntervalTimeout = 50;
-  timeouts.ReadTotalTimeoutConstant = 100;
-  timeouts.ReadTotalTimeoutMultiplier = 10;
-  timeouts.WriteTotalTimeoutConstant = 1000;
+  timeouts.ReadIntervalTimeout = MAXDWORD;
+  timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+  timeouts.ReadTotalTimeoutConstant = kHandshakeTimeoutMs;
+  timeouts.WriteTotalTimeoutConstant = kWriteTimeoutMs;
   timeouts.WriteTotalTimeoutMultiplier = 10;
 
   if (!SetCommTimeouts(handle, &timeouts)) {
@@ -393,6 +642,15 @@ bool CdcTransport::open(bool allowInsecure)
     m_fd = -1;
     return false;
   }
+
+  m_readEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  m_writeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (m_readEvent == nullptr || m_writeEvent == nullptr) {
+    m_lastError = "Failed to create I/O events";
+    LOG_ERR("CDC: %s", m_lastError.c_str());
+    close();
+    return false;
+  }
 #else
   m_lastError = "CDC transport not implemented for this platform";
   return false;
@@ -400,7 +658,7 @@ bool CdcTransport::open(bool allowInsecure)
 
   LOG_INFO("CDC: opened device %s", m_devicePath.toUtf8().constData());
   resetState();
-  return performHandshake(allowInsecure);
+  return handshake(allowInsecure);
 }
 
 void CdcTransport::close()
@@ -415,6 +673,14 @@ void CdcTransport::close()
   ::close(m_fd);
 #elif defined(Q_OS_WIN)
   CloseHandle(reinterpret_cast<HANDLE>(m_fd));
+  if (m_readEvent != nullptr) {
+    CloseHandle(static_cast<HANDLE>(m_readEvent));
+    m_readEvent = nullptr;
+  }
+  if (m_writeEvent != nullptr) {
+    CloseHandle(static_cast<HANDLE>(m_writeEvent));
+    m_writeEvent = nullptr;
+  }
 #endif
 
   m_fd = -1;
@@ -427,6 +693,23 @@ bool CdcTransport::isOpen() const
   return m_fd != -1;
 }
 
+bool CdcTransport::handshake(bool allowInsecure)
+{
+  m_handshakeFailure = HandshakeFailure::None;
+  if (performHandshake(allowInsecure)) {
+    if (m_hasDeviceConfig) {
+      BridgeStatusChannel::instance().handshakeCompleted(m_devicePath, m_deviceConfig);
+    }
+    return true;
+  }
+
+  if (m_handshakeFailure == HandshakeFailure::None) {
+    m_handshakeFailure = HandshakeFailure::Error;
+  }
+  BridgeStatusChannel::instance().handshakeFailed(m_devicePath, m_handshakeFailure, m_lastError);
+  return false;
+}
+
 bool CdcTransport::performHandshake(bool allowInsecure)
 {
   if (!isOpen()) {
@@ -435,11 +718,41 @@ bool CdcTransport::performHandshake(bool allowInsecure)
     return false;
   }
 
+  for (int attempt = 0; attempt < kHandshakeAttempts; ++attempt) {
+    switch (attemptHandshake(allowInsecure)) {
+    case HandshakeAttempt::Completed:
+      return true;
+    case HandshakeAttempt::Failed:
+      return false;
+    case HandshakeAttempt::RetryWithoutTicket:
+      break;
+    }
+  }
+
+  m_lastError = "Handshake retries exhausted";
+  LOG_ERR("CDC: %s", m_lastError.c_str());
+  return false;
+}
+
+CdcTransport::HandshakeAttempt CdcTransport::attemptHandshake(bool allowInsecure)
+{
+  using enum HandshakeAttempt;
+
+  // Nothing from an earlier attempt may leak into this one
+  m_isSecure = false;
+  m_isResumed = false;
+  m_handshakeComplete = false;
+
   quint32 tempNonce[kAuthNonceBytes / sizeof(quint32)];
   QRandomGenerator::global()->fillRange(tempNonce);
   std::memcpy(m_hostNonce.data(), tempNonce, kAuthNonceBytes);
   m_hasHostNonce = true;
 
+  std::optional<SessionTicket> ticket;
+  if (!allowInsecure && m_ticketCache != nullptr) {
+    ticket = m_ticketCache->find(m_devicePath.toStdString());
+  }
+
   std::vector<uint8_t> payload(1 + kHelloPayloadLen);
   payload[0] = kUsbControlHello;
   payload[1] = kUsbLinkVersion;
@@ -447,6 +760,12 @@ bool CdcTransport::performHandshake(bool allowInsecure)
   if (allowInsecure) {
     payload[2] = kAuthModeNone;
     std::memcpy(payload.data() + 3, m_hostNonce.data(), kAuthNonceBytes);
+  } else if (ticket.has_value()) {
+    // The host nonce is already random; the ticket id goes where a signature would
+    payload[2] = kAuthModeTicket;
+    std::memcpy(payload.data() + 3, m_hostNonce.data(), kAuthNonceBytes);
+    std::memset(payload.data() + 3 + kAuthNonceBytes, 0, kAuthTagBytes);
+    std::memcpy(payload.data() + 3 + kAuthNonceBytes, ticket->id.data(), ticket->id.size());
   } else {
     payload[2] = kAuthModeEcdsa; // Request ECDSA
     // Randomize Host Nonce
@@ -461,19 +780,15 @@ bool CdcTransport::performHandshake(bool allowInsecure)
   }
 
   if (!sendUsbFrame(kUsbFrameTypeControl, 0, payload)) {
-    return false;
+    return Failed;
   }
 
-  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kHandshakeTimeoutMs);
-  while (std::chrono::steady_clock::now() < deadline) {
-    uint8_t type = 0;
-    uint8_t flags = 0;
-    std::vector<uint8_t> framePayload;
-    if (!readFrame(type, flags, framePayload, kReadPollIntervalMs)) {
-      continue;
-    }
-
-    if (type != kUsbFrameTypeControl || framePayload.empty()) {
+  const auto deadline = Clock::now() + std::chrono::milliseconds(kHandshakeTimeoutMs);
+  LinkFrame frame;
+  while (readFrame(frame, deadline)) {
+    // Points into the receive buffer, so it is only used until the next read
+    const auto framePayload = frame.payload;
+    if (frame.type != kUsbFrameTypeControl || framePayload.empty()) {
       continue;
     }
 
@@ -481,13 +796,13 @@ bool CdcTransport::performHandshake(bool allowInsecure)
       if (!m_hasHostNonce) {
         m_lastError = "Handshake host nonce not initialized";
         LOG_ERR("CDC: %s", m_lastError.c_str());
-        return false;
+        return Failed;
       }
 
       if (framePayload.size() < kAckTotalPayloadWithId) {
         m_lastError = "Handshake ACK payload too short";
         LOG_ERR("CDC: %s (size=%zu)", m_lastError.c_str(), framePayload.size());
-        return false;
+        return Failed;
       }
 
       const uint8_t *ackCore = framePayload.data() + 1;
@@ -495,11 +810,21 @@ bool CdcTransport::performHandshake(bool allowInsecure)
       const uint8_t *ackTag = framePayload.data() + kAckTagOffset;
 
       // Verify tag (only if not in insecure mode and auth was requested)
-      if (!allowInsecure) {
-        if (!verifySignature(m_hostNonce.data(), deviceNonce, ackCore, ackTag)) {
+      if (ticket.has_value()) {
+        if (!verifyTicketTag(*ticket, m_hostNonce.data(), deviceNonce, ackCore, ackTag)) {
+          // The firmware no longer knows the ticket (rebooted, expired, or another device on this path)
+          LOG_INFO("CDC: session ticket rejected, running full handshake");
+          m_ticketCache->erase(m_devicePath.toStdString());
+          return RetryWithoutTicket;
+        }
+        m_isSecure = true;
+        m_isResumed = true;
+      } else if (!allowInsecure) {
+        if (!verifySignature(m_trustedKey, m_hostNonce.data(), deviceNonce, ackCore, ackTag)) {
           m_lastError = "Handshake authentication failed.";
+          m_handshakeFailure = HandshakeFailure::Authentication;
           LOG_ERR("CDC: %s", m_lastError.c_str());
-          return false;
+          return Failed;
         }
         m_isSecure = true;
       } else {
@@ -538,6 +863,23 @@ bool CdcTransport::performHandshake(bool allowInsecure)
         }
 
         m_hasDeviceConfig = true;
+        if (protocolVersion >= kProtocolVersionHidBatch) {
+          m_hidEncoding = HidEncoding::Batch;
+        } else if (protocolVersion >= kProtocolVersionCompactHid) {
+          m_hidEncoding = HidEncoding::Compact;
+        } else {
+          m_hidEncoding = HidEncoding::Legacy;
+        }
+        m_hasFlowControl = protocolVersion >= kProtocolVersionFlowControl;
+        m_hasKeyboardReport = protocolVersion >= kProtocolVersionKeyboardReport;
+        m_hasAbsolutePointer = protocolVersion >= kProtocolVersionAbsolutePointer;
+        if (protocolVersion >= kProtocolVersionHiResScroll) {
+          m_scrollMode = ScrollMode::HighResolution;
+        } else if (protocolVersion >= kProtocolVersionHorizontalScroll) {
+          m_scrollMode = ScrollMode::Horizontal;
+        } else {
+          m_scrollMode = ScrollMode::Vertical;
+        }
 
         LOG_INFO(
             "CDC: handshake completed version=%u activation_state=%s(%u) fw_bcd=%u hw_bcd=%u fw_mode=%u "
@@ -548,6 +890,18 @@ bool CdcTransport::performHandshake(bool allowInsecure)
             m_deviceConfig.totalProfiles, m_deviceConfig.isBleConnected ? "YES" : "NO",
             m_deviceConfig.hasOtaPartition ? "YES" : "NO"
         );
+        LOG_INFO(
+            "CDC: HID encoding=%s flow control=%s keyboard report=%s scroll=%s absolute pointer=%s",
+            hidEncodingToString(m_hidEncoding), m_hasFlowControl ? "YES" : "NO", m_hasKeyboardReport ? "YES" : "NO",
+            scrollModeToString(m_scrollMode), m_hasAbsolutePointer ? "YES" : "NO"
+        );
+
+        if (m_isResumed) {
+          // Both were read when the ticket was issued
+          m_deviceConfig.deviceName = ticket->deviceName;
+          LOG_INFO("CDC: session resumed from ticket, device name='%s'", ticket->deviceName.c_str());
+          return Completed;
+        }
 
         std::string fetchedName;
         if (fetchDeviceName(fetchedName)) {
@@ -567,18 +921,88 @@ bool CdcTransport::performHandshake(bool allowInsecure)
           LOG_WARN("CDC: failed to read serial number: %s", m_lastError.c_str());
           m_lastError.clear();
         }
+
+        if (m_isSecure && m_ticketCache != nullptr && protocolVersion >= kProtocolVersionSessionTicket &&
+            !requestSessionTicket()) {
+          LOG_WARN("CDC: failed to obtain session ticket: %s", m_lastError.c_str());
+          m_lastError.clear();
+        }
         LOG_DEBUG("CDC: performHandshake finished success");
       } else {
         LOG_WARN("CDC: handshake ACK missing metadata (payload=%zu)", framePayload.size());
         LOG_INFO("CDC: handshake completed");
       }
-      return true;
+      return Completed;
     }
   }
 
+  if (Clock::now() < deadline) {
+    LOG_ERR("CDC: handshake aborted: %s", m_lastError.c_str());
+    return Failed;
+  }
+
+  if (ticket.has_value()) {
+    LOG_INFO("CDC: no answer to session resumption, running full handshake");
+    m_ticketCache->erase(m_devicePath.toStdString());
+    return RetryWithoutTicket;
+  }
+
   m_lastError = "Timed out waiting for handshake ACK";
+  m_handshakeFailure = HandshakeFailure::Timeout;
   LOG_ERR("CDC: %s", m_lastError.c_str());
-  return false;
+  return Failed;
+}
+
+bool CdcTransport::setTrustedDeviceKey(std::span<const uint8_t> publicKey)
+{
+  auto pkey = loadPublicKey(publicKey);
+  if (!pkey) {
+    return false;
+  }
+  m_trustedKey = std::move(pkey);
+  return true;
+}
+
+bool CdcTransport::requestSessionTicket()
+{
+  std::array<uint8_t, 1> payload = {kUsbConfigIssueTicket};
+  if (!sendUsbFrame(kUsbFrameTypeControl, 0, payload)) {
+    return false;
+  }
+
+  uint8_t msgType = 0;
+  uint8_t status = 0;
+  std::vector<uint8_t> data;
+  if (!waitForConfigResponse(msgType, status, data, kConfigCommandTimeoutMs)) {
+    return false;
+  }
+  if (msgType != kUsbConfigIssueTicket) {
+    m_lastError = "Unexpected config response";
+    return false;
+  }
+  if (status != 0) {
+    m_lastError = "Firmware error code " + std::to_string(status);
+    return false;
+  }
+
+  // Response: [TicketId(16), TicketKey(32), Lifetime seconds(2, LE)]
+  SessionTicket ticket;
+  if (data.size() < ticket.id.size() + ticket.key.size() + 2) {
+    m_lastError = "Invalid session ticket size";
+    return false;
+  }
+  std::copy_n(data.begin(), ticket.id.size(), ticket.id.begin());
+  std::copy_n(data.begin() + ticket.id.size(), ticket.key.size(), ticket.key.begin());
+  const size_t lifetimeOffset = ticket.id.size() + ticket.key.size();
+  const auto lifetime = std::min<std::chrono::seconds>(
+      std::chrono::seconds(data[lifetimeOffset] | (data[lifetimeOffset + 1] << 8)), kMaxTicketLifetime
+  );
+  ticket.expiresAt = std::chrono::system_clock::now() + lifetime;
+  ticket.deviceName = m_deviceConfig.deviceName;
+
+  m_ticketCache->store(m_devicePath.toStdString(), ticket);
+  LOG_DEBUG("CDC: stored session ticket valid for %llds", static_cast<long long>(lifetime.count()));
+  return true;
 }
 
 bool CdcTransport::sendHidEvent(const HidEventPacket &packet)
@@ -587,60 +1011,223 @@ bool CdcTransport::sendHidEvent(const HidEventPacket &packet)
     return false;
   }
 
-  auto payload = packet.serialize();
-  if (payload.empty()) {
+  std::array<uint8_t, HidEventPacket::kMaxSerializedSize> buffer;
+  uint8_t frameType = 0;
+  uint8_t flags = 0;
+  const size_t size = encodeHidEvent(packet, m_hidEncoding != HidEncoding::Legacy, frameType, flags, buffer);
+  if (size == 0) {
     m_lastError = "Failed to serialize HID event";
     return false;
   }
 
-  return sendUsbFrame(kUsbFrameTypeHid, 0, payload);
+  size_t credits = 0;
+  if (!acquireHidCredits(credits) || !sendUsbFrame(frameType, flags, std::span<const uint8_t>(buffer.data(), size))) {
+    return false;
+  }
+  ++m_hidReportsSent;
+  return true;
+}
+
+bool CdcTransport::sendHidEvents(std::span<const HidEventPacket> packets)
+{
+  if (m_hidEncoding != HidEncoding::Batch || packets.size() < 2) {
+    for (const auto &packet : packets) {
+      if (!sendHidEvent(packet)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (!ensureOpen()) {
+    return false;
+  }
+
+  std::array<uint8_t, kHidBatchMaxPayload> batch;
+  size_t used = 0;
+  uint8_t records = 0;
+  size_t credits = 0;
+  const auto sendBatch = [this, &batch, &used, &records] {
+    if (!sendUsbFrame(kUsbFrameTypeHidBatch, records, std::span<const uint8_t>(batch.data(), used))) {
+      return false;
+    }
+    m_hidReportsSent += records;
+    used = 0;
+    records = 0;
+    return true;
+  };
+
+  for (const auto &packet : packets) {
+    std::array<uint8_t, HidEventPacket::kMaxSerializedSize> event;
+    uint8_t frameType = 0;
+    uint8_t flags = 0;
+    const size_t size = encodeHidEvent(packet, true, frameType, flags, event);
+    if (size == 0) {
+      m_lastError = "Failed to serialize HID event";
+      return false;
+    }
+
+    // A frame never carries more reports than the firmware has room for
+    if (records > 0 && (used + kHidBatchRecordHeaderSize + size > batch.size() || records == credits)) {
+      if (!sendBatch()) {
+        return false;
+      }
+    }
+    if (records == 0 && !acquireHidCredits(credits)) {
+      return false;
+    }
+
+    batch[used++] = frameType;
+    batch[used++] = flags;
+    batch[used++] = static_cast<uint8_t>(size);
+    std::copy_n(event.begin(), size, batch.begin() + used);
+    used += size;
+    ++records;
+  }
+
+  return sendBatch();
+}
+
+int CdcTransport::waitForHidCredits(int timeoutMs)
+{
+  if (!m_hasFlowControl) {
+    return std::numeric_limits<int>::max();
+  }
+
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  auto readDeadline = Clock::now(); // take in updates that are already waiting before blocking
+  LinkFrame frame;
+  while (true) {
+    // Credit updates are applied by pollFrame; anything else is kept for the next readFrame
+    const int result = pollFrame(frame, readDeadline);
+    if (result < 0) {
+      return -1;
+    }
+    if (result > 0) {
+      if (!isCreditUpdate(frame)) {
+        holdFrame(frame);
+      }
+      readDeadline = Clock::now();
+      continue;
+    }
+
+    const size_t credits = hidCredits();
+    if (credits > 0 || Clock::now() >= deadline) {
+      return static_cast<int>(std::min<size_t>(credits, std::numeric_limits<int>::max()));
+    }
+    readDeadline = deadline;
+  }
+}
+
+size_t CdcTransport::hidCredits() const
+{
+  // Counters are free-running, so the difference stays right across wrap-around
+  const uint32_t inFlight = m_hidReportsSent - m_hidReportsConsumed;
+  return inFlight >= m_hidCreditWindow ? 0 : m_hidCreditWindow - inFlight;
+}
+
+bool CdcTransport::acquireHidCredits(size_t &credits)
+{
+  if (!m_hasFlowControl) {
+    credits = std::numeric_limits<size_t>::max();
+    return true;
+  }
+
+  credits = hidCredits();
+  if (credits > 0) {
+    return true;
+  }
+
+  const int granted = waitForHidCredits(kWriteTimeoutMs);
+  if (granted <= 0) {
+    if (granted == 0) {
+      m_lastError = "Timed out waiting for HID credits";
+    }
+    return false;
+  }
+  credits = static_cast<size_t>(granted);
+  return true;
+}
+
+void CdcTransport::holdFrame(const LinkFrame &frame)
+{
+  if (m_heldFrames.size() >= kMaxHeldFrames) {
+    LOG_WARN("CDC: discarding unread frame type=0x%02x", static_cast<unsigned>(m_heldFrames.front().type));
+    m_heldFrames.pop_front();
+  }
+  m_heldFrames.push_back({frame.type, frame.flags, {frame.payload.begin(), frame.payload.end()}});
+}
+
+void CdcTransport::applyCreditUpdate(std::span<const uint8_t> payload)
+{
+  m_hidReportsConsumed = static_cast<uint32_t>(payload[1]) | (static_cast<uint32_t>(payload[2]) << 8) |
+                         (static_cast<uint32_t>(payload[3]) << 16) | (static_cast<uint32_t>(payload[4]) << 24);
+  m_hidCreditWindow = static_cast<uint16_t>(payload[5] | (payload[6] << 8));
+  LOG_DEBUG2(
+      "CDC: credit update consumed=%u window=%u in flight=%u", m_hidReportsConsumed,
+      static_cast<unsigned>(m_hidCreditWindow), m_hidReportsSent - m_hidReportsConsumed
+  );
 }
 
 bool CdcTransport::sendUsbFrame(uint8_t type, uint8_t flags, const std::vector<uint8_t> &payload)
 {
-  return sendUsbFrame(type, flags, payload.data(), static_cast<uint16_t>(payload.size()));
+  return sendUsbFrame(type, flags, std::span<const uint8_t>(payload));
 }
 
 bool CdcTransport::sendUsbFrame(uint8_t type, uint8_t flags, const uint8_t *payload, uint16_t length)
+{
+  if (payload == nullptr) {
+    length = 0;
+  }
+  return sendUsbFrame(type, flags, std::span<const uint8_t>(payload, length));
+}
+
+bool CdcTransport::sendUsbFrame(uint8_t type, uint8_t flags, std::span<const uint8_t> payload)
 {
   if (!isOpen()) {
     m_lastError = "Device not open";
     return false;
   }
 
-  std::vector<uint8_t> frame;
-  frame.reserve(8 + length);
-
-  frame.push_back(static_cast<uint8_t>(kUsbLinkMagic & 0xFF));
-  frame.push_back(static_cast<uint8_t>((kUsbLinkMagic >> 8) & 0xFF));
-  frame.push_back(kUsbLinkVersion);
-  frame.push_back(type);
-  frame.push_back(flags);
-  frame.push_back(0); // reserved
-  frame.push_back(static_cast<uint8_t>(length & 0xFF));
-  frame.push_back(static_cast<uint8_t>((length >> 8) & 0xFF));
+  if (payload.size() > 0xFFFF) {
+    m_lastError = "USB frame payload too large";
+    return false;
+  }
+  const auto length = static_cast<uint16_t>(payload.size());
+  const size_t frameSize = kUsbFrameHeaderSize + length;
 
-  if (length > 0 && payload != nullptr) {
-    frame.insert(frame.end(), payload, payload + length);
+  // HID frames always fit on the stack; only large control payloads fall back to the heap
+  std::array<uint8_t, kInlineFrameCapacity> inlineFrame;
+  std::vector<uint8_t> heapFrame;
+  uint8_t *frame = inlineFrame.data();
+  if (frameSize > inlineFrame.size()) {
+    heapFrame.resize(frameSize);
+    frame = heapFrame.data();
   }
 
+  frame[0] = static_cast<uint8_t>(kUsbLinkMagic & 0xFF);
+  frame[1] = static_cast<uint8_t>((kUsbLinkMagic >> 8) & 0xFF);
+  frame[2] = kUsbLinkVersion;
+  frame[3] = type;
+  frame[4] = flags;
+  frame[5] = 0; // reserved
+  frame[6] = static_cast<uint8_t>(length & 0xFF);
+  frame[7] = static_cast<uint8_t>((length >> 8) & 0xFF);
+  std::copy(payload.begin(), payload.end(), frame + kUsbFrameHeaderSize);
+
   if (CLOG->getFilter() >= LogLevel::Debug) {
-    std::string frameHex = hexDump(frame.data(), frame.size(), 128);
+    std::string frameHex = hexDump(frame, frameSize, 128);
     if (!frameHex.empty()) {
       LOG_DEBUG(
           "CDC: TX frame type=0x%02x flags=0x%02x len=%u bytes=%s%s", type, flags, length, frameHex.c_str(),
-          frame.size() > 128 ? " ..." : ""
+          frameSize > 128 ? " ..." : ""
       );
     } else {
       LOG_DEBUG("CDC: TX frame type=0x%02x flags=0x%02x len=%u", type, flags, length);
     }
   }
 
-  if (!writeAll(frame.data(), frame.size())) {
-    return false;
-  }
-
-  return true;
+  return writeAll(frame, frameSize);
 }
 
 bool CdcTransport::sendKeepAlive(uint32_t &uptimeSeconds)
@@ -689,15 +1276,11 @@ bool CdcTransport::waitForConfigResponse(
     uint8_t &msgType, uint8_t &status, std::vector<uint8_t> &payload, int timeoutMs
 )
 {
-  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
-  while (std::chrono::steady_clock::now() < deadline) {
-    uint8_t frameType = 0;
-    uint8_t flags = 0;
-    std::vector<uint8_t> framePayload;
-    if (!readFrame(frameType, flags, framePayload, kReadPollIntervalMs)) {
-      continue;
-    }
-    if (frameType != kUsbFrameTypeControl || framePayload.empty() || framePayload[0] != kUsbControlConfigResponse) {
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  LinkFrame frame;
+  while (readFrame(frame, deadline)) {
+    const auto framePayload = frame.payload;
+    if (frame.type != kUsbFrameTypeControl || framePayload.empty() || framePayload[0] != kUsbControlConfigResponse) {
       continue;
     }
     if (framePayload.size() < 3) {
@@ -709,21 +1292,20 @@ bool CdcTransport::waitForConfigResponse(
     payload.assign(framePayload.begin() + 3, framePayload.end());
     return true;
   }
+  if (Clock::now() < deadline) {
+    return false; // I/O error, m_lastError already set by readFrame
+  }
   m_lastError = "Timed out waiting for config response";
   return false;
 }
 
 bool CdcTransport::waitForControlMessage(uint8_t controlId, std::vector<uint8_t> &payload, int timeoutMs)
 {
-  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
-  while (std::chrono::steady_clock::now() < deadline) {
-    uint8_t frameType = 0;
-    uint8_t flags = 0;
-    std::vector<uint8_t> framePayload;
-    if (!readFrame(frameType, flags, framePayload, kReadPollIntervalMs)) {
-      continue;
-    }
-    if (frameType != kUsbFrameTypeControl || framePayload.empty() || framePayload[0] != controlId) {
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  LinkFrame frame;
+  while (readFrame(frame, deadline)) {
+    const auto framePayload = frame.payload;
+    if (frame.type != kUsbFrameTypeControl || framePayload.empty() || framePayload[0] != controlId) {
       continue;
     }
 
@@ -731,6 +1313,10 @@ bool CdcTransport::waitForControlMessage(uint8_t controlId, std::vector<uint8_t>
     return true;
   }
 
+  if (Clock::now() < deadline) {
+    return false; // I/O error, m_lastError already set by readFrame
+  }
+
   std::ostringstream oss;
   oss << "Timed out waiting for control message 0x" << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
       << static_cast<unsigned>(controlId);
@@ -807,6 +1393,10 @@ bool CdcTransport::setDeviceName(const std::string &name)
   }
 
   m_deviceConfig.deviceName = name;
+  if (m_ticketCache != nullptr) {
+    // The ticket caches the old name; the next open does a full handshake and reads it again
+    m_ticketCache->erase(m_devicePath.toStdString());
+  }
   return true;
 }
 
@@ -1035,6 +1625,106 @@ bool CdcTransport::setProfile(uint8_t index, const DeviceProfile &profile)
   return true;
 }
 
+bool CdcTransport::getProfiles(uint8_t first, uint8_t count, std::vector<std::optional<DeviceProfile>> &outProfiles)
+{
+  outProfiles.assign(count, std::nullopt);
+  if (!ensureOpen()) {
+    return false;
+  }
+
+  return pipelineControlRequests(
+      count, "getProfile",
+      [first](size_t i, std::vector<uint8_t> &payload) {
+        payload = {kUsbControlGetProfile, static_cast<uint8_t>(first + i)};
+      },
+      [this, first, &outProfiles](size_t i, const std::vector<uint8_t> &response) {
+        // Response: [Status(1), ProfileData(52)]
+        if (response.size() < 1 + sizeof(DeviceProfile) || response[0] != 0) {
+          return true;
+        }
+        DeviceProfile profile;
+        std::memcpy(&profile, response.data() + 1, sizeof(DeviceProfile));
+        // A stray ACK would shift every later profile into the wrong slot
+        if (profile.slot != first + i) {
+          m_lastError = "Profile " + std::to_string(profile.slot) + " returned for slot " + std::to_string(first + i);
+          return false;
+        }
+        outProfiles[i] = profile;
+        return true;
+      }
+  );
+}
+
+bool CdcTransport::setProfiles(std::span<const std::pair<uint8_t, DeviceProfile>> profiles, std::vector<bool> &outOk)
+{
+  outOk.assign(profiles.size(), false);
+  if (!ensureOpen()) {
+    return false;
+  }
+
+  return pipelineControlRequests(
+      profiles.size(), "setProfile",
+      [profiles](size_t i, std::vector<uint8_t> &payload) {
+        // Payload: [Cmd(1), Index(1), ProfileData(52)]
+        payload.resize(2 + sizeof(DeviceProfile));
+        payload[0] = kUsbControlSetProfile;
+        payload[1] = profiles[i].first;
+        std::memcpy(payload.data() + 2, &profiles[i].second, sizeof(DeviceProfile));
+      },
+      [&outOk](size_t i, const std::vector<uint8_t> &response) {
+        outOk[i] = !response.empty() && response[0] == 0;
+        return true;
+      }
+  );
+}
+
+bool CdcTransport::pipelineControlRequests(
+    size_t count, const char *what, const std::function<void(size_t, std::vector<uint8_t> &)> &buildRequest,
+    const std::function<bool(size_t, const std::vector<uint8_t> &)> &onReply
+)
+{
+  // The firmware handles control frames one at a time in arrival order and the ACKs carry no
+  // request id, so replies are matched to requests by position
+  std::vector<uint8_t> payload;
+  size_t sent = 0;
+  size_t received = 0;
+  const auto abandon = [this, what, &payload, &sent, &received] {
+    // ACKs still on their way would answer whichever control command comes next. How many there are
+    // depends on whether a reply went missing or one too many arrived, so take them until the link
+    // goes quiet
+    const std::string error = m_lastError;
+    size_t drained = 0;
+    while (drained <= sent - received && waitForControlMessage(kUsbControlAck, payload, kConfigCommandTimeoutMs)) {
+      ++drained;
+    }
+    LOG_WARN("CDC: discarded %zu late %s response(s)", drained, what);
+    m_lastError = error;
+    return false;
+  };
+
+  for (; received < count; ++received) {
+    for (; sent < count && sent - received < kMaxPipelinedRequests; ++sent) {
+      buildRequest(sent, payload);
+      if (!sendUsbFrame(kUsbFrameTypeControl, 0, payload)) {
+        LOG_ERR("CDC: Failed to send %s command", what);
+        return abandon();
+      }
+    }
+
+    if (!waitForControlMessage(kUsbControlAck, payload, kConfigCommandTimeoutMs)) {
+      LOG_ERR("CDC: Timeout waiting for %s response %zu of %zu", what, received + 1, count);
+      return abandon();
+    }
+    if (!onReply(received, payload)) {
+      LOG_ERR(
+          "CDC: %s response %zu of %zu does not match its request (%s)", what, received + 1, count, m_lastError.c_str()
+      );
+      return abandon();
+    }
+  }
+  return true;
+}
+
 bool CdcTransport::switchProfile(uint8_t index)
 {
   if (!ensureOpen()) {
@@ -1123,100 +1813,188 @@ bool CdcTransport::eraseAllProfiles()
 
 bool CdcTransport::writeAll(const uint8_t *data, size_t length)
 {
+  const auto deadline = Clock::now() + std::chrono::milliseconds(kWriteTimeoutMs);
   size_t offset = 0;
   while (offset < length) {
-#if defined(Q_OS_UNIX)
-    ssize_t written = ::write(m_fd, data + offset, length - offset);
+    const int written = writeSome(data + offset, length - offset, deadline);
     if (written < 0) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(kReadPollIntervalMs));
-        continue;
-      }
-      m_lastError = "Failed to write to device: " + std::string(strerror(errno));
       return false;
     }
-    offset += static_cast<size_t>(written);
-#elif defined(Q_OS_WIN)
-    DWORD written = 0;
-    if (!WriteFile(
-            reinterpret_cast<HANDLE>(m_fd), data + offset, static_cast<DWORD>(length - offset), &written, nullptr
-        )) {
-      m_lastError = "Failed to write to device";
+    if (written == 0) {
+      m_lastError = "Timed out writing to device";
       return false;
     }
     offset += static_cast<size_t>(written);
-#else
-    m_lastError = "CDC transport not implemented for this platform";
-    return false;
-#endif
   }
   return true;
 }
 
-bool CdcTransport::readFrame(uint8_t &type, uint8_t &flags, std::vector<uint8_t> &payload, int timeoutMs)
+int CdcTransport::writeSome(const uint8_t *data, size_t length, Clock::time_point deadline)
 {
-  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
-
-  while (std::chrono::steady_clock::now() < deadline) {
-    if (m_rxBuffer.size() >= 8) {
-      uint16_t magic = static_cast<uint16_t>(m_rxBuffer[0]) | (static_cast<uint16_t>(m_rxBuffer[1]) << 8);
-      if (magic != kUsbLinkMagic) {
-        m_rxBuffer.erase(m_rxBuffer.begin());
-        continue;
-      }
-
-      uint8_t version = m_rxBuffer[2];
-      uint8_t frameType = m_rxBuffer[3];
-      uint8_t frameFlags = m_rxBuffer[4];
-      uint16_t length = static_cast<uint16_t>(m_rxBuffer[6]) | (static_cast<uint16_t>(m_rxBuffer[7]) << 8);
-
-      const size_t frameSize = 8 + length;
-      // LOG_INFO("CDC: readFrame magic=%04x len=%u size=%zu", magic, length, m_rxBuffer.size());
-      if (m_rxBuffer.size() < frameSize) {
-        // Need more data
-      } else {
-        // Complete frame
-        payload.assign(m_rxBuffer.begin() + 8, m_rxBuffer.begin() + 8 + length);
-        m_rxBuffer.erase(m_rxBuffer.begin(), m_rxBuffer.begin() + frameSize);
-
-        if (version != kUsbLinkVersion) {
-          continue;
-        }
+#if defined(Q_OS_UNIX)
+  while (true) {
+    const ssize_t written = ::write(m_fd, data, length);
+    if (written >= 0) {
+      return static_cast<int>(written);
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      m_lastError = "Failed to write to device: " + std::string(strerror(errno));
+      return -1;
+    }
 
-        type = frameType;
-        flags = frameFlags;
-        return true;
+    // Endpoint is backed up, sleep in the kernel until it drains rather than on a fixed tick
+    struct pollfd pfd = {static_cast<int>(m_fd), POLLOUT, 0};
+    const int ready = ::poll(&pfd, 1, remainingMs(deadline));
+    if (ready == 0) {
+      return 0;
+    }
+    if (ready < 0 && errno != EINTR) {
+      m_lastError = "Failed to poll device: " + std::string(strerror(errno));
+      return -1;
+    }
+    if (ready > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0) {
+      m_lastError = "Device disconnected";
+      return -1;
+    }
+  }
+#elif defined(Q_OS_WIN)
+  const auto handle = reinterpret_cast<HANDLE>(m_fd);
+  OVERLAPPED overlapped = {};
+  overlapped.hEvent = static_cast<HANDLE>(m_writeEvent);
+  ResetEvent(overlapped.hEvent);
+
+  DWORD written = 0;
+  if (!WriteFile(handle, data, static_cast<DWORD>(length), &written, &overlapped)) {
+    if (GetLastError() != ERROR_IO_PENDING) {
+      m_lastError = "Failed to write to device";
+      return -1;
+    }
+    if (WaitForSingleObject(overlapped.hEvent, static_cast<DWORD>(remainingMs(deadline))) != WAIT_OBJECT_0) {
+      CancelIo(handle);
+    }
+    if (!GetOverlappedResult(handle, &overlapped, &written, TRUE)) {
+      if (GetLastError() == ERROR_OPERATION_ABORTED) {
+        return 0;
       }
+      m_lastError = "Failed to write to device";
+      return -1;
     }
+  }
+  return static_cast<int>(written);
+#else
+  m_lastError = "CDC transport not implemented for this platform";
+  return -1;
+#endif
+}
 
-    uint8_t buffer[128];
+int CdcTransport::readSome(uint8_t *buffer, size_t capacity, Clock::time_point deadline)
+{
 #if defined(Q_OS_UNIX)
-    ssize_t bytesRead = ::read(m_fd, buffer, sizeof(buffer));
+  while (true) {
+    const ssize_t bytesRead = ::read(m_fd, buffer, capacity);
     if (bytesRead > 0) {
-      m_rxBuffer.insert(m_rxBuffer.end(), buffer, buffer + bytesRead);
-    } else if (bytesRead == 0) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(kReadPollIntervalMs));
-    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(kReadPollIntervalMs));
-    } else {
+      return static_cast<int>(bytesRead);
+    }
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
       m_lastError = "Failed to read from device: " + std::string(strerror(errno));
-      return false;
+      return -1;
+    }
+
+    // Nothing buffered: block until the device signals readability or the deadline passes
+    const int timeoutMs = remainingMs(deadline);
+    if (timeoutMs == 0) {
+      return 0;
+    }
+    struct pollfd pfd = {static_cast<int>(m_fd), POLLIN, 0};
+    const int ready = ::poll(&pfd, 1, timeoutMs);
+    if (ready == 0) {
+      return 0;
+    }
+    if (ready < 0 && errno != EINTR) {
+      m_lastError = "Failed to poll device: " + std::string(strerror(errno));
+      return -1;
+    }
+    // A hung-up tty stays readable but reads return 0, so readability alone does not rule it out
+    if (ready > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0 &&
+        ((pfd.revents & POLLIN) == 0 || bytesRead == 0)) {
+      m_lastError = "Device disconnected";
+      return -1;
     }
+  }
 #elif defined(Q_OS_WIN)
-    DWORD bytesRead = 0;
-    if (ReadFile(reinterpret_cast<HANDLE>(m_fd), buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
-      m_rxBuffer.insert(m_rxBuffer.end(), buffer, buffer + bytesRead);
-    } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(kReadPollIntervalMs));
+  const auto handle = reinterpret_cast<HANDLE>(m_fd);
+  OVERLAPPED overlapped = {};
+  overlapped.hEvent = static_cast<HANDLE>(m_readEvent);
+  ResetEvent(overlapped.hEvent);
+
+  DWORD bytesRead = 0;
+  if (!ReadFile(handle, buffer, static_cast<DWORD>(capacity), &bytesRead, &overlapped)) {
+    if (GetLastError() != ERROR_IO_PENDING) {
+      m_lastError = "Failed to read from device";
+      return -1;
+    }
+    if (WaitForSingleObject(overlapped.hEvent, static_cast<DWORD>(remainingMs(deadline))) != WAIT_OBJECT_0) {
+      CancelIo(handle);
     }
+    // Waits for the cancellation to settle; bytes that raced the cancel are still returned
+    if (!GetOverlappedResult(handle, &overlapped, &bytesRead, TRUE)) {
+      if (GetLastError() == ERROR_OPERATION_ABORTED) {
+        return 0;
+      }
+      m_lastError = "Failed to read from device";
+      return -1;
+    }
+  }
+  return static_cast<int>(bytesRead);
 #else
-    (void)buffer;
-    m_lastError = "CDC transport not implemented for this platform";
-    return false;
+  m_lastError = "CDC transport not implemented for this platform";
+  return -1;
 #endif
+}
+
+bool CdcTransport::readFrame(LinkFrame &frame, Clock::time_point deadline)
+{
+  if (!m_heldFrames.empty()) {
+    m_replayedFrame = std::move(m_heldFrames.front());
+    m_heldFrames.pop_front();
+    frame.type = m_replayedFrame.type;
+    frame.flags = m_replayedFrame.flags;
+    frame.payload = m_replayedFrame.payload;
+    return true;
   }
+  return pollFrame(frame, deadline) > 0;
+}
 
-  return false;
+bool CdcTransport::isCreditUpdate(const LinkFrame &frame)
+{
+  return frame.type == kUsbFrameTypeControl && frame.payload.size() >= kCreditUpdatePayloadSize &&
+         frame.payload[0] == kUsbControlCreditUpdate;
+}
+
+int CdcTransport::pollFrame(LinkFrame &frame, Clock::time_point deadline)
+{
+  while (true) {
+    if (auto next = m_rxParser.next()) {
+      frame = *next;
+      if (isCreditUpdate(frame)) {
+        applyCreditUpdate(frame.payload);
+      }
+      return 1;
+    }
+
+    const auto space = m_rxParser.writableSpace();
+    const int bytesRead = readSome(space.data(), space.size(), deadline);
+    if (bytesRead <= 0) {
+      return bytesRead;
+    }
+    m_rxParser.commit(static_cast<size_t>(bytesRead));
+  }
 }
 
 } // namespace deskflow::bridge
@@ -5,14 +5,25 @@
 #pragma once
 
 #include "HidFrame.h"
+#include "LinkFrameParser.h"
+#include "SessionTicketCache.h"
 
 #include <array>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <QString>
 
+struct evp_pkey_st;
+
 namespace deskflow::bridge {
 
 enum class ActivationState : uint8_t
@@ -45,6 +56,26 @@ inline const char *activationStateToString(ActivationState state)
   }
 }
 
+/**
+ * @brief Wire encoding used for HID events, negotiated from the ACK protocol version
+ */
+enum class HidEncoding : uint8_t
+{
+  Legacy = 0,  // kUsbFrameTypeHid carrying a serialized HidEventPacket (inner AA55 header)
+  Compact = 1, // Dedicated per-event frame types carrying only the HID payload
+  Batch = 2,   // Compact encoding, plus kUsbFrameTypeHidBatch frames carrying several events
+};
+
+/**
+ * @brief Wheel events the firmware accepts, negotiated from the ACK protocol version
+ */
+enum class ScrollMode : uint8_t
+{
+  Vertical = 0,       // MouseScroll in whole detents only
+  Horizontal = 1,     // MouseScroll and MousePan in whole detents
+  HighResolution = 2, // MouseScrollHiRes on both axes, in kHiResScrollUnitsPerDetent per detent
+};
+
 /**
  * @brief Device Profile structure (matches firmware layout)
  */
@@ -59,10 +90,14 @@ struct DeviceProfile
   uint8_t rotation;      // 0: Portrait, 1: Landscape
   uint8_t invert;        // scroll direction 0: no invert, 1: invert
   uint8_t speed;         // scroll speed  0: 120; default is 120
-  uint8_t reserved[11];  // reserved for future use, total size is 52 bytes
+  uint8_t pointerMode;   // kPointerModeRelative or kPointerModeAbsolute, zero on older firmware
+  uint8_t reserved[10];  // reserved for future use, total size is 52 bytes
 };
 #pragma pack(pop)
 
+constexpr uint8_t kPointerModeRelative = 0; // Relative mouse reports
+constexpr uint8_t kPointerModeAbsolute = 1; // Digitizer reports, see DigitizerMapping
+
 /**
  * @brief Firmware-reported configuration structure
  */
@@ -97,6 +132,17 @@ struct FirmwareConfig
 class CdcTransport
 {
 public:
+  /**
+   * @brief Why the last handshake failed
+   */
+  enum class HandshakeFailure
+  {
+    None,
+    Timeout,        // the firmware never acknowledged the hello
+    Authentication, // the acknowledgement did not verify, e.g. factory firmware
+    Error           // I/O or protocol error, see lastError()
+  };
+
   explicit CdcTransport(const QString &devicePath);
   ~CdcTransport();
 
@@ -117,6 +163,11 @@ public:
    */
   virtual bool isOpen() const;
 
+  const QString &devicePath() const
+  {
+    return m_devicePath;
+  }
+
   /**
    * @brief Check if connection is authenticated/secure
    */
@@ -125,12 +176,109 @@ public:
     return m_isSecure;
   }
 
+  /**
+   * @brief Check if the secure session was resumed from a session ticket
+   */
+  bool isResumed() const
+  {
+    return m_isResumed;
+  }
+
+  /**
+   * @brief Cache to resume recent sessions from, and to keep newly issued tickets in
+   *
+   * Without a cache every secure open() runs the full ECDSA handshake.
+   */
+  void setSessionTicketCache(std::shared_ptr<SessionTicketCache> cache)
+  {
+    m_ticketCache = std::move(cache);
+  }
+
+  /**
+   * @brief Verify this transport's device against another public key than the built-in one
+   *
+   * For firmware emulators and development boards flashed with their own key.
+   * Other transports keep the built-in key.
+   * @param publicKey Uncompressed P-256 point (0x04 | X | Y)
+   * @return false if the key could not be parsed, in which case the current key stays in place
+   */
+  bool setTrustedDeviceKey(std::span<const uint8_t> publicKey);
+
   /**
    * @brief Send HID event packet to firmware device
+   *
+   * Uses the compact frame types when the firmware negotiated them, falling back to
+   * the legacy wrapped packet for events that have no compact form.
    * @return true if successful
    */
   virtual bool sendHidEvent(const HidEventPacket &packet);
 
+  /**
+   * @brief Send several HID events, in order
+   *
+   * Packs the events into as few batch frames as possible when the firmware negotiated
+   * batching, otherwise sends them one frame each.
+   * @return true if all events were sent
+   */
+  virtual bool sendHidEvents(std::span<const HidEventPacket> packets);
+
+  /**
+   * @brief Whether the firmware grants HID credits, negotiated during the handshake
+   *
+   * With flow control the firmware advertises how many reports its BLE output queue can still
+   * take. Sending stops while there is no room, so input waits on the host, where motion can be
+   * coalesced, instead of piling up in USB and firmware buffers.
+   */
+  bool hasFlowControl() const
+  {
+    return m_hasFlowControl;
+  }
+
+  /**
+   * @brief Apply pending credit updates and wait until the firmware has room for a report
+   *
+   * Any other frame read meanwhile, such as a reply or a notification, is kept for whoever reads next.
+   * @param timeoutMs How long to block if there is no room; 0 only applies updates already received
+   * @return Reports that can be sent now, 0 on timeout, -1 on I/O error (lastError() is set);
+   *         INT_MAX without flow control
+   */
+  virtual int waitForHidCredits(int timeoutMs);
+
+  /**
+   * @brief Whether the firmware takes whole keyboard reports, negotiated during the handshake
+   *
+   * A KeyboardReport event carries the complete keyboard state, so a lost or reordered report is
+   * corrected by the next one and a chord released at once needs a single frame.
+   */
+  bool hasKeyboardReport() const
+  {
+    return m_hasKeyboardReport;
+  }
+
+  /**
+   * @brief Whether the firmware has a digitizer interface taking MouseAbsolute events
+   */
+  bool hasAbsolutePointer() const
+  {
+    return m_hasAbsolutePointer;
+  }
+
+  /**
+   * @brief Wheel events the firmware accepts, negotiated during the handshake
+   */
+  ScrollMode scrollMode() const
+  {
+    return m_scrollMode;
+  }
+
+  /**
+   * @brief HID wire encoding negotiated during the handshake
+   */
+  HidEncoding hidEncoding() const
+  {
+    return m_hidEncoding;
+  }
+
   bool fetchDeviceName(std::string &outName);
   bool setDeviceName(const std::string &name);
 
@@ -176,6 +324,27 @@ public:
    */
   bool setProfile(uint8_t index, const DeviceProfile &profile);
 
+  /**
+   * @brief Get consecutive profiles, pipelining the requests
+   *
+   * Requests are sent ahead of the replies, which the firmware answers in order, so reading
+   * every slot costs about one round-trip instead of one per profile.
+   * @param first Index of the first profile
+   * @param count Number of profiles to read
+   * @param outProfiles One entry per profile, empty where the firmware refused the request
+   * @return false if the exchange failed or a reply was for another slot; per-profile firmware
+   *         errors only leave an entry empty
+   */
+  bool getProfiles(uint8_t first, uint8_t count, std::vector<std::optional<DeviceProfile>> &outProfiles);
+
+  /**
+   * @brief Set several profiles, pipelining the requests
+   * @param profiles Index and data of each profile to write
+   * @param outOk One entry per profile, true where the firmware accepted it
+   * @return false if the exchange failed; per-profile firmware errors only clear an entry
+   */
+  bool setProfiles(std::span<const std::pair<uint8_t, DeviceProfile>> profiles, std::vector<bool> &outOk);
+
   /**
    * @brief Switch to a specific profile
    * @param index Profile index
@@ -204,6 +373,11 @@ public:
     return m_lastError;
   }
 
+  HandshakeFailure handshakeFailure() const
+  {
+    return m_handshakeFailure;
+  }
+
   /**
    * @brief Check whether the device provided configuration data during handshake
    */
@@ -232,26 +406,112 @@ private:
   static constexpr size_t kSignatureSize = 64; // R + S (32 bytes each)
   static constexpr size_t kAuthNonceSize = 32;
 
+  using Clock = std::chrono::steady_clock;
+
+  enum class HandshakeAttempt
+  {
+    Completed,
+    Failed,
+    RetryWithoutTicket // the session ticket was refused or went unanswered and has been dropped
+  };
+
+  bool handshake(bool allowInsecure);
   bool performHandshake(bool allowInsecure);
+  HandshakeAttempt attemptHandshake(bool allowInsecure);
+  bool requestSessionTicket();
+  bool sendUsbFrame(uint8_t type, uint8_t flags, std::span<const uint8_t> payload);
   bool sendUsbFrame(uint8_t type, uint8_t flags, const uint8_t *payload, uint16_t length);
   bool sendUsbFrame(uint8_t type, uint8_t flags, const std::vector<uint8_t> &payload);
   bool waitForConfigResponse(uint8_t &msgType, uint8_t &status, std::vector<uint8_t> &payload, int timeoutMs);
   bool waitForControlMessage(uint8_t controlId, std::vector<uint8_t> &payload, int timeoutMs);
+
+  /**
+   * @brief Send control requests with up to kMaxPipelinedRequests awaiting their ACK
+   * @param buildRequest Fills the control payload of request i
+   * @param onReply Receives the ACK payload of request i, returns false if it answers another request
+   * @return false if a request could not be sent, its ACK did not arrive or did not match; ACKs
+   *         still in flight are then read and discarded, so none answers a later command
+   */
+  bool pipelineControlRequests(
+      size_t count, const char *what, const std::function<void(size_t, std::vector<uint8_t> &)> &buildRequest,
+      const std::function<bool(size_t, const std::vector<uint8_t> &)> &onReply
+  );
   bool writeAll(const uint8_t *data, size_t length);
-  bool readFrame(uint8_t &type, uint8_t &flags, std::vector<uint8_t> &payload, int timeoutMs);
+
+  /**
+   * @brief Read the next frame, starting with any held back by waitForHidCredits()
+   *
+   * The frame payload stays valid until the next read.
+   */
+  bool readFrame(LinkFrame &frame, Clock::time_point deadline);
+
+  /**
+   * @brief Read the next frame, applying credit updates on the way
+   *
+   * The frame payload points into the receive buffer and stays valid until the next read.
+   * @return 1 when a frame was read, 0 on timeout, -1 on I/O error (m_lastError is set)
+   */
+  int pollFrame(LinkFrame &frame, Clock::time_point deadline);
+
+  static bool isCreditUpdate(const LinkFrame &frame);
+  size_t hidCredits() const;
+  bool acquireHidCredits(size_t &credits);
+  void applyCreditUpdate(std::span<const uint8_t> payload);
+  void holdFrame(const LinkFrame &frame);
+
+  /**
+   * @brief Read whatever the device has ready, blocking until data arrives or the deadline passes
+   * @return Bytes read, 0 on timeout, -1 on I/O error (m_lastError is set)
+   */
+  int readSome(uint8_t *buffer, size_t capacity, Clock::time_point deadline);
+
+  /**
+   * @brief Write as much as the device accepts, blocking until it is writable or the deadline passes
+   * @return Bytes written, 0 on timeout, -1 on I/O error (m_lastError is set)
+   */
+  int writeSome(const uint8_t *data, size_t length, Clock::time_point deadline);
+
   void resetState();
   bool ensureOpen(bool allowInsecure = false);
 
   QString m_devicePath;
   intptr_t m_fd = -1; // File descriptor (Unix) or HANDLE (Windows)
+#if defined(Q_OS_WIN)
+  void *m_readEvent = nullptr;  // Overlapped read completion event
+  void *m_writeEvent = nullptr; // Overlapped write completion event
+#endif
   bool m_handshakeComplete = false;
+  HandshakeFailure m_handshakeFailure = HandshakeFailure::None;
   bool m_isSecure = false;
+  bool m_isResumed = false;
+  std::shared_ptr<SessionTicketCache> m_ticketCache;
+  std::shared_ptr<evp_pkey_st> m_trustedKey; // Verifies the ECDSA handshake signature
   std::array<uint8_t, kAuthNonceSize> m_hostNonce{};
   bool m_hasHostNonce = false;
-  std::vector<uint8_t> m_rxBuffer;
+  LinkFrameParser m_rxParser;
+
+  // A frame copied out of the receive buffer
+  struct HeldFrame
+  {
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    std::vector<uint8_t> payload;
+  };
+  std::deque<HeldFrame> m_heldFrames; // read by waitForHidCredits(), not yet by readFrame()
+  HeldFrame m_replayedFrame;          // backs the payload readFrame() last returned from m_heldFrames
   std::string m_lastError;
   bool m_hasDeviceConfig = false;
   FirmwareConfig m_deviceConfig;
+  HidEncoding m_hidEncoding = HidEncoding::Legacy;
+  bool m_hasKeyboardReport = false;
+  ScrollMode m_scrollMode = ScrollMode::Vertical;
+  bool m_hasAbsolutePointer = false;
+
+  // HID flow control; report counters are free-running and compared modulo 2^32
+  bool m_hasFlowControl = false;
+  uint32_t m_hidReportsSent = 0;
+  uint32_t m_hidReportsConsumed = 0; // as last advertised by the firmware
+  uint16_t m_hidCreditWindow = 0;
 };
 
 } // namespace deskflow::bridge
@@ -0,0 +1,42 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "DigitizerMapping.h"
+
+#include <algorithm>
+
+namespace deskflow::bridge {
+
+DigitizerMapping::DigitizerMapping(int32_t screenWidth, int32_t screenHeight, uint8_t rotation)
+    : m_screenWidth(screenWidth),
+      m_screenHeight(screenHeight),
+      m_landscape(rotation != 0)
+{
+}
+
+void DigitizerMapping::map(int32_t x, int32_t y, uint16_t &logicalX, uint16_t &logicalY) const
+{
+  x = std::clamp(x, 0, (std::max)(m_screenWidth - 1, 0));
+  y = std::clamp(y, 0, (std::max)(m_screenHeight - 1, 0));
+
+  if (m_landscape) {
+    // The phone's x axis runs from the bottom of the screen to the top, its y axis left to right
+    logicalX = scale(m_screenHeight - 1 - y, m_screenHeight);
+    logicalY = scale(x, m_screenWidth);
+  } else {
+    logicalX = scale(x, m_screenWidth);
+    logicalY = scale(y, m_screenHeight);
+  }
+}
+
+uint16_t DigitizerMapping::scale(int32_t value, int32_t extent)
+{
+  if (extent <= 1) {
+    return 0;
+  }
+  const auto last = static_cast<int64_t>(extent - 1);
+  return static_cast<uint16_t>((static_cast<int64_t>(value) * kLogicalMax + last / 2) / last);
+}
+
+} // namespace deskflow::bridge
@@ -0,0 +1,43 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace deskflow::bridge {
+
+/**
+ * @brief Maps bridge screen coordinates onto the logical range of the firmware's digitizer
+ *
+ * The bridge screen is laid out the way the phone is held, while the digitizer reports in the
+ * phone's natural portrait frame. For a landscape profile the phone is assumed to be turned
+ * counter-clockwise, so the left edge of the screen is the top of the phone.
+ *
+ * Positions are clamped to the screen and scaled so that both edges land exactly on 0 and
+ * kLogicalMax, independent of the phone's pixel resolution.
+ */
+class DigitizerMapping
+{
+public:
+  static constexpr uint16_t kLogicalMax = 32767;
+
+  DigitizerMapping() = default;
+
+  /**
+   * @param rotation Profile rotation, 0 for portrait and 1 for landscape
+   */
+  DigitizerMapping(int32_t screenWidth, int32_t screenHeight, uint8_t rotation);
+
+  void map(int32_t x, int32_t y, uint16_t &logicalX, uint16_t &logicalY) const;
+
+private:
+  static uint16_t scale(int32_t value, int32_t extent);
+
+  int32_t m_screenWidth = 0;
+  int32_t m_screenHeight = 0;
+  bool m_landscape = false;
+};
+
+} // namespace deskflow::bridge
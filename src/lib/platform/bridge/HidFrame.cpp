@@ -4,24 +4,44 @@
 
 #include "HidFrame.h"
 
+#include "base/Log.h"
+
+#include <algorithm>
+
 namespace deskflow::bridge {
 
-std::vector<uint8_t> HidEventPacket::serialize() const
+HidEventPacket::HidEventPacket(HidEventType eventType, std::initializer_list<uint8_t> bytes)
+    : HidEventPacket(eventType, std::span<const uint8_t>(bytes.begin(), bytes.size()))
 {
-  if (payload.size() > 0xFF) {
-    return {};
-  }
+}
 
-  std::vector<uint8_t> data;
-  data.reserve(4 + payload.size());
+HidEventPacket::HidEventPacket(HidEventType eventType, std::span<const uint8_t> bytes) : type(eventType)
+{
+  if (bytes.size() > kMaxPayloadSize) {
+    LOG_ERR(
+        "HID: rejecting type=0x%02x payload of %zu bytes, at most %zu fit a packet", static_cast<unsigned>(eventType),
+        bytes.size(), kMaxPayloadSize
+    );
+    valid = false;
+    return;
+  }
+  length = static_cast<uint8_t>(bytes.size());
+  std::copy_n(bytes.begin(), length, data.begin());
+}
 
-  data.push_back(static_cast<uint8_t>(MAGIC & 0xFF));
-  data.push_back(static_cast<uint8_t>((MAGIC >> 8) & 0xFF));
-  data.push_back(static_cast<uint8_t>(type));
-  data.push_back(static_cast<uint8_t>(payload.size()));
+size_t HidEventPacket::serialize(std::span<uint8_t> out) const
+{
+  const size_t total = kHeaderSize + length;
+  if (!valid || out.size() < total) {
+    return 0;
+  }
 
-  data.insert(data.end(), payload.begin(), payload.end());
-  return data;
+  out[0] = static_cast<uint8_t>(MAGIC & 0xFF);
+  out[1] = static_cast<uint8_t>((MAGIC >> 8) & 0xFF);
+  out[2] = static_cast<uint8_t>(type);
+  out[3] = length;
+  std::copy_n(data.begin(), length, out.begin() + kHeaderSize);
+  return total;
 }
 
 } // namespace deskflow::bridge
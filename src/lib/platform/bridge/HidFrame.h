@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <initializer_list>
+#include <span>
 
 namespace deskflow::bridge {
 
@@ -19,22 +22,63 @@ enum class HidEventType : uint8_t
   MouseScroll = 0x06,
   ConsumerControlPress = 0x07,
   ConsumerControlRelease = 0x08,
+  KeyboardReport = 0x09,   // Whole boot keyboard report, see kKeyboardReportSize
+  MousePan = 0x0A,         // Horizontal wheel (consumer AC Pan) in int8 detents, positive is right
+  MouseScrollHiRes = 0x0B, // Vertical then horizontal int16 LE, see kHiResScrollUnitsPerDetent
+  MouseAbsolute = 0x0C,    // Digitizer x then y as uint16 LE, 0..DigitizerMapping::kLogicalMax
 };
 
+// Boot keyboard report: modifier bitmap, reserved byte, then up to six pressed key codes
+constexpr size_t kKeyboardReportSize = 8;
+constexpr size_t kKeyboardReportKeyOffset = 2;
+constexpr size_t kKeyboardReportMaxKeys = kKeyboardReportSize - kKeyboardReportKeyOffset;
+constexpr uint8_t kKeyErrorRollOver = 0x01; // Every key slot holds this while too many keys are down
+
+// High-resolution scroll counts wheel travel in fractions of a detent; the firmware applies its own
+// resolution multiplier when it forwards them
+constexpr int32_t kHiResScrollUnitsPerDetent = 120;
+
 /**
  * @brief HID protocol packet wrapper
  *
  * Format (little endian):
  *   header (0xAA55) | type (1 byte) | length (1 byte) | payload (N bytes)
+ *
+ * The payload is stored inline so building and sending a packet never touches the heap. A payload
+ * longer than kMaxPayloadSize is rejected rather than truncated: the packet is left empty and
+ * invalid, and serialize() refuses it.
  */
 struct HidEventPacket
 {
   static constexpr uint16_t MAGIC = 0xAA55;
+  static constexpr size_t kHeaderSize = 4;
+  static constexpr size_t kMaxPayloadSize = 8;
+  static constexpr size_t kMaxSerializedSize = kHeaderSize + kMaxPayloadSize;
+
+  HidEventPacket() = default;
+  HidEventPacket(HidEventType eventType, std::initializer_list<uint8_t> bytes);
+  HidEventPacket(HidEventType eventType, std::span<const uint8_t> bytes);
+
+  HidEventType type = HidEventType::KeyboardPress;
+  uint8_t length = 0;
+  std::array<uint8_t, kMaxPayloadSize> data{};
+  bool valid = true;
+
+  bool isValid() const
+  {
+    return valid;
+  }
 
-  HidEventType type;
-  std::vector<uint8_t> payload;
+  std::span<const uint8_t> payload() const
+  {
+    return {data.data(), length};
+  }
 
-  std::vector<uint8_t> serialize() const;
+  /**
+   * @brief Serialize into a caller-provided buffer
+   * @return Number of bytes written, 0 if the packet is invalid or the buffer is too small
+   */
+  size_t serialize(std::span<uint8_t> out) const;
 };
 
 } // namespace deskflow::bridge
@@ -0,0 +1,269 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "deskflow/KeyTypes.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @file HidKeyMap.h
+ * @brief Compile-time tables mapping deskflow keys onto HID usages
+ *
+ * Every keystroke looks its key up here, so the mappings are dense arrays built at compile time:
+ * one for the ASCII range and one indexed by the low byte of the kKey* function key pages, which
+ * mirror the X11 keysyms at 0xEFxx and 0xFFxx, and one for the media keys at 0xE0xx. The few IDs
+ * that do not fit a page table sit in a short sorted table searched with lower_bound.
+ */
+
+namespace deskflow::bridge {
+
+namespace hidkeymap {
+
+struct SparseEntry
+{
+  KeyID id;
+  uint16_t value;
+};
+
+template <size_t N> constexpr bool isSorted(const std::array<SparseEntry, N> &table)
+{
+  return std::is_sorted(table.begin(), table.end(), [](const auto &a, const auto &b) { return a.id < b.id; });
+}
+
+template <size_t N> constexpr uint16_t findSparse(const std::array<SparseEntry, N> &table, KeyID id)
+{
+  const auto it = std::lower_bound(table.begin(), table.end(), id, [](const SparseEntry &entry, KeyID key) {
+    return entry.id < key;
+  });
+  return it != table.end() && it->id == id ? it->value : 0;
+}
+
+// Keyboard page usages for printable ASCII; shifted symbols share the usage of their base key
+inline constexpr auto kAsciiUsages = [] {
+  std::array<uint8_t, 128> table{};
+  for (int i = 0; i < 26; ++i) {
+    table['a' + i] = static_cast<uint8_t>(0x04 + i);
+    table['A' + i] = static_cast<uint8_t>(0x04 + i);
+  }
+  for (int i = 0; i < 9; ++i) {
+    table['1' + i] = static_cast<uint8_t>(0x1E + i);
+  }
+  table['0'] = 0x27;
+  table[' '] = 0x2C;
+
+  constexpr std::pair<char, uint8_t> symbols[] = {
+      {'-', 0x2D}, {'_', 0x2D}, {'=', 0x2E}, {'+', 0x2E}, {'[', 0x2F}, {'{', 0x2F}, {']', 0x30},
+      {'}', 0x30}, {'\\', 0x31}, {'|', 0x31}, {';', 0x33}, {':', 0x33}, {'\'', 0x34}, {'"', 0x34},
+      {'`', 0x35}, {'~', 0x35}, {',', 0x36}, {'<', 0x36}, {'.', 0x37}, {'>', 0x37}, {'/', 0x38},
+      {'?', 0x38}, {'!', 0x1E}, {'@', 0x1F}, {'#', 0x20}, {'$', 0x21}, {'%', 0x22}, {'^', 0x23},
+      {'&', 0x24}, {'*', 0x25}, {'(', 0x26}, {')', 0x27},
+  };
+  for (const auto &[symbol, usage] : symbols) {
+    table[static_cast<uint8_t>(symbol)] = usage;
+  }
+  return table;
+}();
+
+// Keyboard page usages by the low byte of a key in the 0xEFxx / 0xFFxx pages
+inline constexpr auto kFunctionKeyUsages = [] {
+  std::array<uint8_t, 256> table{};
+  for (int i = 0; i < 12; ++i) {
+    table[0xBE + i] = static_cast<uint8_t>(0x3A + i); // F1..F12
+  }
+
+  constexpr std::pair<uint8_t, uint8_t> keys[] = {
+      {0x08, 0x2A}, // BackSpace
+      {0x09, 0x2B}, // Tab
+      {0x0D, 0x28}, // Return
+      {0x13, 0x48}, // Pause
+      {0x14, 0x47}, // ScrollLock
+      {0x1B, 0x29}, // Escape
+      {0x50, 0x4A}, // Home
+      {0x51, 0x50}, // Left
+      {0x52, 0x52}, // Up
+      {0x53, 0x4F}, // Right
+      {0x54, 0x51}, // Down
+      {0x55, 0x4B}, // PageUp
+      {0x56, 0x4E}, // PageDown
+      {0x57, 0x4D}, // End
+      {0x61, 0x46}, // Print
+      {0x63, 0x49}, // Insert
+      {0x67, 0x65}, // Menu
+      {0x7F, 0x53}, // NumLock
+      {0xE5, 0x39}, // CapsLock
+      {0xFF, 0x4C}, // Delete
+  };
+  for (const auto &[low, usage] : keys) {
+    table[low] = usage;
+  }
+  return table;
+}();
+
+// Modifier bitmap bits by the low byte of a key in the 0xEFxx / 0xFFxx pages
+inline constexpr auto kFunctionKeyModifierBits = [] {
+  std::array<uint8_t, 256> table{};
+  table[0xE1] = 0x02; // Shift_L
+  table[0xE2] = 0x20; // Shift_R
+  table[0xE3] = 0x01; // Control_L
+  table[0xE4] = 0x10; // Control_R
+  table[0xE7] = 0x08; // Meta_L
+  table[0xE8] = 0x80; // Meta_R
+  table[0xE9] = 0x04; // Alt_L
+  table[0xEA] = 0x40; // Alt_R
+  table[0xEB] = 0x08; // Super_L
+  table[0xEC] = 0x80; // Super_R
+  return table;
+}();
+
+// Modifiers whose ID has no counterpart in the X11 page
+inline constexpr std::array<SparseEntry, 1> kSparseModifierBits = {{
+    {kKeyAltGr, 0x40},
+}};
+
+// Consumer page usages for media and browser keys
+inline constexpr std::pair<KeyID, uint16_t> kConsumerKeys[] = {
+    {kKeyWWWBack, 0x0224},      {kKeyWWWForward, 0x0225},     {kKeyWWWRefresh, 0x0227},
+    {kKeyWWWStop, 0x0226},      {kKeyWWWSearch, 0x0221},      {kKeyWWWFavorites, 0x022A},
+    {kKeyWWWHome, 0x0223},      {kKeyAudioMute, 0x00E2},      {kKeyAudioDown, 0x00EA},
+    {kKeyAudioUp, 0x00E9},      {kKeyAudioNext, 0x00B5},      {kKeyAudioPrev, 0x00B6},
+    {kKeyAudioStop, 0x00B7},    {kKeyAudioPlay, 0x00CD},      {kKeyAppMail, 0x018A},
+    {kKeyAppMedia, 0x0183},     {kKeyBrightnessDown, 0x0070}, {kKeyBrightnessUp, 0x006F},
+};
+
+// kConsumerKeys by the low byte of a key in the 0xE0xx page
+inline constexpr auto kConsumerUsages = [] {
+  std::array<uint16_t, 256> table{};
+  for (const auto &[id, usage] : kConsumerKeys) {
+    table[id & 0xFF] = usage;
+  }
+  return table;
+}();
+
+// Keyboard page usages by the platform key code the server sends when it has no KeyID
+inline constexpr auto kButtonUsages = [] {
+  std::array<uint8_t, 256> table{};
+  const auto &ascii = kAsciiUsages;
+#if defined(__APPLE__)
+  const std::pair<KeyButton, uint8_t> buttons[] = {
+      // Number row
+      {19, ascii['1']}, {20, ascii['2']}, {21, ascii['3']}, {22, ascii['4']}, {24, ascii['5']},
+      {23, ascii['6']}, {27, ascii['7']}, {29, ascii['8']}, {26, ascii['9']}, {30, ascii['0']},
+      {28, 0x2D}, {25, 0x2E}, {52, 0x2A},
+      // Top row
+      {49, 0x2B}, {13, ascii['q']}, {14, ascii['w']}, {15, ascii['e']}, {16, ascii['r']},
+      {18, ascii['t']}, {17, ascii['y']}, {33, ascii['u']}, {35, ascii['i']}, {32, ascii['o']},
+      {36, ascii['p']}, {34, 0x2F}, {31, 0x30}, {37, 0x28},
+      // Home row
+      {1, ascii['a']}, {2, ascii['s']}, {3, ascii['d']}, {4, ascii['f']}, {6, ascii['g']},
+      {5, ascii['h']}, {39, ascii['j']}, {41, ascii['k']}, {38, ascii['l']}, {42, 0x33},
+      {40, 0x34}, {51, 0x35}, {43, 0x31},
+      // Bottom row
+      {7, ascii['z']}, {8, ascii['x']}, {9, ascii['c']}, {10, ascii['v']}, {12, ascii['b']},
+      {46, ascii['n']}, {47, ascii['m']}, {44, 0x36}, {48, 0x37}, {45, 0x38}, {50, 0x2C},
+      {58, 0x39}, // CapsLock
+      // F1..F13
+      {123, 0x3A}, {121, 0x3B}, {100, 0x3C}, {119, 0x3D}, {97, 0x3E}, {98, 0x3F}, {99, 0x40},
+      {101, 0x41}, {102, 0x42}, {110, 0x43}, {104, 0x44}, {112, 0x45}, {111, 0x65},
+      // Navigation
+      {72, 0x53}, // NumLock (Clear)
+      {127, 0x52}, {124, 0x50}, {125, 0x4F}, {126, 0x51}, {115, 0x49}, {118, 0x4C},
+  };
+#else
+  const std::pair<KeyButton, uint8_t> buttons[] = {
+      // Number row
+      {10, ascii['1']}, {90, ascii['1']}, {11, ascii['2']}, {12, ascii['3']}, {13, ascii['4']},
+      {14, ascii['5']}, {15, ascii['6']}, {16, ascii['7']}, {17, ascii['8']}, {18, ascii['9']},
+      {19, ascii['0']}, {20, 0x2D}, {21, 0x2E}, {22, 0x2A},
+      // Top row
+      {23, 0x2B}, {24, ascii['q']}, {25, ascii['w']}, {26, ascii['e']}, {27, ascii['r']},
+      {28, ascii['t']}, {29, ascii['y']}, {30, ascii['u']}, {31, ascii['i']}, {32, ascii['o']},
+      {33, ascii['p']}, {34, 0x2F}, {35, 0x30}, {36, 0x28},
+      // Home row
+      {38, ascii['a']}, {39, ascii['s']}, {40, ascii['d']}, {41, ascii['f']}, {42, ascii['g']},
+      {43, ascii['h']}, {44, ascii['j']}, {45, ascii['k']}, {46, ascii['l']}, {47, 0x33},
+      {48, 0x34}, {49, 0x35}, {51, 0x31},
+      // Bottom row
+      {52, ascii['z']}, {53, ascii['x']}, {54, ascii['c']}, {55, ascii['v']}, {56, ascii['b']},
+      {57, ascii['n']}, {58, ascii['m']}, {59, 0x36}, {60, 0x37}, {61, 0x38}, {65, 0x2C},
+      {66, 0x39}, // CapsLock
+      // F1..F12
+      {67, 0x3A}, {68, 0x3B}, {69, 0x3C}, {70, 0x3D}, {71, 0x3E}, {72, 0x3F}, {73, 0x40},
+      {74, 0x41}, {75, 0x42}, {76, 0x43}, {95, 0x44}, {96, 0x45},
+      // Locks and navigation
+      {77, 0x53}, {78, 0x47}, {107, 0x46}, {127, 0x48}, // NumLock, ScrollLock, PrintScreen, Pause
+      {111, 0x52}, {113, 0x50}, {114, 0x4F}, {116, 0x51}, {118, 0x49}, {119, 0x4C},
+      {135, 0x65}, // Menu
+  };
+#endif
+  for (const auto &[button, usage] : buttons) {
+    table[button] = usage;
+  }
+  return table;
+}();
+
+} // namespace hidkeymap
+
+/**
+ * @brief Keyboard page usage for a KeyID, 0 if it has none
+ */
+constexpr uint8_t hidUsageForKeyId(KeyID id)
+{
+  if (id < hidkeymap::kAsciiUsages.size()) {
+    return hidkeymap::kAsciiUsages[id];
+  }
+  if (const KeyID page = id & ~KeyID(0xFF); page == 0xEF00 || page == 0xFF00) {
+    return hidkeymap::kFunctionKeyUsages[id & 0xFF];
+  }
+  return 0;
+}
+
+/**
+ * @brief Keyboard page usage for a platform key code, 0 if it has none
+ */
+constexpr uint8_t hidUsageForKeyButton(KeyButton button)
+{
+  return button < hidkeymap::kButtonUsages.size() ? hidkeymap::kButtonUsages[button] : 0;
+}
+
+/**
+ * @brief HID modifier bitmap bit for a modifier KeyID, 0 for other keys
+ */
+constexpr uint8_t hidModifierBitForKeyId(KeyID id)
+{
+  if (const KeyID page = id & ~KeyID(0xFF); page != 0xEF00 && page != 0xFF00) {
+    return 0;
+  }
+  if (const uint8_t bit = hidkeymap::kFunctionKeyModifierBits[id & 0xFF]; bit != 0) {
+    return bit;
+  }
+  return static_cast<uint8_t>(hidkeymap::findSparse(hidkeymap::kSparseModifierBits, id));
+}
+
+/**
+ * @brief Consumer page usage for a media or browser KeyID, 0 for other keys
+ */
+constexpr uint16_t consumerUsageForKeyId(KeyID id)
+{
+  return (id & ~KeyID(0xFF)) == 0xE000 ? hidkeymap::kConsumerUsages[id & 0xFF] : 0;
+}
+
+static_assert(hidkeymap::isSorted(hidkeymap::kSparseModifierBits));
+static_assert(std::ranges::all_of(hidkeymap::kConsumerKeys, [](const auto &key) { return (key.first >> 8) == 0xE0; }));
+static_assert(hidUsageForKeyId('a') == 0x04 && hidUsageForKeyId('Z') == 0x1D && hidUsageForKeyId('0') == 0x27);
+static_assert(hidUsageForKeyId(kKeyReturn) == 0x28 && hidUsageForKeyId(0xFF0D) == 0x28);
+static_assert(hidUsageForKeyId(kKeyF1) == 0x3A && hidUsageForKeyId(kKeyF12) == 0x45);
+static_assert(hidUsageForKeyId(kKeyDelete) == 0x4C && hidUsageForKeyId(kKeyAudioMute) == 0);
+static_assert(hidModifierBitForKeyId(kKeyShift_L) == 0x02 && hidModifierBitForKeyId(0xFFEC) == 0x80);
+// The sparse modifiers are only consulted within the function key pages
+static_assert(hidModifierBitForKeyId(kKeyAltGr) == 0x40 && hidModifierBitForKeyId(0xFF7E) == 0);
+static_assert(consumerUsageForKeyId(kKeyAudioMute) == 0x00E2 && consumerUsageForKeyId(kKeyAppMedia) == 0x0183);
+static_assert(consumerUsageForKeyId('a') == 0 && hidUsageForKeyButton(0xFFFF) == 0);
+
+} // namespace deskflow::bridge
@@ -0,0 +1,177 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "HidRecording.h"
+
+#include "base/Log.h"
+
+#include <algorithm>
+#include <iterator>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace deskflow::bridge {
+
+namespace {
+constexpr int32_t kMaxStepDelta = 32767;
+
+size_t writeVarint(uint64_t value, uint8_t *out)
+{
+  size_t length = 0;
+  while (value >= 0x80) {
+    out[length++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  out[length++] = static_cast<uint8_t>(value);
+  return length;
+}
+
+bool readVarint(std::span<const uint8_t> bytes, size_t &offset, uint64_t &value)
+{
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (offset >= bytes.size()) {
+      return false;
+    }
+    const uint8_t byte = bytes[offset++];
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+HidRecorder::HidRecorder(std::filesystem::path path, Clock::time_point start) : m_path(std::move(path)), m_last(start)
+{
+#if !defined(_WIN32)
+  // Create the file for its owner only before the stream opens it, and take access away from a
+  // file that already exists; on Windows it inherits the ACL of the directory it is in
+  const int fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+  const bool restricted = fd >= 0 && ::fchmod(fd, S_IRUSR | S_IWUSR) == 0;
+  if (fd >= 0) {
+    ::close(fd);
+  }
+  if (!restricted) {
+    LOG_WARN("HidRecorder: failed to create %s for its owner only", m_path.string().c_str());
+    return;
+  }
+#endif
+
+  m_file.open(m_path, std::ios::binary | std::ios::trunc);
+  if (!m_file) {
+    LOG_WARN("HidRecorder: failed to create %s", m_path.string().c_str());
+    m_file.close();
+    return;
+  }
+
+  std::array<uint8_t, kHeaderSize> header{};
+  std::copy(kMagic.begin(), kMagic.end(), header.begin());
+  header[kMagic.size()] = kVersion;
+  m_file.write(reinterpret_cast<const char *>(header.data()), header.size());
+}
+
+void HidRecorder::record(const HidEventPacket &packet, Clock::time_point now)
+{
+  if (isOpen()) {
+    write(packet, now);
+  }
+}
+
+void HidRecorder::recordMouseMove(int32_t dx, int32_t dy, Clock::time_point now)
+{
+  while (isOpen() && (dx != 0 || dy != 0)) {
+    const auto stepDx = static_cast<int16_t>(std::clamp(dx, -kMaxStepDelta, kMaxStepDelta));
+    const auto stepDy = static_cast<int16_t>(std::clamp(dy, -kMaxStepDelta, kMaxStepDelta));
+    write(
+        HidEventPacket(
+            HidEventType::MouseMove,
+            {static_cast<uint8_t>(stepDx & 0xFF), static_cast<uint8_t>((stepDx >> 8) & 0xFF),
+             static_cast<uint8_t>(stepDy & 0xFF), static_cast<uint8_t>((stepDy >> 8) & 0xFF)}
+        ),
+        now
+    );
+    dx -= stepDx;
+    dy -= stepDy;
+  }
+}
+
+void HidRecorder::write(const HidEventPacket &packet, Clock::time_point now)
+{
+  // The clock is monotonic, but a caller-supplied time may still be older than the last record
+  const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::max(now, m_last) - m_last);
+  m_last = std::max(now, m_last);
+
+  std::array<uint8_t, kMaxRecordSize> record{};
+  size_t length = writeVarint(static_cast<uint64_t>(delta.count()), record.data());
+  record[length++] = static_cast<uint8_t>(packet.type);
+  record[length++] = packet.length;
+  const auto payload = packet.payload();
+  std::copy(payload.begin(), payload.end(), record.begin() + length);
+  length += payload.size();
+
+  if (!m_file.write(reinterpret_cast<const char *>(record.data()), static_cast<std::streamsize>(length))) {
+    LOG_WARN("HidRecorder: write to %s failed, recording stopped", m_path.string().c_str());
+    m_file.close();
+    return;
+  }
+  ++m_recorded;
+}
+
+std::optional<std::vector<HidRecord>> parseHidRecording(std::span<const uint8_t> bytes, std::string &error)
+{
+  if (bytes.size() < HidRecorder::kHeaderSize ||
+      !std::equal(HidRecorder::kMagic.begin(), HidRecorder::kMagic.end(), bytes.begin())) {
+    error = "not a HID recording";
+    return std::nullopt;
+  }
+  if (bytes[HidRecorder::kMagic.size()] != HidRecorder::kVersion) {
+    error = "unsupported recording version " + std::to_string(bytes[HidRecorder::kMagic.size()]);
+    return std::nullopt;
+  }
+
+  std::vector<HidRecord> records;
+  std::chrono::microseconds time{0};
+  size_t offset = HidRecorder::kHeaderSize;
+  while (offset < bytes.size()) {
+    uint64_t delta = 0;
+    if (!readVarint(bytes, offset, delta) || bytes.size() - offset < 2) {
+      break;
+    }
+    const auto type = static_cast<HidEventType>(bytes[offset]);
+    const size_t length = bytes[offset + 1];
+    offset += 2;
+    if (length > HidEventPacket::kMaxPayloadSize) {
+      error = "record " + std::to_string(records.size()) + " has an oversized payload";
+      return std::nullopt;
+    }
+    if (bytes.size() - offset < length) {
+      break;
+    }
+
+    time += std::chrono::microseconds(delta);
+    records.push_back(HidRecord{time, HidEventPacket(type, bytes.subspan(offset, length))});
+    offset += length;
+  }
+  return records;
+}
+
+std::optional<std::vector<HidRecord>> loadHidRecording(const std::filesystem::path &path, std::string &error)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "cannot open " + path.string();
+    return std::nullopt;
+  }
+
+  const std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  return parseHidRecording(bytes, error);
+}
+
+} // namespace deskflow::bridge
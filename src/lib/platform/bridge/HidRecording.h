@@ -0,0 +1,108 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "HidFrame.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace deskflow::bridge {
+
+/**
+ * @brief HID event from a recording
+ */
+struct HidRecord
+{
+  std::chrono::microseconds time{0}; // since the recording started
+  HidEventPacket packet;
+};
+
+/**
+ * @brief Writes the HID events a bridge screen emits to a compact binary trace
+ *
+ * Events are recorded as the screen hands them to the transmit queue, before motion is coalesced
+ * or shaped, so replaying a trace puts the same input through the same queue again.
+ *
+ * Format (little endian):
+ *   header: magic "DSHR" (4 bytes) | format version (1 byte) | reserved (3 bytes)
+ *   record: microseconds since the previous record (LEB128) | type (1 byte) | length (1 byte) | payload
+ *
+ * Relative motion is stored as MouseMove records of int16 x then y, split if a move is larger.
+ * Records go through the stream's buffer, so a trace cut short by a crash ends in at most one
+ * partial record, which the reader drops.
+ *
+ * A trace holds every key typed while it is recorded, passwords included, so on POSIX systems
+ * the file is readable and writable by its owner only.
+ */
+class HidRecorder
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::array<uint8_t, 4> kMagic = {'D', 'S', 'H', 'R'};
+  static constexpr uint8_t kVersion = 0x01;
+  static constexpr size_t kHeaderSize = 8;
+  static constexpr size_t kMaxRecordSize = 10 + 2 + HidEventPacket::kMaxPayloadSize;
+
+  /**
+   * @param start Time the first record is measured from
+   */
+  explicit HidRecorder(std::filesystem::path path, Clock::time_point start = Clock::now());
+
+  HidRecorder(const HidRecorder &) = delete;
+  HidRecorder &operator=(const HidRecorder &) = delete;
+
+  /**
+   * @brief False if the file could not be created or a write failed
+   */
+  bool isOpen() const
+  {
+    return m_file.is_open();
+  }
+
+  const std::filesystem::path &path() const
+  {
+    return m_path;
+  }
+
+  uint64_t recorded() const
+  {
+    return m_recorded;
+  }
+
+  void record(const HidEventPacket &packet, Clock::time_point now = Clock::now());
+  void recordMouseMove(int32_t dx, int32_t dy, Clock::time_point now = Clock::now());
+
+private:
+  void write(const HidEventPacket &packet, Clock::time_point now);
+
+  std::filesystem::path m_path;
+  std::ofstream m_file;
+  Clock::time_point m_last;
+  uint64_t m_recorded = 0;
+};
+
+/**
+ * @brief Decode a trace written by HidRecorder
+ * @param error Reason the trace was rejected
+ */
+std::optional<std::vector<HidRecord>> parseHidRecording(std::span<const uint8_t> bytes, std::string &error);
+
+/**
+ * @brief Read and decode a trace file
+ * @param error Reason the file was rejected
+ */
+std::optional<std::vector<HidRecord>> loadHidRecording(const std::filesystem::path &path, std::string &error);
+
+} // namespace deskflow::bridge
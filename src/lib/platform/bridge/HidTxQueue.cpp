@@ -0,0 +1,512 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "HidTxQueue.h"
+
+#include "CdcTransport.h"
+#include "base/Log.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace deskflow::bridge {
+
+namespace {
+// Pending motion is packed into one word so producer and writer can update it with a single CAS:
+//   bits 0-23 dx | bits 24-47 dy | bits 48-63 ring tail when the motion was recorded
+// The tail tag lets the writer tell whether events queued before the motion are still in the ring.
+constexpr uint64_t kMotionMask = (uint64_t(1) << 48) - 1;
+constexpr int32_t kMaxPendingDelta = (1 << 23) - 1;
+constexpr int32_t kMaxStepDelta = 32767;
+
+// Without room on the device the writer blocks on the link for credit updates, in slices so the
+// transport lock is released now and then for keep-alives
+constexpr int kCreditWaitMs = 50;
+constexpr auto kCreditStallWarning = std::chrono::seconds(2);
+
+uint64_t packMotion(int32_t dx, int32_t dy, uint64_t tail)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(dx) & 0xFFFFFF)) |
+         (static_cast<uint64_t>(static_cast<uint32_t>(dy) & 0xFFFFFF) << 24) | ((tail & 0xFFFF) << 48);
+}
+
+int32_t signExtend24(uint64_t value)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(value & 0xFFFFFF) << 8) >> 8;
+}
+
+void unpackMotion(uint64_t packed, int32_t &dx, int32_t &dy)
+{
+  dx = signExtend24(packed);
+  dy = signExtend24(packed >> 24);
+}
+
+uint16_t motionTail(uint64_t packed)
+{
+  return static_cast<uint16_t>(packed >> 48);
+}
+
+HidEventPacket mouseMovePacket(int16_t dx, int16_t dy)
+{
+  return HidEventPacket(
+      HidEventType::MouseMove,
+      {static_cast<uint8_t>(dx & 0xFF), static_cast<uint8_t>((dx >> 8) & 0xFF), static_cast<uint8_t>(dy & 0xFF),
+       static_cast<uint8_t>((dy >> 8) & 0xFF)}
+  );
+}
+
+int16_t clampStep(int32_t delta)
+{
+  return static_cast<int16_t>(std::clamp(delta, -kMaxStepDelta, kMaxStepDelta));
+}
+} // namespace
+
+HidTxQueue::HidTxQueue(
+    std::shared_ptr<CdcTransport> transport, ErrorCallback onError, MotionShaper::Config shaping
+)
+    : m_transport(std::move(transport)),
+      m_onError(std::move(onError)),
+      m_shaper(shaping)
+{
+  m_running = true;
+  m_writer = std::thread(&HidTxQueue::run, this);
+}
+
+HidTxQueue::~HidTxQueue()
+{
+  // The writer drains whatever is still queued (e.g. key releases from leave()) before exiting,
+  // including motion the shaper has not paced out yet
+  m_running = false;
+  wake();
+  if (m_writer.joinable()) {
+    m_writer.join();
+  }
+}
+
+bool HidTxQueue::enqueue(const HidEventPacket &packet, const InputLatency::Trace &trace)
+{
+  // An invalid packet was already reported when it was built; it must not reach the writer,
+  // which would take the serialization failure for a broken link
+  if (!packet.isValid() || m_failed.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  // Motion recorded so far happened before this event, so it has to be queued first
+  const bool queued = flushPendingMotion() && queuePacket(packet, trace);
+  wakeUnlessBatching();
+  return queued;
+}
+
+bool HidTxQueue::enqueueMouseMove(int32_t dx, int32_t dy, const InputLatency::Trace &trace)
+{
+  if (m_failed.load(std::memory_order_acquire)) {
+    return false;
+  }
+  if (dx == 0 && dy == 0) {
+    return true;
+  }
+
+  const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+  uint64_t current = m_pendingMotion.load(std::memory_order_relaxed);
+  uint64_t next = 0;
+  do {
+    int32_t pendingDx = 0;
+    int32_t pendingDy = 0;
+    unpackMotion(current, pendingDx, pendingDy);
+    const auto sumDx = static_cast<int32_t>(
+        std::clamp<int64_t>(int64_t(pendingDx) + dx, -kMaxPendingDelta, kMaxPendingDelta)
+    );
+    const auto sumDy = static_cast<int32_t>(
+        std::clamp<int64_t>(int64_t(pendingDy) + dy, -kMaxPendingDelta, kMaxPendingDelta)
+    );
+    next = (sumDx == 0 && sumDy == 0) ? 0 : packMotion(sumDx, sumDy, tail);
+  } while (!m_pendingMotion.compare_exchange_weak(
+      current, next, std::memory_order_acq_rel, std::memory_order_relaxed
+  ));
+
+  if ((current & kMotionMask) != 0) {
+    m_coalesced.fetch_add(1, std::memory_order_relaxed);
+  } else if (next != 0) {
+    setPendingMotionTrace(trace);
+  }
+
+  wakeUnlessBatching();
+  return true;
+}
+
+void HidTxQueue::beginBatch()
+{
+  m_batching = true;
+}
+
+void HidTxQueue::flush()
+{
+  m_batching = false;
+  wake();
+}
+
+std::unique_lock<std::mutex> HidTxQueue::lockTransport()
+{
+  return std::unique_lock<std::mutex>(m_transportMutex);
+}
+
+void HidTxQueue::resetError()
+{
+  m_failed.store(false, std::memory_order_release);
+}
+
+bool HidTxQueue::hasFailed() const
+{
+  return m_failed.load(std::memory_order_acquire);
+}
+
+HidTxQueue::Stats HidTxQueue::stats() const
+{
+  Stats stats;
+  stats.depth = static_cast<size_t>(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire));
+  stats.maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+  stats.eventsSent = m_eventsSent.load(std::memory_order_relaxed);
+  stats.batches = m_batches.load(std::memory_order_relaxed);
+  stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+  stats.creditStalls = m_creditStalls.load(std::memory_order_relaxed);
+  stats.spilled = m_spilled.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void HidTxQueue::run()
+{
+  while (true) {
+    const size_t credits = pollCredits(0);
+    if (credits > 0 && drainOnce(MotionShaper::Clock::now(), credits)) {
+      continue;
+    }
+    if (!m_running.load(std::memory_order_acquire) && (credits > 0 || !hasQueued())) {
+      break;
+    }
+    if (credits == 0 && hasQueued()) {
+      // The device has no room: hold everything back, relative motion keeps coalescing meanwhile
+      waitForCredits();
+      continue;
+    }
+    if (m_shaper.hasPending()) {
+      // Sleep until the next paced report is due, unless new events arrive first
+      m_wake.try_acquire_until(m_shaper.nextReportTime());
+    } else {
+      m_wake.acquire();
+    }
+  }
+}
+
+size_t HidTxQueue::pollCredits(int timeoutMs)
+{
+  if (m_ignoreCredits) {
+    return std::numeric_limits<size_t>::max();
+  }
+
+  int credits = 0;
+  {
+    std::scoped_lock lock(m_transportMutex);
+    if (m_transport == nullptr || !m_transport->hasFlowControl()) {
+      return std::numeric_limits<size_t>::max();
+    }
+    credits = m_transport->waitForHidCredits(timeoutMs);
+    if (credits < 0) {
+      LOG_ERR("BridgeTx: failed to read HID credits (%s)", m_transport->lastError().c_str());
+    }
+  }
+
+  if (credits < 0) {
+    // Nothing more can be written; let the queue discard what is left
+    fail();
+    return std::numeric_limits<size_t>::max();
+  }
+  return static_cast<size_t>(credits);
+}
+
+void HidTxQueue::waitForCredits()
+{
+  const auto start = MotionShaper::Clock::now();
+  bool warned = false;
+  while (pollCredits(kCreditWaitMs) == 0) {
+    if (!m_running.load(std::memory_order_acquire)) {
+      // The device stopped granting credits; on shutdown send the rest regardless, so key
+      // releases still get a chance to reach it
+      LOG_WARN("BridgeTx: device granted no HID credits, flushing without flow control");
+      m_ignoreCredits = true;
+      return;
+    }
+    if (!warned && MotionShaper::Clock::now() - start >= kCreditStallWarning) {
+      LOG_WARN("BridgeTx: device has granted no HID credits for 2s, holding input back");
+      warned = true;
+    }
+  }
+  m_creditStalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool HidTxQueue::hasQueued() const
+{
+  return m_head.load(std::memory_order_relaxed) != m_tail.load(std::memory_order_acquire) ||
+         m_spilling.load(std::memory_order_acquire) || (m_pendingMotion.load(std::memory_order_acquire) & kMotionMask) != 0 || m_shaper.hasPending();
+}
+
+bool HidTxQueue::drainOnce(MotionShaper::Clock::time_point now, size_t budget)
+{
+  std::array<HidEventPacket, kMaxBatchEvents> batch;
+  std::array<InputLatency::Trace, kMaxBatchEvents> traces;
+  size_t count = 0;
+  size_t appended = 0;
+  const auto sendBatch = [this, &batch, &traces, &count] {
+    send(std::span(batch.data(), count), std::span(traces.data(), count));
+    count = 0;
+  };
+  const auto append = [&](const HidEventPacket &packet, const InputLatency::Trace &trace) {
+    if (count == batch.size()) {
+      sendBatch();
+    }
+    batch[count] = packet;
+    traces[count] = trace;
+    ++count;
+    ++appended;
+  };
+  // Never more events than the device has credits for
+  const auto hasBudget = [&appended, budget] { return appended < budget; };
+
+  int16_t stepDx = 0;
+  int16_t stepDy = 0;
+  // Motion still being paced out happened before any queued event, so it lands first
+  const auto flushShaper = [&] {
+    while (hasBudget() && m_shaper.nextImmediate(stepDx, stepDy)) {
+      append(mouseMovePacket(stepDx, stepDy), std::exchange(m_shaperTrace, {}));
+    }
+  };
+
+  uint64_t head = m_head.load(std::memory_order_relaxed);
+  const uint64_t tail = m_tail.load(std::memory_order_acquire);
+  if (head != tail) {
+    flushShaper();
+    for (size_t taken = 0; head != tail && taken < kMaxBatchEvents && hasBudget(); ++taken, ++head) {
+      append(m_ring[head % kCapacity], m_traces[head % kCapacity]);
+    }
+    m_head.store(head, std::memory_order_release);
+  }
+
+  // The overflow list follows the ring
+  if (head == tail && hasBudget() && m_spilling.load(std::memory_order_acquire)) {
+    std::array<HidEventPacket, kMaxBatchEvents> spilled;
+    std::array<InputLatency::Trace, kMaxBatchEvents> spilledTraces;
+    flushShaper();
+    const size_t taken =
+        takeSpilled(head, std::span(spilled).first(std::min(kMaxBatchEvents, budget - appended)), spilledTraces);
+    for (size_t i = 0; i < taken; ++i) {
+      append(spilled[i], spilledTraces[i]);
+    }
+  }
+
+  // Pending motion can only follow once the ring and the overflow list have been emptied
+  int32_t dx = 0;
+  int32_t dy = 0;
+  InputLatency::Trace trace;
+  if (head == tail && takePendingMotion(dx, dy, trace)) {
+    m_shaper.add(dx, dy);
+    if (!m_shaperTrace.isValid()) {
+      m_shaperTrace = trace;
+    }
+  }
+
+  // Pacing is dropped on shutdown so nothing is left behind
+  const bool paced = m_running.load(std::memory_order_acquire);
+  if (hasBudget() && (paced ? m_shaper.next(now, stepDx, stepDy) : m_shaper.nextImmediate(stepDx, stepDy))) {
+    append(mouseMovePacket(stepDx, stepDy), std::exchange(m_shaperTrace, {}));
+  }
+
+  if (count == 0) {
+    return false;
+  }
+  sendBatch();
+  return true;
+}
+
+bool HidTxQueue::queuePacket(const HidEventPacket &packet, const InputLatency::Trace &trace)
+{
+  // Once one event had to wait in the overflow list, everything after it waits there too
+  if (!m_spilling.load(std::memory_order_relaxed) && push(packet, trace)) {
+    return true;
+  }
+  return spill(packet, trace);
+}
+
+bool HidTxQueue::push(const HidEventPacket &packet, const InputLatency::Trace &trace)
+{
+  const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+  const uint64_t head = m_head.load(std::memory_order_acquire);
+  if (tail - head >= kCapacity) {
+    // Waiting for the writer would stall the event loop behind a wedged device
+    return false;
+  }
+
+  m_ring[tail % kCapacity] = packet;
+  m_traces[tail % kCapacity] = trace;
+  m_tail.store(tail + 1, std::memory_order_release);
+
+  const auto depth = static_cast<size_t>(tail + 1 - head);
+  if (depth > m_maxDepth.load(std::memory_order_relaxed)) {
+    m_maxDepth.store(depth, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool HidTxQueue::spill(const HidEventPacket &packet, const InputLatency::Trace &trace)
+{
+  {
+    std::scoped_lock lock(m_spillMutex);
+    if (m_spill.size() < kSpillCapacity) {
+      if (m_spill.empty()) {
+        LOG_WARN("BridgeTx: HID queue full, holding events back until the device catches up");
+      }
+      m_spill.emplace_back(packet, trace);
+      m_spilling.store(true, std::memory_order_release);
+      m_spilled.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // Key and button transitions must not be lost, so rather than dropping one the queue gives up on
+  // a device that has not read anything for this long; the caller reports the screen error
+  LOG_ERR("BridgeTx: device stopped reading with %zu HID events waiting, failing the queue", kSpillCapacity);
+  m_failed.store(true, std::memory_order_release);
+  wake();
+  return false;
+}
+
+size_t HidTxQueue::takeSpilled(
+    uint64_t head, std::span<HidEventPacket> packets, std::span<InputLatency::Trace> traces
+)
+{
+  std::scoped_lock lock(m_spillMutex);
+  // The producer only adds to the ring while the list is empty, and always under this lock when it
+  // goes on to spill, so a ring that is still empty here holds nothing older than the list
+  if (m_tail.load(std::memory_order_acquire) != head) {
+    return 0;
+  }
+
+  size_t taken = 0;
+  for (; taken < packets.size() && !m_spill.empty(); ++taken) {
+    packets[taken] = m_spill.front().first;
+    traces[taken] = m_spill.front().second;
+    m_spill.pop_front();
+  }
+  if (m_spill.empty()) {
+    m_spilling.store(false, std::memory_order_release);
+  }
+  return taken;
+}
+
+bool HidTxQueue::flushPendingMotion()
+{
+  const uint64_t pending = m_pendingMotion.exchange(0, std::memory_order_acq_rel);
+  if ((pending & kMotionMask) == 0) {
+    return true;
+  }
+
+  int32_t dx = 0;
+  int32_t dy = 0;
+  unpackMotion(pending, dx, dy);
+  auto trace = takePendingMotionTrace();
+  while (dx != 0 || dy != 0) {
+    const int16_t stepDx = clampStep(dx);
+    const int16_t stepDy = clampStep(dy);
+    // The first step is the one that shows the motion has arrived
+    if (!queuePacket(mouseMovePacket(stepDx, stepDy), std::exchange(trace, {}))) {
+      return false;
+    }
+    dx -= stepDx;
+    dy -= stepDy;
+  }
+  return true;
+}
+
+bool HidTxQueue::takePendingMotion(int32_t &dx, int32_t &dy, InputLatency::Trace &trace)
+{
+  uint64_t current = m_pendingMotion.load(std::memory_order_acquire);
+  while ((current & kMotionMask) != 0) {
+    // Events queued before this motion are still in the ring or the overflow list and go first
+    if (motionTail(current) != static_cast<uint16_t>(m_head.load(std::memory_order_relaxed)) ||
+        m_spilling.load(std::memory_order_acquire)) {
+      return false;
+    }
+    if (m_pendingMotion.compare_exchange_weak(current, 0, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      unpackMotion(current, dx, dy);
+      trace = takePendingMotionTrace();
+      return true;
+    }
+  }
+  return false;
+}
+
+void HidTxQueue::setPendingMotionTrace(const InputLatency::Trace &trace)
+{
+  // Not atomic with the motion itself: if the writer takes the move in between, that sample is
+  // lost or lands on the next move, which is fine for statistics
+  m_pendingReceived.store(trace.received.time_since_epoch().count(), std::memory_order_relaxed);
+  m_pendingQueued.store(trace.queued.time_since_epoch().count(), std::memory_order_release);
+}
+
+InputLatency::Trace HidTxQueue::takePendingMotionTrace()
+{
+  using Clock = InputLatency::Clock;
+  const auto queued = m_pendingQueued.exchange(0, std::memory_order_acquire);
+  const auto received = m_pendingReceived.exchange(0, std::memory_order_relaxed);
+  return InputLatency::Trace{Clock::time_point(Clock::duration(received)), Clock::time_point(Clock::duration(queued))};
+}
+
+bool HidTxQueue::send(std::span<const HidEventPacket> packets, std::span<const InputLatency::Trace> traces)
+{
+  if (m_failed.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  {
+    std::scoped_lock lock(m_transportMutex);
+    if (m_transport != nullptr && m_transport->sendHidEvents(packets)) {
+      m_eventsSent.fetch_add(packets.size(), std::memory_order_relaxed);
+      if (packets.size() > 1) {
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+      }
+      const auto written = InputLatency::Clock::now();
+      for (const auto &trace : traces) {
+        InputLatency::instance().recordWritten(trace, written);
+      }
+      return true;
+    }
+    LOG_ERR(
+        "BridgeTx: failed to send %zu HID event(s) (%s)", packets.size(),
+        m_transport != nullptr ? m_transport->lastError().c_str() : "no transport"
+    );
+  }
+
+  fail();
+  return false;
+}
+
+void HidTxQueue::fail()
+{
+  if (!m_failed.exchange(true, std::memory_order_acq_rel) && m_onError) {
+    m_onError();
+  }
+}
+
+void HidTxQueue::wake()
+{
+  m_wake.release();
+}
+
+void HidTxQueue::wakeUnlessBatching()
+{
+  if (!m_batching) {
+    wake();
+  }
+}
+
+} // namespace deskflow::bridge
@@ -0,0 +1,178 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include "HidFrame.h"
+#include "MotionShaper.h"
+#include "base/InputLatency.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <span>
+#include <thread>
+#include <utility>
+
+namespace deskflow::bridge {
+
+class CdcTransport;
+
+/**
+ * @brief Asynchronous HID transmit queue in front of CdcTransport
+ *
+ * The client event loop enqueues HID events and a writer thread drains them to the device, so a
+ * congested CDC endpoint never stalls event processing. Key, button and scroll events travel
+ * through a bounded single-producer/single-consumer ring and are never reordered or dropped. The
+ * producer never waits for the writer: should the ring fill up because the device stopped reading,
+ * further events wait in a locked overflow list, which the writer empties once it has drained the
+ * ring. Only if that list fills up too is the device considered wedged and the queue fails.
+ * Relative mouse motion is summed into one pending move which the writer sends once it has caught
+ * up, so a slow device receives fewer, larger moves instead of a growing backlog. On the writer
+ * side the motion passes through a MotionShaper, which sub-steps and paces large deltas; anything
+ * it still holds is sent unpaced ahead of the next key or button event.
+ *
+ * Between beginBatch() and flush() the writer is not woken, so everything queued in between goes
+ * out together and can share one batch frame. Outside a batch every event wakes the writer.
+ *
+ * When the firmware negotiated flow control the writer only takes as many events as the device has
+ * credits for. Without credits it sends nothing, so motion keeps coalescing into the pending move
+ * and the delay between input and report stays bounded by the device queue.
+ *
+ * Events may carry an InputLatency trace; the writer records it once the write completes. Motion
+ * merged into a pending move keeps the trace of the oldest contribution.
+ *
+ * Only one thread may enqueue. Anyone else talking to the transport must hold lockTransport().
+ */
+class HidTxQueue
+{
+public:
+  struct Stats
+  {
+    size_t depth = 0;          // events waiting in the ring
+    size_t maxDepth = 0;       // high-water mark of depth
+    uint64_t eventsSent = 0;   // HID events written to the device
+    uint64_t batches = 0;      // transport writes that carried more than one event
+    uint64_t coalesced = 0;    // mouse moves merged into an already pending move
+    uint64_t creditStalls = 0; // times the writer had to wait for the device to grant credits
+    uint64_t spilled = 0;      // events that waited in the overflow list because the ring was full
+  };
+
+  static constexpr size_t kCapacity = 256;
+  static constexpr size_t kMaxBatchEvents = 32;
+  static constexpr size_t kSpillCapacity = 4096;
+
+  using ErrorCallback = std::function<void()>;
+
+  /**
+   * @param onError Called from the writer thread when the first write fails; later events are
+   *                discarded until resetError()
+   * @param shaping Sub-stepping and pacing of relative motion
+   */
+  explicit HidTxQueue(
+      std::shared_ptr<CdcTransport> transport, ErrorCallback onError = {}, MotionShaper::Config shaping = {}
+  );
+  ~HidTxQueue();
+
+  HidTxQueue(const HidTxQueue &) = delete;
+  HidTxQueue &operator=(const HidTxQueue &) = delete;
+
+  /**
+   * @brief Queue an event
+   * @return false if the packet is invalid, the writer has failed, or the overflow list is full,
+   *         which fails the queue as well
+   */
+  bool enqueue(const HidEventPacket &packet, const InputLatency::Trace &trace = {});
+
+  /**
+   * @brief Add relative motion to the pending move
+   * @return false if the writer has failed
+   */
+  bool enqueueMouseMove(int32_t dx, int32_t dy, const InputLatency::Trace &trace = {});
+
+  /**
+   * @brief Hold the writer back until flush(), which the caller must guarantee
+   */
+  void beginBatch();
+
+  /**
+   * @brief Hand everything queued so far to the writer and end the batch
+   */
+  void flush();
+
+  /**
+   * @brief Serialize access to the transport with the writer thread
+   */
+  std::unique_lock<std::mutex> lockTransport();
+
+  void resetError();
+  bool hasFailed() const;
+  Stats stats() const;
+
+private:
+  void run();
+  bool drainOnce(MotionShaper::Clock::time_point now, size_t budget);
+  size_t pollCredits(int timeoutMs);
+  void waitForCredits();
+  bool hasQueued() const;
+  bool queuePacket(const HidEventPacket &packet, const InputLatency::Trace &trace);
+  bool push(const HidEventPacket &packet, const InputLatency::Trace &trace);
+  bool spill(const HidEventPacket &packet, const InputLatency::Trace &trace);
+  size_t takeSpilled(uint64_t head, std::span<HidEventPacket> packets, std::span<InputLatency::Trace> traces);
+  bool flushPendingMotion();
+  bool takePendingMotion(int32_t &dx, int32_t &dy, InputLatency::Trace &trace);
+  void setPendingMotionTrace(const InputLatency::Trace &trace);
+  InputLatency::Trace takePendingMotionTrace();
+  bool send(std::span<const HidEventPacket> packets, std::span<const InputLatency::Trace> traces);
+  void fail();
+  void wake();
+  void wakeUnlessBatching();
+
+  std::shared_ptr<CdcTransport> m_transport;
+  ErrorCallback m_onError;
+  std::mutex m_transportMutex;
+
+  // Ring indices grow monotonically; slots are addressed modulo kCapacity
+  std::array<HidEventPacket, kCapacity> m_ring;
+  std::array<InputLatency::Trace, kCapacity> m_traces; // latency trace of each ring slot
+  std::atomic<uint64_t> m_head = 0; // next slot the writer reads
+  std::atomic<uint64_t> m_tail = 0; // next slot the producer writes
+
+  // Events that found the ring full, in order; while any are waiting the producer adds to this list
+  // rather than the ring, so nothing overtakes them
+  std::mutex m_spillMutex;
+  std::deque<std::pair<HidEventPacket, InputLatency::Trace>> m_spill;
+  std::atomic_bool m_spilling = false; // set by the producer, cleared by the writer once m_spill is empty
+
+  // Packed pending motion, see HidTxQueue.cpp
+  std::atomic<uint64_t> m_pendingMotion = 0;
+
+  // Trace of the oldest motion in m_pendingMotion, as clock ticks; zero when there is none
+  std::atomic<InputLatency::Clock::rep> m_pendingReceived = 0;
+  std::atomic<InputLatency::Clock::rep> m_pendingQueued = 0;
+
+  std::counting_semaphore<> m_wake{0};
+  MotionShaper m_shaper; // writer only
+  InputLatency::Trace m_shaperTrace; // writer only, trace of motion the shaper has not sent yet
+  bool m_ignoreCredits = false;      // writer only, set when the device stops granting credits on shutdown
+  std::atomic_bool m_running = false;
+  std::atomic_bool m_failed = false;
+  bool m_batching = false; // producer only, between beginBatch() and flush()
+
+  std::atomic<size_t> m_maxDepth = 0;
+  std::atomic<uint64_t> m_eventsSent = 0;
+  std::atomic<uint64_t> m_batches = 0;
+  std::atomic<uint64_t> m_coalesced = 0;
+  std::atomic<uint64_t> m_creditStalls = 0;
+  std::atomic<uint64_t> m_spilled = 0;
+
+  std::thread m_writer;
+};
+
+} // namespace deskflow::bridge
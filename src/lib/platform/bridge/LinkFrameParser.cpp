@@ -0,0 +1,79 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "LinkFrameParser.h"
+
+#include <cstring>
+
+namespace deskflow::bridge {
+
+namespace {
+constexpr uint8_t kMagicLow = LinkFrameParser::kMagic & 0xFF;
+constexpr uint8_t kMagicHigh = LinkFrameParser::kMagic >> 8;
+} // namespace
+
+LinkFrameParser::LinkFrameParser() : m_buffer(std::make_unique<uint8_t[]>(kCapacity))
+{
+}
+
+std::span<uint8_t> LinkFrameParser::writableSpace()
+{
+  if (m_head == m_tail) {
+    m_head = 0;
+    m_tail = 0;
+  } else if (kCapacity - m_tail < kReadChunk) {
+    // What is left is shorter than one frame, so this moves at most kMaxFrameSize bytes and then
+    // leaves room for at least one more chunk
+    std::memmove(m_buffer.get(), m_buffer.get() + m_head, m_tail - m_head);
+    m_tail -= m_head;
+    m_head = 0;
+  }
+  return {m_buffer.get() + m_tail, kCapacity - m_tail};
+}
+
+void LinkFrameParser::commit(size_t length)
+{
+  m_tail += length;
+}
+
+std::optional<LinkFrame> LinkFrameParser::next()
+{
+  while (m_tail - m_head >= kHeaderSize) {
+    const uint8_t *begin = m_buffer.get() + m_head;
+    const size_t available = m_tail - m_head;
+
+    if (begin[0] != kMagicLow || begin[1] != kMagicHigh) {
+      // Skip to the next candidate magic; a trailing low byte may be completed by the next read
+      const auto *candidate = static_cast<const uint8_t *>(std::memchr(begin + 1, kMagicLow, available - 1));
+      discard(candidate != nullptr ? static_cast<size_t>(candidate - begin) : available);
+      continue;
+    }
+
+    const size_t length = static_cast<size_t>(begin[6]) | (static_cast<size_t>(begin[7]) << 8);
+    if (available < kHeaderSize + length) {
+      return std::nullopt;
+    }
+
+    m_head += kHeaderSize + length;
+    if (begin[2] != kVersion) {
+      continue;
+    }
+    return LinkFrame{begin[3], begin[4], std::span<const uint8_t>(begin + kHeaderSize, length)};
+  }
+  return std::nullopt;
+}
+
+void LinkFrameParser::reset()
+{
+  m_head = 0;
+  m_tail = 0;
+}
+
+void LinkFrameParser::discard(size_t length)
+{
+  m_head += length;
+  m_discarded += length;
+}
+
+} // namespace deskflow::bridge
@@ -0,0 +1,95 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace deskflow::bridge {
+
+/**
+ * @brief Frame of the USB link protocol, pointing into the parser's receive buffer
+ */
+struct LinkFrame
+{
+  uint8_t type = 0;
+  uint8_t flags = 0;
+  std::span<const uint8_t> payload; // valid until the parser is written to again
+};
+
+/**
+ * @brief Incremental parser for the USB link protocol
+ *
+ * Bytes are read straight into writableSpace() and parsed in place, so a frame costs no copy and
+ * no allocation. The buffer has a fixed capacity large enough for the biggest frame plus one read;
+ * consumed bytes are reclaimed by moving the unparsed tail (at most one partial frame) back to the
+ * start, which happens only when the free space runs out.
+ *
+ * Resynchronising after line noise scans for the magic with memchr, so garbage costs linear time.
+ * Frames with an unknown link version are skipped.
+ */
+class LinkFrameParser
+{
+public:
+  static constexpr uint16_t kMagic = 0xC35A;
+  static constexpr uint8_t kVersion = 0x01;
+  static constexpr size_t kHeaderSize = 8;
+  static constexpr size_t kMaxFrameSize = kHeaderSize + 0xFFFF;
+  static constexpr size_t kReadChunk = 4096;
+  static constexpr size_t kCapacity = kMaxFrameSize + kReadChunk;
+
+  LinkFrameParser();
+
+  LinkFrameParser(const LinkFrameParser &) = delete;
+  LinkFrameParser &operator=(const LinkFrameParser &) = delete;
+
+  /**
+   * @brief Free space to read into, at least kReadChunk bytes
+   *
+   * Invalidates the payload of the last frame returned by next().
+   */
+  std::span<uint8_t> writableSpace();
+
+  /**
+   * @brief Account for bytes written into writableSpace()
+   */
+  void commit(size_t length);
+
+  /**
+   * @brief Next complete frame, or nothing until more bytes arrive
+   */
+  std::optional<LinkFrame> next();
+
+  void reset();
+
+  /**
+   * @brief Bytes received but not yet returned as part of a frame
+   */
+  size_t buffered() const
+  {
+    return m_tail - m_head;
+  }
+
+  /**
+   * @brief Bytes thrown away while looking for the start of a frame
+   */
+  uint64_t discarded() const
+  {
+    return m_discarded;
+  }
+
+private:
+  void discard(size_t length);
+
+  std::unique_ptr<uint8_t[]> m_buffer;
+  size_t m_head = 0; // first unparsed byte
+  size_t m_tail = 0; // end of received bytes
+  uint64_t m_discarded = 0;
+};
+
+} // namespace deskflow::bridge
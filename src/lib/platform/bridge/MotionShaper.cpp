@@ -0,0 +1,94 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "MotionShaper.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace deskflow::bridge {
+
+namespace {
+// Number of reports needed so that no axis moves more than maxStep in one of them
+int64_t reportsNeeded(int64_t remaining, int64_t maxStep)
+{
+  return (std::llabs(remaining) + maxStep - 1) / maxStep;
+}
+
+// Even share of remaining over the given number of reports, rounded to the nearest pixel
+int64_t share(int64_t remaining, int64_t reports)
+{
+  const int64_t magnitude = (std::llabs(remaining) * 2 + reports) / (reports * 2);
+  return remaining < 0 ? -magnitude : magnitude;
+}
+} // namespace
+
+MotionShaper::MotionShaper() : MotionShaper(Config{})
+{
+}
+
+MotionShaper::MotionShaper(Config config) : m_config(config)
+{
+  m_config.maxStep = std::clamp<int32_t>(m_config.maxStep, 1, 32767);
+  m_config.reportInterval = std::max(m_config.reportInterval, std::chrono::microseconds(0));
+}
+
+void MotionShaper::add(int32_t dx, int32_t dy)
+{
+  m_remainingX += dx;
+  m_remainingY += dy;
+}
+
+bool MotionShaper::hasPending() const
+{
+  return m_remainingX != 0 || m_remainingY != 0;
+}
+
+bool MotionShaper::next(Clock::time_point now, int16_t &dx, int16_t &dy)
+{
+  if (!hasPending() || now < m_nextReport) {
+    return false;
+  }
+
+  emit(dx, dy);
+  m_nextReport = now + m_config.reportInterval;
+  return true;
+}
+
+bool MotionShaper::nextImmediate(int16_t &dx, int16_t &dy)
+{
+  if (!hasPending()) {
+    return false;
+  }
+
+  emit(dx, dy);
+  return true;
+}
+
+MotionShaper::Clock::time_point MotionShaper::nextReportTime() const
+{
+  return m_nextReport;
+}
+
+void MotionShaper::reset()
+{
+  m_remainingX = 0;
+  m_remainingY = 0;
+  m_nextReport = Clock::time_point::min();
+}
+
+void MotionShaper::emit(int16_t &dx, int16_t &dy)
+{
+  const int64_t reports =
+      std::max({reportsNeeded(m_remainingX, m_config.maxStep), reportsNeeded(m_remainingY, m_config.maxStep), int64_t(1)});
+  const int64_t stepX = share(m_remainingX, reports);
+  const int64_t stepY = share(m_remainingY, reports);
+
+  m_remainingX -= stepX;
+  m_remainingY -= stepY;
+  dx = static_cast<int16_t>(stepX);
+  dy = static_cast<int16_t>(stepY);
+}
+
+} // namespace deskflow::bridge
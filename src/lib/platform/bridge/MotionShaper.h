@@ -0,0 +1,69 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace deskflow::bridge {
+
+/**
+ * @brief Splits relative mouse motion into paced HID reports
+ *
+ * A large delta (a fast flick, or the jump when the cursor enters the screen) is spread over
+ * several reports no larger than maxStep per axis, one per report interval, instead of reaching the
+ * phone as a single jump that its pointer acceleration would treat unevenly. Each report takes an
+ * even share of the remaining motion; whatever does not divide evenly stays in the remainder for the
+ * next report, so the total displacement is always preserved exactly.
+ *
+ * The shaper is not thread-safe and takes the current time as a parameter, which keeps it deterministic.
+ */
+class MotionShaper
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Config
+  {
+    std::chrono::microseconds reportInterval{0}; // 0 disables pacing
+    int32_t maxStep = 32767;                     // largest per-axis delta in one report
+  };
+
+  MotionShaper();
+  explicit MotionShaper(Config config);
+
+  void add(int32_t dx, int32_t dy);
+  bool hasPending() const;
+
+  /**
+   * @brief Emit the next report if pacing allows one at now
+   * @return false if nothing is pending or the next report is not due yet
+   */
+  bool next(Clock::time_point now, int16_t &dx, int16_t &dy);
+
+  /**
+   * @brief Emit the next report without waiting for the report interval
+   *
+   * Used to get all motion out before a button or key event that has to land at the final position.
+   */
+  bool nextImmediate(int16_t &dx, int16_t &dy);
+
+  /**
+   * @brief Earliest time at which next() will emit another report
+   */
+  Clock::time_point nextReportTime() const;
+
+  void reset();
+
+private:
+  void emit(int16_t &dx, int16_t &dy);
+
+  Config m_config;
+  int64_t m_remainingX = 0;
+  int64_t m_remainingY = 0;
+  Clock::time_point m_nextReport = Clock::time_point::min();
+};
+
+} // namespace deskflow::bridge
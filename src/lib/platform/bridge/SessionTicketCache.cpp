@@ -0,0 +1,247 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "SessionTicketCache.h"
+
+#include "base/Log.h"
+#include "common/Settings.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QLockFile>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace deskflow::bridge {
+
+namespace {
+// One ticket per line: <device path> <id> <key> <expiry, unix seconds> <device name>
+// Strings are hex encoded so paths and names with spaces survive, and "-" stands for empty
+using TicketMap = std::map<std::string, SessionTicket>;
+
+// How long a writer waits for another process to finish updating the file
+constexpr int kLockTimeoutMs = 2000;
+
+std::string toHex(const uint8_t *data, size_t length)
+{
+  static const char kDigits[] = "0123456789abcdef";
+  if (length == 0) {
+    return "-";
+  }
+  std::string hex;
+  hex.reserve(length * 2);
+  for (size_t i = 0; i < length; ++i) {
+    hex.push_back(kDigits[data[i] >> 4]);
+    hex.push_back(kDigits[data[i] & 0x0F]);
+  }
+  return hex;
+}
+
+std::string toHex(const std::string &text)
+{
+  return toHex(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+int hexDigit(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+bool fromHex(const std::string &hex, std::string &out)
+{
+  out.clear();
+  if (hex == "-") {
+    return true;
+  }
+  if (hex.size() % 2 != 0) {
+    return false;
+  }
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    const int high = hexDigit(hex[i]);
+    const int low = hexDigit(hex[i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    out.push_back(static_cast<char>((high << 4) | low));
+  }
+  return true;
+}
+
+template <size_t N> bool fromHex(const std::string &hex, std::array<uint8_t, N> &out)
+{
+  std::string bytes;
+  if (!fromHex(hex, bytes) || bytes.size() != N) {
+    return false;
+  }
+  std::copy(bytes.begin(), bytes.end(), out.begin());
+  return true;
+}
+
+TicketMap readTickets(const std::filesystem::path &filePath)
+{
+  TicketMap tickets;
+  std::ifstream file(filePath);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string path, id, key, name;
+    int64_t expiresAt = 0;
+    if (!(fields >> path >> id >> key >> expiresAt >> name)) {
+      continue;
+    }
+
+    std::string devicePath;
+    SessionTicket ticket;
+    if (!fromHex(path, devicePath) || !fromHex(id, ticket.id) || !fromHex(key, ticket.key) ||
+        !fromHex(name, ticket.deviceName)) {
+      continue;
+    }
+    ticket.expiresAt = std::chrono::system_clock::time_point(std::chrono::seconds(expiresAt));
+    tickets[devicePath] = ticket;
+  }
+  return tickets;
+}
+
+// Creates a file that nobody else may read, since it holds the ticket keys, and fills it with contents
+bool writeNewFile(const std::filesystem::path &filePath, const std::string &contents)
+{
+#if !defined(_WIN32)
+  // Owner-only from the moment it exists, rather than chmod'ed once written
+  const int fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    return false;
+  }
+  for (size_t written = 0; written < contents.size();) {
+    const auto result = ::write(fd, contents.data() + written, contents.size() - written);
+    if (result < 0 && errno != EINTR) {
+      ::close(fd);
+      return false;
+    }
+    written += result > 0 ? static_cast<size_t>(result) : 0;
+  }
+  return ::close(fd) == 0;
+#else
+  // The user config directory is already private to the user
+  std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+  return file.write(contents.data(), static_cast<std::streamsize>(contents.size())) && file.flush();
+#endif
+}
+
+void writeTickets(const std::filesystem::path &filePath, const TicketMap &tickets)
+{
+  std::error_code ec;
+  if (filePath.has_parent_path()) {
+    std::filesystem::create_directories(filePath.parent_path(), ec);
+  }
+
+  std::ostringstream contents;
+  const auto now = std::chrono::system_clock::now();
+  for (const auto &[devicePath, ticket] : tickets) {
+    if (ticket.expiresAt <= now) {
+      continue;
+    }
+    contents << toHex(devicePath) << ' ' << toHex(ticket.id.data(), ticket.id.size()) << ' '
+             << toHex(ticket.key.data(), ticket.key.size()) << ' '
+             << std::chrono::duration_cast<std::chrono::seconds>(ticket.expiresAt.time_since_epoch()).count() << ' '
+             << toHex(ticket.deviceName) << '\n';
+  }
+
+  // Write beside the target and rename over it, so a reader never sees a partial file. The name is
+  // unique to this write, so a stale temp file or another process can never get in the way
+  auto tempPath = filePath;
+  tempPath += "." + std::to_string(QCoreApplication::applicationPid()) + "-" +
+              std::to_string(QRandomGenerator::global()->generate()) + ".tmp";
+  if (!writeNewFile(tempPath, contents.str())) {
+    LOG_WARN("CDC: failed to write session tickets to %s", tempPath.string().c_str());
+    std::filesystem::remove(tempPath, ec);
+    return;
+  }
+
+  std::filesystem::rename(tempPath, filePath, ec);
+  if (ec) {
+    LOG_WARN("CDC: failed to replace session ticket file: %s", ec.message().c_str());
+    std::filesystem::remove(tempPath, ec);
+  }
+}
+} // namespace
+
+SessionTicketCache::SessionTicketCache(std::filesystem::path filePath) : m_filePath(std::move(filePath))
+{
+}
+
+std::shared_ptr<SessionTicketCache> SessionTicketCache::shared()
+{
+  static const auto cache = std::make_shared<SessionTicketCache>(
+      std::filesystem::path(QDir(Settings::UserDir).filePath(QStringLiteral("bridge-sessions")).toStdU16String())
+  );
+  return cache;
+}
+
+std::optional<SessionTicket> SessionTicketCache::find(const std::string &devicePath) const
+{
+  std::scoped_lock lock(m_mutex);
+  const auto tickets = readTickets(m_filePath);
+  const auto it = tickets.find(devicePath);
+  if (it == tickets.end() || it->second.expiresAt <= std::chrono::system_clock::now()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void SessionTicketCache::store(const std::string &devicePath, const SessionTicket &ticket)
+{
+  update([&devicePath, &ticket](TicketMap &tickets) {
+    tickets[devicePath] = ticket;
+    return true;
+  });
+}
+
+void SessionTicketCache::erase(const std::string &devicePath)
+{
+  update([&devicePath](TicketMap &tickets) { return tickets.erase(devicePath) != 0; });
+}
+
+void SessionTicketCache::update(const std::function<bool(TicketMap &)> &change)
+{
+  std::scoped_lock lock(m_mutex);
+
+  // The GUI and every core process share the file, so the read-modify-write is serialised across
+  // processes too; otherwise one writer would undo another's change
+  std::error_code ec;
+  if (m_filePath.has_parent_path()) {
+    std::filesystem::create_directories(m_filePath.parent_path(), ec);
+  }
+  auto lockPath = m_filePath;
+  lockPath += ".lock";
+  QLockFile fileLock(QString::fromStdU16String(lockPath.u16string()));
+  if (!fileLock.tryLock(kLockTimeoutMs)) {
+    LOG_WARN("CDC: session ticket file is locked by another process, not updating it");
+    return;
+  }
+
+  auto tickets = readTickets(m_filePath);
+  if (change(tickets)) {
+    writeTickets(m_filePath, tickets);
+  }
+}
+
+} // namespace deskflow::bridge
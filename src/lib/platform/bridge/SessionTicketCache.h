@@ -0,0 +1,78 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace deskflow::bridge {
+
+/**
+ * @brief Session ticket issued by the firmware after a verified ECDSA handshake
+ *
+ * Presenting the ticket id in HELLO lets a reopen within the ticket lifetime resume the session
+ * in one round-trip: the firmware proves it holds the ticket key with an HMAC over both nonces
+ * instead of an ECDSA signature, and the handshake skips the device name and serial queries.
+ */
+struct SessionTicket
+{
+  static constexpr size_t kIdSize = 16;
+  static constexpr size_t kKeySize = 32;
+
+  std::array<uint8_t, kIdSize> id{};
+  std::array<uint8_t, kKeySize> key{};
+  std::chrono::system_clock::time_point expiresAt;
+  std::string deviceName; // cached so a resumed session does not have to ask again
+};
+
+/**
+ * @brief File-backed store of session tickets, keyed by device path
+ *
+ * The GUI and deskflow-core open the same device from different processes, so tickets are kept
+ * in a small file readable only by the user. Writes replace the file atomically, and updates hold
+ * a lock file so processes storing tickets at the same time keep each other's.
+ */
+class SessionTicketCache
+{
+public:
+  explicit SessionTicketCache(std::filesystem::path filePath);
+
+  /**
+   * @brief Cache shared by every transport in this process, stored in the user config directory
+   */
+  static std::shared_ptr<SessionTicketCache> shared();
+
+  /**
+   * @brief Look up an unexpired ticket for the device
+   */
+  std::optional<SessionTicket> find(const std::string &devicePath) const;
+
+  void store(const std::string &devicePath, const SessionTicket &ticket);
+  void erase(const std::string &devicePath);
+
+  const std::filesystem::path &filePath() const
+  {
+    return m_filePath;
+  }
+
+private:
+  using TicketMap = std::map<std::string, SessionTicket>;
+
+  // Applies change to the tickets on file and writes them back if it returns true
+  void update(const std::function<bool(TicketMap &)> &change);
+
+  std::filesystem::path m_filePath;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace deskflow::bridge
@@ -0,0 +1,50 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "EventHandlerTableBenchmarks.h"
+
+#include "base/Event.h"
+#include "base/EventHandlerTable.h"
+
+namespace {
+
+void *targetFor(uintptr_t n)
+{
+  return reinterpret_cast<void *>((n + 1) * 64);
+}
+
+} // namespace
+
+void EventHandlerTableBenchmarks::dispatch_data()
+{
+  QTest::addColumn<size_t>("targets");
+
+  for (const size_t targets : {4, 64, 1024}) {
+    QTest::addRow("%zu targets", targets) << targets;
+  }
+}
+
+void EventHandlerTableBenchmarks::dispatch()
+{
+  QFETCH(size_t, targets);
+
+  // Two handlers per target, as a socket or timer owner registers, and timer events spread over them all
+  constexpr size_t kDispatches = 100000;
+  EventHandlerTable table;
+  size_t calls = 0;
+  for (uintptr_t n = 0; n < targets; ++n) {
+    table.add(EventTypes::Timer, targetFor(n), [&calls](const Event &) { ++calls; });
+    table.add(EventTypes::SocketDisconnected, targetFor(n), [&calls](const Event &) { ++calls; });
+  }
+
+  QBENCHMARK {
+    calls = 0;
+    for (size_t i = 0; i < kDispatches; ++i) {
+      table.dispatch(Event(EventTypes::Timer, targetFor(i % targets)));
+    }
+  }
+  QCOMPARE(calls, kDispatches);
+}
+
+QTEST_MAIN(EventHandlerTableBenchmarks)
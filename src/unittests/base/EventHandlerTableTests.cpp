@@ -0,0 +1,135 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "EventHandlerTableTests.h"
+
+#include "base/Event.h"
+#include "base/EventHandlerTable.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void *targetFor(uintptr_t n)
+{
+  return reinterpret_cast<void *>((n + 1) * 64);
+}
+
+} // namespace
+
+void EventHandlerTableTests::dispatchFindsHandlerByTargetAndType()
+{
+  EventHandlerTable table;
+  std::vector<std::pair<uintptr_t, EventTypes>> seen;
+  for (uintptr_t n = 0; n < 100; ++n) {
+    for (auto type : {EventTypes::Timer, EventTypes::DataSocketConnected}) {
+      table.add(type, targetFor(n), [&seen, n](const Event &event) { seen.emplace_back(n, event.getType()); });
+    }
+  }
+  QCOMPARE(table.size(), size_t(200));
+
+  QVERIFY(table.dispatch(Event(EventTypes::DataSocketConnected, targetFor(42))));
+  QVERIFY(table.dispatch(Event(EventTypes::Timer, targetFor(7))));
+  QVERIFY(!table.dispatch(Event(EventTypes::SocketDisconnected, targetFor(7))));
+  QVERIFY(!table.dispatch(Event(EventTypes::Timer, targetFor(100))));
+
+  QCOMPARE(seen.size(), size_t(2));
+  QCOMPARE(seen[0].first, uintptr_t(42));
+  QVERIFY(seen[0].second == EventTypes::DataSocketConnected);
+  QCOMPARE(seen[1].first, uintptr_t(7));
+  QVERIFY(seen[1].second == EventTypes::Timer);
+}
+
+void EventHandlerTableTests::unknownTypeCatchesTheRest()
+{
+  EventHandlerTable table;
+  int specific = 0;
+  int any = 0;
+  table.add(EventTypes::Timer, targetFor(1), [&specific](const Event &) { ++specific; });
+  table.add(EventTypes::Unknown, targetFor(1), [&any](const Event &) { ++any; });
+
+  QVERIFY(table.dispatch(Event(EventTypes::Timer, targetFor(1))));
+  QVERIFY(table.dispatch(Event(EventTypes::DataSocketConnected, targetFor(1))));
+  QCOMPARE(specific, 1);
+  QCOMPARE(any, 1);
+}
+
+void EventHandlerTableTests::addReplacesAndRemoveForgets()
+{
+  EventHandlerTable table;
+  int first = 0;
+  int second = 0;
+  table.add(EventTypes::Timer, targetFor(1), [&first](const Event &) { ++first; });
+  table.add(EventTypes::Timer, targetFor(1), [&second](const Event &) { ++second; });
+  table.add(EventTypes::DataSocketConnected, targetFor(1), [](const Event &) {});
+  table.add(EventTypes::Timer, targetFor(2), [](const Event &) {});
+  QCOMPARE(table.size(), size_t(3));
+
+  QVERIFY(table.dispatch(Event(EventTypes::Timer, targetFor(1))));
+  QCOMPARE(first, 0);
+  QCOMPARE(second, 1);
+
+  table.remove(EventTypes::Timer, targetFor(1));
+  QVERIFY(!table.dispatch(Event(EventTypes::Timer, targetFor(1))));
+  QCOMPARE(table.size(), size_t(2));
+
+  table.removeAll(targetFor(1));
+  QVERIFY(!table.dispatch(Event(EventTypes::DataSocketConnected, targetFor(1))));
+  QVERIFY(table.dispatch(Event(EventTypes::Timer, targetFor(2))));
+  QCOMPARE(table.size(), size_t(1));
+}
+
+void EventHandlerTableTests::handlerMayRemoveItself()
+{
+  EventHandlerTable table;
+  int calls = 0;
+  std::string captured = "kept alive while running";
+  table.add(EventTypes::Timer, targetFor(1), [&table, &calls, captured](const Event &) {
+    // The running handler must survive its own removal and the tables built around it
+    table.removeAll(targetFor(1));
+    for (uintptr_t n = 2; n < 50; ++n) {
+      table.add(EventTypes::Timer, targetFor(n), [](const Event &) {});
+    }
+    calls += captured.size() == 24 ? 1 : 100;
+  });
+
+  QVERIFY(table.dispatch(Event(EventTypes::Timer, targetFor(1))));
+  QCOMPARE(calls, 1);
+  QVERIFY(!table.dispatch(Event(EventTypes::Timer, targetFor(1))));
+  QCOMPARE(table.size(), size_t(48));
+}
+
+void EventHandlerTableTests::dispatchWhileRegistering()
+{
+  EventHandlerTable table;
+  std::atomic_int calls = 0;
+  table.add(EventTypes::Timer, targetFor(0), [&calls](const Event &) { ++calls; });
+
+  std::atomic_bool stop = false;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i) {
+    readers.emplace_back([&table, &stop] {
+      while (!stop.load()) {
+        table.dispatch(Event(EventTypes::Timer, targetFor(0)));
+        table.dispatch(Event(EventTypes::Timer, targetFor(1)));
+      }
+    });
+  }
+
+  for (int round = 0; round < 2000; ++round) {
+    table.add(EventTypes::Timer, targetFor(1), [](const Event &) {});
+    table.remove(EventTypes::Timer, targetFor(1));
+  }
+  stop = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  QVERIFY(calls > 0);
+  QCOMPARE(table.size(), size_t(1));
+}
+
+QTEST_MAIN(EventHandlerTableTests)
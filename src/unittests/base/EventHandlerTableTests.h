@@ -0,0 +1,16 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class EventHandlerTableTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void dispatchFindsHandlerByTargetAndType();
+  void unknownTypeCatchesTheRest();
+  void addReplacesAndRemoveForgets();
+  void handlerMayRemoveItself();
+  void dispatchWhileRegistering();
+};
@@ -0,0 +1,83 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "EventQueueBenchmarks.h"
+
+#include "base/EventQueue.h"
+#include "base/SimpleEventQueueBuffer.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+void EventQueueBenchmarks::initTestCase()
+{
+  m_arch.init();
+}
+
+void EventQueueBenchmarks::addEventFromThreads_data()
+{
+  QTest::addColumn<bool>("lockedBuffer");
+  QTest::addColumn<unsigned>("producers");
+
+  for (const unsigned producers : {1u, 2u, 4u, 8u}) {
+    QTest::addRow("default buffer, %u producer(s)", producers) << false << producers;
+    QTest::addRow("SimpleEventQueueBuffer, %u producer(s)", producers) << true << producers;
+  }
+}
+
+void EventQueueBenchmarks::addEventFromThreads()
+{
+  QFETCH(bool, lockedBuffer);
+  QFETCH(unsigned, producers);
+
+  // Threads add events while the loop dispatches them, the way transport and input threads do
+  constexpr uint64_t kPerProducer = 50000;
+  const uint64_t total = producers * kPerProducer;
+  EventQueue events;
+  if (lockedBuffer) {
+    events.adoptBuffer(new SimpleEventQueueBuffer);
+  }
+
+  // The producers start once the loop dispatches the first event, so they never add to a queue
+  // that is not ready yet
+  int start = 0;
+  std::atomic_bool started = false;
+  events.addHandler(EventTypes::DataSocketConnected, &start, [&started](const Event &) { started = true; });
+
+  int target = 0;
+  uint64_t received = 0;
+  events.addHandler(EventTypes::DataSocketConnected, &target, [&events, &received, total](const Event &) {
+    if (++received == total) {
+      events.addEvent(Event(EventTypes::Quit));
+    }
+  });
+
+  QBENCHMARK {
+    started = false;
+    received = 0;
+    std::vector<std::thread> threads;
+    for (unsigned producer = 0; producer < producers; ++producer) {
+      threads.emplace_back([&events, &started, &target] {
+        while (!started) {
+          std::this_thread::yield();
+        }
+        for (uint64_t i = 0; i < kPerProducer; ++i) {
+          events.addEvent(Event(EventTypes::DataSocketConnected, &target));
+        }
+      });
+    }
+    events.addEvent(Event(EventTypes::DataSocketConnected, &start));
+    events.loop();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  events.removeHandlers(&start);
+  events.removeHandlers(&target);
+  QCOMPARE(received, total);
+}
+
+QTEST_MAIN(EventQueueBenchmarks)
@@ -0,0 +1,21 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#include <QTest>
+
+class EventQueueBenchmarks : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void initTestCase();
+  void addEventFromThreads_data();
+  void addEventFromThreads();
+
+private:
+  Arch m_arch;
+  Log m_log;
+};
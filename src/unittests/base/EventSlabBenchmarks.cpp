@@ -0,0 +1,48 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "EventSlabBenchmarks.h"
+
+#include "base/EventSlab.h"
+
+#include <deque>
+
+void EventSlabBenchmarks::motionFlood_data()
+{
+  QTest::addColumn<size_t>("burst");
+
+  for (const size_t burst : {1, 16, 256}) {
+    QTest::addRow("bursts of %zu", burst) << burst;
+  }
+}
+
+void EventSlabBenchmarks::motionFlood()
+{
+  QFETCH(size_t, burst);
+
+  // A second of motion at 100k events/s, arriving in bursts while the event loop is busy and
+  // taken out in order, as the queue buffer would
+  constexpr size_t kEvents = 100000;
+  EventSlab slab;
+  std::deque<uint32_t> pending;
+  uintptr_t checksum = 0;
+  QBENCHMARK {
+    checksum = 0;
+    for (size_t sent = 0; sent < kEvents;) {
+      for (size_t i = 0; i < burst && sent < kEvents; ++i, ++sent) {
+        const auto target = reinterpret_cast<void *>(sent + 1);
+        pending.push_back(*slab.insert(Event(EventTypes::PrimaryScreenMotionOnSecondary, target)));
+      }
+      while (!pending.empty()) {
+        Event event;
+        slab.remove(pending.front(), event);
+        checksum += reinterpret_cast<uintptr_t>(event.getTarget());
+        pending.pop_front();
+      }
+    }
+  }
+  QCOMPARE(checksum, kEvents * (kEvents + 1) / 2);
+}
+
+QTEST_MAIN(EventSlabBenchmarks)
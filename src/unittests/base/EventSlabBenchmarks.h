@@ -0,0 +1,13 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class EventSlabBenchmarks : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void motionFlood_data();
+  void motionFlood();
+};
@@ -0,0 +1,123 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "EventSlabTests.h"
+
+#include "base/EventSlab.h"
+
+#include <vector>
+
+namespace {
+
+void *targetFor(uintptr_t n)
+{
+  return reinterpret_cast<void *>(n + 1);
+}
+
+Event motionEvent(uintptr_t n)
+{
+  return Event(EventTypes::PrimaryScreenMotionOnSecondary, targetFor(n));
+}
+
+} // namespace
+
+void EventSlabTests::eventsComeBackById()
+{
+  EventSlab slab;
+  std::vector<uint32_t> ids;
+  for (uintptr_t n = 0; n < 3; ++n) {
+    const auto id = slab.insert(motionEvent(n));
+    QVERIFY(id.has_value());
+    ids.push_back(*id);
+  }
+  QCOMPARE(slab.size(), size_t(3));
+
+  for (uintptr_t n : {1, 0, 2}) {
+    Event event;
+    QVERIFY(slab.remove(ids[n], event));
+    QCOMPARE(event.getTarget(), targetFor(n));
+    QVERIFY(event.getType() == EventTypes::PrimaryScreenMotionOnSecondary);
+  }
+  QVERIFY(slab.empty());
+}
+
+void EventSlabTests::staleIdsAreRejected()
+{
+  EventSlab slab;
+  const auto first = slab.insert(motionEvent(1));
+  Event event;
+  QVERIFY(slab.remove(*first, event));
+  QVERIFY(!slab.remove(*first, event));
+
+  // The slot is reused under a new generation, so the old ID still does not reach its event
+  const auto second = slab.insert(motionEvent(2));
+  QVERIFY(*second != *first);
+  QVERIFY(!slab.remove(*first, event));
+  QVERIFY(slab.remove(*second, event));
+  QCOMPARE(event.getTarget(), targetFor(2));
+
+  QVERIFY(!slab.remove(12345, event));
+}
+
+void EventSlabTests::clearInvalidatesIds()
+{
+  EventSlab slab;
+  const auto first = slab.insert(motionEvent(1));
+  const auto second = slab.insert(motionEvent(2));
+
+  int visited = 0;
+  slab.clear([&visited](const Event &) { ++visited; });
+  QCOMPARE(visited, 2);
+  QVERIFY(slab.empty());
+
+  Event event;
+  QVERIFY(!slab.remove(*first, event));
+  QVERIFY(!slab.remove(*second, event));
+}
+
+void EventSlabTests::fullSlabLeavesEventAlone()
+{
+  EventSlab slab(2);
+  QVERIFY(slab.insert(motionEvent(1)).has_value());
+  QVERIFY(slab.insert(motionEvent(2)).has_value());
+
+  Event event = motionEvent(3);
+  QVERIFY(!slab.insert(std::move(event)).has_value());
+  QCOMPARE(event.getTarget(), targetFor(3));
+  QCOMPARE(slab.size(), size_t(2));
+}
+
+void EventSlabTests::freedSlotsAreReusedOldestFirst()
+{
+  EventSlab slab;
+  const auto first = slab.insert(motionEvent(1));
+  const auto second = slab.insert(motionEvent(2));
+  const auto third = slab.insert(motionEvent(3));
+  Event event;
+  QVERIFY(slab.remove(*second, event));
+  QVERIFY(slab.remove(*first, event));
+
+  constexpr uint32_t kIndex = EventSlab::kMaxEvents - 1;
+  QCOMPARE(*slab.insert(motionEvent(4)) & kIndex, *second & kIndex);
+  QCOMPARE(*slab.insert(motionEvent(5)) & kIndex, *first & kIndex);
+  QVERIFY(slab.remove(*third, event));
+}
+
+void EventSlabTests::staleIdsSurviveSlotReuse()
+{
+  // One event at a time keeps reusing the same slot, the worst case for a stale ID
+  EventSlab slab;
+  const auto stale = slab.insert(motionEvent(0));
+  Event event;
+  QVERIFY(slab.remove(*stale, event));
+
+  for (uint32_t reuse = 1; reuse < 65536; ++reuse) {
+    const auto id = slab.insert(motionEvent(reuse));
+    QCOMPARE(*id & (EventSlab::kMaxEvents - 1), *stale & (EventSlab::kMaxEvents - 1));
+    QVERIFY(!slab.remove(*stale, event));
+    QVERIFY(slab.remove(*id, event));
+  }
+}
+
+QTEST_MAIN(EventSlabTests)
@@ -0,0 +1,17 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class EventSlabTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void eventsComeBackById();
+  void staleIdsAreRejected();
+  void clearInvalidatesIds();
+  void fullSlabLeavesEventAlone();
+  void freedSlotsAreReusedOldestFirst();
+  void staleIdsSurviveSlotReuse();
+};
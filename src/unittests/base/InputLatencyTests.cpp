@@ -0,0 +1,106 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "InputLatencyTests.h"
+
+#include "base/InputLatency.h"
+
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using deskflow::InputLatency;
+using deskflow::LatencyHistogram;
+
+namespace {
+bool withinBucketError(std::chrono::nanoseconds value, std::chrono::nanoseconds expected)
+{
+  // A bucket spans one eighth of its power of two
+  const auto tolerance = expected.count() / 8 + 1;
+  return value.count() >= expected.count() - tolerance && value.count() <= expected.count() + tolerance;
+}
+} // namespace
+
+void InputLatencyTests::emptyHistogram()
+{
+  LatencyHistogram histogram;
+  const auto summary = histogram.summary();
+  QCOMPARE(summary.count, 0u);
+  QCOMPARE(summary.p50.count(), 0);
+  QCOMPARE(summary.max.count(), 0);
+}
+
+void InputLatencyTests::percentilesWithinBucketError()
+{
+  LatencyHistogram histogram;
+  for (int us = 1; us <= 1000; ++us) {
+    histogram.record(std::chrono::microseconds(us));
+  }
+
+  const auto summary = histogram.summary();
+  QCOMPARE(summary.count, 1000u);
+  QVERIFY2(withinBucketError(summary.p50, 500us), QByteArray::number(qint64(summary.p50.count())));
+  QVERIFY2(withinBucketError(summary.p99, 990us), QByteArray::number(qint64(summary.p99.count())));
+  QCOMPARE(summary.max, std::chrono::nanoseconds(1000us));
+
+  histogram.reset();
+  QCOMPARE(histogram.summary().count, 0u);
+}
+
+void InputLatencyTests::concurrentRecording()
+{
+  LatencyHistogram histogram;
+  constexpr int kThreads = 4;
+  constexpr int kSamples = 10000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&histogram, t] {
+      for (int i = 0; i < kSamples; ++i) {
+        histogram.record(std::chrono::nanoseconds(100 * (t + 1)));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const auto summary = histogram.summary();
+  QCOMPARE(summary.count, uint64_t(kThreads * kSamples));
+  QCOMPARE(summary.max.count(), 400);
+  QVERIFY(withinBucketError(summary.p50, 200ns));
+}
+
+void InputLatencyTests::stagesFollowTrace()
+{
+  using Stage = InputLatency::Stage;
+  auto &latency = InputLatency::instance();
+  latency.reset();
+
+  const InputLatency::Clock::time_point start = InputLatency::Clock::now();
+  InputLatency::markReceived(start);
+  InputLatency::markDispatched(start + 10us);
+  const auto trace = InputLatency::markQueued(start + 30us);
+  // A second event from the same message is not charged with the dispatch again
+  InputLatency::markQueued(start + 40us);
+  latency.recordWritten(trace, start + 100us);
+
+  QCOMPARE(latency.histogram(Stage::ReceiveToDispatch).summary().max, std::chrono::nanoseconds(10us));
+  QCOMPARE(latency.histogram(Stage::DispatchToQueue).summary().count, 1u);
+  QCOMPARE(latency.histogram(Stage::DispatchToQueue).summary().max, std::chrono::nanoseconds(20us));
+  QCOMPARE(latency.histogram(Stage::QueueToWrite).summary().max, std::chrono::nanoseconds(70us));
+  QCOMPARE(latency.histogram(Stage::Total).summary().max, std::chrono::nanoseconds(100us));
+
+  // Output queued outside a message only counts towards the write stage
+  InputLatency::clearCurrent();
+  const auto untraced = InputLatency::markQueued(start + 200us);
+  latency.recordWritten(untraced, start + 210us);
+  QCOMPARE(latency.histogram(Stage::QueueToWrite).summary().count, 2u);
+  QCOMPARE(latency.histogram(Stage::Total).summary().count, 1u);
+
+  latency.report();
+  latency.reset();
+}
+
+QTEST_MAIN(InputLatencyTests)
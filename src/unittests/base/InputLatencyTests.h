@@ -0,0 +1,20 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include <QTest>
+
+class InputLatencyTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void emptyHistogram();
+  void percentilesWithinBucketError();
+  void concurrentRecording();
+  void stagesFollowTrace();
+
+private:
+  Log m_log;
+};
@@ -0,0 +1,165 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "MpscEventQueueBufferTests.h"
+
+#include "base/Event.h"
+#include "base/MpscEventQueueBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr unsigned kProducerShift = 24;
+
+bool take(IEventQueueBuffer &buffer, uint32_t &dataID)
+{
+  Event event;
+  return buffer.getEvent(event, dataID) == IEventQueueBuffer::Type::User;
+}
+
+/**
+ * Every producer adds its own numbered events while one consumer takes them out, as the event
+ * loop would. Returns false if an event went missing or overtook one from the same producer.
+ */
+bool runProducers(IEventQueueBuffer &buffer, unsigned producers, uint32_t perProducer)
+{
+  std::atomic_bool go = false;
+  std::vector<std::thread> threads;
+  for (uint32_t producer = 0; producer < producers; ++producer) {
+    threads.emplace_back([&buffer, &go, producer, perProducer] {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (uint32_t i = 0; i < perProducer; ++i) {
+        buffer.addEvent((producer << kProducerShift) | i);
+      }
+    });
+  }
+
+  std::vector<uint32_t> next(producers, 0);
+  const uint64_t total = uint64_t(producers) * perProducer;
+  bool ordered = true;
+  go.store(true, std::memory_order_release);
+  for (uint64_t received = 0; received < total;) {
+    while (buffer.isEmpty()) {
+      buffer.waitForEvent(1.0);
+    }
+    uint32_t dataID = 0;
+    if (!take(buffer, dataID)) {
+      continue;
+    }
+    const uint32_t producer = dataID >> kProducerShift;
+    const uint32_t sequence = dataID & ((1u << kProducerShift) - 1);
+    ordered = ordered && producer < producers && sequence == next[producer];
+    if (producer < producers) {
+      next[producer] = sequence + 1;
+    }
+    ++received;
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  return ordered && buffer.isEmpty();
+}
+
+} // namespace
+
+void MpscEventQueueBufferTests::initTestCase()
+{
+  m_arch.init();
+}
+
+void MpscEventQueueBufferTests::eventsComeOutInOrder()
+{
+  MpscEventQueueBuffer buffer;
+  QVERIFY(buffer.isEmpty());
+
+  for (uint32_t id = 0; id < 100; ++id) {
+    QVERIFY(buffer.addEvent(id));
+  }
+  QVERIFY(!buffer.isEmpty());
+
+  for (uint32_t id = 0; id < 100; ++id) {
+    uint32_t dataID = 0;
+    QVERIFY(take(buffer, dataID));
+    QCOMPARE(dataID, id);
+  }
+  QVERIFY(buffer.isEmpty());
+
+  uint32_t dataID = 0;
+  QVERIFY(!take(buffer, dataID));
+}
+
+void MpscEventQueueBufferTests::overflowKeepsOrder()
+{
+  MpscEventQueueBuffer buffer(4);
+  for (uint32_t id = 0; id < 10; ++id) {
+    QVERIFY(buffer.addEvent(id));
+  }
+
+  // A freed ring slot must not let a later event overtake the ones waiting in the overflow list
+  uint32_t dataID = 0;
+  QVERIFY(take(buffer, dataID));
+  QCOMPARE(dataID, 0u);
+  QVERIFY(buffer.addEvent(10));
+
+  for (uint32_t id = 1; id <= 10; ++id) {
+    QVERIFY(take(buffer, dataID));
+    QCOMPARE(dataID, id);
+  }
+  QVERIFY(buffer.isEmpty());
+
+  // Once drained, events go through the ring again
+  QVERIFY(buffer.addEvent(11));
+  QVERIFY(take(buffer, dataID));
+  QCOMPARE(dataID, 11u);
+}
+
+void MpscEventQueueBufferTests::addEventWakesWaiter()
+{
+  MpscEventQueueBuffer buffer;
+  std::thread producer([&buffer] {
+    std::this_thread::sleep_for(20ms);
+    buffer.addEvent(7);
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  while (buffer.isEmpty()) {
+    buffer.waitForEvent(5.0);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  producer.join();
+
+  QVERIFY2(elapsed < 1s, QByteArray::number(std::chrono::duration<double>(elapsed).count()));
+  uint32_t dataID = 0;
+  QVERIFY(take(buffer, dataID));
+  QCOMPARE(dataID, 7u);
+}
+
+void MpscEventQueueBufferTests::waitTimesOut()
+{
+  MpscEventQueueBuffer buffer;
+  const auto start = std::chrono::steady_clock::now();
+  buffer.waitForEvent(0.02);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  QVERIFY(buffer.isEmpty());
+  QVERIFY2(elapsed >= 15ms && elapsed < 1s, QByteArray::number(std::chrono::duration<double>(elapsed).count()));
+}
+
+void MpscEventQueueBufferTests::concurrentProducersKeepTheirOrder()
+{
+  // A small ring makes the producers spill into the overflow list now and then
+  MpscEventQueueBuffer buffer(64);
+  QVERIFY(runProducers(buffer, 4, 50000));
+}
+
+QTEST_MAIN(MpscEventQueueBufferTests)
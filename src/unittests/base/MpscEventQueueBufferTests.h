@@ -0,0 +1,24 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#include <QTest>
+
+class MpscEventQueueBufferTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void initTestCase();
+  void eventsComeOutInOrder();
+  void overflowKeepsOrder();
+  void addEventWakesWaiter();
+  void waitTimesOut();
+  void concurrentProducersKeepTheirOrder();
+
+private:
+  Arch m_arch;
+  Log m_log;
+};
@@ -0,0 +1,56 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "TimerWheelBenchmarks.h"
+
+#include "base/TimerWheel.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+void TimerWheelBenchmarks::churn_data()
+{
+  QTest::addColumn<size_t>("timers");
+
+  for (const size_t timers : {100, 1000, 4000}) {
+    QTest::addRow("%zu timers", timers) << timers;
+  }
+}
+
+void TimerWheelBenchmarks::churn()
+{
+  QFETCH(size_t, timers);
+
+  // Many clients' keepalive timers, each re-armed every round, with the clock checked in between
+  constexpr int kRounds = 20;
+  std::mt19937 random(1);
+  std::vector<std::unique_ptr<TimerWheel::Entry>> entries(timers);
+  for (auto &entry : entries) {
+    entry = std::make_unique<TimerWheel::Entry>();
+  }
+
+  TimerWheel wheel;
+  size_t fired = 0;
+  QBENCHMARK {
+    for (int round = 0; round < kRounds; ++round) {
+      for (auto &entry : entries) {
+        wheel.cancel(*entry);
+        wheel.schedule(*entry, wheel.now() + 3000 + random() % 1000);
+      }
+      wheel.advance(wheel.now() + 1);
+      while (wheel.popExpired() != nullptr) {
+        ++fired;
+      }
+    }
+  }
+  QCOMPARE(fired, size_t(0));
+  QCOMPARE(wheel.size(), timers);
+
+  for (auto &entry : entries) {
+    wheel.cancel(*entry);
+  }
+}
+
+QTEST_MAIN(TimerWheelBenchmarks)
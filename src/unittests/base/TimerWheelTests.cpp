@@ -0,0 +1,176 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "TimerWheelTests.h"
+
+#include "base/TimerWheel.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct TestEntry : TimerWheel::Entry
+{
+  uint64_t firedAt = 0;
+  int fired = 0;
+};
+
+std::vector<TestEntry *> drain(TimerWheel &wheel)
+{
+  std::vector<TestEntry *> popped;
+  while (auto *entry = static_cast<TestEntry *>(wheel.popExpired())) {
+    entry->firedAt = wheel.now();
+    ++entry->fired;
+    popped.push_back(entry);
+  }
+  return popped;
+}
+
+} // namespace
+
+void TimerWheelTests::firesAtDeadline()
+{
+  TimerWheel wheel;
+  std::vector<std::unique_ptr<TestEntry>> entries;
+  const std::vector<uint64_t> deadlines = {1, 5, 63, 64, 65, 4095, 4096, 4099, 300000};
+  for (uint64_t deadline : deadlines) {
+    entries.push_back(std::make_unique<TestEntry>());
+    wheel.schedule(*entries.back(), deadline);
+  }
+  QCOMPARE(wheel.size(), deadlines.size());
+
+  for (uint64_t tick = 1; tick <= 300000; ++tick) {
+    wheel.advance(tick);
+    for (auto *entry : drain(wheel)) {
+      QCOMPARE(entry->firedAt, entry->deadline());
+    }
+  }
+
+  QVERIFY(wheel.empty());
+  for (const auto &entry : entries) {
+    QCOMPARE(entry->fired, 1);
+    QVERIFY(!entry->isScheduled());
+  }
+}
+
+void TimerWheelTests::cancelAndReschedule()
+{
+  TimerWheel wheel;
+  TestEntry cancelled;
+  TestEntry moved;
+  TestEntry kept;
+  wheel.schedule(cancelled, 100);
+  wheel.schedule(moved, 100);
+  wheel.schedule(kept, 5000);
+
+  wheel.cancel(cancelled);
+  wheel.cancel(cancelled);
+  wheel.schedule(moved, 7000);
+  QCOMPARE(wheel.size(), size_t(2));
+
+  wheel.advance(6999);
+  auto popped = drain(wheel);
+  QCOMPARE(popped.size(), size_t(1));
+  QCOMPARE(popped[0], &kept);
+
+  wheel.advance(7000);
+  popped = drain(wheel);
+  QCOMPARE(popped.size(), size_t(1));
+  QCOMPARE(popped[0], &moved);
+  QCOMPARE(cancelled.fired, 0);
+  QVERIFY(wheel.empty());
+}
+
+void TimerWheelTests::pastDeadlineIsDue()
+{
+  TimerWheel wheel(1000);
+  TestEntry late;
+  TestEntry now;
+  wheel.schedule(late, 10);
+  wheel.schedule(now, 1000);
+  QCOMPARE(wheel.nextDeadline(), std::optional<uint64_t>(1000));
+
+  const auto popped = drain(wheel);
+  QCOMPARE(popped.size(), size_t(2));
+  QCOMPARE(popped[0], &late);
+  QCOMPARE(popped[1], &now);
+
+  // the clock never runs backwards
+  wheel.advance(500);
+  QCOMPARE(wheel.now(), uint64_t(1000));
+}
+
+void TimerWheelTests::randomDeadlinesFireOnTime()
+{
+  std::mt19937_64 random(42);
+  TimerWheel wheel(random() % 1000000);
+  std::vector<std::unique_ptr<TestEntry>> entries(3000);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    entries[i] = std::make_unique<TestEntry>();
+    // Spread across every level and past the end of the wheel
+    const uint64_t delay = 1 + (random() >> (random() % 62));
+    wheel.schedule(*entries[i], wheel.now() + std::min<uint64_t>(delay, uint64_t{1} << 34));
+  }
+
+  // Advance in uneven jumps; an entry must pop on the first advance that reaches its deadline
+  uint64_t previous = wheel.now();
+  while (!wheel.empty()) {
+    const uint64_t now = previous + 1 + (random() >> (random() % 64 + 20));
+    wheel.advance(now);
+    for (auto *entry : drain(wheel)) {
+      QVERIFY2(entry->deadline() <= now, QByteArray::number(qulonglong(entry->deadline())));
+      QVERIFY2(entry->deadline() > previous, QByteArray::number(qulonglong(entry->deadline())));
+    }
+    previous = now;
+  }
+
+  for (const auto &entry : entries) {
+    QCOMPARE(entry->fired, 1);
+  }
+}
+
+void TimerWheelTests::nextDeadlineIsNeverLate()
+{
+  std::mt19937_64 random(7);
+  TimerWheel wheel;
+  QVERIFY(!wheel.nextDeadline().has_value());
+
+  std::vector<std::unique_ptr<TestEntry>> entries(200);
+  for (auto &entry : entries) {
+    entry = std::make_unique<TestEntry>();
+    wheel.schedule(*entry, 1 + random() % 10000000);
+  }
+
+  // Sleeping until nextDeadline() and advancing must never skip past a deadline
+  while (!wheel.empty()) {
+    const auto next = wheel.nextDeadline();
+    QVERIFY(next.has_value());
+    QVERIFY(*next >= wheel.now());
+    wheel.advance(*next);
+    for (auto *entry : drain(wheel)) {
+      QCOMPARE(entry->firedAt, entry->deadline());
+    }
+  }
+
+  // Within the first level it is exact
+  TestEntry soon;
+  wheel.schedule(soon, wheel.now() + 40);
+  QCOMPARE(wheel.nextDeadline(), std::optional<uint64_t>(wheel.now() + 40));
+  wheel.cancel(soon);
+}
+
+void TimerWheelTests::destroyWithScheduledEntries()
+{
+  TestEntry survivor;
+  {
+    TimerWheel wheel;
+    wheel.schedule(survivor, 1u << 20);
+  }
+  QVERIFY(!survivor.isScheduled());
+}
+
+QTEST_MAIN(TimerWheelTests)
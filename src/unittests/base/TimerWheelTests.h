@@ -0,0 +1,17 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class TimerWheelTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void firesAtDeadline();
+  void cancelAndReschedule();
+  void pastDeadlineIsDue();
+  void randomDeadlinesFireOnTime();
+  void nextDeadlineIsNeverLate();
+  void destroyWithScheduledEntries();
+};
@@ -0,0 +1,83 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "MultiBridgeClientAppTests.h"
+
+#include "client/MultiBridgeClientApp.h"
+
+using Spec = MultiBridgeClientApp::Spec;
+
+void MultiBridgeClientAppTests::parseSpec()
+{
+  QString error;
+  const auto spec = Spec::parse(QStringLiteral("name=desk, link=/dev/ttyACM0,width=2560,height=1440"), error);
+  QVERIFY(spec.has_value());
+  QCOMPARE(spec->screenName, QStringLiteral("desk"));
+  QCOMPARE(spec->linkDevice, QStringLiteral("/dev/ttyACM0"));
+  QCOMPARE(spec->screenWidth, 2560);
+  QCOMPARE(spec->screenHeight, 1440);
+  QVERIFY(!spec->invertScroll.has_value());
+  QVERIFY(!spec->bluetoothKeepAlive.has_value());
+}
+
+void MultiBridgeClientAppTests::parseSpecInvertScroll()
+{
+  const QString base = QStringLiteral("name=desk,link=/dev/ttyACM0,width=1920,height=1080,invertScroll=");
+  QString error;
+  for (const char *value : {"true", "TRUE", "1"}) {
+    const auto spec = Spec::parse(base + QString::fromUtf8(value), error);
+    QVERIFY(spec.has_value());
+    QVERIFY(spec->invertScroll == true);
+  }
+  for (const char *value : {"false", "False", "0"}) {
+    const auto spec = Spec::parse(base + QString::fromUtf8(value), error);
+    QVERIFY(spec.has_value());
+    QVERIFY(spec->invertScroll == false);
+  }
+
+  // Anything else is a typo, not a silent false
+  for (const char *value : {"yes", "on", "2", ""}) {
+    error.clear();
+    QVERIFY(!Spec::parse(base + QString::fromUtf8(value), error).has_value());
+    QVERIFY(!error.isEmpty());
+  }
+}
+
+void MultiBridgeClientAppTests::parseSpecKeepAlive()
+{
+  const QString base = QStringLiteral("name=desk,link=/dev/ttyACM0,width=1920,height=1080,keepAlive=");
+  QString error;
+  auto spec = Spec::parse(base + QStringLiteral("true"), error);
+  QVERIFY(spec.has_value());
+  QVERIFY(spec->bluetoothKeepAlive == true);
+  QVERIFY(!spec->invertScroll.has_value());
+
+  spec = Spec::parse(base + QStringLiteral("0"), error);
+  QVERIFY(spec.has_value());
+  QVERIFY(spec->bluetoothKeepAlive == false);
+
+  error.clear();
+  QVERIFY(!Spec::parse(base + QStringLiteral("maybe"), error).has_value());
+  QVERIFY(!error.isEmpty());
+}
+
+void MultiBridgeClientAppTests::parseSpecRejectsMalformed()
+{
+  const char *const malformed[] = {
+      "link=/dev/ttyACM0,width=1920,height=1080",                  // no name
+      "name=desk,width=1920,height=1080",                          // no link
+      "name=desk,link=/dev/ttyACM0,width=1920",                    // no height
+      "name=desk,link=/dev/ttyACM0,width=0,height=1080",           // empty screen
+      "name=desk,link=/dev/ttyACM0,width=wide,height=1080",        // not a number
+      "name=desk,link=/dev/ttyACM0,width=1920,height=1080,dpi=96", // unknown key
+      "name=desk,/dev/ttyACM0,width=1920,height=1080",             // not key=value
+  };
+  for (const char *text : malformed) {
+    QString error;
+    QVERIFY(!Spec::parse(QString::fromUtf8(text), error).has_value());
+    QVERIFY(!error.isEmpty());
+  }
+}
+
+QTEST_MAIN(MultiBridgeClientAppTests)
@@ -0,0 +1,15 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class MultiBridgeClientAppTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void parseSpec();
+  void parseSpecInvertScroll();
+  void parseSpecKeepAlive();
+  void parseSpecRejectsMalformed();
+};
@@ -0,0 +1,151 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "IPrimaryScreenTests.h"
+
+#include "base/Event.h"
+#include "base/EventQueue.h"
+#include "deskflow/IPrimaryScreen.h"
+
+#include <atomic>
+#include <cstdlib>
+
+namespace {
+
+std::atomic_size_t s_allocations = 0;
+
+bool isInside(const void *data, const Event &event)
+{
+  const auto *begin = reinterpret_cast<const char *>(&event);
+  const auto *pointer = static_cast<const char *>(data);
+  return pointer >= begin && pointer < begin + sizeof(Event);
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+// Count every malloc() in this test, which covers operator new and the ::alloc() helpers alike
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+  ++s_allocations;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+  ++s_allocations;
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) noexcept
+{
+  ++s_allocations;
+  return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+void IPrimaryScreenTests::initTestCase()
+{
+  m_arch.init();
+}
+
+void IPrimaryScreenTests::motionInfoIsStoredInline()
+{
+  using MotionInfo = IPrimaryScreen::MotionInfo;
+  int target = 0;
+  const auto event = Event::withData(EventTypes::PrimaryScreenMotionOnSecondary, &target, MotionInfo{3, -4});
+
+  QVERIFY(event.getType() == EventTypes::PrimaryScreenMotionOnSecondary);
+  QCOMPARE(event.getTarget(), &target);
+  QVERIFY(isInside(event.getData(), event));
+
+  const auto *info = static_cast<const MotionInfo *>(event.getData());
+  QCOMPARE(info->m_x, 3);
+  QCOMPARE(info->m_y, -4);
+  QCOMPARE(event.getInlineData<MotionInfo>(), info);
+  QVERIFY(event.getInlineData<IPrimaryScreen::WheelInfo>() == nullptr);
+
+  // Heap data still comes back from getData() and is not tagged inline
+  Event heap(EventTypes::PrimaryScreenMotionOnSecondary, &target, MotionInfo::alloc(5, 6));
+  QCOMPARE(static_cast<const MotionInfo *>(heap.getData())->m_x, 5);
+  QVERIFY(heap.getInlineData<MotionInfo>() == nullptr);
+  Event::deleteData(heap);
+}
+
+void IPrimaryScreenTests::inlineDataSurvivesMove()
+{
+  using ButtonInfo = IPrimaryScreen::ButtonInfo;
+  auto event = Event::withData(EventTypes::PrimaryScreenButtonDown, nullptr, ButtonInfo{kButtonRight, 0x10});
+
+  Event moved(std::move(event));
+  Event assigned;
+  assigned = std::move(moved);
+
+  QVERIFY(isInside(assigned.getData(), assigned));
+  const auto *info = static_cast<const ButtonInfo *>(assigned.getData());
+  QCOMPARE(info->m_button, kButtonRight);
+  QCOMPARE(info->m_mask, KeyModifierMask(0x10));
+  Event::deleteData(assigned);
+}
+
+void IPrimaryScreenTests::motionPathDoesNotAllocate()
+{
+#if !defined(__GLIBC__)
+  QSKIP("counting malloc() needs glibc");
+#endif
+  using MotionInfo = IPrimaryScreen::MotionInfo;
+  constexpr int kEvents = 160 * 64;
+  constexpr int kBacklog = 64;
+
+  // Get the queue ready the way the event loop does, so events go straight to its buffer
+  EventQueue events;
+  events.addEvent(Event(EventTypes::Quit));
+  events.loop();
+
+  int64_t sum = 0;
+  int target = 0;
+  events.addHandler(EventTypes::PrimaryScreenMotionOnSecondary, &target, [&sum](const Event &event) {
+    const auto *info = static_cast<const MotionInfo *>(event.getData());
+    sum += info->m_x + info->m_y;
+  });
+
+  // Queue and dispatch motion the way the screens and the event loop do
+  auto pump = [&events, &target](int count, bool inlineData) {
+    for (int i = 0; i < count; i += kBacklog) {
+      for (int j = 0; j < kBacklog; ++j) {
+        if (inlineData) {
+          events.addEvent(Event::withData(EventTypes::PrimaryScreenMotionOnSecondary, &target, MotionInfo{i, j}));
+        } else {
+          events.addEvent(Event(EventTypes::PrimaryScreenMotionOnSecondary, &target, MotionInfo::alloc(i, j)));
+        }
+      }
+      for (int j = 0; j < kBacklog; ++j) {
+        Event event;
+        events.getEvent(event, 0.0);
+        events.dispatchEvent(event);
+        Event::deleteData(event);
+      }
+    }
+  };
+
+  // The first pass grows the queue's event storage to the backlog depth
+  pump(kBacklog, true);
+  size_t before = s_allocations;
+  pump(kEvents, true);
+  QCOMPARE(s_allocations - before, size_t(0));
+
+  // The counter does see the malloc() that heap data costs per event
+  before = s_allocations;
+  pump(kEvents, false);
+  QCOMPARE(s_allocations - before, size_t(kEvents));
+  QVERIFY(sum > 0);
+}
+
+QTEST_MAIN(IPrimaryScreenTests)
@@ -0,0 +1,23 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include "arch/Arch.h"
+
+#include <QTest>
+
+class IPrimaryScreenTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void initTestCase();
+  void motionInfoIsStoredInline();
+  void inlineDataSurvivesMove();
+  void motionPathDoesNotAllocate();
+
+private:
+  Arch m_arch;
+  Log m_log;
+};
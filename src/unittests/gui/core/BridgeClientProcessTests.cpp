@@ -0,0 +1,121 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "BridgeClientProcessTests.h"
+
+#include "common/BridgeStatus.h"
+#include "gui/core/BridgeClientProcess.h"
+
+#include <QJsonObject>
+#include <QSignalSpy>
+
+using namespace deskflow::gui;
+
+namespace {
+const QString kDevice = QStringLiteral("/dev/ttyACM0");
+
+QJsonObject status(const QString &event, QJsonObject fields = {}, const QString &device = kDevice)
+{
+  fields.insert(BridgeStatus::kEventKey, event);
+  fields.insert(BridgeStatus::kDeviceKey, device);
+  return fields;
+}
+} // namespace
+
+void BridgeClientProcessTests::connectedAndDeviceName()
+{
+  BridgeClientProcess process(kDevice);
+  QSignalSpy connectedSpy(&process, &BridgeClientProcess::connectionEstablished);
+  QSignalSpy nameSpy(&process, &BridgeClientProcess::deviceNameDetected);
+  QVERIFY(connectedSpy.isValid());
+  QVERIFY(nameSpy.isValid());
+
+  process.handleStatus(status(BridgeStatus::kConnected));
+  process.handleStatus(status(BridgeStatus::kDeviceName, {{BridgeStatus::kNameKey, QStringLiteral("desk")}}));
+
+  QCOMPARE(connectedSpy.count(), 1);
+  QCOMPARE(nameSpy.count(), 1);
+  QCOMPARE(nameSpy.first().first().toString(), QStringLiteral("desk"));
+}
+
+void BridgeClientProcessTests::activationAndBle()
+{
+  BridgeClientProcess process(kDevice);
+  QSignalSpy activationSpy(&process, &BridgeClientProcess::activationStatusDetected);
+  QSignalSpy bleSpy(&process, &BridgeClientProcess::bleStatusDetected);
+  QVERIFY(activationSpy.isValid());
+  QVERIFY(bleSpy.isValid());
+
+  process.handleStatus(status(
+      BridgeStatus::kActivation,
+      {{BridgeStatus::kStateKey, QStringLiteral("activated")}, {BridgeStatus::kProfileKey, 2}}
+  ));
+  process.handleStatus(status(BridgeStatus::kBle, {{BridgeStatus::kConnectedKey, true}}));
+
+  QCOMPARE(activationSpy.count(), 1);
+  QCOMPARE(activationSpy.first().at(0).toString(), QStringLiteral("activated"));
+  QCOMPARE(activationSpy.first().at(1).toInt(), 2);
+  QCOMPARE(bleSpy.count(), 1);
+  QCOMPARE(bleSpy.first().first().toBool(), true);
+}
+
+void BridgeClientProcessTests::handshakeFailureReasons()
+{
+  BridgeClientProcess process(kDevice);
+  QSignalSpy spy(&process, &BridgeClientProcess::handshakeFailed);
+  QVERIFY(spy.isValid());
+
+  const auto failed = [](const QString &reason) {
+    return status(BridgeStatus::kHandshakeFailed, {{BridgeStatus::kReasonKey, reason}});
+  };
+  process.handleStatus(failed(BridgeStatus::kReasonAuthentication));
+  process.handleStatus(failed(BridgeStatus::kReasonTimeout));
+  // Other failures show up in the log only
+  process.handleStatus(failed(BridgeStatus::kReasonError));
+
+  QCOMPARE(spy.count(), 2);
+  QCOMPARE(spy.at(0).first().toString(), QStringLiteral("Factory firmware detected"));
+  QCOMPARE(spy.at(1).first().toString(), QStringLiteral("Handshake timeout"));
+}
+
+void BridgeClientProcessTests::otherDevicesAreIgnored()
+{
+  BridgeClientProcess process(kDevice);
+  QSignalSpy connectedSpy(&process, &BridgeClientProcess::connectionEstablished);
+  QSignalSpy nameSpy(&process, &BridgeClientProcess::deviceNameDetected);
+  QVERIFY(connectedSpy.isValid());
+  QVERIFY(nameSpy.isValid());
+
+  const auto otherDevice = QStringLiteral("/dev/ttyACM1");
+  process.handleStatus(status(BridgeStatus::kConnected, {}, otherDevice));
+  process.handleStatus(
+      status(BridgeStatus::kDeviceName, {{BridgeStatus::kNameKey, QStringLiteral("other")}}, otherDevice)
+  );
+  process.handleStatus(status(QStringLiteral("unknownEvent")));
+
+  QCOMPARE(connectedSpy.count(), 0);
+  QCOMPARE(nameSpy.count(), 0);
+}
+
+void BridgeClientProcessTests::bridgeSpec()
+{
+  BridgeClientProcess::Config config;
+  config.screenName = QStringLiteral("desk");
+  config.devicePath = kDevice;
+  config.screenWidth = 2560;
+  config.screenHeight = 1440;
+  config.invertScroll = true;
+  config.bluetoothKeepAlive = false;
+
+  QCOMPARE(
+      BridgeClientProcess::bridgeSpec(config),
+      QStringLiteral("name=desk,link=/dev/ttyACM0,width=2560,height=1440,invertScroll=true,keepAlive=false")
+  );
+
+  // A comma would split the spec in the wrong place
+  config.screenName = QStringLiteral("desk,2");
+  QVERIFY(BridgeClientProcess::bridgeSpec(config).isEmpty());
+}
+
+QTEST_MAIN(BridgeClientProcessTests)
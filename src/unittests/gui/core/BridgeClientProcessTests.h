@@ -0,0 +1,16 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class BridgeClientProcessTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void connectedAndDeviceName();
+  void activationAndBle();
+  void handshakeFailureReasons();
+  void otherDevicesAreIgnored();
+  void bridgeSpec();
+};
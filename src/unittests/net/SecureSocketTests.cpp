@@ -0,0 +1,48 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "SecureSocketTests.h"
+
+#include "common/Settings.h"
+#include "net/SecureSocket.h"
+#include "net/SecureUtils.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <openssl/ssl.h>
+
+void SecureSocketTests::initTestCase()
+{
+  QFile oldSettings(m_settingsFile);
+  if (oldSettings.exists())
+    oldSettings.remove();
+  Settings::setSettingsFile(m_settingsFile);
+}
+
+void SecureSocketTests::sharedClientContextHoldsCertificate()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString certificate = dir.filePath(QStringLiteral("deskflow.pem"));
+  deskflow::generatePemSelfSignedCert(certificate);
+  Settings::setValue(Settings::Security::Certificate, certificate);
+
+  // Sockets on a shared context skip loading the certificate, so it must already be there
+  const auto context = SecureSocket::createClientContext(SecurityLevel::PeerAuth);
+  QVERIFY(context != nullptr);
+  QVERIFY(SSL_CTX_get0_certificate(context.get()) != nullptr);
+  QCOMPARE(SSL_CTX_get_verify_mode(context.get()), SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT);
+}
+
+void SecureSocketTests::sharedClientContextNeedsCertificate()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Settings::setValue(Settings::Security::Certificate, dir.filePath(QStringLiteral("missing.pem")));
+
+  QVERIFY(SecureSocket::createClientContext(SecurityLevel::PeerAuth) == nullptr);
+}
+
+QTEST_MAIN(SecureSocketTests)
@@ -0,0 +1,21 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include <QTest>
+
+class SecureSocketTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void initTestCase();
+  void sharedClientContextHoldsCertificate();
+  void sharedClientContextNeedsCertificate();
+
+private:
+  Log m_log;
+  inline static const QString m_settingsPathTemp = QStringLiteral("tmp/test");
+  inline static const QString m_settingsFile = QStringLiteral("%1/Deskflow.conf").arg(m_settingsPathTemp);
+};
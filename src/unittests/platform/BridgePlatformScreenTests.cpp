@@ -0,0 +1,546 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "BridgePlatformScreenTests.h"
+
+#include "PtyFakeDevice.h"
+#include "base/EventQueue.h"
+#include "common/Settings.h"
+#include "deskflow/KeyTypes.h"
+#include "deskflow/MouseTypes.h"
+#include "platform/bridge/BridgePlatformScreen.h"
+#include "platform/bridge/HidFrame.h"
+
+#include <QFile>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace deskflow::bridge;
+using namespace deskflow::bridge::fake;
+
+namespace {
+// While counting is on, allocations on every host thread are recorded: the screen on the test
+// thread and the HidTxQueue writer that encodes and sends. The fake device thread and the test
+// thread while it only waits for the device are left out.
+std::atomic<bool> g_countAllocations = false;
+std::atomic<size_t> g_allocations = 0;
+thread_local bool t_ignoreAllocations = false;
+
+// Waits for count events of one frame type, batched or not, and returns their payloads
+std::vector<std::vector<uint8_t>> waitForEvents(PtyFakeDevice &device, uint8_t type, size_t count)
+{
+  std::vector<std::vector<uint8_t>> payloads;
+  device.waitForHidFrames([&](const std::vector<ReceivedFrame> &frames) {
+    payloads.clear();
+    for (const auto &event : expandBatches(frames)) {
+      if (event.type == type) {
+        payloads.push_back(event.payload);
+      }
+    }
+    return payloads.size() >= count;
+  });
+  return payloads;
+}
+
+// Keyboard report payloads hold the modifiers and the keys up to the last one held
+std::vector<std::vector<uint8_t>> waitForKeyboardReports(PtyFakeDevice &device, size_t count)
+{
+  return waitForEvents(device, kFrameTypeHidKeyboardReport, count);
+}
+} // namespace
+
+void *operator new(size_t size)
+{
+  if (g_countAllocations.load(std::memory_order_relaxed) && !t_ignoreAllocations && !t_onDeviceThread) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void BridgePlatformScreenTests::initTestCase()
+{
+  m_arch.init();
+  QFile oldSettings(m_settingsFile);
+  if (oldSettings.exists())
+    oldSettings.remove();
+  Settings::setSettingsFile(m_settingsFile);
+  Settings::setValue(Settings::Bridge::BluetoothKeepAlive, false);
+}
+
+void BridgePlatformScreenTests::mouseMoveDoesNotAllocate()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+
+  // Warm up once so lazily created state is not charged to the hot path, and wait until the
+  // writer has sent it so its first-use state is settled as well
+  screen.fakeMouseRelativeMove(1, 1);
+  device.waitForHidFrames(1);
+
+  constexpr int kMoves = 1000;
+  g_allocations = 0;
+  g_countAllocations = true;
+  for (int i = 0; i < kMoves; ++i) {
+    screen.fakeMouseRelativeMove(3, -2);
+  }
+
+  // Keep counting until the writer has delivered everything, so its encode and send work is covered
+  int32_t totalDx = 0;
+  int32_t totalDy = 0;
+  t_ignoreAllocations = true;
+  device.waitForHidFrames([&](const std::vector<ReceivedFrame> &frames) {
+    totalDx = 0;
+    totalDy = 0;
+    for (const auto &frame : frames) {
+      int16_t dx = 0;
+      int16_t dy = 0;
+      if (legacyMouseMove(frame, dx, dy)) {
+        totalDx += dx;
+        totalDy += dy;
+      }
+    }
+    return totalDx == 1 + 3 * kMoves;
+  });
+  t_ignoreAllocations = false;
+  g_countAllocations = false;
+
+  QCOMPARE(g_allocations.load(), size_t(0));
+
+  // Moves may be merged while the device is busy, but none may be lost
+  QCOMPARE(totalDx, 1 + 3 * kMoves);
+  QCOMPARE(totalDy, 1 - 2 * kMoves);
+}
+
+void BridgePlatformScreenTests::timersFireThroughEventQueue()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  Settings::setValue(Settings::Bridge::BluetoothKeepAlive, true);
+  Settings::setValue(Settings::Bridge::LatencyReportInterval, 0.02);
+  EventQueue events;
+  {
+    BridgePlatformScreen screen(&events, transport, 1920, 1080, false);
+
+    // The latency report timer is due first; its event is addressed to the screen, which handles it
+    Event event;
+    QVERIFY(events.getEvent(event, 2.0));
+    QCOMPARE(event.getType(), EventTypes::Timer);
+    QCOMPARE(event.getTarget(), static_cast<void *>(&screen));
+    QVERIFY(events.dispatchEvent(event));
+  }
+  Settings::setValue(Settings::Bridge::LatencyReportInterval, 0.0);
+  Settings::setValue(Settings::Bridge::BluetoothKeepAlive, false);
+
+  // The screen took its timers and handler with it, so nothing is addressed to it any more
+  Event event;
+  QVERIFY(!events.getEvent(event, 0.1));
+}
+
+void BridgePlatformScreenTests::flushSendsQueuedInputTogether()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(3);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+  QCOMPARE(transport->hidEncoding(), HidEncoding::Batch);
+
+  EventQueue events;
+  BridgePlatformScreen screen(&events, transport, 1920, 1080, false);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // Bracketed the way the client handles one read of server messages
+  screen.fakeInputBatchBegin();
+  screen.fakeMouseButton(kButtonLeft, true);
+  screen.fakeMouseRelativeMove(4, 2);
+  screen.fakeMouseButton(kButtonLeft, false);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  QVERIFY(device.hidEvents().empty());
+
+  screen.fakeInputFlush();
+  const auto frames = device.waitForHidFrames(1);
+  QCOMPARE(frames.size(), size_t(1));
+  QCOMPARE(frames[0].type, kFrameTypeHidBatch);
+  QCOMPARE(frames[0].flags, uint8_t(3));
+
+  // Input from anywhere else, such as leave() on a disconnect, is not held back
+  screen.fakeMouseButton(kButtonRight, true);
+  QCOMPARE(device.waitForHidFrames(2).size(), size_t(2));
+}
+
+void BridgePlatformScreenTests::writeFailureRaisesScreenError()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  EventQueue events;
+  BridgePlatformScreen screen(&events, transport, 1920, 1080, false);
+
+  // The error travels from the writer thread through the running queue to the screen's handler
+  bool raised = false;
+  events.addHandler(EventTypes::ScreenError, screen.getEventTarget(), [&events, &raised](const Event &) {
+    raised = true;
+    events.addEvent(Event(EventTypes::Quit));
+  });
+
+  // Once the loop runs, unplug the device and send; the writer finds out on its write
+  int unplug = 0;
+  int timeout = 0;
+  auto *unplugTimer = events.newOneShotTimer(0.01, &unplug);
+  auto *timeoutTimer = events.newOneShotTimer(5.0, &timeout);
+  events.addHandler(EventTypes::Timer, &unplug, [&device, &transport, &screen](const Event &) {
+    device.injectFault(PtyFakeDevice::Fault::HangUp);
+    uint32_t uptime = 0;
+    transport->sendKeepAlive(uptime);
+    screen.fakeMouseButton(kButtonLeft, true);
+  });
+  events.addHandler(EventTypes::Timer, &timeout, [&events](const Event &) {
+    events.addEvent(Event(EventTypes::Quit));
+  });
+
+  events.loop();
+  events.deleteTimer(unplugTimer);
+  events.deleteTimer(timeoutTimer);
+  events.removeHandlers(&unplug);
+  events.removeHandlers(&timeout);
+  events.removeHandler(EventTypes::ScreenError, screen.getEventTarget());
+
+  QVERIFY(raised);
+}
+
+void BridgePlatformScreenTests::keyboardReportSkipsDuplicateKeys()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(6);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // Two buttons that produce the same usage, as a key on both a main and a keypad layout would
+  screen.fakeKeyDown('a', 0, 30, "");
+  screen.fakeKeyDown('a', 0, 31, "");
+  screen.fakeKeyDown('b', 0, 48, "");
+  screen.fakeKeyUp(30);
+
+  const auto reports = waitForKeyboardReports(device, 4);
+  QCOMPARE(reports.size(), size_t(4));
+  QCOMPARE(reports[0], std::vector<uint8_t>({0x00, 0x04}));
+  QCOMPARE(reports[1], std::vector<uint8_t>({0x00, 0x04}));
+  QCOMPARE(reports[2], std::vector<uint8_t>({0x00, 0x04, 0x05}));
+
+  // The other button still holds the usage
+  QCOMPARE(reports[3], std::vector<uint8_t>({0x00, 0x04, 0x05}));
+}
+
+void BridgePlatformScreenTests::keyboardReportRollsOver()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(6);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // A seventh key does not fit, so every slot reports ErrorRollOver until one is released
+  for (KeyButton i = 0; i < 7; ++i) {
+    screen.fakeKeyDown('a' + i, 0, 30 + i, "");
+  }
+  screen.fakeKeyUp(30);
+
+  const auto reports = waitForKeyboardReports(device, 8);
+  QCOMPARE(reports.size(), size_t(8));
+  QCOMPARE(reports[5], std::vector<uint8_t>({0x00, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09}));
+  std::vector<uint8_t> rolledOver(1 + kKeyboardReportMaxKeys, kKeyErrorRollOver);
+  rolledOver[0] = 0x00;
+  QCOMPARE(reports[6], rolledOver);
+  QCOMPARE(reports[7], std::vector<uint8_t>({0x00, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A}));
+}
+
+void BridgePlatformScreenTests::keyRepeatTogglesKeyInReport()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(6);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // A held key repeats by leaving the report and coming back
+  screen.fakeKeyDown('a', 0, 30, "");
+  QVERIFY(screen.fakeKeyRepeat('a', 0, 2, 30, ""));
+
+  // A key that is not held repeats by appearing next to the held ones and going away again
+  QVERIFY(screen.fakeKeyRepeat('b', 0, 1, 48, ""));
+
+  const auto reports = waitForKeyboardReports(device, 7);
+  QCOMPARE(reports.size(), size_t(7));
+  const std::vector<uint8_t> held = {0x00, 0x04};
+  const std::vector<uint8_t> released = {0x00};
+  QCOMPARE(reports[0], held);
+  QCOMPARE(reports[1], released);
+  QCOMPARE(reports[2], held);
+  QCOMPARE(reports[3], released);
+  QCOMPARE(reports[4], held);
+  QCOMPARE(reports[5], std::vector<uint8_t>({0x00, 0x04, 0x05}));
+  QCOMPARE(reports[6], held);
+}
+
+void BridgePlatformScreenTests::allKeysUpSendsEmptyReport()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(6);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  screen.fakeKeyDown(kKeyShift_L, KeyModifierShift, 50, "");
+  screen.fakeKeyDown('a', KeyModifierShift, 30, "");
+  screen.fakeAllKeysUp();
+
+  // One report releases the modifiers and the keys together
+  const auto reports = waitForKeyboardReports(device, 3);
+  QCOMPARE(reports.size(), size_t(3));
+  QCOMPARE(reports[1], std::vector<uint8_t>({0x02, 0x04}));
+  QCOMPARE(reports[2], std::vector<uint8_t>({0x00}));
+
+  // Nothing is left held, so a later key goes out on its own
+  screen.fakeKeyDown('b', 0, 48, "");
+  QCOMPARE(waitForKeyboardReports(device, 4)[3], std::vector<uint8_t>({0x00, 0x05}));
+}
+
+void BridgePlatformScreenTests::wheelCarriesRemainder()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(6);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // Deskflow counts 120 per detent; part of a detent waits for the next wheel event
+  screen.fakeMouseWheel(0, 60);
+  screen.fakeMouseWheel(0, 60);
+  screen.fakeMouseWheel(0, 90);
+  screen.fakeMouseWheel(0, 90);
+  screen.fakeMouseWheel(0, -240);
+
+  // The firmware has no pan, so horizontal scrolling is dropped
+  screen.fakeMouseWheel(240, 0);
+
+  const auto steps = waitForEvents(device, kFrameTypeHidScrollCompact, 3);
+  QCOMPARE(steps.size(), size_t(3));
+  QCOMPARE(steps[0], std::vector<uint8_t>({0x01}));
+  QCOMPARE(steps[1], std::vector<uint8_t>({0x01}));
+  QCOMPARE(steps[2], std::vector<uint8_t>({0xFF}));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  QCOMPARE(device.hidEvents().size(), size_t(3));
+}
+
+void BridgePlatformScreenTests::wheelClampsToReportRange()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(6);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // 200 detents do not fit in one report: 127 go now and the rest with the next wheel event
+  screen.fakeMouseWheel(0, 200 * 120);
+  screen.fakeMouseWheel(0, 1);
+  screen.fakeMouseWheel(0, -200 * 120);
+  screen.fakeMouseWheel(0, -1);
+
+  const auto steps = waitForEvents(device, kFrameTypeHidScrollCompact, 4);
+  QCOMPARE(steps.size(), size_t(4));
+  QCOMPARE(steps[0], std::vector<uint8_t>({0x7F}));
+  QCOMPARE(steps[1], std::vector<uint8_t>({0x49}));
+  QCOMPARE(steps[2], std::vector<uint8_t>({0x81}));
+  QCOMPARE(steps[3], std::vector<uint8_t>({0xB7}));
+}
+
+void BridgePlatformScreenTests::wheelPansAgainstDeskflowAxis()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(7);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // Deskflow counts left as positive and AC Pan counts right, while both wheels count up
+  screen.fakeMouseWheel(120, 120);
+  screen.fakeMouseWheel(-240, 0);
+
+  const auto pans = waitForEvents(device, kFrameTypeHidPanCompact, 2);
+  QCOMPARE(pans.size(), size_t(2));
+  QCOMPARE(pans[0], std::vector<uint8_t>({0xFF}));
+  QCOMPARE(pans[1], std::vector<uint8_t>({0x02}));
+  QCOMPARE(waitForEvents(device, kFrameTypeHidScrollCompact, 1), std::vector<std::vector<uint8_t>>({{0x01}}));
+
+  // Inverting the scroll direction flips both axes
+  PtyFakeDevice invertedDevice;
+  QVERIFY(invertedDevice.isValid());
+  invertedDevice.setProtocolVersion(7);
+
+  auto invertedTransport = std::make_shared<CdcTransport>(invertedDevice.slavePath());
+  QVERIFY(invertedTransport->open(true));
+
+  BridgePlatformScreen inverted(nullptr, invertedTransport, 1920, 1080, true);
+  inverted.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  inverted.fakeMouseWheel(120, 120);
+  QCOMPARE(waitForEvents(invertedDevice, kFrameTypeHidPanCompact, 1), std::vector<std::vector<uint8_t>>({{0x01}}));
+  QCOMPARE(waitForEvents(invertedDevice, kFrameTypeHidScrollCompact, 1), std::vector<std::vector<uint8_t>>({{0xFF}}));
+}
+
+void BridgePlatformScreenTests::wheelSplitsDetentsInHighResolution()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(8);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  BridgePlatformScreen screen(nullptr, transport, 1920, 1080, false);
+  screen.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // A third of a detent up, then half a detent left; each goes out at once with the other axis idle
+  screen.fakeMouseWheel(0, 40);
+  screen.fakeMouseWheel(60, 0);
+
+  // Beyond the 16-bit range the rest waits for the next wheel event, as with whole detents
+  screen.fakeMouseWheel(0, 300 * 120);
+  screen.fakeMouseWheel(0, 1);
+
+  const auto reports = waitForEvents(device, kFrameTypeHidScrollHiRes, 4);
+  QCOMPARE(reports.size(), size_t(4));
+  QCOMPARE(reports[0], std::vector<uint8_t>({0x28, 0x00, 0x00, 0x00}));
+  QCOMPARE(reports[1], std::vector<uint8_t>({0x00, 0x00, 0xC4, 0xFF}));
+  QCOMPARE(reports[2], std::vector<uint8_t>({0xFF, 0x7F, 0x00, 0x00}));
+
+  // 300 * 120 - 32767 + 1 = 3234
+  QCOMPARE(reports[3], std::vector<uint8_t>({0xA2, 0x0C, 0x00, 0x00}));
+  QVERIFY(waitForEvents(device, kFrameTypeHidScrollCompact, 0).empty());
+  QVERIFY(waitForEvents(device, kFrameTypeHidPanCompact, 0).empty());
+}
+
+void BridgePlatformScreenTests::absolutePointerUsesProfileSize()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(9);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  // A phone held in landscape, with a resolution other than the one on the command line
+  DeviceProfile profile{};
+  profile.screenWidth = 1080;
+  profile.screenHeight = 2424;
+  profile.rotation = 1;
+  profile.pointerMode = kPointerModeAbsolute;
+  QVERIFY(transport->setProfile(0, profile));
+
+  EventQueue events;
+  BridgePlatformScreen screen(&events, transport, 1920, 1080, false);
+  bool shapeChanged = false;
+  events.addHandler(EventTypes::ScreenShapeChanged, screen.getEventTarget(), [&events, &shapeChanged](const Event &) {
+    shapeChanged = true;
+    events.addEvent(Event(EventTypes::Quit));
+  });
+  int timeout = 0;
+  auto *timeoutTimer = events.newOneShotTimer(5.0, &timeout);
+  events.addHandler(EventTypes::Timer, &timeout, [&events](const Event &) {
+    events.addEvent(Event(EventTypes::Quit));
+  });
+
+  screen.enter();
+  events.loop();
+  events.deleteTimer(timeoutTimer);
+  events.removeHandlers(&timeout);
+  events.removeHandler(EventTypes::ScreenShapeChanged, screen.getEventTarget());
+
+  // The server is told the profile's shape, turned the way the phone is held
+  QVERIFY(shapeChanged);
+  int32_t x = 0;
+  int32_t y = 0;
+  int32_t width = 0;
+  int32_t height = 0;
+  screen.getShape(x, y, width, height);
+  QCOMPARE(width, 2424);
+  QCOMPARE(height, 1080);
+
+  // The digitizer spans the profile's shape, so the old right edge is no longer the phone's edge
+  screen.fakeMouseMove(1919, 0);
+  const auto positions = waitForEvents(device, kFrameTypeHidAbsoluteCompact, 2);
+  QCOMPARE(positions.size(), size_t(2));
+  QCOMPARE(positions[1], std::vector<uint8_t>({0xFF, 0x7F, 0x5F, 0x65}));
+}
+
+QTEST_MAIN(BridgePlatformScreenTests)
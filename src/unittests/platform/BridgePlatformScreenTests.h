@@ -0,0 +1,35 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include "arch/Arch.h"
+
+#include <QTest>
+
+class BridgePlatformScreenTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void initTestCase();
+  void mouseMoveDoesNotAllocate();
+  void timersFireThroughEventQueue();
+  void flushSendsQueuedInputTogether();
+  void writeFailureRaisesScreenError();
+  void keyboardReportSkipsDuplicateKeys();
+  void keyboardReportRollsOver();
+  void keyRepeatTogglesKeyInReport();
+  void allKeysUpSendsEmptyReport();
+  void wheelCarriesRemainder();
+  void wheelClampsToReportRange();
+  void wheelPansAgainstDeskflowAxis();
+  void wheelSplitsDetentsInHighResolution();
+  void absolutePointerUsesProfileSize();
+
+private:
+  Arch m_arch;
+  Log m_log;
+  inline static const QString m_settingsPathTemp = QStringLiteral("tmp/test");
+  inline static const QString m_settingsFile = QStringLiteral("%1/Deskflow.conf").arg(m_settingsPathTemp);
+};
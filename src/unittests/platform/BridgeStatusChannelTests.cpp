@@ -0,0 +1,188 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "BridgeStatusChannelTests.h"
+
+#include "base/EventQueue.h"
+#include "common/BridgeStatus.h"
+#include "platform/bridge/BridgeStatusChannel.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QUuid>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace deskflow::bridge;
+
+namespace {
+const QString kDevice = QStringLiteral("/dev/ttyACM0");
+
+// The GUI end of the channel
+class StatusPeer
+{
+public:
+  StatusPeer()
+  {
+    m_server.listen(QStringLiteral("bridge-status-test-%1").arg(QUuid::createUuid().toString(QUuid::Id128)));
+  }
+
+  ~StatusPeer()
+  {
+    BridgeStatusChannel::instance().disconnectFromServer();
+  }
+
+  bool connect()
+  {
+    if (!BridgeStatusChannel::instance().connectToServer(m_server.fullServerName()) ||
+        !m_server.waitForNewConnection(1000)) {
+      return false;
+    }
+    m_socket.reset(m_server.nextPendingConnection());
+    return m_socket != nullptr;
+  }
+
+  bool hasData(int timeoutMs)
+  {
+    return m_socket->bytesAvailable() > 0 || m_socket->waitForReadyRead(timeoutMs);
+  }
+
+  QJsonObject next()
+  {
+    while (!m_socket->canReadLine() && m_socket->waitForReadyRead(1000)) {
+    }
+    return QJsonDocument::fromJson(m_socket->readLine()).object();
+  }
+
+  void send(const QByteArray &data)
+  {
+    m_socket->write(data);
+    m_socket->waitForBytesWritten(1000);
+  }
+
+private:
+  QLocalServer m_server;
+  std::unique_ptr<QLocalSocket> m_socket;
+};
+} // namespace
+
+void BridgeStatusChannelTests::initTestCase()
+{
+  m_arch.init();
+}
+
+void BridgeStatusChannelTests::eventsAreJsonLines()
+{
+  StatusPeer peer;
+  QVERIFY(peer.connect());
+  QVERIFY(BridgeStatusChannel::instance().isConnected());
+
+  FirmwareConfig config;
+  config.deviceName = "desk";
+  config.activationState = ActivationState::Activated;
+  config.activeProfile = 1;
+  config.isBleConnected = true;
+  BridgeStatusChannel::instance().handshakeCompleted(kDevice, config);
+
+  auto status = peer.next();
+  QCOMPARE(status.value(BridgeStatus::kEventKey).toString(), BridgeStatus::kDeviceName);
+  QCOMPARE(status.value(BridgeStatus::kDeviceKey).toString(), kDevice);
+  QCOMPARE(status.value(BridgeStatus::kNameKey).toString(), QStringLiteral("desk"));
+
+  status = peer.next();
+  QCOMPARE(status.value(BridgeStatus::kEventKey).toString(), BridgeStatus::kActivation);
+  QCOMPARE(status.value(BridgeStatus::kProfileKey).toInt(), 1);
+
+  status = peer.next();
+  QCOMPARE(status.value(BridgeStatus::kEventKey).toString(), BridgeStatus::kBle);
+  QCOMPARE(status.value(BridgeStatus::kConnectedKey).toBool(), true);
+}
+
+void BridgeStatusChannelTests::otherThreadsWriteThroughEventLoop()
+{
+  StatusPeer peer;
+  QVERIFY(peer.connect());
+  EventQueue events;
+  BridgeStatusChannel::instance().setEventQueue(&events);
+
+  // Like a handshake on the HID writer thread
+  std::thread([&events] {
+    BridgeStatusChannel::instance().handshakeFailed(kDevice, CdcTransport::HandshakeFailure::Timeout, "no reply");
+    events.addEvent(Event(EventTypes::Quit));
+  }).join();
+  QVERIFY(!peer.hasData(50));
+
+  events.loop();
+  BridgeStatusChannel::instance().setEventQueue(nullptr);
+
+  const auto status = peer.next();
+  QCOMPARE(status.value(BridgeStatus::kEventKey).toString(), BridgeStatus::kHandshakeFailed);
+  QCOMPARE(status.value(BridgeStatus::kReasonKey).toString(), BridgeStatus::kReasonTimeout);
+  QCOMPARE(status.value(BridgeStatus::kMessageKey).toString(), QStringLiteral("no reply"));
+}
+
+void BridgeStatusChannelTests::queuedEventsKeepTheirOrder()
+{
+  StatusPeer peer;
+  QVERIFY(peer.connect());
+
+  // Without an event loop the queued event goes out with the next one sent from the owning thread
+  std::thread([] {
+    BridgeStatusChannel::instance().handshakeFailed(
+        kDevice, CdcTransport::HandshakeFailure::Authentication, "bad signature"
+    );
+  }).join();
+  QVERIFY(!peer.hasData(50));
+
+  BridgeStatusChannel::instance().connected(kDevice);
+  QCOMPARE(peer.next().value(BridgeStatus::kEventKey).toString(), BridgeStatus::kHandshakeFailed);
+  QCOMPARE(peer.next().value(BridgeStatus::kEventKey).toString(), BridgeStatus::kConnected);
+}
+
+void BridgeStatusChannelTests::commandsAreRead()
+{
+  StatusPeer peer;
+  QVERIFY(peer.connect());
+  QVERIFY(BridgeStatusChannel::instance().readCommands().empty());
+
+  const auto waitForCommands = [] {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+      if (auto commands = BridgeStatusChannel::instance().readCommands(); !commands.empty()) {
+        return commands;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return std::vector<QJsonObject>{};
+  };
+
+  // Malformed lines are skipped, and a command is only read once its line is complete
+  peer.send(R"({"command":"removeBridge","device":"/dev/ttyACM0"}
+not json
+{"command":"addBridge",)");
+  auto commands = waitForCommands();
+  QCOMPARE(commands.size(), size_t(1));
+  QCOMPARE(commands.front().value(BridgeStatus::kCommandKey).toString(), BridgeStatus::kRemoveBridge);
+  QCOMPARE(commands.front().value(BridgeStatus::kDeviceKey).toString(), kDevice);
+
+  peer.send(R"("bridge":"name=desk,link=/dev/ttyACM1,width=1920,height=1080"}
+)");
+  commands = waitForCommands();
+  QCOMPARE(commands.size(), size_t(1));
+  QCOMPARE(commands.front().value(BridgeStatus::kCommandKey).toString(), BridgeStatus::kAddBridge);
+
+  // Only the thread that connected reads
+  peer.send(R"({"command":"removeBridge","device":"/dev/ttyACM1"}
+)");
+  bool readElsewhere = false;
+  std::thread([&readElsewhere] { readElsewhere = !BridgeStatusChannel::instance().readCommands().empty(); }).join();
+  QVERIFY(!readElsewhere);
+  QCOMPARE(waitForCommands().size(), size_t(1));
+}
+
+QTEST_MAIN(BridgeStatusChannelTests)
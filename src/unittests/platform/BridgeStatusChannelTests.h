@@ -0,0 +1,24 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include "arch/Arch.h"
+
+#include <QTest>
+
+class BridgeStatusChannelTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void initTestCase();
+  void eventsAreJsonLines();
+  void otherThreadsWriteThroughEventLoop();
+  void queuedEventsKeepTheirOrder();
+  void commandsAreRead();
+
+private:
+  Arch m_arch;
+  Log m_log;
+};
@@ -0,0 +1,67 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "CdcTransportBenchmarks.h"
+
+#include "PtyFakeDevice.h"
+#include "platform/bridge/CdcTransport.h"
+
+#include <optional>
+#include <vector>
+
+using namespace deskflow::bridge;
+using namespace deskflow::bridge::fake;
+
+void CdcTransportBenchmarks::secureHandshake()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  // Without a signing key the fake answers with a well-formed but wrong signature, so every attempt
+  // runs the whole handshake and fails verification. The open descriptor is kept, so each attempt is
+  // one HELLO/ACK exchange plus the ECDSA check
+  CdcTransport transport(device.slavePath());
+  QVERIFY(!transport.open());
+  QCOMPARE(transport.handshakeFailure(), CdcTransport::HandshakeFailure::Authentication);
+
+  QBENCHMARK {
+    transport.open();
+  }
+}
+
+void CdcTransportBenchmarks::readProfiles_data()
+{
+  QTest::addColumn<bool>("pipelined");
+
+  QTest::newRow("one slot at a time") << false;
+  QTest::newRow("pipelined") << true;
+}
+
+void CdcTransportBenchmarks::readProfiles()
+{
+  QFETCH(bool, pipelined);
+
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+
+  // Reading every slot the way the configuration dialog does, over a link with 20 ms of reply
+  // latency: one at a time waits it out once per slot, pipelined requests overlap it
+  device.setReplyLatency(std::chrono::milliseconds(20));
+  std::vector<std::optional<DeviceProfile>> profiles;
+  QBENCHMARK {
+    if (pipelined) {
+      QVERIFY(transport.getProfiles(0, static_cast<uint8_t>(kProfileSlots), profiles));
+    } else {
+      DeviceProfile profile;
+      for (size_t i = 0; i < kProfileSlots; ++i) {
+        QVERIFY(transport.getProfile(static_cast<uint8_t>(i), profile));
+      }
+    }
+  }
+}
+
+QTEST_MAIN(CdcTransportBenchmarks)
@@ -0,0 +1,19 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include <QTest>
+
+class CdcTransportBenchmarks : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void secureHandshake();
+  void readProfiles_data();
+  void readProfiles();
+
+private:
+  Log m_log;
+};
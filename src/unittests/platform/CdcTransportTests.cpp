@@ -0,0 +1,617 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "CdcTransportTests.h"
+
+#include "PtyFakeDevice.h"
+#include "platform/bridge/CdcTransport.h"
+
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+using namespace deskflow::bridge;
+using namespace deskflow::bridge::fake;
+
+namespace {
+
+std::shared_ptr<SessionTicketCache> tempTicketCache(const QTemporaryDir &dir)
+{
+  return std::make_shared<SessionTicketCache>(std::filesystem::path(dir.filePath("tickets").toStdString()));
+}
+
+} // namespace
+
+void CdcTransportTests::openInsecure()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QVERIFY(transport.hasDeviceConfig());
+  QCOMPARE(transport.deviceConfig().deviceName, std::string("fake"));
+  QCOMPARE(transport.deviceConfig().totalProfiles, uint8_t(2));
+  QCOMPARE(transport.handshakeFailure(), CdcTransport::HandshakeFailure::None);
+}
+
+void CdcTransportTests::keepAliveRoundTripLatency()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+
+  constexpr int kRounds = 200;
+  std::vector<std::chrono::nanoseconds> samples;
+  samples.reserve(kRounds);
+  for (int i = 0; i < kRounds; ++i) {
+    uint32_t uptime = 0;
+    const auto start = std::chrono::steady_clock::now();
+    QVERIFY(transport.sendKeepAlive(uptime));
+    samples.push_back(std::chrono::steady_clock::now() - start);
+    QCOMPARE(uptime, uint32_t(42));
+  }
+
+  std::sort(samples.begin(), samples.end());
+  const auto median = samples[samples.size() / 2];
+
+  // The old poll loop slept 10 ms whenever the device had nothing ready; the bound leaves room for
+  // a loaded machine while still catching that
+  QVERIFY(median < std::chrono::milliseconds(5));
+}
+
+void CdcTransportTests::readTimeoutHonoursDeadline()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  device.setMute(true);
+
+  uint32_t uptime = 0;
+  const auto start = std::chrono::steady_clock::now();
+  QVERIFY(!transport.sendKeepAlive(uptime));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // Never early; the ceiling only catches a wait that ignores the deadline altogether
+  QVERIFY(elapsed >= std::chrono::milliseconds(1000));
+  QVERIFY(elapsed < std::chrono::seconds(5));
+}
+
+void CdcTransportTests::handshakeTimeoutIsReported()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setMute(true);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(!transport.open(true));
+  QCOMPARE(transport.handshakeFailure(), CdcTransport::HandshakeFailure::Timeout);
+
+  // A later successful handshake clears it
+  device.setMute(false);
+  QVERIFY(transport.open(true));
+  QCOMPARE(transport.handshakeFailure(), CdcTransport::HandshakeFailure::None);
+}
+
+void CdcTransportTests::resumeSessionFromTicket()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  // As left behind by an earlier process that completed a verified handshake with this device
+  SessionTicket ticket;
+  ticket.id.fill(0x11);
+  ticket.key.fill(0x22);
+  ticket.expiresAt = std::chrono::system_clock::now() + std::chrono::seconds(60);
+  ticket.deviceName = "cached";
+  device.setSessionTicket(ticket.id, ticket.key, 60);
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  auto cache = tempTicketCache(dir);
+  cache->store(device.slavePath().toStdString(), ticket);
+
+  CdcTransport transport(device.slavePath());
+  transport.setSessionTicketCache(cache);
+  QVERIFY(transport.open());
+  QVERIFY(transport.isSecure());
+  QVERIFY(transport.isResumed());
+  QCOMPARE(transport.deviceConfig().deviceName, std::string("cached"));
+  QCOMPARE(transport.deviceConfig().totalProfiles, uint8_t(2));
+
+  // HELLO was the only request: no device name or serial number queries
+  QCOMPARE(device.controlRequests(), size_t(1));
+}
+
+void CdcTransportTests::rejectedTicketFallsBackToFullHandshake()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  // The device has rebooted and forgotten the ticket
+  SessionTicket ticket;
+  ticket.id.fill(0x11);
+  ticket.key.fill(0x22);
+  ticket.expiresAt = std::chrono::system_clock::now() + std::chrono::seconds(60);
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  auto cache = tempTicketCache(dir);
+  cache->store(device.slavePath().toStdString(), ticket);
+
+  CdcTransport transport(device.slavePath());
+  transport.setSessionTicketCache(cache);
+
+  // The fake cannot sign, so the full handshake it falls back to is rejected as well
+  QVERIFY(!transport.open());
+  QCOMPARE(transport.lastError(), std::string("Handshake authentication failed."));
+  QVERIFY(!transport.isResumed());
+  QVERIFY(!transport.isSecure());
+  QVERIFY(!cache->find(device.slavePath().toStdString()).has_value());
+  QCOMPARE(device.controlRequests(), size_t(2));
+}
+
+void CdcTransportTests::secureHandshakeWithTestKey()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(4);
+  const auto publicKey = device.enableSigning();
+
+  SessionTicket issued;
+  issued.id.fill(0x33);
+  issued.key.fill(0x44);
+  device.setSessionTicket(issued.id, issued.key, 30);
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  auto cache = tempTicketCache(dir);
+
+  {
+    CdcTransport transport(device.slavePath());
+    QVERIFY(transport.setTrustedDeviceKey(publicKey));
+    transport.setSessionTicketCache(cache);
+    QVERIFY(transport.open());
+    QVERIFY(transport.isSecure());
+    QVERIFY(!transport.isResumed());
+  }
+
+  // The key was given to that transport only; others still trust just the built-in key
+  {
+    CdcTransport transport(device.slavePath());
+    QVERIFY(!transport.open());
+  }
+
+  // The verified session left a ticket behind, so the next open resumes it
+  const auto ticket = cache->find(device.slavePath().toStdString());
+  QVERIFY(ticket.has_value());
+  QCOMPARE(ticket->id, issued.id);
+  QCOMPARE(ticket->deviceName, std::string("fake"));
+
+  {
+    CdcTransport transport(device.slavePath());
+    transport.setSessionTicketCache(cache);
+    QVERIFY(transport.open());
+    QVERIFY(transport.isResumed());
+  }
+}
+
+void CdcTransportTests::replyFaultsAreSurvived()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+
+  uint32_t uptime = 0;
+  device.injectFault(PtyFakeDevice::Fault::NoisyReply);
+  QVERIFY(transport.sendKeepAlive(uptime));
+  device.injectFault(PtyFakeDevice::Fault::FragmentReply);
+  QVERIFY(transport.sendKeepAlive(uptime));
+
+  // A lost reply costs one timeout, after which the link carries on
+  device.injectFault(PtyFakeDevice::Fault::DropReply);
+  QVERIFY(!transport.sendKeepAlive(uptime));
+  QVERIFY(transport.sendKeepAlive(uptime));
+  QCOMPARE(uptime, uint32_t(42));
+}
+
+void CdcTransportTests::hangUpFailsRequest()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+
+  device.injectFault(PtyFakeDevice::Fault::HangUp);
+  uint32_t uptime = 0;
+  const auto start = std::chrono::steady_clock::now();
+  QVERIFY(!transport.sendKeepAlive(uptime));
+
+  // Reported as an I/O error rather than waiting out the reply timeout
+  QVERIFY(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+}
+
+void CdcTransportTests::throughputLimitPacesHidEvents()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(3);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+
+  // 400 key events in batch frames are about 2.2 KB on the wire
+  constexpr size_t kEvents = 400;
+  constexpr size_t kBytesPerSecond = 20000;
+  device.setThroughputLimit(kBytesPerSecond);
+  std::vector<HidEventPacket> packets;
+  for (size_t i = 0; i < kEvents; ++i) {
+    packets.emplace_back(HidEventType::KeyboardPress, std::initializer_list<uint8_t>{0x00, uint8_t(i)});
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  QVERIFY(transport.sendHidEvents(packets));
+  device.waitForHidFrames([&device](const std::vector<ReceivedFrame> &frames) {
+    return expandBatches(frames).size() >= kEvents;
+  });
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  const auto events = device.hidEvents();
+  QCOMPARE(events.size(), kEvents);
+  for (size_t i = 0; i < kEvents; ++i) {
+    QCOMPARE(events[i].payload.back(), uint8_t(i));
+  }
+
+  QVERIFY(elapsed >= std::chrono::milliseconds(80));
+}
+
+void CdcTransportTests::sendHidEventLegacy()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QCOMPARE(transport.hidEncoding(), HidEncoding::Legacy);
+
+  QVERIFY(transport.sendHidEvent({HidEventType::MouseMove, {0x05, 0x00, 0xFB, 0xFF}}));
+
+  const auto frames = device.waitForHidFrames(1);
+  QCOMPARE(frames.size(), size_t(1));
+  QCOMPARE(frames[0].type, kFrameTypeHid);
+  const std::vector<uint8_t> expected = {0x55, 0xAA, 0x03, 0x04, 0x05, 0x00, 0xFB, 0xFF};
+  QCOMPARE(frames[0].payload, expected);
+}
+
+void CdcTransportTests::sendHidEventCompact()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(2);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QCOMPARE(transport.hidEncoding(), HidEncoding::Compact);
+
+  QVERIFY(transport.sendHidEvent({HidEventType::MouseMove, {0x05, 0x00, 0xFB, 0xFF}}));
+  QVERIFY(transport.sendHidEvent({HidEventType::MouseMove, {0x00, 0x01, 0x00, 0x00}}));
+  QVERIFY(transport.sendHidEvent({HidEventType::KeyboardPress, {0x02, 0x04}}));
+  QVERIFY(transport.sendHidEvent({HidEventType::KeyboardRelease, {0x00, 0x04}}));
+  QVERIFY(transport.sendHidEvent({HidEventType::ConsumerControlPress, {0xE9, 0x00}}));
+
+  const auto frames = device.waitForHidFrames(5);
+  QCOMPARE(frames.size(), size_t(5));
+
+  // Small deltas fit one byte per axis
+  QCOMPARE(frames[0].type, kFrameTypeHidMouseCompact);
+  QCOMPARE(frames[0].payload, std::vector<uint8_t>({0x05, 0xFB}));
+
+  // Large deltas keep the 16-bit form
+  QCOMPARE(frames[1].type, kFrameTypeHidMouseCompact);
+  QCOMPARE(frames[1].payload, std::vector<uint8_t>({0x00, 0x01, 0x00, 0x00}));
+
+  QCOMPARE(frames[2].type, kFrameTypeHidKeyCompact);
+  QCOMPARE(frames[2].flags, uint8_t(0x01));
+  QCOMPARE(frames[2].payload, std::vector<uint8_t>({0x02, 0x04}));
+  QCOMPARE(frames[3].type, kFrameTypeHidKeyCompact);
+  QCOMPARE(frames[3].flags, uint8_t(0x00));
+
+  // Consumer control has no compact form
+  QCOMPARE(frames[4].type, kFrameTypeHid);
+}
+
+void CdcTransportTests::sendHidEventsBatched()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(3);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QCOMPARE(transport.hidEncoding(), HidEncoding::Batch);
+
+  // 40 events do not fit one batch frame, so they are split without losing order
+  std::vector<HidEventPacket> packets;
+  for (uint8_t i = 0; i < 40; ++i) {
+    packets.emplace_back(HidEventType::KeyboardPress, std::initializer_list<uint8_t>{0x00, i});
+  }
+  QVERIFY(transport.sendHidEvents(packets));
+
+  const auto frames = device.waitForHidFrames(2);
+  QCOMPARE(frames.size(), size_t(2));
+  uint8_t next = 0;
+  for (const auto &frame : frames) {
+    QCOMPARE(frame.type, kFrameTypeHidBatch);
+    QCOMPARE(frame.payload.size(), size_t(frame.flags) * 5);
+    for (size_t offset = 0; offset < frame.payload.size(); offset += 5) {
+      QCOMPARE(frame.payload[offset], kFrameTypeHidKeyCompact);
+      QCOMPARE(frame.payload[offset + 4], next++);
+    }
+  }
+  QCOMPARE(next, uint8_t(40));
+
+  // A single event goes out in its plain compact frame
+  QVERIFY(transport.sendHidEvents(std::span<const HidEventPacket>(packets.data(), 1)));
+  QCOMPARE(device.waitForHidFrames(3).back().type, kFrameTypeHidKeyCompact);
+}
+
+void CdcTransportTests::sendHidEventsWaitForCredits()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(5);
+  device.setCreditWindow(4);
+  device.setReportRate(500);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QVERIFY(transport.hasFlowControl());
+  QCOMPARE(transport.waitForHidCredits(1000), 4);
+
+  // Frames never carry more reports than the device has room for, so its queue cannot overrun
+  std::vector<HidEventPacket> packets;
+  for (uint8_t i = 0; i < 40; ++i) {
+    packets.emplace_back(HidEventType::KeyboardPress, std::initializer_list<uint8_t>{0x00, i});
+  }
+  const auto start = std::chrono::steady_clock::now();
+  QVERIFY(transport.sendHidEvents(packets));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  const auto events = expandBatches(device.waitForHidFrames([](const std::vector<ReceivedFrame> &frames) {
+    return expandBatches(frames).size() >= 40;
+  }));
+  QCOMPARE(events.size(), size_t(40));
+  for (uint8_t i = 0; i < 40; ++i) {
+    QCOMPARE(events[i].payload[1], i);
+  }
+  QCOMPARE(device.overflows(), size_t(0));
+  QVERIFY(device.maxQueuedReports() <= 4);
+  // 36 reports had to wait for the device to forward earlier ones at 500 per second
+  QVERIFY(elapsed >= std::chrono::milliseconds(60));
+
+  // Without flow control the window is not consulted at all
+  device.setProtocolVersion(3);
+  transport.close();
+  QVERIFY(transport.open(true));
+  QVERIFY(!transport.hasFlowControl());
+  QCOMPARE(transport.waitForHidCredits(0), std::numeric_limits<int>::max());
+}
+
+void CdcTransportTests::creditWaitKeepsOtherFrames()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(5);
+  device.setCreditWindow(2);
+  device.setReportRate(20);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  std::vector<HidEventPacket> packets;
+  packets.emplace_back(HidEventType::KeyboardPress, std::initializer_list<uint8_t>{0x00, 0x04});
+  packets.emplace_back(HidEventType::KeyboardRelease, std::initializer_list<uint8_t>{0x00, 0x04});
+  QVERIFY(transport.sendHidEvents(packets));
+  QCOMPARE(transport.waitForHidCredits(0), 0);
+
+  // The device reports its uptime unprompted while the host waits for the window to reopen
+  device.notify({kControlConfigResponse, kControlKeepAlive, 0, 7, 0, 0, 0});
+  QVERIFY(transport.waitForHidCredits(1000) > 0);
+  QVERIFY(transport.waitForHidCredits(0) > 0);
+
+  // The credit waits read the notification but leave it to the next reader
+  uint32_t uptime = 0;
+  QVERIFY(transport.sendKeepAlive(uptime));
+  QCOMPARE(uptime, uint32_t(7));
+}
+
+void CdcTransportTests::sendKeyboardReports()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(6);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QVERIFY(transport.hasKeyboardReport());
+
+  // A chord pressed key by key and released at once; empty key slots are not put on the wire
+  const std::vector<HidEventPacket> packets = {
+      {HidEventType::KeyboardReport, {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {HidEventType::KeyboardReport, {0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {HidEventType::KeyboardReport, {0x03, 0x00, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00}},
+      {HidEventType::KeyboardReport, {0x00, 0x00, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09}},
+      {HidEventType::KeyboardReport, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+  };
+  QVERIFY(transport.sendHidEvent(packets[0]));
+  QVERIFY(transport.sendHidEvents(std::span<const HidEventPacket>(packets).subspan(1)));
+
+  const auto events = expandBatches(device.waitForHidFrames([](const std::vector<ReceivedFrame> &frames) {
+    return expandBatches(frames).size() >= 5;
+  }));
+  QCOMPARE(events.size(), size_t(5));
+  for (const auto &event : events) {
+    QCOMPARE(event.type, kFrameTypeHidKeyboardReport);
+    QCOMPARE(event.flags, uint8_t(0x00));
+  }
+  QCOMPARE(events[0].payload, std::vector<uint8_t>({0x01}));
+  QCOMPARE(events[1].payload, std::vector<uint8_t>({0x03}));
+  QCOMPARE(events[2].payload, std::vector<uint8_t>({0x03, 0x17}));
+  QCOMPARE(events[3].payload, std::vector<uint8_t>({0x00, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09}));
+  QCOMPARE(events[4].payload, std::vector<uint8_t>({0x00}));
+
+  // Older firmware only understands key transitions
+  device.setProtocolVersion(5);
+  transport.close();
+  QVERIFY(transport.open(true));
+  QVERIFY(!transport.hasKeyboardReport());
+}
+
+void CdcTransportTests::scrollModeFollowsFirmware()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(8);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QCOMPARE(transport.scrollMode(), ScrollMode::HighResolution);
+
+  // A third of a detent down and two detents right, then a plain pan
+  QVERIFY(transport.sendHidEvent({HidEventType::MouseScrollHiRes, {0xD8, 0xFF, 0xF0, 0x00}}));
+  QVERIFY(transport.sendHidEvent({HidEventType::MousePan, {0xFE}}));
+
+  const auto frames = device.waitForHidFrames(2);
+  QCOMPARE(frames.size(), size_t(2));
+  QCOMPARE(frames[0].type, kFrameTypeHidScrollHiRes);
+  QCOMPARE(frames[0].payload, std::vector<uint8_t>({0xD8, 0xFF, 0xF0, 0x00}));
+  QCOMPARE(frames[1].type, kFrameTypeHidPanCompact);
+  QCOMPARE(frames[1].payload, std::vector<uint8_t>({0xFE}));
+
+  device.setProtocolVersion(7);
+  transport.close();
+  QVERIFY(transport.open(true));
+  QCOMPARE(transport.scrollMode(), ScrollMode::Horizontal);
+
+  device.setProtocolVersion(6);
+  transport.close();
+  QVERIFY(transport.open(true));
+  QCOMPARE(transport.scrollMode(), ScrollMode::Vertical);
+}
+
+void CdcTransportTests::sendAbsolutePointer()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(9);
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  QVERIFY(transport.hasAbsolutePointer());
+
+  QVERIFY(transport.sendHidEvent({HidEventType::MouseAbsolute, {0xFF, 0x7F, 0x00, 0x40}}));
+  const auto frames = device.waitForHidFrames(1);
+  QCOMPARE(frames.size(), size_t(1));
+  QCOMPARE(frames[0].type, kFrameTypeHidAbsoluteCompact);
+  QCOMPARE(frames[0].payload, std::vector<uint8_t>({0xFF, 0x7F, 0x00, 0x40}));
+
+  device.setProtocolVersion(8);
+  transport.close();
+  QVERIFY(transport.open(true));
+  QVERIFY(!transport.hasAbsolutePointer());
+}
+
+void CdcTransportTests::getProfilesPipelined()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+  // With replies slow enough that several requests are always in flight
+  device.setReplyLatency(std::chrono::milliseconds(20));
+
+  std::vector<std::optional<DeviceProfile>> profiles;
+  QVERIFY(transport.getProfiles(0, static_cast<uint8_t>(kProfileSlots), profiles));
+
+  QCOMPARE(profiles.size(), kProfileSlots);
+  for (size_t i = 0; i < kProfileSlots; ++i) {
+    QVERIFY(profiles[i].has_value());
+    QCOMPARE(std::memcmp(&*profiles[i], device.profile(i).data(), sizeof(DeviceProfile)), 0);
+  }
+  QCOMPARE(device.profileRequests(), kProfileSlots);
+
+  // A refused slot leaves its entry empty without failing the rest
+  QVERIFY(transport.getProfiles(static_cast<uint8_t>(kProfileSlots - 1), 2, profiles));
+  QCOMPARE(profiles.size(), size_t(2));
+  QVERIFY(profiles[0].has_value());
+  QVERIFY(!profiles[1].has_value());
+}
+
+void CdcTransportTests::setProfilesPipelined()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+
+  std::vector<std::pair<uint8_t, DeviceProfile>> updates;
+  for (uint8_t slot : {uint8_t(1), uint8_t(3), uint8_t(9)}) {
+    DeviceProfile profile;
+    std::memset(&profile, 0, sizeof(profile));
+    std::snprintf(profile.hostname, sizeof(profile.hostname), "host-%u", unsigned(slot));
+    profile.slot = slot;
+    profile.screenWidth = 1000 + slot;
+    updates.emplace_back(slot, profile);
+  }
+
+  std::vector<bool> ok;
+  QVERIFY(transport.setProfiles(updates, ok));
+  QCOMPARE(ok, std::vector<bool>({true, true, false}));
+
+  std::vector<std::optional<DeviceProfile>> profiles;
+  QVERIFY(transport.getProfiles(0, static_cast<uint8_t>(kProfileSlots), profiles));
+  QCOMPARE(std::string(profiles[1]->hostname), std::string("host-1"));
+  QCOMPARE(profiles[3]->screenWidth, uint16_t(1003));
+  QCOMPARE(profiles[2]->slot, uint8_t(2)); // untouched slots keep their contents
+}
+
+void CdcTransportTests::lateRepliesAreDrained()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  CdcTransport transport(device.slavePath());
+  QVERIFY(transport.open(true));
+
+  // A second ACK to the first request would shift every later profile into the wrong slot
+  std::vector<std::optional<DeviceProfile>> profiles;
+  device.injectFault(PtyFakeDevice::Fault::DuplicateReply);
+  QVERIFY(!transport.getProfiles(0, static_cast<uint8_t>(kProfileSlots), profiles));
+
+  // The ACKs still in flight are discarded, so the next command gets its own
+  DeviceProfile profile;
+  QVERIFY(transport.getProfile(4, profile));
+  QCOMPARE(profile.slot, uint8_t(4));
+
+  // Likewise when a reply goes missing halfway through
+  device.injectFault(PtyFakeDevice::Fault::DropReply);
+  QVERIFY(!transport.getProfiles(0, static_cast<uint8_t>(kProfileSlots), profiles));
+  QVERIFY(transport.getProfiles(0, static_cast<uint8_t>(kProfileSlots), profiles));
+  for (size_t i = 0; i < kProfileSlots; ++i) {
+    QCOMPARE(profiles[i]->slot, static_cast<uint8_t>(i));
+  }
+}
+
+QTEST_MAIN(CdcTransportTests)
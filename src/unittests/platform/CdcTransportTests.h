@@ -0,0 +1,38 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include <QTest>
+
+class CdcTransportTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  // Test are run in order top to bottom
+  void openInsecure();
+  void keepAliveRoundTripLatency();
+  void readTimeoutHonoursDeadline();
+  void handshakeTimeoutIsReported();
+  void resumeSessionFromTicket();
+  void rejectedTicketFallsBackToFullHandshake();
+  void secureHandshakeWithTestKey();
+  void replyFaultsAreSurvived();
+  void hangUpFailsRequest();
+  void throughputLimitPacesHidEvents();
+  void sendHidEventLegacy();
+  void sendHidEventCompact();
+  void sendHidEventsBatched();
+  void sendHidEventsWaitForCredits();
+  void creditWaitKeepsOtherFrames();
+  void sendKeyboardReports();
+  void scrollModeFollowsFirmware();
+  void sendAbsolutePointer();
+  void getProfilesPipelined();
+  void setProfilesPipelined();
+  void lateRepliesAreDrained();
+
+private:
+  Log m_log;
+};
@@ -0,0 +1,66 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "DigitizerMappingTests.h"
+
+#include "platform/bridge/DigitizerMapping.h"
+
+#include <cstdlib>
+#include <utility>
+
+using namespace deskflow::bridge;
+
+namespace {
+
+constexpr uint16_t kMax = DigitizerMapping::kLogicalMax;
+
+std::pair<uint16_t, uint16_t> map(const DigitizerMapping &mapping, int32_t x, int32_t y)
+{
+  uint16_t logicalX = 0;
+  uint16_t logicalY = 0;
+  mapping.map(x, y, logicalX, logicalY);
+  return {logicalX, logicalY};
+}
+
+} // namespace
+
+void DigitizerMappingTests::portraitEdgesReachLogicalRange()
+{
+  const DigitizerMapping mapping(1080, 2424, 0);
+
+  QCOMPARE(map(mapping, 0, 0), std::make_pair(uint16_t(0), uint16_t(0)));
+  QCOMPARE(map(mapping, 1079, 2423), std::make_pair(kMax, kMax));
+
+  // The center lands within half a logical unit of the middle
+  const auto [x, y] = map(mapping, 1079 / 2, 2423 / 2);
+  QVERIFY(std::abs(int(x) - kMax / 2) <= kMax / 1079);
+  QVERIFY(std::abs(int(y) - kMax / 2) <= kMax / 2423);
+}
+
+void DigitizerMappingTests::landscapeTurnsAxes()
+{
+  // The phone is turned counter-clockwise: its top is on the left of the screen
+  const DigitizerMapping mapping(2424, 1080, 1);
+
+  QCOMPARE(map(mapping, 0, 1079), std::make_pair(uint16_t(0), uint16_t(0)));
+  QCOMPARE(map(mapping, 0, 0), std::make_pair(kMax, uint16_t(0)));
+  QCOMPARE(map(mapping, 2423, 1079), std::make_pair(uint16_t(0), kMax));
+  QCOMPARE(map(mapping, 2423, 0), std::make_pair(kMax, kMax));
+}
+
+void DigitizerMappingTests::positionsOutsideScreenAreClamped()
+{
+  const DigitizerMapping mapping(1920, 1080, 0);
+
+  QCOMPARE(map(mapping, -50, -1), std::make_pair(uint16_t(0), uint16_t(0)));
+  QCOMPARE(map(mapping, 5000, 1080), std::make_pair(kMax, kMax));
+}
+
+void DigitizerMappingTests::degenerateScreenMapsToOrigin()
+{
+  QCOMPARE(map(DigitizerMapping(), 10, 10), std::make_pair(uint16_t(0), uint16_t(0)));
+  QCOMPARE(map(DigitizerMapping(1, 1, 0), 0, 0), std::make_pair(uint16_t(0), uint16_t(0)));
+}
+
+QTEST_MAIN(DigitizerMappingTests)
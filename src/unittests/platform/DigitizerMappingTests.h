@@ -0,0 +1,15 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class DigitizerMappingTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void portraitEdgesReachLogicalRange();
+  void landscapeTurnsAxes();
+  void positionsOutsideScreenAreClamped();
+  void degenerateScreenMapsToOrigin();
+};
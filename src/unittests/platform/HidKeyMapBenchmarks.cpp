@@ -0,0 +1,37 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "HidKeyMapBenchmarks.h"
+
+#include "platform/bridge/HidKeyMap.h"
+
+#include <vector>
+
+using namespace deskflow::bridge;
+
+void HidKeyMapBenchmarks::keyLookup()
+{
+  // A typing mix: mostly letters, some modifiers, function keys and media keys
+  std::vector<KeyID> ids;
+  for (KeyID id = 'a'; id <= 'z'; ++id) {
+    ids.push_back(id);
+    ids.push_back(id);
+  }
+  for (const KeyID id : {kKeyShift_L, kKeyControl_R, kKeyReturn, kKeyBackSpace, kKeyF5, kKeyLeft, kKeyAudioUp}) {
+    ids.push_back(id);
+  }
+
+  // What fakeKeyDown asks for each key: consumer usage, modifier bit and key usage
+  volatile unsigned sum = 0;
+  QBENCHMARK {
+    unsigned total = 0;
+    for (const KeyID id : ids) {
+      total += consumerUsageForKeyId(id) + hidModifierBitForKeyId(id) + hidUsageForKeyId(id);
+    }
+    sum = total;
+  }
+  QVERIFY(sum != 0);
+}
+
+QTEST_MAIN(HidKeyMapBenchmarks)
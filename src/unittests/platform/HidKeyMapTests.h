@@ -0,0 +1,13 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class HidKeyMapTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void keyIdsMatchSwitchMapping();
+  void keyButtonsMatchSwitchMapping();
+};
@@ -0,0 +1,166 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "HidRecordingTests.h"
+
+#include "platform/bridge/HidRecording.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <unistd.h>
+
+using namespace deskflow::bridge;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::filesystem::path tempRecordingFile()
+{
+  static std::atomic_int counter = 0;
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("HidRecordingTests-" + std::to_string(getpid()) + "-" + std::to_string(counter++));
+  std::filesystem::remove(path);
+  return path;
+}
+
+std::vector<uint8_t> readFile(const std::filesystem::path &path)
+{
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+int16_t moveX(const HidEventPacket &packet)
+{
+  return static_cast<int16_t>(packet.data[0] | (packet.data[1] << 8));
+}
+
+int16_t moveY(const HidEventPacket &packet)
+{
+  return static_cast<int16_t>(packet.data[2] | (packet.data[3] << 8));
+}
+
+} // namespace
+
+void HidRecordingTests::roundTripThroughFile()
+{
+  const auto file = tempRecordingFile();
+  const auto start = HidRecorder::Clock::now();
+  const HidEventPacket press(HidEventType::KeyboardPress, {0x02, 0x04});
+  const HidEventPacket report(HidEventType::KeyboardReport, {0x02, 0x00, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09});
+  {
+    HidRecorder recorder(file, start);
+    QVERIFY(recorder.isOpen());
+    recorder.record(press, start + 1500us);
+    recorder.recordMouseMove(-3, 7, start + 1500us);
+    // Ten minutes needs a multi-byte delta
+    recorder.record(report, start + 10min);
+    QCOMPARE(recorder.recorded(), uint64_t(3));
+  }
+
+  std::string error;
+  const auto records = loadHidRecording(file, error);
+  QVERIFY2(records.has_value(), error.c_str());
+  QCOMPARE(records->size(), size_t(3));
+
+  QCOMPARE((*records)[0].time, std::chrono::microseconds(1500us));
+  QVERIFY((*records)[0].packet.type == HidEventType::KeyboardPress);
+  QVERIFY(std::ranges::equal((*records)[0].packet.payload(), press.payload()));
+
+  QCOMPARE((*records)[1].time, std::chrono::microseconds(1500us));
+  QVERIFY((*records)[1].packet.type == HidEventType::MouseMove);
+  QCOMPARE(moveX((*records)[1].packet), int16_t(-3));
+  QCOMPARE(moveY((*records)[1].packet), int16_t(7));
+
+  QCOMPARE((*records)[2].time, std::chrono::microseconds(10min));
+  QVERIFY(std::ranges::equal((*records)[2].packet.payload(), report.payload()));
+
+  std::filesystem::remove(file);
+}
+
+void HidRecordingTests::largeMovesAreSplit()
+{
+  const auto file = tempRecordingFile();
+  {
+    HidRecorder recorder(file);
+    recorder.recordMouseMove(40000, -70000);
+  }
+
+  std::string error;
+  const auto records = loadHidRecording(file, error);
+  QVERIFY2(records.has_value(), error.c_str());
+  QCOMPARE(records->size(), size_t(3));
+
+  int32_t dx = 0;
+  int32_t dy = 0;
+  for (const auto &record : *records) {
+    dx += moveX(record.packet);
+    dy += moveY(record.packet);
+  }
+  QCOMPARE(dx, 40000);
+  QCOMPARE(dy, -70000);
+
+  std::filesystem::remove(file);
+}
+
+void HidRecordingTests::truncatedRecordIsDropped()
+{
+  const auto file = tempRecordingFile();
+  {
+    HidRecorder recorder(file);
+    recorder.record(HidEventPacket(HidEventType::MouseButtonPress, {0x01}));
+    recorder.record(HidEventPacket(HidEventType::MouseButtonRelease, {0x00}));
+  }
+  auto bytes = readFile(file);
+  bytes.pop_back();
+
+  // A recording cut short by a crash still plays back up to the last complete event
+  std::string error;
+  const auto records = parseHidRecording(bytes, error);
+  QVERIFY2(records.has_value(), error.c_str());
+  QCOMPARE(records->size(), size_t(1));
+  QVERIFY(records->front().packet.type == HidEventType::MouseButtonPress);
+
+  std::filesystem::remove(file);
+}
+
+void HidRecordingTests::foreignFilesAreRejected()
+{
+  std::string error;
+  const std::vector<uint8_t> foreign = {'n', 'o', 't', ' ', 'h', 'i', 'd', '!'};
+  QVERIFY(!parseHidRecording(foreign, error).has_value());
+
+  std::vector<uint8_t> future = {'D', 'S', 'H', 'R', HidRecorder::kVersion + 1, 0, 0, 0};
+  QVERIFY(!parseHidRecording(future, error).has_value());
+
+  std::vector<uint8_t> oversized = {'D', 'S', 'H', 'R', HidRecorder::kVersion, 0, 0, 0, 0x00, 0x01, 0x20};
+  oversized.resize(oversized.size() + 0x20);
+  QVERIFY(!parseHidRecording(oversized, error).has_value());
+
+  QVERIFY(!loadHidRecording(tempRecordingFile(), error).has_value());
+}
+
+void HidRecordingTests::fileIsOwnerOnly()
+{
+  constexpr auto kOwnerOnly = std::filesystem::perms::owner_read | std::filesystem::perms::owner_write;
+
+  const auto fresh = tempRecordingFile();
+  QVERIFY(HidRecorder(fresh).isOpen());
+  QCOMPARE(std::filesystem::status(fresh).permissions(), kOwnerOnly);
+  std::filesystem::remove(fresh);
+
+  // A file left open to everyone by an earlier run is restricted as well as emptied
+  const auto old = tempRecordingFile();
+  std::ofstream(old) << "old trace";
+  std::filesystem::permissions(old, std::filesystem::perms::all);
+  QVERIFY(HidRecorder(old).isOpen());
+  QCOMPARE(std::filesystem::status(old).permissions(), kOwnerOnly);
+  QCOMPARE(readFile(old).size(), HidRecorder::kHeaderSize);
+  std::filesystem::remove(old);
+}
+
+QTEST_MAIN(HidRecordingTests)
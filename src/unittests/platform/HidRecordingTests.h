@@ -0,0 +1,16 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class HidRecordingTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void roundTripThroughFile();
+  void largeMovesAreSplit();
+  void truncatedRecordIsDropped();
+  void foreignFilesAreRejected();
+  void fileIsOwnerOnly();
+};
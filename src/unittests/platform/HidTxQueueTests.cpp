@@ -0,0 +1,270 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "HidTxQueueTests.h"
+
+#include "PtyFakeDevice.h"
+#include "platform/bridge/CdcTransport.h"
+#include "platform/bridge/HidTxQueue.h"
+
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace deskflow::bridge;
+using namespace deskflow::bridge::fake;
+
+namespace {
+bool isKeyFrame(const ReceivedFrame &frame, uint8_t type, uint8_t keycode)
+{
+  return frame.type == kFrameTypeHid && frame.payload.size() == 6 && frame.payload[2] == type &&
+         frame.payload[5] == keycode;
+}
+
+// Horizontal motion carried by a compact or legacy mouse move, 0 for anything else
+int32_t motionX(const ReceivedFrame &frame)
+{
+  int16_t dx = 0;
+  int16_t dy = 0;
+  if (frame.type == kFrameTypeHidMouseCompact && frame.payload.size() == 2) {
+    return static_cast<int8_t>(frame.payload[0]);
+  }
+  return legacyMouseMove(frame, dx, dy) ? dx : 0;
+}
+} // namespace
+
+void HidTxQueueTests::coalescesMotionWhileDeviceBusy()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  HidTxQueue queue(transport);
+  {
+    // Holding the transport stands in for a congested device: the writer takes the first key
+    // and then blocks, so everything after it has to queue up
+    auto busy = queue.lockTransport();
+    QVERIFY(queue.enqueue({HidEventType::KeyboardPress, {0x00, 0x04}}));
+    for (int i = 0; i < 50; ++i) {
+      QVERIFY(queue.enqueueMouseMove(2, 1));
+    }
+    QVERIFY(queue.enqueue({HidEventType::KeyboardRelease, {0x00, 0x04}}));
+    for (int i = 0; i < 50; ++i) {
+      QVERIFY(queue.enqueueMouseMove(-1, 0));
+    }
+  }
+
+  const auto frames = device.waitForHidFrames(4);
+  QCOMPARE(frames.size(), size_t(4));
+
+  int16_t dx = 0;
+  int16_t dy = 0;
+  QVERIFY(isKeyFrame(frames[0], 0x01, 0x04));
+  QVERIFY(legacyMouseMove(frames[1], dx, dy));
+  QCOMPARE(dx, int16_t(100));
+  QCOMPARE(dy, int16_t(50));
+  QVERIFY(isKeyFrame(frames[2], 0x02, 0x04));
+  QVERIFY(legacyMouseMove(frames[3], dx, dy));
+  QCOMPARE(dx, int16_t(-50));
+  QCOMPARE(dy, int16_t(0));
+
+  QCOMPARE(queue.stats().coalesced, uint64_t(98));
+  QCOMPARE(queue.stats().depth, size_t(0));
+  QTRY_COMPARE(queue.stats().eventsSent, uint64_t(4));
+}
+
+void HidTxQueueTests::fullRingKeepsEveryTransition()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  // Key and button presses and releases, each followed by a mouse move
+  constexpr size_t kTransitions = HidTxQueue::kCapacity * 4;
+  const auto transition = [](size_t i) {
+    const auto n = static_cast<uint8_t>(i / 4);
+    switch (i % 4) {
+    case 0:
+      return HidEventPacket(HidEventType::KeyboardPress, {0x00, n});
+    case 1:
+      return HidEventPacket(HidEventType::KeyboardRelease, {0x00, n});
+    case 2:
+      return HidEventPacket(HidEventType::MouseButtonPress, {n});
+    default:
+      return HidEventPacket(HidEventType::MouseButtonRelease, {n});
+    }
+  };
+
+  HidTxQueue queue(transport);
+  {
+    // A device that stopped reading: the writer blocks on the transport, yet the producer must
+    // never wait for it (holding the lock here would deadlock a producer that did)
+    auto busy = queue.lockTransport();
+    for (size_t i = 0; i < kTransitions; ++i) {
+      QVERIFY(queue.enqueue(transition(i)));
+      QVERIFY(queue.enqueueMouseMove(1, 0));
+    }
+    const auto stats = queue.stats();
+    QCOMPARE(stats.maxDepth, HidTxQueue::kCapacity);
+    QVERIFY(stats.spilled >= kTransitions * 2 - HidTxQueue::kCapacity - HidTxQueue::kMaxBatchEvents);
+  }
+
+  // Once the device reads again every transition arrives in order, with the motion in between
+  const auto frames = device.waitForHidFrames(kTransitions * 2);
+  QCOMPARE(frames.size(), kTransitions * 2);
+  for (size_t i = 0; i < kTransitions; ++i) {
+    const auto expected = transition(i);
+    const auto &frame = frames[i * 2];
+    QCOMPARE(frame.type, kFrameTypeHid);
+    QCOMPARE(frame.payload[2], static_cast<uint8_t>(expected.type));
+    QVERIFY(frame.payload.back() == expected.payload().back());
+    QCOMPARE(motionX(frames[i * 2 + 1]), 1);
+  }
+  QTRY_COMPARE(queue.stats().depth, size_t(0));
+  QVERIFY(!queue.hasFailed());
+}
+
+void HidTxQueueTests::overflowFailsQueue()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  HidTxQueue queue(transport);
+  {
+    // Rather than drop a transition the queue gives up once the overflow list is full too
+    auto busy = queue.lockTransport();
+    constexpr size_t kRoom = HidTxQueue::kCapacity + HidTxQueue::kSpillCapacity;
+    size_t accepted = 0;
+    while (accepted <= kRoom + HidTxQueue::kMaxBatchEvents &&
+           queue.enqueue({HidEventType::KeyboardPress, {0x00, 0x04}})) {
+      ++accepted;
+    }
+    QVERIFY(accepted >= kRoom);
+    QVERIFY(accepted <= kRoom + HidTxQueue::kMaxBatchEvents);
+    QVERIFY(queue.hasFailed());
+  }
+
+  QVERIFY(!queue.enqueue({HidEventType::KeyboardRelease, {0x00, 0x04}}));
+}
+
+void HidTxQueueTests::flushSendsOneBatch()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(3);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+  QCOMPARE(transport->hidEncoding(), HidEncoding::Batch);
+
+  // Let the writer finish its first pass and go idle
+  HidTxQueue queue(transport);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // Ctrl+C with a mouse move in between, as one drain cycle of server messages would produce
+  queue.beginBatch();
+  QVERIFY(queue.enqueue({HidEventType::KeyboardPress, {0x01, 0x06}}));
+  QVERIFY(queue.enqueueMouseMove(5, -3));
+  QVERIFY(queue.enqueue({HidEventType::KeyboardRelease, {0x00, 0x06}}));
+  QVERIFY(queue.enqueueMouseMove(1, 1));
+  queue.flush();
+
+  const auto frames = device.waitForHidFrames(1);
+  QCOMPARE(frames.size(), size_t(1));
+  QCOMPARE(frames[0].type, kFrameTypeHidBatch);
+  QCOMPARE(frames[0].flags, uint8_t(4));
+  const std::vector<uint8_t> expected = {
+      kFrameTypeHidKeyCompact,   0x01, 2, 0x01, 0x06, // press
+      kFrameTypeHidMouseCompact, 0x00, 2, 0x05, 0xFD, // move
+      kFrameTypeHidKeyCompact,   0x00, 2, 0x00, 0x06, // release
+      kFrameTypeHidMouseCompact, 0x00, 2, 0x01, 0x01, // trailing move
+  };
+  QCOMPARE(frames[0].payload, expected);
+  QTRY_COMPARE(queue.stats().batches, uint64_t(1));
+
+  // Outside a batch nothing waits for a flush that may never come
+  QVERIFY(queue.enqueue({HidEventType::KeyboardPress, {0x00, 0x04}}));
+  QCOMPARE(device.waitForHidFrames(2).size(), size_t(2));
+}
+
+void HidTxQueueTests::creditsHoldMotionBack()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+  device.setProtocolVersion(5);
+  device.setCreditWindow(4);
+  device.setReportRate(200);
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+  QVERIFY(transport->hasFlowControl());
+
+  constexpr int kMoves = 300;
+  HidTxQueue::Stats stats;
+  {
+    HidTxQueue queue(transport);
+    // Motion arrives about three times faster than the device forwards reports over BLE
+    for (int i = 0; i < kMoves; ++i) {
+      QVERIFY(queue.enqueueMouseMove(1, 0));
+      std::this_thread::sleep_for(std::chrono::microseconds(1600));
+    }
+    QVERIFY(queue.enqueue({HidEventType::KeyboardPress, {0x00, 0x04}}));
+    QTRY_COMPARE(queue.stats().depth, size_t(0));
+    stats = queue.stats();
+  }
+
+  const auto events = device.waitForHidFrames([](const std::vector<ReceivedFrame> &frames) {
+    const auto expanded = expandBatches(frames);
+    return !expanded.empty() && expanded.back().type == kFrameTypeHidKeyCompact;
+  });
+  const auto expanded = expandBatches(events);
+
+  // Nothing was lost or overran the device queue; the backlog turned into fewer, larger moves
+  int32_t totalX = 0;
+  for (const auto &event : expanded) {
+    totalX += motionX(event);
+  }
+  QCOMPARE(totalX, kMoves);
+  QCOMPARE(device.overflows(), size_t(0));
+  QVERIFY(device.maxQueuedReports() <= 4);
+  QVERIFY(expanded.size() < size_t(kMoves / 2));
+  QVERIFY(stats.creditStalls > 0);
+}
+
+void HidTxQueueTests::oversizePacketIsRejected()
+{
+  PtyFakeDevice device;
+  QVERIFY(device.isValid());
+
+  auto transport = std::make_shared<CdcTransport>(device.slavePath());
+  QVERIFY(transport->open(true));
+
+  const std::array<uint8_t, HidEventPacket::kMaxPayloadSize + 1> payload{};
+  const HidEventPacket oversize(HidEventType::KeyboardReport, payload);
+  QVERIFY(!oversize.isValid());
+  QCOMPARE(oversize.payload().size(), size_t(0));
+
+  std::array<uint8_t, HidEventPacket::kMaxSerializedSize + 1> buffer;
+  QCOMPARE(oversize.serialize(buffer), size_t(0));
+
+  // The packet is refused up front and the queue carries on with the next one
+  HidTxQueue queue(transport);
+  QVERIFY(!queue.enqueue(oversize));
+  QVERIFY(queue.enqueue({HidEventType::KeyboardPress, {0x00, 0x04}}));
+
+  const auto frames = device.waitForHidFrames(1);
+  QCOMPARE(frames.size(), size_t(1));
+  QVERIFY(isKeyFrame(frames[0], 0x01, 0x04));
+  QTRY_COMPARE(queue.stats().eventsSent, uint64_t(1));
+}
+
+QTEST_MAIN(HidTxQueueTests)
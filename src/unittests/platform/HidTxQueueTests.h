@@ -0,0 +1,23 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include <QTest>
+
+class HidTxQueueTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  // Test are run in order top to bottom
+  void coalescesMotionWhileDeviceBusy();
+  void fullRingKeepsEveryTransition();
+  void overflowFailsQueue();
+  void flushSendsOneBatch();
+  void creditsHoldMotionBack();
+  void oversizePacketIsRejected();
+
+private:
+  Log m_log;
+};
@@ -0,0 +1,63 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "LinkFrameParserBenchmarks.h"
+
+#include "platform/bridge/LinkFrameParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace deskflow::bridge;
+
+void LinkFrameParserBenchmarks::parse()
+{
+  // 1 MB of mostly HID-sized frames, with a burst of noise now and then
+  std::mt19937 rng(6);
+  std::vector<uint8_t> stream;
+  size_t frames = 0;
+  while (stream.size() < 1024 * 1024) {
+    if (frames % 64 == 0) {
+      stream.insert(stream.end(), 512, 0x00);
+    }
+    const auto length = static_cast<uint16_t>(std::uniform_int_distribution<size_t>(0, 16)(rng));
+    const uint8_t header[] = {
+        LinkFrameParser::kMagic & 0xFF,
+        LinkFrameParser::kMagic >> 8,
+        LinkFrameParser::kVersion,
+        static_cast<uint8_t>(rng()),
+        static_cast<uint8_t>(rng()),
+        0,
+        static_cast<uint8_t>(length & 0xFF),
+        static_cast<uint8_t>(length >> 8)
+    };
+    stream.insert(stream.end(), std::begin(header), std::end(header));
+    for (uint16_t i = 0; i < length; ++i) {
+      stream.push_back(static_cast<uint8_t>(rng()));
+    }
+    ++frames;
+  }
+
+  LinkFrameParser parser;
+  size_t parsed = 0;
+  QBENCHMARK {
+    parser.reset();
+    parsed = 0;
+    for (size_t offset = 0; offset < stream.size();) {
+      const auto space = parser.writableSpace();
+      const size_t length = std::min({LinkFrameParser::kReadChunk, space.size(), stream.size() - offset});
+      std::memcpy(space.data(), stream.data() + offset, length);
+      parser.commit(length);
+      offset += length;
+      while (parser.next()) {
+        ++parsed;
+      }
+    }
+  }
+  QCOMPARE(parsed, frames);
+}
+
+QTEST_MAIN(LinkFrameParserBenchmarks)
@@ -0,0 +1,12 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class LinkFrameParserBenchmarks : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void parse();
+};
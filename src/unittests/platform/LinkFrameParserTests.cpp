@@ -0,0 +1,188 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "LinkFrameParserTests.h"
+
+#include "platform/bridge/LinkFrameParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace deskflow::bridge;
+
+namespace {
+
+struct Frame
+{
+  uint8_t type = 0;
+  uint8_t flags = 0;
+  std::vector<uint8_t> payload;
+
+  bool operator==(const Frame &) const = default;
+};
+
+void appendFrame(std::vector<uint8_t> &stream, const Frame &frame, uint8_t version = LinkFrameParser::kVersion)
+{
+  const auto length = static_cast<uint16_t>(frame.payload.size());
+  const uint8_t header[] = {
+      LinkFrameParser::kMagic & 0xFF,
+      LinkFrameParser::kMagic >> 8,
+      version,
+      frame.type,
+      frame.flags,
+      0,
+      static_cast<uint8_t>(length & 0xFF),
+      static_cast<uint8_t>(length >> 8)
+  };
+  stream.insert(stream.end(), std::begin(header), std::end(header));
+  stream.insert(stream.end(), frame.payload.begin(), frame.payload.end());
+}
+
+Frame randomFrame(std::mt19937 &rng, size_t maxPayload)
+{
+  Frame frame;
+  frame.type = static_cast<uint8_t>(rng());
+  frame.flags = static_cast<uint8_t>(rng());
+  frame.payload.resize(std::uniform_int_distribution<size_t>(0, maxPayload)(rng));
+  for (auto &byte : frame.payload) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  return frame;
+}
+
+// Feeds the stream in chunks of up to maxChunk bytes, the way reads from the device arrive
+std::vector<Frame>
+parse(LinkFrameParser &parser, const std::vector<uint8_t> &stream, std::mt19937 &rng, size_t maxChunk)
+{
+  std::vector<Frame> frames;
+  std::uniform_int_distribution<size_t> chunkSize(1, maxChunk);
+  for (size_t offset = 0; offset < stream.size();) {
+    const auto space = parser.writableSpace();
+    const size_t length = std::min({chunkSize(rng), space.size(), stream.size() - offset});
+    std::memcpy(space.data(), stream.data() + offset, length);
+    parser.commit(length);
+    offset += length;
+
+    while (const auto frame = parser.next()) {
+      frames.push_back({frame->type, frame->flags, {frame->payload.begin(), frame->payload.end()}});
+    }
+  }
+  return frames;
+}
+
+} // namespace
+
+void LinkFrameParserTests::framesSplitAcrossReads()
+{
+  std::mt19937 rng(1);
+  std::vector<Frame> expected;
+  std::vector<uint8_t> stream;
+  for (int i = 0; i < 500; ++i) {
+    expected.push_back(randomFrame(rng, 300));
+    appendFrame(stream, expected.back());
+  }
+
+  for (const size_t maxChunk : {size_t(1), size_t(7), size_t(128), LinkFrameParser::kReadChunk}) {
+    LinkFrameParser parser;
+    QCOMPARE(parse(parser, stream, rng, maxChunk), expected);
+    QCOMPARE(parser.buffered(), size_t(0));
+    QCOMPARE(parser.discarded(), uint64_t(0));
+  }
+}
+
+void LinkFrameParserTests::largestFrameFits()
+{
+  std::mt19937 rng(2);
+  Frame large = randomFrame(rng, 0);
+  large.payload.assign(0xFFFF, 0xC3);
+  const Frame small = randomFrame(rng, 16);
+
+  // A partial frame left behind by the previous read forces the buffer to compact
+  std::vector<uint8_t> stream;
+  appendFrame(stream, small);
+  appendFrame(stream, large);
+  appendFrame(stream, small);
+
+  LinkFrameParser parser;
+  QCOMPARE(parse(parser, stream, rng, LinkFrameParser::kReadChunk), (std::vector<Frame>{small, large, small}));
+}
+
+void LinkFrameParserTests::unknownVersionIsSkipped()
+{
+  std::mt19937 rng(3);
+  const Frame first = randomFrame(rng, 32);
+  const Frame skipped = randomFrame(rng, 32);
+  const Frame last = randomFrame(rng, 32);
+
+  std::vector<uint8_t> stream;
+  appendFrame(stream, first);
+  appendFrame(stream, skipped, LinkFrameParser::kVersion + 1);
+  appendFrame(stream, last);
+
+  LinkFrameParser parser;
+  QCOMPARE(parse(parser, stream, rng, 64), (std::vector<Frame>{first, last}));
+  QCOMPARE(parser.discarded(), uint64_t(0));
+}
+
+void LinkFrameParserTests::garbageBetweenFramesIsSkipped()
+{
+  std::mt19937 rng(4);
+  std::vector<Frame> expected;
+  std::vector<uint8_t> stream;
+  uint64_t garbage = 0;
+  for (int i = 0; i < 2000; ++i) {
+    // Line noise, including lone magic bytes that only look like the start of a frame
+    const size_t noise = std::uniform_int_distribution<size_t>(0, 40)(rng);
+    for (size_t n = 0; n < noise; ++n) {
+      uint8_t byte = static_cast<uint8_t>(rng());
+      if (byte == (LinkFrameParser::kMagic & 0xFF)) {
+        stream.push_back(byte);
+        ++garbage;
+        byte = 0x00;
+      }
+      stream.push_back(byte);
+      ++garbage;
+    }
+    expected.push_back(randomFrame(rng, 120));
+    appendFrame(stream, expected.back());
+  }
+
+  LinkFrameParser parser;
+  QCOMPARE(parse(parser, stream, rng, 600), expected);
+  QCOMPARE(parser.discarded(), garbage);
+}
+
+void LinkFrameParserTests::randomBytesStayBounded()
+{
+  std::mt19937 rng(5);
+  std::vector<uint8_t> stream(4 * 1024 * 1024);
+  for (auto &byte : stream) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  // Sprinkle magic so the parser also sees bogus headers with random lengths
+  for (size_t i = 0; i + 1 < stream.size(); i += 997) {
+    stream[i] = LinkFrameParser::kMagic & 0xFF;
+    stream[i + 1] = LinkFrameParser::kMagic >> 8;
+  }
+
+  LinkFrameParser parser;
+  std::uniform_int_distribution<size_t> chunkSize(1, LinkFrameParser::kReadChunk);
+  for (size_t offset = 0; offset < stream.size();) {
+    const auto space = parser.writableSpace();
+    QVERIFY(space.size() >= LinkFrameParser::kReadChunk);
+    const size_t length = std::min({chunkSize(rng), space.size(), stream.size() - offset});
+    std::memcpy(space.data(), stream.data() + offset, length);
+    parser.commit(length);
+    offset += length;
+
+    while (const auto frame = parser.next()) {
+      QVERIFY(frame->payload.size() <= 0xFFFF);
+    }
+    QVERIFY(parser.buffered() < LinkFrameParser::kMaxFrameSize);
+  }
+}
+
+QTEST_MAIN(LinkFrameParserTests)
@@ -0,0 +1,16 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class LinkFrameParserTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void framesSplitAcrossReads();
+  void largestFrameFits();
+  void unknownVersionIsSkipped();
+  void garbageBetweenFramesIsSkipped();
+  void randomBytesStayBounded();
+};
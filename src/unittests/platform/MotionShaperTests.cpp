@@ -0,0 +1,165 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "MotionShaperTests.h"
+
+#include "platform/bridge/MotionShaper.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace deskflow::bridge;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Report
+{
+  MotionShaper::Clock::duration at;
+  int16_t dx = 0;
+  int16_t dy = 0;
+};
+
+// Runs the shaper on a simulated clock, ticking 1 ms at a time until it has nothing left
+std::vector<Report> drain(MotionShaper &shaper, MotionShaper::Clock::time_point start)
+{
+  std::vector<Report> reports;
+  for (auto now = start; shaper.hasPending(); now += 1ms) {
+    int16_t dx = 0;
+    int16_t dy = 0;
+    if (shaper.next(now, dx, dy)) {
+      reports.push_back({now - start, dx, dy});
+    }
+  }
+  return reports;
+}
+
+} // namespace
+
+void MotionShaperTests::smallMoveIsNotSplit()
+{
+  MotionShaper shaper({8ms, 127});
+  shaper.add(40, -12);
+
+  const auto reports = drain(shaper, MotionShaper::Clock::time_point{});
+  QCOMPARE(reports.size(), size_t(1));
+  QCOMPARE(reports[0].dx, int16_t(40));
+  QCOMPARE(reports[0].dy, int16_t(-12));
+}
+
+void MotionShaperTests::largeMoveIsPaced()
+{
+  MotionShaper shaper({8ms, 127});
+  shaper.add(1000, 10);
+
+  const auto reports = drain(shaper, MotionShaper::Clock::time_point{});
+  QCOMPARE(reports.size(), size_t(8));
+
+  int32_t totalX = 0;
+  int32_t totalY = 0;
+  for (size_t i = 0; i < reports.size(); ++i) {
+    QCOMPARE(reports[i].at, MotionShaper::Clock::duration(8ms * i));
+    QVERIFY(std::abs(reports[i].dx) <= 127);
+    // Evenly spread, not seven full steps and a short tail
+    QVERIFY(reports[i].dx >= 124 && reports[i].dx <= 126);
+    totalX += reports[i].dx;
+    totalY += reports[i].dy;
+  }
+  QCOMPARE(totalX, 1000);
+  QCOMPARE(totalY, 10);
+}
+
+void MotionShaperTests::remainderCarriesAcrossCalls()
+{
+  MotionShaper shaper({10ms, 4});
+  const MotionShaper::Clock::time_point start{};
+
+  // 7 px needs two reports; the odd pixel is kept rather than lost or rounded away
+  shaper.add(7, 0);
+  int16_t dx = 0;
+  int16_t dy = 0;
+  QVERIFY(shaper.next(start, dx, dy));
+  QCOMPARE(dx, int16_t(4));
+
+  // Motion arriving mid-flight joins the remainder and is re-spread
+  shaper.add(5, 3);
+  QVERIFY(!shaper.next(start + 5ms, dx, dy));
+  QCOMPARE(shaper.nextReportTime(), start + 10ms);
+
+  int32_t totalX = 4;
+  int32_t totalY = 0;
+  for (const auto &report : drain(shaper, start + 10ms)) {
+    QVERIFY(std::abs(report.dx) <= 4 && std::abs(report.dy) <= 4);
+    totalX += report.dx;
+    totalY += report.dy;
+  }
+  QCOMPARE(totalX, 12);
+  QCOMPARE(totalY, 3);
+}
+
+void MotionShaperTests::randomMotionPreservesDisplacement()
+{
+  MotionShaper shaper({7500us, 127});
+  auto now = MotionShaper::Clock::time_point{};
+
+  // Fixed-seed generator so every run sees the same sequence
+  uint32_t seed = 12345;
+  const auto nextRandom = [&seed](int32_t range) {
+    seed = seed * 1103515245 + 12345;
+    return static_cast<int32_t>((seed >> 8) % (2 * range + 1)) - range;
+  };
+
+  int64_t expectedX = 0;
+  int64_t expectedY = 0;
+  int64_t sentX = 0;
+  int64_t sentY = 0;
+  auto lastReport = MotionShaper::Clock::time_point::min();
+  for (int i = 0; i < 5000; ++i) {
+    // Mostly small moves with the occasional flick
+    const int32_t range = (i % 97 == 0) ? 4000 : 20;
+    const int32_t dx = nextRandom(range);
+    const int32_t dy = nextRandom(range);
+    shaper.add(dx, dy);
+    expectedX += dx;
+    expectedY += dy;
+
+    int16_t stepX = 0;
+    int16_t stepY = 0;
+    if (shaper.next(now, stepX, stepY)) {
+      QVERIFY(std::abs(stepX) <= 127 && std::abs(stepY) <= 127);
+      QVERIFY(lastReport == MotionShaper::Clock::time_point::min() || now - lastReport >= 7500us);
+      lastReport = now;
+      sentX += stepX;
+      sentY += stepY;
+    }
+    now += 1ms;
+  }
+
+  for (const auto &report : drain(shaper, now)) {
+    sentX += report.dx;
+    sentY += report.dy;
+  }
+  QCOMPARE(sentX, expectedX);
+  QCOMPARE(sentY, expectedY);
+}
+
+void MotionShaperTests::immediateIgnoresPacing()
+{
+  MotionShaper shaper({1s, 100});
+  shaper.add(-250, 0);
+
+  int16_t dx = 0;
+  int16_t dy = 0;
+  int32_t total = 0;
+  int reports = 0;
+  while (shaper.nextImmediate(dx, dy)) {
+    total += dx;
+    ++reports;
+  }
+  QCOMPARE(total, -250);
+  QCOMPARE(reports, 3);
+  QVERIFY(!shaper.hasPending());
+}
+
+QTEST_MAIN(MotionShaperTests)
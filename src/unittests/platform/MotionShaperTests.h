@@ -0,0 +1,16 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include <QTest>
+
+class MotionShaperTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void smallMoveIsNotSplit();
+  void largeMoveIsPaced();
+  void remainderCarriesAcrossCalls();
+  void randomMotionPreservesDisplacement();
+  void immediateIgnoresPacing();
+};
@@ -0,0 +1,705 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#pragma once
+
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <openssl/core_names.h>
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+
+namespace deskflow::bridge::fake {
+
+constexpr uint16_t kLinkMagic = 0xC35A;
+constexpr uint8_t kLinkVersion = 0x01;
+constexpr uint8_t kFrameTypeHid = 0x01;
+constexpr uint8_t kFrameTypeHidMouseCompact = 0x02;
+constexpr uint8_t kFrameTypeHidKeyCompact = 0x03;
+constexpr uint8_t kFrameTypeHidScrollCompact = 0x05;
+constexpr uint8_t kFrameTypeHidBatch = 0x06;
+constexpr uint8_t kFrameTypeHidKeyboardReport = 0x07;
+constexpr uint8_t kFrameTypeHidPanCompact = 0x08;
+constexpr uint8_t kFrameTypeHidScrollHiRes = 0x09;
+constexpr uint8_t kFrameTypeHidAbsoluteCompact = 0x0A;
+constexpr uint8_t kFrameTypeControl = 0x80;
+constexpr uint8_t kControlHello = 0x01;
+constexpr uint8_t kControlKeepAlive = 0x09;
+constexpr uint8_t kControlGetProfile = 0x32;
+constexpr uint8_t kControlSetProfile = 0x33;
+constexpr uint8_t kControlAck = 0x81;
+constexpr uint8_t kControlConfigResponse = 0x82;
+constexpr uint8_t kControlCreditUpdate = 0x83;
+constexpr uint8_t kConfigGetDeviceName = 0x02;
+constexpr uint8_t kConfigGetSerialNumber = 0x04;
+constexpr uint8_t kConfigIssueTicket = 0x0A;
+constexpr uint8_t kAuthModeEcdsa = 0x02;
+constexpr uint8_t kAuthModeTicket = 0x03;
+constexpr size_t kAckPayloadLen = 1 + 16 + 32 + 64;
+constexpr size_t kAckCoreOffset = 1;
+constexpr size_t kAckNonceOffset = kAckCoreOffset + 16;
+constexpr size_t kAckTagOffset = kAckNonceOffset + 32;
+constexpr size_t kHelloNonceOffset = 3;
+constexpr size_t kHelloTagOffset = kHelloNonceOffset + 32;
+constexpr size_t kPublicKeySize = 65; // 0x04 | X | Y
+constexpr size_t kTicketIdSize = 16;
+constexpr size_t kTicketKeySize = 32;
+constexpr size_t kProfileSize = 52;
+constexpr size_t kProfileSlots = 6;
+constexpr uint8_t kProtocolVersionFlowControl = 5;
+
+// True on the thread that plays the device, so tests watching the host side can leave it out
+inline thread_local bool t_onDeviceThread = false;
+
+struct ReceivedFrame
+{
+  uint8_t type = 0;
+  uint8_t flags = 0;
+  std::vector<uint8_t> payload;
+};
+
+// Splits batch frames into one frame per record, so callers see every HID event on its own
+inline std::vector<ReceivedFrame> expandBatches(const std::vector<ReceivedFrame> &frames)
+{
+  std::vector<ReceivedFrame> events;
+  for (const auto &frame : frames) {
+    if (frame.type != kFrameTypeHidBatch) {
+      events.push_back(frame);
+      continue;
+    }
+    for (size_t offset = 0; offset + 3 <= frame.payload.size();) {
+      const size_t length = frame.payload[offset + 2];
+      const auto begin = frame.payload.begin() + offset + 3;
+      if (offset + 3 + length > frame.payload.size()) {
+        break;
+      }
+      events.push_back({frame.payload[offset], frame.payload[offset + 1], std::vector<uint8_t>(begin, begin + length)});
+      offset += 3 + length;
+    }
+  }
+  return events;
+}
+
+// Decodes a legacy HID frame ([0x55, 0xAA, type, len, payload...]) carrying a mouse move
+inline bool legacyMouseMove(const ReceivedFrame &frame, int16_t &dx, int16_t &dy)
+{
+  if (frame.type != kFrameTypeHid || frame.payload.size() != 8 || frame.payload[2] != 0x03) {
+    return false;
+  }
+  dx = static_cast<int16_t>(frame.payload[4] | (frame.payload[5] << 8));
+  dy = static_cast<int16_t>(frame.payload[6] | (frame.payload[7] << 8));
+  return true;
+}
+
+/**
+ * @brief Firmware emulator on the master side of a pseudo-terminal
+ *
+ * Speaks the USB link protocol so CdcTransport and everything above it can be tested and
+ * benchmarked without hardware:
+ * - HELLO is answered with an ACK; once enableSigning() has generated a test key, ECDSA HELLOs
+ *   get a valid signature, otherwise a well-formed but wrong one.
+ * - Config requests from the handshake, keep-alives, profile reads and writes, and session
+ *   tickets given with setSessionTicket() are served.
+ * - HID frames are recorded for inspection. From protocol version 5 they go through an emulated
+ *   BLE output queue which grants credits for setCreditWindow() reports and forwards them at
+ *   setReportRate(); reports beyond the window are counted as overflows.
+ * - notify() sends a control frame that answers no request.
+ *
+ * The link can be degraded with reply latency, a receive throughput limit and injected faults.
+ */
+class PtyFakeDevice
+{
+public:
+  PtyFakeDevice()
+  {
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0) {
+      return;
+    }
+    m_slavePath = QString::fromUtf8(ptsname(m_master));
+
+    // Hold the slave open so the master never sees a hang-up between transport reconnects
+    m_slaveKeepAlive = ::open(ptsname(m_master), O_RDWR | O_NOCTTY);
+    struct termios tty;
+    tcgetattr(m_master, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(m_master, TCSANOW, &tty);
+
+    for (size_t slot = 0; slot < kProfileSlots; ++slot) {
+      m_profiles[slot].fill(static_cast<uint8_t>(slot));
+    }
+
+    m_running = true;
+    m_thread = std::thread([this] {
+      t_onDeviceThread = true;
+      run();
+    });
+  }
+
+  ~PtyFakeDevice()
+  {
+    m_running = false;
+    if (m_thread.joinable()) {
+      m_thread.join();
+    }
+    if (m_slaveKeepAlive >= 0) {
+      ::close(m_slaveKeepAlive);
+    }
+    if (m_master >= 0) {
+      ::close(m_master);
+    }
+    EVP_PKEY_free(m_signingKey);
+  }
+
+  enum class Fault
+  {
+    DropReply,      // the reply is never sent
+    NoisyReply,     // line noise precedes the reply, so the host has to resynchronise on the magic
+    FragmentReply,  // the reply trickles out one byte at a time
+    DuplicateReply, // the reply goes out twice, like a late ACK to an earlier command
+    HangUp          // instead of replying, the device disappears like an unplugged cable
+  };
+
+  bool isValid() const
+  {
+    return m_running;
+  }
+
+  QString slavePath() const
+  {
+    return m_slavePath;
+  }
+
+  // When set, the device swallows requests without answering
+  void setMute(bool mute)
+  {
+    m_mute = mute;
+  }
+
+  void setProtocolVersion(uint8_t version)
+  {
+    m_protocolVersion = version;
+  }
+
+  // Every reply leaves this long after its request arrived; requests keep being processed meanwhile
+  void setReplyLatency(std::chrono::milliseconds latency)
+  {
+    m_replyLatency = latency;
+  }
+
+  // Caps how fast the device drains what the host writes, 0 for no limit
+  void setThroughputLimit(size_t bytesPerSecond)
+  {
+    m_bytesPerSecond = bytesPerSecond;
+  }
+
+  // Reports the emulated BLE output queue holds, advertised as credits from protocol version 5
+  void setCreditWindow(uint16_t window)
+  {
+    m_creditWindow = window;
+  }
+
+  // How fast queued reports are forwarded over BLE, 0 to forward them as soon as they arrive
+  void setReportRate(size_t reportsPerSecond)
+  {
+    m_reportsPerSecond = reportsPerSecond;
+  }
+
+  // Reports that arrived while the output queue was already full
+  size_t overflows() const
+  {
+    return m_overflows;
+  }
+
+  // High-water mark of reports waiting in the output queue
+  size_t maxQueuedReports() const
+  {
+    return m_maxQueuedReports;
+  }
+
+  // Applies the fault to the next count replies
+  void injectFault(Fault fault, size_t count = 1)
+  {
+    std::scoped_lock lock(m_mutex);
+    m_fault = fault;
+    m_faultCount = count;
+  }
+
+  // Sends a control frame that answers no request, like a firmware notification
+  void notify(std::vector<uint8_t> payload)
+  {
+    std::scoped_lock lock(m_mutex);
+    m_notifications.push_back(std::move(payload));
+  }
+
+  // Generates a P-256 test key to sign ECDSA handshakes with and returns its public point,
+  // for CdcTransport::setTrustedDeviceKey() on the transport under test
+  std::vector<uint8_t> enableSigning()
+  {
+    std::scoped_lock lock(m_mutex);
+    if (m_signingKey == nullptr) {
+      m_signingKey = EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256");
+    }
+    std::vector<uint8_t> publicKey(kPublicKeySize);
+    size_t size = 0;
+    if (m_signingKey == nullptr ||
+        EVP_PKEY_get_octet_string_param(
+            m_signingKey, OSSL_PKEY_PARAM_PUB_KEY, publicKey.data(), publicKey.size(), &size
+        ) != 1 ||
+        size != kPublicKeySize) {
+      return {};
+    }
+    return publicKey;
+  }
+
+  // Profiles are stored as raw firmware layout; a fresh device has slot i filled with byte i
+  std::array<uint8_t, kProfileSize> profile(size_t slot)
+  {
+    std::scoped_lock lock(m_mutex);
+    return m_profiles.at(slot);
+  }
+
+  size_t profileRequests()
+  {
+    std::scoped_lock lock(m_mutex);
+    return m_profileRequests;
+  }
+
+  // Control requests of any kind received so far, HELLO included
+  size_t controlRequests() const
+  {
+    return m_controlRequests;
+  }
+
+  void setSessionTicket(
+      const std::array<uint8_t, kTicketIdSize> &id, const std::array<uint8_t, kTicketKeySize> &key, uint16_t lifetime
+  )
+  {
+    std::scoped_lock lock(m_mutex);
+    m_ticketId = id;
+    m_ticketKey = key;
+    m_ticketLifetime = lifetime;
+    m_hasTicket = true;
+  }
+
+  // Non-control frames received so far, with batch frames split into their records
+  std::vector<ReceivedFrame> hidEvents()
+  {
+    std::scoped_lock lock(m_mutex);
+    return expandBatches(m_hidFrames);
+  }
+
+  // Waits until at least count non-control frames arrived and returns them
+  std::vector<ReceivedFrame> waitForHidFrames(size_t count)
+  {
+    return waitForHidFrames([count](const std::vector<ReceivedFrame> &frames) { return frames.size() >= count; });
+  }
+
+  // Waits until done accepts the non-control frames received so far and returns them
+  std::vector<ReceivedFrame> waitForHidFrames(const std::function<bool(const std::vector<ReceivedFrame> &)> &done)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (std::chrono::steady_clock::now() < deadline) {
+      {
+        std::scoped_lock lock(m_mutex);
+        if (done(m_hidFrames)) {
+          return m_hidFrames;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::scoped_lock lock(m_mutex);
+    return m_hidFrames;
+  }
+
+private:
+  void run()
+  {
+    std::vector<uint8_t> rx;
+    uint8_t buffer[512];
+    auto lastRefill = std::chrono::steady_clock::now();
+    double budget = 0;
+    while (m_running && !m_hungUp) {
+      sendNotifications();
+      sendDueReplies();
+      forwardReports();
+
+      // Token bucket: what the link could have carried since the last read, at most one buffer
+      size_t capacity = sizeof(buffer);
+      if (const size_t rate = m_bytesPerSecond; rate != 0) {
+        const auto now = std::chrono::steady_clock::now();
+        budget = std::min<double>(
+            budget + std::chrono::duration<double>(now - lastRefill).count() * static_cast<double>(rate),
+            sizeof(buffer)
+        );
+        lastRefill = now;
+        if (budget < 1) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          continue;
+        }
+        capacity = static_cast<size_t>(budget);
+      }
+
+      struct pollfd pfd = {m_master, POLLIN, 0};
+      const bool busy = !m_delayedReplies.empty() || m_reportsForwarded != m_reportsReceived;
+      if (::poll(&pfd, 1, busy ? 1 : 20) <= 0) {
+        continue;
+      }
+      const ssize_t n = ::read(m_master, buffer, capacity);
+      if (n <= 0) {
+        continue;
+      }
+      if (m_bytesPerSecond != 0) {
+        budget -= static_cast<double>(n);
+      }
+      rx.insert(rx.end(), buffer, buffer + n);
+
+      while (rx.size() >= 8) {
+        if ((rx[0] | (rx[1] << 8)) != kLinkMagic) {
+          rx.erase(rx.begin());
+          continue;
+        }
+        const size_t length = rx[6] | (rx[7] << 8);
+        if (rx.size() < 8 + length) {
+          break;
+        }
+        const uint8_t type = rx[3];
+        const uint8_t flags = rx[4];
+        std::vector<uint8_t> payload(rx.begin() + 8, rx.begin() + 8 + length);
+        rx.erase(rx.begin(), rx.begin() + 8 + length);
+        if (type != kFrameTypeControl) {
+          queueReports(type == kFrameTypeHidBatch ? flags : 1);
+          std::scoped_lock lock(m_mutex);
+          m_hidFrames.push_back({type, flags, std::move(payload)});
+        } else if (!m_mute && !payload.empty()) {
+          ++m_controlRequests;
+          handleControl(payload);
+        }
+      }
+    }
+  }
+
+  void handleControl(const std::vector<uint8_t> &payload)
+  {
+    switch (payload[0]) {
+    case kControlHello: {
+      std::vector<uint8_t> ack(kAckPayloadLen, 0);
+      ack[0] = kControlAck;
+      ack[1] = m_protocolVersion;
+      ack[2] = 3;    // activated
+      ack[7] = 0x20; // 2 profiles, active 0
+      // Device nonce and a well-formed but wrong signature, so a secure handshake runs the full
+      // ECDSA verification before it is rejected
+      std::fill(ack.begin() + kAckNonceOffset, ack.end(), 0x5A);
+      if (payload.size() >= kHelloTagOffset + kTicketIdSize && payload[2] == kAuthModeTicket) {
+        signWithTicket(payload, ack);
+      } else if (payload.size() >= kHelloTagOffset && payload[2] == kAuthModeEcdsa) {
+        signWithTestKey(payload, ack);
+      }
+      send(ack);
+
+      // A new session starts with an empty output queue and a full window
+      m_reportsReceived = 0;
+      m_reportsForwarded = 0;
+      m_forwardCredit = 0;
+      m_lastForward = std::chrono::steady_clock::now();
+      if (m_protocolVersion >= kProtocolVersionFlowControl) {
+        sendCreditUpdate();
+      }
+      break;
+    }
+    case kConfigIssueTicket: {
+      std::unique_lock lock(m_mutex);
+      if (!m_hasTicket) {
+        lock.unlock();
+        sendConfigResponse(kConfigIssueTicket, {}, 1);
+        break;
+      }
+      std::vector<uint8_t> data(m_ticketId.begin(), m_ticketId.end());
+      data.insert(data.end(), m_ticketKey.begin(), m_ticketKey.end());
+      data.push_back(static_cast<uint8_t>(m_ticketLifetime & 0xFF));
+      data.push_back(static_cast<uint8_t>(m_ticketLifetime >> 8));
+      lock.unlock();
+      sendConfigResponse(kConfigIssueTicket, std::move(data));
+      break;
+    }
+    case kConfigGetDeviceName:
+      sendConfigResponse(kConfigGetDeviceName, {'f', 'a', 'k', 'e'});
+      break;
+    case kConfigGetSerialNumber:
+      sendConfigResponse(kConfigGetSerialNumber, {'S', 'N', '0', '1'});
+      break;
+    case kControlKeepAlive:
+      sendConfigResponse(kControlKeepAlive, {0x2A, 0, 0, 0});
+      break;
+    case kControlGetProfile:
+    case kControlSetProfile:
+      handleProfile(payload);
+      break;
+    default:
+      break;
+    }
+  }
+
+  void handleProfile(const std::vector<uint8_t> &payload)
+  {
+    std::vector<uint8_t> ack = {kControlAck, 0x01}; // status 1: bad request
+    {
+      std::scoped_lock lock(m_mutex);
+      ++m_profileRequests;
+      const size_t slot = payload.size() >= 2 ? payload[1] : kProfileSlots;
+      if (slot < kProfileSlots && payload[0] == kControlGetProfile) {
+        ack[1] = 0;
+        ack.insert(ack.end(), m_profiles[slot].begin(), m_profiles[slot].end());
+      } else if (slot < kProfileSlots && payload.size() == 2 + kProfileSize) {
+        ack[1] = 0;
+        std::memcpy(m_profiles[slot].data(), payload.data() + 2, kProfileSize);
+      }
+    }
+    send(ack);
+  }
+
+  // Replaces the ACK tag with HMAC-SHA256("DFACK" | host nonce | device nonce | ACK core) if the
+  // HELLO presents the ticket this device holds
+  void signWithTicket(const std::vector<uint8_t> &hello, std::vector<uint8_t> &ack)
+  {
+    std::scoped_lock lock(m_mutex);
+    if (!m_hasTicket || !std::equal(m_ticketId.begin(), m_ticketId.end(), hello.begin() + kHelloTagOffset)) {
+      return;
+    }
+    std::vector<uint8_t> msg = {'D', 'F', 'A', 'C', 'K'};
+    msg.insert(msg.end(), hello.begin() + kHelloNonceOffset, hello.begin() + kHelloTagOffset);
+    msg.insert(msg.end(), ack.begin() + kAckNonceOffset, ack.begin() + kAckTagOffset);
+    msg.insert(msg.end(), ack.begin() + kAckCoreOffset, ack.begin() + kAckNonceOffset);
+    size_t tagSize = 0;
+    EVP_Q_mac(
+        nullptr, "HMAC", nullptr, "SHA256", nullptr, m_ticketKey.data(), m_ticketKey.size(), msg.data(), msg.size(),
+        ack.data() + kAckTagOffset, 32, &tagSize
+    );
+  }
+
+  // Replaces the ACK tag with the raw ECDSA signature (R | S) of host nonce | device nonce
+  void signWithTestKey(const std::vector<uint8_t> &hello, std::vector<uint8_t> &ack)
+  {
+    std::scoped_lock lock(m_mutex);
+    if (m_signingKey == nullptr) {
+      return;
+    }
+    ++m_deviceNonce;
+    std::fill(ack.begin() + kAckNonceOffset, ack.begin() + kAckTagOffset, static_cast<uint8_t>(m_deviceNonce));
+
+    std::vector<uint8_t> msg(hello.begin() + kHelloNonceOffset, hello.begin() + kHelloTagOffset);
+    msg.insert(msg.end(), ack.begin() + kAckNonceOffset, ack.begin() + kAckTagOffset);
+    std::array<uint8_t, 80> der;
+    size_t derSize = der.size();
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    const bool signedOk = EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, m_signingKey) == 1 &&
+                          EVP_DigestSign(ctx, der.data(), &derSize, msg.data(), msg.size()) == 1;
+    EVP_MD_CTX_free(ctx);
+    if (!signedOk) {
+      return;
+    }
+
+    const uint8_t *p = der.data();
+    ECDSA_SIG *sig = d2i_ECDSA_SIG(nullptr, &p, static_cast<long>(derSize));
+    if (sig != nullptr) {
+      BN_bn2binpad(ECDSA_SIG_get0_r(sig), ack.data() + kAckTagOffset, 32);
+      BN_bn2binpad(ECDSA_SIG_get0_s(sig), ack.data() + kAckTagOffset + 32, 32);
+      ECDSA_SIG_free(sig);
+    }
+  }
+
+  void queueReports(size_t count)
+  {
+    m_reportsReceived += static_cast<uint32_t>(count);
+    const size_t queued = m_reportsReceived - m_reportsForwarded;
+    if (m_protocolVersion >= kProtocolVersionFlowControl && queued > m_creditWindow) {
+      m_overflows += queued - std::max<size_t>(m_creditWindow, queued - count);
+    }
+    m_maxQueuedReports = std::max<size_t>(m_maxQueuedReports, queued);
+  }
+
+  // Forwards queued reports at the BLE report rate and advertises the credits this frees up
+  void forwardReports()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const uint32_t queued = m_reportsReceived - m_reportsForwarded;
+    uint32_t forwarded = queued;
+    if (const size_t rate = m_reportsPerSecond; rate != 0) {
+      m_forwardCredit = std::min<double>(
+          m_forwardCredit + std::chrono::duration<double>(now - m_lastForward).count() * static_cast<double>(rate),
+          static_cast<double>(queued)
+      );
+      forwarded = static_cast<uint32_t>(m_forwardCredit);
+      m_forwardCredit -= forwarded;
+    }
+    m_lastForward = now;
+    if (forwarded == 0) {
+      return;
+    }
+    m_reportsForwarded += forwarded;
+    if (m_protocolVersion >= kProtocolVersionFlowControl) {
+      sendCreditUpdate();
+    }
+  }
+
+  void sendCreditUpdate()
+  {
+    const uint32_t consumed = m_reportsForwarded;
+    const uint16_t window = m_creditWindow;
+    send(
+        {kControlCreditUpdate, static_cast<uint8_t>(consumed & 0xFF), static_cast<uint8_t>((consumed >> 8) & 0xFF),
+         static_cast<uint8_t>((consumed >> 16) & 0xFF), static_cast<uint8_t>(consumed >> 24),
+         static_cast<uint8_t>(window & 0xFF), static_cast<uint8_t>(window >> 8)}
+    );
+  }
+
+  void sendConfigResponse(uint8_t msgType, std::vector<uint8_t> data, uint8_t status = 0)
+  {
+    data.insert(data.begin(), {kControlConfigResponse, msgType, status});
+    send(data);
+  }
+
+  void send(const std::vector<uint8_t> &payload)
+  {
+    const auto length = static_cast<uint16_t>(payload.size());
+    std::vector<uint8_t> frame = {
+        static_cast<uint8_t>(kLinkMagic & 0xFF),
+        static_cast<uint8_t>(kLinkMagic >> 8),
+        kLinkVersion,
+        kFrameTypeControl,
+        0,
+        0,
+        static_cast<uint8_t>(length & 0xFF),
+        static_cast<uint8_t>(length >> 8)
+    };
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    if (m_replyLatency.load() > std::chrono::milliseconds(0)) {
+      m_delayedReplies.push_back({std::chrono::steady_clock::now() + m_replyLatency.load(), std::move(frame)});
+      return;
+    }
+    transmit(frame);
+  }
+
+  void sendNotifications()
+  {
+    std::vector<std::vector<uint8_t>> notifications;
+    {
+      std::scoped_lock lock(m_mutex);
+      notifications.swap(m_notifications);
+    }
+    for (const auto &payload : notifications) {
+      send(payload);
+    }
+  }
+
+  void sendDueReplies()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    while (!m_delayedReplies.empty() && m_delayedReplies.front().first <= now) {
+      transmit(m_delayedReplies.front().second);
+      m_delayedReplies.erase(m_delayedReplies.begin());
+    }
+  }
+
+  // Writes a reply to the host, through whatever fault is pending
+  void transmit(const std::vector<uint8_t> &frame)
+  {
+    std::optional<Fault> fault;
+    {
+      std::scoped_lock lock(m_mutex);
+      if (m_faultCount > 0) {
+        --m_faultCount;
+        fault = m_fault;
+      }
+    }
+
+    if (!fault.has_value()) {
+      [[maybe_unused]] const auto written = ::write(m_master, frame.data(), frame.size());
+      return;
+    }
+
+    switch (*fault) {
+    case Fault::DropReply:
+      break;
+    case Fault::NoisyReply: {
+      const uint8_t noise[] = {0x5A, 0x00, 0xC3, 0x5A, 0xFF, 0x01};
+      [[maybe_unused]] const auto noiseWritten = ::write(m_master, noise, sizeof(noise));
+      [[maybe_unused]] const auto written = ::write(m_master, frame.data(), frame.size());
+      break;
+    }
+    case Fault::FragmentReply:
+      for (const uint8_t byte : frame) {
+        [[maybe_unused]] const auto written = ::write(m_master, &byte, 1);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+      break;
+    case Fault::DuplicateReply:
+      for (int i = 0; i < 2; ++i) {
+        [[maybe_unused]] const auto written = ::write(m_master, frame.data(), frame.size());
+      }
+      break;
+    case Fault::HangUp:
+      ::close(m_master);
+      m_master = -1;
+      m_hungUp = true;
+      break;
+    }
+  }
+
+  int m_master = -1;
+  int m_slaveKeepAlive = -1;
+  QString m_slavePath;
+  std::atomic_bool m_running = false;
+  std::atomic_bool m_mute = false;
+  std::atomic<uint8_t> m_protocolVersion = 1;
+  std::atomic<std::chrono::milliseconds> m_replyLatency = std::chrono::milliseconds(0);
+  std::atomic<size_t> m_bytesPerSecond = 0;
+  std::atomic_bool m_hungUp = false;
+  std::atomic<uint16_t> m_creditWindow = 16;
+  std::atomic<size_t> m_reportsPerSecond = 0;
+  std::atomic<size_t> m_overflows = 0;
+  std::atomic<size_t> m_maxQueuedReports = 0;
+  uint32_t m_reportsReceived = 0;  // device thread only
+  uint32_t m_reportsForwarded = 0; // device thread only
+  double m_forwardCredit = 0;      // device thread only, reports the BLE link could have sent so far
+  std::chrono::steady_clock::time_point m_lastForward = std::chrono::steady_clock::now(); // device thread only
+  std::vector<std::pair<std::chrono::steady_clock::time_point, std::vector<uint8_t>>> m_delayedReplies; // device thread only
+  std::mutex m_mutex;
+  std::vector<ReceivedFrame> m_hidFrames;
+  std::vector<std::vector<uint8_t>> m_notifications;
+  std::array<std::array<uint8_t, kProfileSize>, kProfileSlots> m_profiles{};
+  size_t m_profileRequests = 0;
+  std::atomic<size_t> m_controlRequests = 0;
+  bool m_hasTicket = false;
+  std::array<uint8_t, kTicketIdSize> m_ticketId{};
+  std::array<uint8_t, kTicketKeySize> m_ticketKey{};
+  uint16_t m_ticketLifetime = 0;
+  Fault m_fault = Fault::DropReply;
+  size_t m_faultCount = 0;
+  EVP_PKEY *m_signingKey = nullptr;
+  uint8_t m_deviceNonce = 0;
+  std::thread m_thread;
+};
+
+} // namespace deskflow::bridge::fake
@@ -0,0 +1,121 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "SessionTicketCacheTests.h"
+
+#include "platform/bridge/SessionTicketCache.h"
+
+#include <QTemporaryDir>
+
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+using namespace deskflow::bridge;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::filesystem::path cacheFileIn(const QTemporaryDir &dir)
+{
+  return std::filesystem::path(dir.filePath("tickets").toStdString());
+}
+
+SessionTicket makeTicket(uint8_t seed, std::chrono::system_clock::duration lifetime)
+{
+  SessionTicket ticket;
+  ticket.id.fill(seed);
+  ticket.key.fill(static_cast<uint8_t>(seed + 1));
+  ticket.expiresAt = std::chrono::system_clock::now() + lifetime;
+  ticket.deviceName = "desk " + std::to_string(seed);
+  return ticket;
+}
+
+} // namespace
+
+void SessionTicketCacheTests::roundTripThroughFile()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto file = cacheFileIn(dir);
+  const auto ticket = makeTicket(7, 60s);
+  SessionTicketCache(file).store("/dev/tty ACM0", ticket);
+
+  // A second instance stands in for the other process opening the device next
+  const auto found = SessionTicketCache(file).find("/dev/tty ACM0");
+  QVERIFY(found.has_value());
+  QCOMPARE(found->id, ticket.id);
+  QCOMPARE(found->key, ticket.key);
+  QCOMPARE(found->deviceName, ticket.deviceName);
+  QCOMPARE(
+      std::chrono::duration_cast<std::chrono::seconds>(found->expiresAt.time_since_epoch()),
+      std::chrono::duration_cast<std::chrono::seconds>(ticket.expiresAt.time_since_epoch())
+  );
+
+  const auto perms = std::filesystem::status(file).permissions();
+  QVERIFY(
+      (perms & (std::filesystem::perms::group_all | std::filesystem::perms::others_all)) ==
+      std::filesystem::perms::none
+  );
+}
+
+void SessionTicketCacheTests::expiredTicketIsIgnored()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto file = cacheFileIn(dir);
+  SessionTicketCache cache(file);
+  cache.store("/dev/ttyACM0", makeTicket(1, -1s));
+  QVERIFY(!cache.find("/dev/ttyACM0").has_value());
+}
+
+void SessionTicketCacheTests::eraseKeepsOtherDevices()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto file = cacheFileIn(dir);
+  SessionTicketCache cache(file);
+  cache.store("/dev/ttyACM0", makeTicket(1, 60s));
+  cache.store("/dev/ttyACM1", makeTicket(2, 60s));
+
+  cache.erase("/dev/ttyACM0");
+  QVERIFY(!cache.find("/dev/ttyACM0").has_value());
+  QVERIFY(cache.find("/dev/ttyACM1").has_value());
+  QCOMPARE(cache.find("/dev/ttyACM1")->deviceName, std::string("desk 2"));
+}
+
+void SessionTicketCacheTests::concurrentStoresKeepEveryTicket()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const auto file = cacheFileIn(dir);
+
+  // Separate instances share nothing but the file, as the GUI and core processes do
+  constexpr int kWriters = 4;
+  constexpr int kStoresEach = 10;
+  std::vector<std::thread> writers;
+  for (int writer = 0; writer < kWriters; ++writer) {
+    writers.emplace_back([&file, writer] {
+      SessionTicketCache cache(file);
+      for (int i = 0; i < kStoresEach; ++i) {
+        cache.store("/dev/ttyACM" + std::to_string(writer * kStoresEach + i), makeTicket(uint8_t(writer), 60s));
+      }
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  SessionTicketCache cache(file);
+  for (int device = 0; device < kWriters * kStoresEach; ++device) {
+    QVERIFY2(cache.find("/dev/ttyACM" + std::to_string(device)).has_value(), std::to_string(device).c_str());
+  }
+
+  // Only the ticket file and its lock file are left; no temp files
+  for (const auto &entry : std::filesystem::directory_iterator(file.parent_path())) {
+    QVERIFY2(entry.path().extension() != ".tmp", entry.path().string().c_str());
+  }
+}
+
+QTEST_MAIN(SessionTicketCacheTests)
@@ -0,0 +1,20 @@
+/*
+ * dshare-hid -- created by locke.huang@gmail.com
+ */
+
+#include "base/Log.h"
+
+#include <QTest>
+
+class SessionTicketCacheTests : public QObject
+{
+  Q_OBJECT
+private Q_SLOTS:
+  void roundTripThroughFile();
+  void expiredTicketIsIgnored();
+  void eraseKeepsOtherDevices();
+  void concurrentStoresKeepEveryTicket();
+
+private:
+  Log m_log;
+};